@@ -0,0 +1,53 @@
+/**
+ * @file
+ *
+ * @brief Benchmark for the Base64 codec shared by the base64 and crypto plugins
+ *
+ * @copyright BSD License (see LICENSE.md or https://www.libelektra.org)
+ */
+
+#include <benchmarks.h>
+
+#include <base64_functions.h>
+
+#define BINARY_SIZE (16 * 1024 * 1024)
+#define ROUNDS 10
+
+int main (void)
+{
+	kdb_octet_t * binary = elektraMalloc (BINARY_SIZE);
+	if (!binary) return 1;
+
+	int32_t seed = elektraRandGetInitSeed ();
+	for (size_t i = 0; i < BINARY_SIZE; ++i)
+	{
+		elektraRand (&seed);
+		binary[i] = seed & 0xff;
+	}
+
+	char * encoded = 0;
+	timeInit ();
+	for (int i = 0; i < ROUNDS; ++i)
+	{
+		if (encoded) elektraFree (encoded);
+		encoded = ELEKTRA_PLUGIN_FUNCTION (base64, base64Encode) (binary, BINARY_SIZE);
+	}
+	timePrint ("Encode");
+
+	kdb_octet_t * decoded = 0;
+	size_t decodedLength = 0;
+	for (int i = 0; i < ROUNDS; ++i)
+	{
+		if (decoded) elektraFree (decoded);
+		if (ELEKTRA_PLUGIN_FUNCTION (base64, base64Decode) (encoded, &decoded, &decodedLength) != 1) return 1;
+	}
+	timePrint ("Decode");
+
+	int ret = decodedLength != BINARY_SIZE || memcmp (binary, decoded, BINARY_SIZE);
+	if (ret) printf ("round trip failed\n");
+
+	elektraFree (decoded);
+	elektraFree (encoded);
+	elektraFree (binary);
+	return ret;
+}
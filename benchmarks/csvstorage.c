@@ -0,0 +1,90 @@
+/**
+ * @file
+ *
+ * @brief Benchmark for reading large CSV files with the csvstorage plugin
+ *
+ * @copyright BSD License (see LICENSE.md or https://www.libelektra.org)
+ */
+
+#include <benchmarks.h>
+
+#define CSV_FILE "benchmark_csvstorage.csv"
+#define CSV_ROWS 1000000
+
+KeySet * modules;
+Plugin * plugin;
+Key * parentKey;
+KeySet * returned;
+
+int benchmarkWriteFile (const char * fileName, int rows)
+{
+	FILE * fp = fopen (fileName, "w");
+	if (!fp) return -1;
+
+	fprintf (fp, "id;name;description;value\n");
+	for (int i = 0; i < rows; i++)
+	{
+		fprintf (fp, "%d;name%d;\"some text; with delimiter %d\";%d\n", i, i, i, i * 7);
+	}
+
+	return fclose (fp);
+}
+
+int benchmarkOpen (void)
+{
+	modules = ksNew (0, KS_END);
+	elektraModulesInit (modules, 0);
+	KeySet * config = ksNew (2, keyNew ("user/delimiter", KEY_VALUE, ";", KEY_END), keyNew ("user/header", KEY_VALUE, "colname", KEY_END),
+				 KS_END);
+	plugin = elektraPluginOpen ("csvstorage", modules, config, parentKey);
+	return plugin ? 0 : -1;
+}
+
+void benchmarkRead (void)
+{
+	returned = ksNew (0, KS_END);
+	plugin->kdbGet (plugin, returned, parentKey);
+}
+
+void benchmarkClose (void)
+{
+	if (plugin) elektraPluginClose (plugin, parentKey);
+	elektraModulesClose (modules, 0);
+	ksDel (modules);
+}
+
+int main (int argc, char ** argv)
+{
+	int rows = argc > 1 ? atoi (argv[1]) : CSV_ROWS;
+	const char * fileName = argc > 2 ? argv[2] : CSV_FILE;
+	parentKey = keyNew (KEY_ROOT, KEY_VALUE, fileName, KEY_END);
+
+	timeInit ();
+	if (benchmarkWriteFile (fileName, rows) != 0)
+	{
+		fprintf (stderr, "Could not write file %s\n", fileName);
+		keyDel (parentKey);
+		return 1;
+	}
+	timePrint ("Wrote CSV file");
+
+	if (benchmarkOpen () != 0)
+	{
+		fprintf (stderr, "Could not open csvstorage plugin\n");
+		benchmarkClose ();
+		keyDel (parentKey);
+		unlink (fileName);
+		return 1;
+	}
+	timePrint ("Opened plugin");
+
+	benchmarkRead ();
+	timePrint ("Read CSV file");
+
+	fprintf (stdout, "Read %zd keys from %d rows\n", ksGetSize (returned), rows);
+
+	ksDel (returned);
+	benchmarkClose ();
+	keyDel (parentKey);
+	unlink (fileName);
+}
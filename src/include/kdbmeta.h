@@ -52,6 +52,7 @@ int keySetCTime (Key * key, time_t ctime);
 #endif
 
 int elektraKeyCmpOrder (const Key * a, const Key * b);
+int elektraSortKeysByOrder (Key ** array, size_t size);
 
 KeySet * elektraMetaArrayToKS (Key *, const char *);
 
@@ -102,12 +102,25 @@ extern "C" {
 
 typedef struct _Plugin Plugin;
 
+/**
+ * @brief Checks a single key, exported as `checkkey` by validation plugins.
+ *
+ * @retval 1 if the key is valid
+ * @retval 0 or -1 if not, the error is added to errorKey
+ *
+ * @see elektraPluginCheckKeys()
+ * @ingroup plugin
+ */
+typedef int (*kdbCheckKeyPtr) (Plugin * handle, Key * key, Key * errorKey);
+
 Plugin * elektraPluginExport (const char * pluginName, ...);
 
 KeySet * elektraPluginGetConfig (Plugin * handle);
 void elektraPluginSetData (Plugin * plugin, void * handle);
 void * elektraPluginGetData (Plugin * plugin);
 
+int elektraPluginCheckKeys (Plugin * handle, KeySet * ks, const char * metaName, kdbCheckKeyPtr checkKey, Key * parentKey);
+
 
 #define PLUGINVERSION "1"
 
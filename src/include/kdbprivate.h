@@ -208,6 +208,12 @@ struct _Key
 	 * All the key's meta information.
 	 */
 	KeySet * meta;
+
+	/**
+	 * Incremented whenever the meta information changes.
+	 * @see elektraKsNextWithMeta()
+	 */
+	size_t metaVersion;
 };
 
 
@@ -238,6 +244,12 @@ struct _KeySet
 	 * Some control and internal flags.
 	 */
 	ksflag_t flags;
+
+	/**
+	 * Keys having certain meta information, built by elektraKsNextWithMeta().
+	 * Removed whenever keys are added or removed.
+	 */
+	struct _KsMetaIndex * metaIndex;
 #ifdef ELEKTRA_ENABLE_OPTIMIZATIONS
 	/**
 	 * The Order Preserving Minimal Perfect Hash Map.
@@ -468,6 +480,8 @@ int elektraProcessPlugins (Plugin ** plugins, KeySet * modules, KeySet * referen
 
 Plugin * elektraPluginMissing (void);
 Plugin * elektraPluginVersion (void);
+int elektraPluginCheckKeysWith (Plugin * handle, KeySet * ks, const char * metaName, kdbCheckKeyPtr checkKey, Key * parentKey,
+				size_t workers, size_t minKeys);
 
 /*Trie handling*/
 int trieClose (Trie * trie, Key * errorKey);
@@ -500,6 +514,9 @@ KeySet * ksDeepDup (const KeySet * source);
 
 Key * elektraKsPrev (KeySet * ks);
 Key * elektraKsPopAtCursor (KeySet * ks, cursor_t pos);
+Key * elektraKsNextWithMeta (KeySet * ks, const char * metaName);
+void elektraKsClearMetaIndex (KeySet * ks);
+ssize_t elektraKsDiff (const KeySet * oldKs, const KeySet * newKs, KeySet * added, KeySet * removed, KeySet * modified);
 
 int elektraKeyLock (Key * key, enum elektraLockOptions what);
 
@@ -65,6 +65,8 @@ KeySet * elektraKeyGetMetaKeySet (const Key * key);
 
 Key * ksPrev (KeySet * ks);
 Key * ksPopAtCursor (KeySet * ks, cursor_t c);
+Key * ksNextWithMeta (KeySet * ks, const char * metaName);
+ssize_t ksDiff (const KeySet * oldKs, const KeySet * newKs, KeySet * added, KeySet * removed, KeySet * modified);
 
 
 typedef enum {
@@ -538,30 +538,114 @@ static int elektraGetDoUpdate (Split * split, Key * parentKey)
 
 typedef enum { FIRST, LAST } UpdatePass;
 
+/**
+ * @internal
+ *
+ * The namespaces of the keys passed to post-storage plugins, in the
+ * order they have in a sorted keyset. Keys in spec are not passed.
+ */
+static const char * const globalKSNamespaces[] = { "dir", "proc", "system", "user" };
+
+/**
+ * @internal
+ *
+ * @brief Find the keys of ks below or same as parentKey in the namespace ns
+ *
+ * Keys below a key directly follow it in a sorted keyset, so both ends
+ * of the range are found by binary search.
+ *
+ * @param begin set to the index of the first key in the range
+ * @param end set to the index after the last key in the range
+ */
+static void findGlobalKSRange (KeySet * ks, Key * parentKey, const char * ns, size_t * begin, size_t * end)
+{
+	Key * cutKey = keyNew (ns, KEY_END);
+	const char * name = strchr (keyName (parentKey), '/');
+	if (name) keyAddName (cutKey, name);
+
+	ssize_t first = ksSearchInternal (ks, cutKey);
+	if (first < 0) first = -first - 1;
+
+	size_t lower = first;
+	size_t upper = ks->size;
+	while (lower < upper)
+	{
+		size_t middle = lower + (upper - lower) / 2;
+		if (keyIsBelowOrSame (cutKey, ks->array[middle]))
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+
+	keyDel (cutKey);
+	*begin = first;
+	*end = upper;
+}
+
+/**
+ * @internal
+ *
+ * @brief Collect the keys of ks a post-storage plugin of the backend of parentKey works on
+ *
+ * The keys are below parentKey in any namespace but spec. They stay in ks,
+ * so if the plugins do not add or remove keys nothing needs to be merged.
+ *
+ * @see mergeGlobalKS()
+ */
 static KeySet * prepareGlobalKS (KeySet * ks, Key * parentKey)
 {
+	KeySet * globalKS = ksNew (0, KS_END);
+	for (size_t n = 0; n < sizeof (globalKSNamespaces) / sizeof (globalKSNamespaces[0]); ++n)
+	{
+		size_t begin, end;
+		findGlobalKSRange (ks, parentKey, globalKSNamespaces[n], &begin, &end);
+		for (size_t i = begin; i < end; ++i)
+		{
+			ksAppendKey (globalKS, ks->array[i]);
+		}
+	}
 	ksRewind (ks);
-	Key * cutKey = keyNew ("/", KEY_CASCADING_NAME, KEY_END);
-	keyAddName (cutKey, strchr (keyName (parentKey), '/'));
-	KeySet * cutKS = ksCut (ks, cutKey);
-	Key * specCutKey = keyNew ("spec", KEY_END);
-	KeySet * specCut = ksCut (cutKS, specCutKey);
-	ksRewind (specCut);
-	Key * cur;
-	while ((cur = ksNext (specCut)) != NULL)
+	ksRewind (globalKS);
+	return globalKS;
+}
+
+/**
+ * @internal
+ *
+ * @brief Write the changes of the plugins to globalKS back to ks and delete globalKS
+ *
+ * @param globalKS the keyset returned by prepareGlobalKS(), may be NULL
+ */
+static void mergeGlobalKS (KeySet * ks, KeySet * globalKS, Key * parentKey)
+{
+	if (!globalKS) return;
+
+	int changed = 0;
+	size_t pos = 0;
+	for (size_t n = 0; !changed && n < sizeof (globalKSNamespaces) / sizeof (globalKSNamespaces[0]); ++n)
 	{
-		if (keyGetNamespace (cur) == KEY_NS_CASCADING)
+		size_t begin, end;
+		findGlobalKSRange (ks, parentKey, globalKSNamespaces[n], &begin, &end);
+		for (size_t i = begin; !changed && i < end; ++i)
 		{
-			ksAppendKey (cutKS, cur);
-			keyDel (ksLookup (specCut, cur, KDB_O_POP));
+			changed = pos >= globalKS->size || globalKS->array[pos++] != ks->array[i];
 		}
 	}
-	ksAppend (ks, specCut);
-	ksDel (specCut);
-	keyDel (specCutKey);
-	keyDel (cutKey);
-	ksRewind (cutKS);
-	return cutKS;
+	if (pos != globalKS->size) changed = 1;
+
+	if (changed)
+	{
+		for (size_t n = 0; n < sizeof (globalKSNamespaces) / sizeof (globalKSNamespaces[0]); ++n)
+		{
+			Key * cutKey = keyNew (globalKSNamespaces[n], KEY_END);
+			const char * name = strchr (keyName (parentKey), '/');
+			if (name) keyAddName (cutKey, name);
+			ksDel (ksCut (ks, cutKey));
+			keyDel (cutKey);
+		}
+		ksAppend (ks, globalKS);
+	}
+	ksDel (globalKS);
 }
 
 static int elektraGetDoUpdateWithGlobalHooks (KDB * handle, Split * split, KeySet * ks, Key * parentKey, Key * initialParent,
@@ -598,6 +682,8 @@ static int elektraGetDoUpdateWithGlobalHooks (KDB * handle, Split * split, KeySe
 			start = STORAGE_PLUGIN + 1;
 			end = NR_OF_PLUGINS;
 		}
+		// keys of the backend passed to all its post-storage plugins
+		KeySet * globalKS = 0;
 		for (int p = start; p < end; ++p)
 		{
 			int ret = 0;
@@ -605,6 +691,8 @@ static int elektraGetDoUpdateWithGlobalHooks (KDB * handle, Split * split, KeySe
 			if (!pgs_done && (p == (STORAGE_PLUGIN + 1)) && handle->globalPlugins[POSTGETSTORAGE][FOREACH])
 			{
 				pgs_done = 1;
+				mergeGlobalKS (ks, globalKS, parentKey);
+				globalKS = 0;
 				keySetName (parentKey, keyName (initialParent));
 				ksRewind (ks);
 				handle->globalPlugins[POSTGETSTORAGE][FOREACH]->kdbGet (handle->globalPlugins[POSTGETSTORAGE][FOREACH], ks,
@@ -614,6 +702,8 @@ static int elektraGetDoUpdateWithGlobalHooks (KDB * handle, Split * split, KeySe
 			else if (!pgc_done && (p == (NR_OF_PLUGINS - 1)) && handle->globalPlugins[POSTGETCLEANUP][FOREACH])
 			{
 				pgc_done = 1;
+				mergeGlobalKS (ks, globalKS, parentKey);
+				globalKS = 0;
 				keySetName (parentKey, keyName (initialParent));
 				ksRewind (ks);
 				handle->globalPlugins[POSTGETCLEANUP][FOREACH]->kdbGet (handle->globalPlugins[POSTGETCLEANUP][FOREACH], ks,
@@ -629,10 +719,9 @@ static int elektraGetDoUpdateWithGlobalHooks (KDB * handle, Split * split, KeySe
 				}
 				else
 				{
-					KeySet * cutKS = prepareGlobalKS (ks, parentKey);
-					ret = backend->getplugins[p]->kdbGet (backend->getplugins[p], cutKS, parentKey);
-					ksAppend (ks, cutKS);
-					ksDel (cutKS);
+					if (!globalKS) globalKS = prepareGlobalKS (ks, parentKey);
+					ksRewind (globalKS);
+					ret = backend->getplugins[p]->kdbGet (backend->getplugins[p], globalKS, parentKey);
 				}
 			}
 
@@ -640,11 +729,13 @@ static int elektraGetDoUpdateWithGlobalHooks (KDB * handle, Split * split, KeySe
 			{
 				// Ohh, an error occurred,
 				// lets stop the process.
+				mergeGlobalKS (ks, globalKS, parentKey);
 				elektraGlobalError (handle, ks, parentKey, GETSTORAGE, DEINIT);
 				// elektraGlobalError (handle, ks, parentKey, POSTGETSTORAGE, DEINIT);
 				return -1;
 			}
 		}
+		mergeGlobalKS (ks, globalKS, parentKey);
 	}
 	elektraGlobalGet (handle, ks, parentKey, GETSTORAGE, DEINIT);
 	// elektraGlobalGet (handle, ks, parentKey, POSTGETSTORAGE, DEINIT);
@@ -397,6 +397,7 @@ int keyCopy (Key * dest, const Key * source)
 
 	// successful, now do the irreversible stuff: we obviously modified dest
 	set_bit (dest->flags, KEY_FLAG_SYNC);
+	++dest->metaVersion;
 
 	// copy sizes accordingly
 	dest->keySize = source->keySize;
@@ -503,6 +504,7 @@ int keyClear (Key * key)
 	}
 
 	size_t ref = 0;
+	size_t metaVersion = key->metaVersion;
 
 	ref = key->ksReference;
 	if (key->key) elektraFree (key->key);
@@ -514,6 +516,7 @@ int keyClear (Key * key)
 
 	/* Set reference properties */
 	key->ksReference = ref;
+	key->metaVersion = metaVersion + 1;
 
 	return 0;
 }
@@ -283,6 +283,7 @@ int keyCopyMeta (Key * dest, const Key * source, const char * metaName)
 	if (!dest) return -1;
 	if (dest->flags & KEY_FLAG_RO_META) return -1;
 
+	++dest->metaVersion;
 	ret = (Key *)keyGetMeta (source, metaName);
 
 	if (!ret)
@@ -371,6 +372,7 @@ int keyCopyAllMeta (Key * dest, const Key * source)
 
 	if (source->meta)
 	{
+		++dest->metaVersion;
 		/*Make sure that dest also does not have metaName*/
 		if (dest->meta)
 		{
@@ -473,6 +475,8 @@ ssize_t keySetMeta (Key * key, const char * metaName, const char * newMetaString
 	// optimization: we have nothing and want to remove something:
 	if (!key->meta && !newMetaString) return 0;
 
+	++key->metaVersion;
+
 	toSet = keyNew (0);
 	if (!toSet) return -1;
 
@@ -808,6 +808,8 @@ ssize_t ksAppendKey (KeySet * ks, Key * toAppend)
 			return ks->size;
 		}
 
+		elektraKsClearMetaIndex (ks);
+
 		/* Pop the key in the result */
 		keyDecRef (ks->array[result]);
 		keyDel (ks->array[result]);
@@ -821,6 +823,8 @@ ssize_t ksAppendKey (KeySet * ks, Key * toAppend)
 	{
 		ssize_t insertpos = -result - 1;
 
+		elektraKsClearMetaIndex (ks);
+
 		/* We want to append a new key
 		  in position insertpos */
 		++ks->size;
@@ -924,6 +928,8 @@ ssize_t ksCopyInternal (KeySet * ks, size_t to, size_t from)
 	ELEKTRA_ASSERT (length >= 0, "length %zu too small", length);
 	ELEKTRA_ASSERT (ks->size >= to, "ks->size %zu smaller than %zu", ks->size, to);
 
+	elektraKsClearMetaIndex (ks);
+
 	ks->size = ssize + sizediff;
 
 	if (length != 0)
@@ -1193,6 +1199,8 @@ Key * ksPop (KeySet * ks)
 
 	if (ks->size == 0) return 0;
 
+	elektraKsClearMetaIndex (ks);
+
 	--ks->size;
 	if (ks->size + 1 < ks->alloc / 2) ksResize (ks, ks->alloc / 2 - 1);
 	ret = ks->array[ks->size];
@@ -2349,6 +2357,7 @@ int ksInit (KeySet * ks)
 	ks->size = 0;
 	ks->alloc = 0;
 	ks->flags = 0;
+	ks->metaIndex = 0;
 
 	ksRewind (ks);
 
@@ -2385,6 +2394,8 @@ int ksClose (KeySet * ks)
 
 	ks->size = 0;
 
+	elektraKsClearMetaIndex (ks);
+
 #ifdef ELEKTRA_ENABLE_OPTIMIZATIONS
 	if (ks->opmphm) opmphmDel (ks->opmphm);
 #endif
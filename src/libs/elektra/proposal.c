@@ -144,3 +144,280 @@ Key * elektraKsPopAtCursor (KeySet * ks, cursor_t pos)
 
 	return ksPop (ks);
 }
+
+
+/**
+ * @internal
+ *
+ * Positions of the keys of a KeySet having some meta information.
+ */
+typedef struct
+{
+	char * metaName;
+	Key * search;	    // key to look up metaName within the meta information
+	size_t * positions; // ascending
+	size_t size;
+} MetaIndexEntry;
+
+struct _KsMetaIndex
+{
+	MetaIndexEntry * entries; // sorted by metaName
+	size_t size;
+	size_t alloc;
+	size_t metaVersion; // sum of metaVersion of all keys when the index was built
+};
+
+static size_t elektraKsMetaVersion (const KeySet * ks)
+{
+	size_t version = 0;
+	for (size_t i = 0; i < ks->size; ++i)
+	{
+		version += ks->array[i]->metaVersion;
+	}
+	return version;
+}
+
+static void elektraMetaIndexClearEntries (struct _KsMetaIndex * index)
+{
+	for (size_t i = 0; i < index->size; ++i)
+	{
+		elektraFree (index->entries[i].metaName);
+		keyDel (index->entries[i].search);
+		elektraFree (index->entries[i].positions);
+	}
+	index->size = 0;
+}
+
+/**
+ * @internal
+ *
+ * @brief Removes the index of elektraKsNextWithMeta()
+ *
+ * Needs to be called whenever keys are added to or removed from ks.
+ *
+ * @param ks the keyset to work with
+ */
+void elektraKsClearMetaIndex (KeySet * ks)
+{
+	if (!ks->metaIndex) return;
+
+	elektraMetaIndexClearEntries (ks->metaIndex);
+	if (ks->metaIndex->entries) elektraFree (ks->metaIndex->entries);
+	elektraFree (ks->metaIndex);
+	ks->metaIndex = 0;
+}
+
+/**
+ * @internal
+ *
+ * @brief Collects the positions of all keys having the meta information metaName
+ *
+ * @retval 0 on success
+ * @retval -1 on memory error
+ */
+static int elektraMetaIndexBuildEntry (const KeySet * ks, MetaIndexEntry * entry, const char * metaName)
+{
+	memset (entry, 0, sizeof (MetaIndexEntry));
+	entry->metaName = elektraStrDup (metaName);
+	entry->search = keyNew (0);
+	if (!entry->metaName || !entry->search) goto error;
+	if (elektraKeySetName (entry->search, metaName, KEY_META_NAME | KEY_EMPTY_NAME) == -1) goto error;
+
+	size_t alloc = 0;
+	for (size_t i = 0; i < ks->size; ++i)
+	{
+		Key * cur = ks->array[i];
+		if (!cur->meta || !ksLookup (cur->meta, entry->search, 0)) continue;
+
+		if (entry->size == alloc)
+		{
+			alloc = alloc ? alloc * 2 : 16;
+			if (elektraRealloc ((void **)&entry->positions, alloc * sizeof (size_t)) == -1) goto error;
+		}
+		entry->positions[entry->size++] = i;
+	}
+	return 0;
+
+error:
+	elektraFree (entry->metaName);
+	keyDel (entry->search);
+	elektraFree (entry->positions);
+	return -1;
+}
+
+/**
+ * @internal
+ *
+ * @brief Returns the index entry for metaName, building it if needed
+ *
+ * @param validate if the meta information of the keys is checked for modifications
+ *
+ * @retval 0 on memory error
+ */
+static MetaIndexEntry * elektraKsGetMetaIndexEntry (KeySet * ks, const char * metaName, int validate)
+{
+	struct _KsMetaIndex * index = ks->metaIndex;
+	if (!index)
+	{
+		index = elektraCalloc (sizeof (struct _KsMetaIndex));
+		if (!index) return 0;
+		index->metaVersion = elektraKsMetaVersion (ks);
+		ks->metaIndex = index;
+	}
+	else if (validate)
+	{
+		size_t metaVersion = elektraKsMetaVersion (ks);
+		if (metaVersion != index->metaVersion)
+		{
+			elektraMetaIndexClearEntries (index);
+			index->metaVersion = metaVersion;
+		}
+	}
+
+	size_t lower = 0;
+	size_t upper = index->size;
+	while (lower < upper)
+	{
+		size_t middle = lower + (upper - lower) / 2;
+		int cmp = strcmp (index->entries[middle].metaName, metaName);
+		if (cmp == 0) return &index->entries[middle];
+		if (cmp < 0)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+
+	if (index->size == index->alloc)
+	{
+		size_t alloc = index->alloc ? index->alloc * 2 : 8;
+		if (elektraRealloc ((void **)&index->entries, alloc * sizeof (MetaIndexEntry)) == -1) return 0;
+		index->alloc = alloc;
+	}
+	MetaIndexEntry entry;
+	if (elektraMetaIndexBuildEntry (ks, &entry, metaName) == -1) return 0;
+	memmove (index->entries + lower + 1, index->entries + lower, (index->size - lower) * sizeof (MetaIndexEntry));
+	index->entries[lower] = entry;
+	++index->size;
+	return &index->entries[lower];
+}
+
+/**
+ * @copydoc ksNextWithMeta
+ */
+Key * elektraKsNextWithMeta (KeySet * ks, const char * metaName)
+{
+	if (!ks) return 0;
+	if (!metaName) return 0;
+
+	if (ks->size == 0) return 0;
+	if (ks->current >= ks->size) return 0;
+
+	size_t start = ks->cursor ? ks->current + 1 : ks->current;
+	// a new iteration starts without cursor, only then modified meta information is detected
+	MetaIndexEntry * entry = elektraKsGetMetaIndexEntry (ks, metaName, !ks->cursor);
+	if (!entry)
+	{
+		// not enough memory for the index, so search without
+		for (size_t i = start; i < ks->size; ++i)
+		{
+			if (keyGetMeta (ks->array[i], metaName))
+			{
+				ks->current = i;
+				return ks->cursor = ks->array[i];
+			}
+		}
+		ks->current = ks->size;
+		return ks->cursor = 0;
+	}
+
+	// find the first key at or after start
+	size_t lower = 0;
+	size_t upper = entry->size;
+	while (lower < upper)
+	{
+		size_t middle = lower + (upper - lower) / 2;
+		if (entry->positions[middle] < start)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	if (lower == entry->size)
+	{
+		ks->current = ks->size;
+		return ks->cursor = 0;
+	}
+	ks->current = entry->positions[lower];
+	return ks->cursor = ks->array[ks->current];
+}
+
+static int elektraKeyValueEqual (const Key * key1, const Key * key2)
+{
+	if (key1->dataSize != key2->dataSize) return 0;
+	if (key1->dataSize == 0) return 1;
+	return !memcmp (key1->data.v, key2->data.v, key1->dataSize);
+}
+
+static int elektraKeyMetaEqual (const Key * key1, const Key * key2)
+{
+	size_t size1 = key1->meta ? key1->meta->size : 0;
+	size_t size2 = key2->meta ? key2->meta->size : 0;
+	if (size1 != size2) return 0;
+
+	// meta keys are sorted, so they can be compared pairwise
+	for (size_t i = 0; i < size1; ++i)
+	{
+		const Key * meta1 = key1->meta->array[i];
+		const Key * meta2 = key2->meta->array[i];
+		if (meta1 == meta2) continue;
+		if (strcmp (keyName (meta1), keyName (meta2)) || !elektraKeyValueEqual (meta1, meta2)) return 0;
+	}
+	return 1;
+}
+
+/**
+ * @copydoc ksDiff
+ */
+ssize_t elektraKsDiff (const KeySet * oldKs, const KeySet * newKs, KeySet * added, KeySet * removed, KeySet * modified)
+{
+	if (!oldKs || !newKs) return -1;
+
+	ssize_t changes = 0;
+	size_t o = 0;
+	size_t n = 0;
+	// both arrays are sorted, so a single walk over both finds all differences
+	while (o < oldKs->size || n < newKs->size)
+	{
+		int cmp;
+		if (o == oldKs->size)
+			cmp = 1;
+		else if (n == newKs->size)
+			cmp = -1;
+		else
+			cmp = keyCmp (oldKs->array[o], newKs->array[n]);
+
+		if (cmp < 0)
+		{
+			if (removed) ksAppendKey (removed, oldKs->array[o]);
+			++o;
+			++changes;
+			continue;
+		}
+		if (cmp > 0)
+		{
+			if (added) ksAppendKey (added, newKs->array[n]);
+			++n;
+			++changes;
+			continue;
+		}
+
+		Key * oldKey = oldKs->array[o++];
+		Key * newKey = newKs->array[n++];
+		if (keyNeedSync (newKey) ||
+		    (oldKey != newKey && (!elektraKeyValueEqual (oldKey, newKey) || !elektraKeyMetaEqual (oldKey, newKey))))
+		{
+			if (modified) ksAppendKey (modified, newKey);
+			++changes;
+		}
+	}
+	return changes;
+}
@@ -854,6 +854,37 @@ int keySetCTime (Key * key, time_t ctime)
 
 #endif
 
+/**
+ * @internal
+ *
+ * returns the number of the order metadata of key, -1 if it has none
+ */
+static int getOrderNumber (const Key * key)
+{
+	const Key * meta = keyGetMeta (key, "order");
+	if (!meta) return -1;
+	return atoi (keyString (meta));
+}
+
+/**
+ * @internal
+ *
+ * compares two numbers returned by getOrderNumber()
+ */
+static int cmpOrderNumber (int aorder, int border)
+{
+	if (aorder > 0 && border > 0) return aorder - border;
+
+	if (aorder < 0 && border < 0) return 0;
+
+	if (aorder < 0 && border >= 0) return -1;
+
+	if (aorder >= 0 && border < 0) return 1;
+
+	/* cannot happen anyway */
+	return 0;
+}
+
 /**
  * Compare the order metadata of two keys.
  *
@@ -879,24 +910,73 @@ int elektraKeyCmpOrder (const Key * ka, const Key * kb)
 
 	if (!ka && kb) return -1;
 
-	int aorder = -1;
-	int border = -1;
-
-	const Key * kam = keyGetMeta (ka, "order");
-	const Key * kbm = keyGetMeta (kb, "order");
-
-	if (kam) aorder = atoi (keyString (kam));
-	if (kbm) border = atoi (keyString (kbm));
+	return cmpOrderNumber (getOrderNumber (ka), getOrderNumber (kb));
+}
 
-	if (aorder > 0 && border > 0) return aorder - border;
+/**
+ * @internal
+ *
+ * elektraSortKeysByOrder helper
+ * a key with its order number
+ */
+typedef struct
+{
+	Key * key;
+	int order;
+	size_t position; // position in the array to sort
+} _orderEntry;
 
-	if (aorder < 0 && border < 0) return 0;
+/**
+ * @internal
+ *
+ * elektraSortKeysByOrder helper
+ * ordering function for qsort, keys with the same order keep their position
+ */
+static int orderEntryCmp (const void * a, const void * b)
+{
+	const _orderEntry * ea = a;
+	const _orderEntry * eb = b;
 
-	if (aorder < 0 && border >= 0) return -1;
+	int ret = cmpOrderNumber (ea->order, eb->order);
+	if (ret) return ret;
+	if (ea->position < eb->position) return -1;
+	return ea->position > eb->position;
+}
 
-	if (aorder >= 0 && border < 0) return 1;
+/**
+ * @brief Sort keys by their order metadata.
+ *
+ * Keys are compared like with elektraKeyCmpOrder(), keys which compare
+ * equal keep their relative position. In contrast to sorting with
+ * elektraKeyCmpOrder() the order metadata of each key is only read
+ * once and not in every comparison.
+ *
+ * @param array the keys to sort, must not contain NULL
+ * @param size the number of keys in array
+ *
+ * @retval 0 on success
+ * @retval -1 if array is NULL or no memory could be allocated,
+ *         array is left unchanged then
+ */
+int elektraSortKeysByOrder (Key ** array, size_t size)
+{
+	if (!array) return -1;
+	if (size < 2) return 0;
 
-	/* cannot happen anyway */
+	_orderEntry * entries = elektraMalloc (size * sizeof (_orderEntry));
+	if (!entries) return -1;
+	for (size_t i = 0; i < size; ++i)
+	{
+		entries[i].key = array[i];
+		entries[i].order = getOrderNumber (array[i]);
+		entries[i].position = i;
+	}
+	qsort (entries, size, sizeof (_orderEntry), orderEntryCmp);
+	for (size_t i = 0; i < size; ++i)
+	{
+		array[i] = entries[i].key;
+	}
+	elektraFree (entries);
 	return 0;
 }
 
@@ -994,181 +1074,217 @@ KeySet * elektraMetaArrayToKS (Key * key, const char * metaName)
  * @internal
  *
  * elektraSortTopology helper
- * matrix struct
+ * a key with its edges in the dependency graph
  */
 typedef struct
 {
 	Key * key;
+	const char * order; // only used for sorting, before the "order" metakeys are rewritten
+	size_t position;    // position of the key in ks
+	KeySet * deps;	    // dependencies from the "dep" metakeys
+	size_t depBegin;    // dependencies are depList[depBegin, depEnd)
+	size_t depEnd;
+	size_t dependentBegin; // keys depending on this key are dependentList[dependentBegin, dependentEnd)
+	size_t dependentEnd;
+	size_t unresolved; // number of dependencies not resolved yet
 	kdb_octet_t isResolved;
-	unsigned long * deps;
-} _adjMatrix;
+	kdb_octet_t inScope; // currently resolved by sweeps
+} _topNode;
 
 /**
  * @internal
  *
  * elektraSortTopology helper
- * ordering function for qsort
+ * state of the sorting
  */
-static int topCmpOrder (const void * a, const void * b)
+typedef struct
 {
-	const Key * ka = (*(const Key **)a);
-	const Key * kb = (*(const Key **)b);
-
-	if (!ka && !kb) return 0;
-	if (ka && !kb) return 1;
-	if (!ka && kb) return -1;
+	_topNode * nodes; // sorted by "order"
+	size_t size;
+	size_t * depList;
+	size_t * dependentList;
+	size_t * current; // min-heap of the keys which can be resolved in the current sweep
+	size_t currentSize;
+	size_t * next; // min-heap of the keys which can be resolved in the next sweep
+	size_t nextSize;
+	size_t * scope; // the keys currently resolved by sweeps
+	Key ** sorted;
+	size_t resolved;
+	Key * orderCounter;
+} _topSort;
 
-	const Key * kam = keyGetMeta (ka, "order");
-	const Key * kbm = keyGetMeta (kb, "order");
+/**
+ * @internal
+ *
+ * elektraSortTopology helper
+ * ordering function for qsort, keys with the same order keep their position
+ */
+static int topCmpOrder (const void * a, const void * b)
+{
+	const _topNode * na = a;
+	const _topNode * nb = b;
 
-	return strcmp (keyString (kam), keyString (kbm));
+	int cmp = strcmp (na->order, nb->order);
+	if (cmp) return cmp;
+	if (na->position < nb->position) return -1;
+	return na->position > nb->position;
 }
 
-
 /**
  * @internal
  *
  * elektraSortTopology helper
- * returns the index of dependency depKey
+ * adds index i to a min-heap
  */
-static int getArrayIndex (Key * depKey, _adjMatrix * adjMatrix, size_t size)
+static void topHeapPush (size_t * heap, size_t * heapSize, size_t i)
 {
-	for (unsigned int i = 0; i < size; ++i)
+	size_t pos = (*heapSize)++;
+	while (pos > 0 && heap[(pos - 1) / 2] > i)
 	{
-		if (!strcmp (keyName (adjMatrix[i].key), keyString (depKey))) return i;
+		heap[pos] = heap[(pos - 1) / 2];
+		pos = (pos - 1) / 2;
 	}
-	return -1;
+	heap[pos] = i;
 }
+
 /**
  * @internal
  *
  * elektraSortTopology helper
- * removes resolved dependency j from our matrix
+ * removes the smallest index from a non-empty min-heap
  */
-static int resolveDep (unsigned int j, _adjMatrix * adjMatrix, size_t size)
+static size_t topHeapPop (size_t * heap, size_t * heapSize)
 {
-	int removed = 0;
-	for (unsigned int i = 0; i < size; ++i)
+	size_t top = heap[0];
+	size_t last = heap[--(*heapSize)];
+	size_t pos = 0;
+	while (2 * pos + 1 < *heapSize)
 	{
-		if (adjMatrix[i].deps[j])
-		{
-			++removed;
-			adjMatrix[i].deps[j] = 0;
-		}
+		size_t child = 2 * pos + 1;
+		if (child + 1 < *heapSize && heap[child + 1] < heap[child]) ++child;
+		if (last <= heap[child]) break;
+		heap[pos] = heap[child];
+		pos = child;
 	}
-	return removed;
+	heap[pos] = last;
+	return top;
 }
 
 /**
  * @internal
  *
  * elektraSortTopology helper
- * checks if the key with index j has unresolved dependencies
+ * gives the key with the index j an order number and removes it from
+ * the dependencies of all other keys.
  */
-static int hasUnresolvedDependencies (unsigned int j, _adjMatrix * adjMatrix, size_t size)
+static void topResolve (_topSort * ts, size_t j)
 {
-	for (unsigned int i = 0; i < size; ++i)
+	_topNode * node = &ts->nodes[j];
+	node->isResolved = 1;
+	node->inScope = 0;
+	keySetMeta (node->key, "order", keyBaseName (ts->orderCounter));
+	elektraArrayIncName (ts->orderCounter);
+	ts->sorted[ts->resolved++] = node->key;
+
+	for (size_t d = node->dependentBegin; d < node->dependentEnd; ++d)
 	{
-		if (adjMatrix[j].deps[i]) return 1;
+		size_t i = ts->dependentList[d];
+		_topNode * dependent = &ts->nodes[i];
+		if (--dependent->unresolved || !dependent->inScope) continue;
+		// keys before the current one have to wait for the next sweep
+		if (i > j)
+			topHeapPush (ts->current, &ts->currentSize, i);
+		else
+			topHeapPush (ts->next, &ts->nextSize, i);
 	}
-	return 0;
 }
 
 /**
  * @internal
  *
  * elektraSortTopology helper
- * resolve all dependencies of the key with the index j in our matrix.
+ * resolves the keys in scope by sweeping over them in order, as long as
+ * a sweep resolves any key.
+ *
+ * @param scope the indices of the keys in scope
+ * @param count the number of keys in scope
+ *
+ * @retval 1 if all keys in scope were resolved
+ * @retval 0 if a cycle is left
  */
-static int resolveDeps (unsigned int j, _adjMatrix * adjMatrix, size_t size, KeySet * done, Key * orderCounter)
+static int topSweep (_topSort * ts, const size_t * scope, size_t count)
 {
-	unsigned int loops = 0;
-	unsigned int frontier[size];
-	unsigned int todo = 0;
-	for (unsigned int i = 0; i < size; ++i)
+	for (size_t s = 0; s < count; ++s)
 	{
-		if (adjMatrix[j].deps[i])
-		{
-			frontier[i] = 1;
-			++todo;
-		}
-		else
-		{
-			frontier[i] = 0;
-		}
+		if (!ts->nodes[scope[s]].unresolved) topHeapPush (ts->current, &ts->currentSize, scope[s]);
 	}
-	int found = 1;
 
-	// loop until all dependencies are added to frontier
-	while (found)
+	while (ts->currentSize || ts->nextSize)
 	{
-		found = 0;
-		for (unsigned int i = 0; i < size; ++i)
+		if (!ts->currentSize)
 		{
-			if (!frontier[i]) continue;
-			if (hasUnresolvedDependencies (i, adjMatrix, size))
-			{
-				for (unsigned int k = 0; k < size; ++k)
-				{
-					if (adjMatrix[i].deps[k])
-					{
-						if (!frontier[k])
-						{
-							found = 1;
-							++todo;
-							frontier[k] = 1;
-						}
-					}
-				}
-			}
+			size_t * heap = ts->current;
+			ts->current = ts->next;
+			ts->next = heap;
+			ts->currentSize = ts->nextSize;
+			ts->nextSize = 0;
 		}
+		topResolve (ts, topHeapPop (ts->current, &ts->currentSize));
+		--count;
 	}
-	if (todo == 0)
-	{
-		// all dependencies are already resolved, give key an order number and add it to
-		// the our list of resolved keys (done)
-		adjMatrix[j].isResolved = 1;
-		resolveDep (j, adjMatrix, size);
-		keySetMeta (adjMatrix[j].key, "order", keyBaseName (orderCounter));
-		elektraArrayIncName (orderCounter);
-		ksAppendKey (done, keyDup (adjMatrix[j].key));
-		return 1;
-	}
-	unsigned int max_loops = todo;
-	for (unsigned int i = 0; todo; ++i)
+	return count == 0;
+}
+
+/**
+ * @internal
+ *
+ * elektraSortTopology helper
+ * puts all unresolved dependencies of the key with the index j (recursively) in scope
+ *
+ * @param scope gets the indices of the keys put in scope
+ *
+ * @return the number of keys put in scope
+ */
+static size_t topCollectDeps (_topSort * ts, size_t j, size_t * scope)
+{
+	size_t count = 0;
+	size_t done = 0;
+	for (size_t i = j;; i = scope[done++])
 	{
-		if (i == size)
-		{
-			++loops;
-			i = 0;
-		}
-		if (loops > max_loops) return -1; // more loops than we had unresolved keys -> cycle
-		if (!frontier[i]) continue;
-		if (!hasUnresolvedDependencies (i, adjMatrix, size))
+		for (size_t d = ts->nodes[i].depBegin; d < ts->nodes[i].depEnd; ++d)
 		{
-			resolveDep (i, adjMatrix, size);
-			frontier[i] = 0;
-			--todo;
-			adjMatrix[i].isResolved = 1;
-			resolveDep (i, adjMatrix, size);
-			keySetMeta (adjMatrix[i].key, "order", keyBaseName (orderCounter));
-			elektraArrayIncName (orderCounter);
-			ksAppendKey (done, keyDup (adjMatrix[i].key));
+			_topNode * dep = &ts->nodes[ts->depList[d]];
+			if (dep->isResolved || dep->inScope) continue;
+			dep->inScope = 1;
+			scope[count++] = ts->depList[d];
 		}
+		if (done == count) break;
 	}
-	return 1;
+	return count;
 }
 
 /**
  * elektraSortTopology helper
- * tests if name is a valid keyname
+ * looks up the key with the name depName
+ *
+ * @retval 1 if the key was found, position is set to its position in ks
+ * @retval 0 if there is no such key
+ * @retval -1 if depName is not a valid keyname
  */
-static int isValidKeyName (const char * testName)
+static int topLookupDep (KeySet * ks, const char * depName, size_t * position)
 {
-	int retVal = 0;
-	Key * testKey = keyNew (testName, KEY_CASCADING_NAME, KEY_END);
-	if (!strcmp (keyName (testKey), testName)) retVal = 1;
-	keyDel (testKey);
+	int retVal = -1;
+	Key * depKey = keyNew (depName, KEY_CASCADING_NAME, KEY_END);
+	if (!strcmp (keyName (depKey), depName))
+	{
+		retVal = 0;
+		if (ksLookup (ks, depKey, KDB_O_NOCASCADING))
+		{
+			*position = ksGetCursor (ks);
+			retVal = 1;
+		}
+	}
+	keyDel (depKey);
 	return retVal;
 }
 
@@ -1192,8 +1308,15 @@ static int isValidKeyName (const char * testName)
  * The algorithm used is a mixture of Kahn and BFS.
  * Furthermore the algorithm does not use recursion.
  *
- * First a BFS with the keys sorted by "order" is used.
- * Then all dependencies (recursively) of every key is collected.
+ * First all keys without dependencies are taken, sorted by "order".
+ * Then Kahn's algorithm resolves the other keys in sweeps over the keys
+ * sorted by "order". If the first key has an "order", the keys are instead
+ * taken one after the other by "order", each after all its dependencies
+ * (recursively), collected with a BFS.
+ *
+ * Dependencies are found by name in ks and kept as adjacency lists, so
+ * the time needed grows linearly with the number of keys and dependencies
+ * (apart from sorting and lookups).
  *
  * @retval 1 on success
  * @retval 0 for cycles
@@ -1203,201 +1326,187 @@ static int isValidKeyName (const char * testName)
 int elektraSortTopology (KeySet * ks, Key ** array)
 {
 	if (ks == NULL || array == NULL) return -1;
-	KeySet * done = ksNew (0, KS_END);
-	ksRewind (ks);
-	Key * cur;
-	ssize_t size = ksGetSize (ks);
-	Key * orderCounter = keyNew ("/#", KEY_CASCADING_NAME, KEY_END);
-	elektraArrayIncName (orderCounter);
-	_adjMatrix adjMatrix[size];
-	int i = 0;
+	ssize_t ksSize = ksGetSize (ks);
+	if (ksSize <= 0) return 1;
+	size_t size = ksSize;
 	int retVal = 1;
-	int depCount = 0;
-	Key ** localArray = elektraMalloc (size * sizeof (Key *));
-	elektraKsToMemArray (ks, localArray);
-	qsort (localArray, size, sizeof (Key *), topCmpOrder);
-	for (long j = 0; j < size; ++j)
+	size_t edges = 0;
+	size_t edgesAlloc = 0;
+	size_t * edgeFrom = NULL; // key depending on edgeTo
+	size_t * edgeTo = NULL;
+	_topSort ts;
+	memset (&ts, 0, sizeof (_topSort));
+	ts.size = size;
+	ts.nodes = elektraCalloc (size * sizeof (_topNode));
+	size_t * byPosition = elektraMalloc (size * sizeof (size_t));
+	ts.current = elektraMalloc (size * sizeof (size_t));
+	ts.next = elektraMalloc (size * sizeof (size_t));
+	ts.scope = elektraMalloc (size * sizeof (size_t));
+	ts.sorted = elektraMalloc (size * sizeof (Key *));
+	ts.orderCounter = keyNew ("/#", KEY_CASCADING_NAME, KEY_END);
+	if (!ts.nodes || !byPosition || !ts.current || !ts.next || !ts.scope || !ts.sorted || !ts.orderCounter)
+	{
+		retVal = -1;
+		goto TopSortCleanup;
+	}
+	elektraArrayIncName (ts.orderCounter);
+
+	elektraKsToMemArray (ks, ts.sorted);
+	for (size_t j = 0; j < size; ++j)
+	{
+		ts.nodes[j].key = ts.sorted[j];
+		ts.nodes[j].order = keyString (keyGetMeta (ts.sorted[j], "order"));
+		ts.nodes[j].position = j;
+	}
+	qsort (ts.nodes, size, sizeof (_topNode), topCmpOrder);
+	for (size_t j = 0; j < size; ++j)
 	{
-		adjMatrix[j].key = localArray[j];
-		adjMatrix[j].isResolved = 0;
-		adjMatrix[j].deps = elektraCalloc (sizeof (unsigned long) * size);
+		byPosition[ts.nodes[j].position] = j;
 	}
 	kdb_octet_t hasOrder = 0;
-	if (keyGetMeta (localArray[0], "order")) hasOrder = 1;
-	unsigned int unresolved = 0;
-	for (int j = 0; j < size; ++j)
+	if (keyGetMeta (ts.nodes[0].key, "order")) hasOrder = 1;
+
+	// keys without dependencies are resolved immediately
+	for (size_t j = 0; j < size; ++j)
 	{
-		cur = localArray[j];
-		KeySet * deps = elektraMetaArrayToKS (cur, "dep");
+		_topNode * node = &ts.nodes[j];
+		KeySet * deps = elektraMetaArrayToKS (node->key, "dep");
 		keyDel (ksLookupByName (deps, "dep", KDB_O_POP));
-		Key * tmpDep;
-		switch (ksGetSize (deps))
+		ssize_t depSize = ksGetSize (deps);
+		if (depSize == -1 || (depSize == 1 && !strcmp (keyName (node->key), keyString (ksHead (deps)))))
 		{
-		case -1:
-		{
-			// key has no dependencies, give it an order number and add it to list of resolved dependencies
-			keySetMeta (cur, "order", keyBaseName (orderCounter));
-			elektraArrayIncName (orderCounter);
-			ksAppendKey (done, keyDup (cur));
-			adjMatrix[j].isResolved = 1;
 			ksDel (deps);
-			break;
+			topResolve (&ts, j);
+		}
+		else
+		{
+			node->deps = deps;
 		}
-		case 1:
+	}
+
+	// collect the edges to unresolved keys
+	for (size_t j = 0; j < size && retVal == 1; ++j)
+	{
+		if (!ts.nodes[j].deps) continue;
+		Key * tmpDep;
+		ksRewind (ts.nodes[j].deps);
+		while ((tmpDep = ksNext (ts.nodes[j].deps)) != NULL)
 		{
-			// only 1 dependency:
-			// test if it's reflexive
-			tmpDep = ksHead (deps);
-			if (!strcmp (keyName (cur), keyString (tmpDep)))
+			size_t position;
+			int found = topLookupDep (ks, keyString (tmpDep), &position);
+			if (found == -1)
 			{
-				keySetMeta (cur, "order", keyBaseName (orderCounter));
-				elektraArrayIncName (orderCounter);
-				ksAppendKey (done, keyDup (cur));
-				adjMatrix[j].isResolved = 1;
-				ksDel (deps);
+				// invalid keyname -> ERROR
+				retVal = -1;
 				break;
 			}
-			// if not, fallthrough to normal dependency handling
-		}
-		// FALLTHROUGH
-		default:
-		{
-			int gotUnresolved = 0;
-			while ((tmpDep = ksNext (deps)) != NULL)
+			// a key that doesn't exist yet but has a valid name is ignored
+			if (found == 0) continue;
+			size_t i = byPosition[position];
+			// reflexive and resolved dependencies are ignored
+			if (i == j || ts.nodes[i].isResolved) continue;
+			if (edges == edgesAlloc)
 			{
-				if (!isValidKeyName (keyString (tmpDep)))
+				edgesAlloc = edgesAlloc ? edgesAlloc * 2 : size;
+				if (elektraRealloc ((void **)&edgeFrom, edgesAlloc * sizeof (size_t)) < 0 ||
+				    elektraRealloc ((void **)&edgeTo, edgesAlloc * sizeof (size_t)) < 0)
 				{
-					// invalid keyname -> ERROR
 					retVal = -1;
 					break;
 				}
-				i = getArrayIndex (tmpDep, adjMatrix, size);
-				if (i == -1)
-				{
-					// key doesn't exist yet but has valid name, ignore it.
-					continue;
-				}
-				else if (i == j)
-				{
-					// reflexiv dependency, do nothing
-				}
-				else
-				{
-					if (!adjMatrix[i].isResolved)
-					{
-						// unresolved dependency
-						adjMatrix[j].deps[i] = 1;
-						++gotUnresolved;
-						// simple cycle detection
-						if (adjMatrix[i].deps[j])
-						{
-							retVal = 0;
-							break;
-						}
-					}
-				}
-			}
-			if (gotUnresolved)
-			{
-				adjMatrix[j].isResolved = 0;
-				++unresolved;
-				// count unresolved dependencies
-				depCount += gotUnresolved;
 			}
-			ksDel (deps);
-			break;
-		}
+			edgeFrom[edges] = j;
+			edgeTo[edges] = i;
+			++edges;
+			++ts.nodes[j].unresolved;
 		}
-		if (retVal <= 0) break;
 	}
-	if (retVal <= 0)
+	if (retVal <= 0) goto TopSortCleanup;
+
+	// adjacency lists in both directions
+	ts.depList = elektraMalloc ((edges + 1) * sizeof (size_t));
+	ts.dependentList = elektraMalloc ((edges + 1) * sizeof (size_t));
+	if (!ts.depList || !ts.dependentList)
 	{
-		// error or cycle: goto cleanup
+		retVal = -1;
 		goto TopSortCleanup;
 	}
-
-	// resolve all dependencies that can be resolved immediately
-	for (int j = 0; j < size; ++j)
+	for (size_t e = 0; e < edges; ++e)
 	{
-		if (adjMatrix[j].isResolved) depCount -= resolveDep (j, adjMatrix, size);
+		++ts.nodes[edgeTo[e]].dependentEnd;
 	}
-
-	ssize_t resolved = ksGetSize (done);
-	if (((depCount + resolved) >= size) && (unresolved))
+	size_t depBegin = 0;
+	size_t dependentBegin = 0;
+	for (size_t j = 0; j < size; ++j)
 	{
-		// more dependencies dependencies than keys:
-		//  cycle found !
-		retVal = 0;
-		goto TopSortCleanup;
+		_topNode * node = &ts.nodes[j];
+		node->depBegin = node->depEnd = depBegin;
+		depBegin += node->unresolved;
+		size_t dependents = node->dependentEnd;
+		node->dependentBegin = node->dependentEnd = dependentBegin;
+		dependentBegin += dependents;
+	}
+	for (size_t e = 0; e < edges; ++e)
+	{
+		ts.depList[ts.nodes[edgeFrom[e]].depEnd++] = edgeTo[e];
+		ts.dependentList[ts.nodes[edgeTo[e]].dependentEnd++] = edgeFrom[e];
 	}
 
-	if (unresolved)
+	if (hasOrder)
 	{
-		int found = 1;
-		// we have unresolved dependencies
-		for (int j = 0; j < size + 1; ++j)
+		// resolve by order, each key after all its dependencies
+		for (size_t j = 0; j < size && retVal == 1; ++j)
 		{
-			// loop until no dependency can be resolved anymore
-			if (j == size)
+			if (ts.nodes[j].isResolved) continue;
+			size_t count = topCollectDeps (&ts, j, ts.scope);
+			if (!topSweep (&ts, ts.scope, count))
 			{
-				if (found)
-				{
-					found = 0;
-					j = -1;
-					unresolved = 0;
-					continue;
-				}
-				else
-					break;
-			}
-			if (adjMatrix[j].isResolved) continue;
-			++unresolved;
-			if (hasOrder)
-			{
-				// resolve by order
-				int ret = resolveDeps (j, adjMatrix, size, done, orderCounter);
-				if (ret == -1) break;
-				j = -1;
-				found = 1;
-				continue;
-			}
-			else
-			{
-				// resolve next possible dependency in keyset
-				if (!hasUnresolvedDependencies (j, adjMatrix, size))
-				{
-					adjMatrix[j].isResolved = 1;
-					resolveDep (j, adjMatrix, size);
-					keySetMeta (localArray[j], "order", keyBaseName (orderCounter));
-					elektraArrayIncName (orderCounter);
-					ksAppendKey (done, keyDup (localArray[j]));
-					found = 1;
-				}
+				// a dependency depends on the key itself
+				retVal = 0;
+				break;
 			}
+			topResolve (&ts, j);
 		}
 	}
-	if (unresolved == 0)
+	else
 	{
-		// everything resolved
-		// add dependencies in topological order to array
-		elektraKsToMemArray (ks, array);
-		qsort (array, size, sizeof (Key *), topCmpOrder);
-		retVal = 1;
+		// resolve next possible dependency in keyset
+		size_t count = 0;
+		for (size_t j = 0; j < size; ++j)
+		{
+			if (ts.nodes[j].isResolved) continue;
+			ts.nodes[j].inScope = 1;
+			ts.scope[count++] = j;
+		}
+		// still unresolved dependencies left: there must be a cycle somewhere
+		if (!topSweep (&ts, ts.scope, count)) retVal = 0;
 	}
-	else
+
+	if (retVal == 1)
 	{
-		// still unresolved dependencies left:
-		// there must be a cycle somewhere
-		retVal = 0;
+		// add dependencies in topological order to array
+		memcpy (array, ts.sorted, size * sizeof (Key *));
 	}
+
 TopSortCleanup:
-	ksDel (done);
-	keyDel (orderCounter);
-	elektraFree (localArray);
-	for (ssize_t j = 0; j < size; ++j)
+	if (ts.nodes)
 	{
-		elektraFree (adjMatrix[j].deps);
+		for (size_t j = 0; j < size; ++j)
+		{
+			ksDel (ts.nodes[j].deps);
+		}
+		elektraFree (ts.nodes);
 	}
+	if (byPosition) elektraFree (byPosition);
+	if (ts.current) elektraFree (ts.current);
+	if (ts.next) elektraFree (ts.next);
+	if (ts.scope) elektraFree (ts.scope);
+	if (ts.sorted) elektraFree (ts.sorted);
+	if (ts.depList) elektraFree (ts.depList);
+	if (ts.dependentList) elektraFree (ts.dependentList);
+	if (edgeFrom) elektraFree (edgeFrom);
+	if (edgeTo) elektraFree (edgeTo);
+	keyDel (ts.orderCounter);
 	return retVal;
 }
 
@@ -0,0 +1,249 @@
+/**
+ * @file
+ *
+ * @brief Run the per key check of a plugin over a keyset.
+ *
+ * @copyright BSD License (see LICENSE.md or https://www.libelektra.org)
+ */
+
+#ifdef HAVE_KDBCONFIG_H
+#include "kdbconfig.h"
+#endif
+
+#include <kdbinternal.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/** Fewer keys are not worth starting another thread */
+#define ELEKTRA_CHECK_KEYS_PER_WORKER 1024
+
+/** Upper limit for the number of threads checking a keyset */
+#define ELEKTRA_CHECK_KEYS_MAX_WORKERS 16
+
+static Key * nextKey (KeySet * ks, const char * metaName)
+{
+	return metaName ? elektraKsNextWithMeta (ks, metaName) : ksNext (ks);
+}
+
+static int checkKeysSequential (Plugin * handle, KeySet * ks, const char * metaName, kdbCheckKeyPtr checkKey, Key * parentKey)
+{
+	Key * cur;
+	ksRewind (ks);
+	while ((cur = nextKey (ks, metaName)) != 0)
+	{
+		if (checkKey (handle, cur, parentKey) <= 0) return -1;
+	}
+	ksRewind (ks);
+	return 1;
+}
+
+#ifdef HAVE_PTHREAD
+
+/**
+ * A contiguous part of the keys checked by one thread.
+ */
+typedef struct
+{
+	struct _Plugin plugin; // own instance, so that the data of the plugin is not shared between threads
+	int opened;
+	kdbCheckKeyPtr checkKey;
+	Key ** keys;
+	char * recheck; // cleared for keys which passed without any error or warning
+	size_t begin;
+	size_t end;
+	Key * errorKey;
+	const Key * parentKey;
+} CheckWorker;
+
+static Key * newErrorKey (const Key * parentKey)
+{
+	return keyNew (keyName (parentKey), KEY_VALUE, keyString (parentKey), KEY_END);
+}
+
+static void checkPart (CheckWorker * worker)
+{
+	for (size_t i = worker->begin; i < worker->end; ++i)
+	{
+		int rc = worker->checkKey (&worker->plugin, worker->keys[i], worker->errorKey);
+		// the remaining keys are left for the recheck, which stops at the first invalid key anyway
+		if (rc <= 0) return;
+		if (worker->errorKey->meta && ksGetSize (worker->errorKey->meta) > 0)
+		{
+			// warnings are added again by the recheck in the order of the keys
+			keyDel (worker->errorKey);
+			worker->errorKey = newErrorKey (worker->parentKey);
+			if (!worker->errorKey) return;
+			continue;
+		}
+		worker->recheck[i] = 0;
+	}
+}
+
+static void * checkPartThread (void * worker)
+{
+	checkPart (worker);
+	return 0;
+}
+
+static int checkKeysParallel (Plugin * handle, KeySet * ks, const char * metaName, kdbCheckKeyPtr checkKey, Key * parentKey,
+			      size_t workers)
+{
+	size_t size = (size_t)ksGetSize (ks);
+	Key ** keys = elektraMalloc (size * sizeof (Key *));
+	cursor_t * cursors = elektraMalloc (size * sizeof (cursor_t));
+	CheckWorker * worker = elektraCalloc (workers * sizeof (CheckWorker));
+	pthread_t * threads = elektraMalloc (workers * sizeof (pthread_t));
+	char * recheck = elektraMalloc (size);
+	if (!keys || !cursors || !worker || !threads || !recheck)
+	{
+		if (keys) elektraFree (keys);
+		if (cursors) elektraFree (cursors);
+		if (worker) elektraFree (worker);
+		if (threads) elektraFree (threads);
+		if (recheck) elektraFree (recheck);
+		return checkKeysSequential (handle, ks, metaName, checkKey, parentKey);
+	}
+
+	size_t count = 0;
+	Key * cur;
+	ksRewind (ks);
+	while ((cur = nextKey (ks, metaName)) != 0)
+	{
+		keys[count] = cur;
+		cursors[count] = ksGetCursor (ks);
+		++count;
+	}
+	memset (recheck, 1, count);
+	if (workers > count) workers = count;
+
+	// plugins are opened and closed in this thread, only the checks run concurrently
+	for (size_t w = 0; w < workers; ++w)
+	{
+		worker[w].plugin = *handle;
+		worker[w].plugin.data = 0;
+		worker[w].plugin.refcounter = 1;
+		worker[w].checkKey = checkKey;
+		worker[w].keys = keys;
+		worker[w].recheck = recheck;
+		worker[w].begin = count * w / workers;
+		worker[w].end = count * (w + 1) / workers;
+		worker[w].parentKey = parentKey;
+		worker[w].errorKey = newErrorKey (parentKey);
+		if (!worker[w].errorKey) continue;
+		worker[w].opened = !handle->kdbOpen || handle->kdbOpen (&worker[w].plugin, worker[w].errorKey) != -1;
+		if (worker[w].errorKey->meta && ksGetSize (worker[w].errorKey->meta) > 0)
+		{
+			keyDel (worker[w].errorKey);
+			worker[w].errorKey = newErrorKey (parentKey);
+			if (!worker[w].errorKey) worker[w].opened = 0;
+		}
+	}
+
+	int * started = elektraCalloc (workers * sizeof (int));
+	for (size_t w = 1; started && w < workers; ++w)
+	{
+		if (!worker[w].opened) continue;
+		started[w] = !pthread_create (&threads[w], 0, checkPartThread, &worker[w]);
+	}
+	if (worker[0].opened) checkPart (&worker[0]);
+	for (size_t w = 1; started && w < workers; ++w)
+	{
+		if (started[w]) pthread_join (threads[w], 0);
+	}
+
+	for (size_t w = 0; w < workers; ++w)
+	{
+		if (!worker[w].errorKey) continue;
+		if (worker[w].opened && handle->kdbClose) handle->kdbClose (&worker[w].plugin, worker[w].errorKey);
+		keyDel (worker[w].errorKey);
+	}
+
+	// errors and warnings are reported as if the keys were checked one after the other
+	int ret = 1;
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (!recheck[i]) continue;
+		if (checkKey (handle, keys[i], parentKey) <= 0)
+		{
+			ksSetCursor (ks, cursors[i]);
+			ret = -1;
+			break;
+		}
+	}
+	if (ret == 1) ksRewind (ks);
+
+	if (started) elektraFree (started);
+	elektraFree (recheck);
+	elektraFree (threads);
+	elektraFree (worker);
+	elektraFree (cursors);
+	elektraFree (keys);
+	return ret;
+}
+
+#endif
+
+/**
+ * @brief Same as elektraPluginCheckKeys(), but with the number of threads given.
+ *
+ * Used directly by tests, which do not want to depend on the number of CPUs.
+ *
+ * @param workers maximum number of threads
+ * @param minKeys minimum number of keys of the keyset per thread, 0 for no minimum
+ */
+int elektraPluginCheckKeysWith (Plugin * handle, KeySet * ks, const char * metaName, kdbCheckKeyPtr checkKey, Key * parentKey,
+				size_t workers, size_t minKeys)
+{
+	if (!handle || !ks || !checkKey || !parentKey) return -1;
+
+#ifdef HAVE_PTHREAD
+	size_t size = (size_t)ksGetSize (ks);
+	if (minKeys && workers > size / minKeys) workers = size / minKeys;
+	if (workers > ELEKTRA_CHECK_KEYS_MAX_WORKERS) workers = ELEKTRA_CHECK_KEYS_MAX_WORKERS;
+	if (workers > 1) return checkKeysParallel (handle, ks, metaName, checkKey, parentKey, workers);
+#else
+	(void)workers;
+	(void)minKeys;
+#endif
+	return checkKeysSequential (handle, ks, metaName, checkKey, parentKey);
+}
+
+/**
+ * @brief Checks all keys of ks having metaName with the per key check of a plugin.
+ *
+ * Plugins which validate each key independently of all other keys can
+ * export such a check as `checkkey` and use this function within their
+ * kdbSet() or kdbGet() instead of iterating the keyset themselves.
+ *
+ * Large keysets are split into contiguous parts checked by several threads.
+ * Each thread uses its own instance of the plugin: it is opened and closed
+ * with the plugin's open and close functions, so data stored with
+ * elektraPluginSetData() is never shared between threads. The check
+ * itself must only depend on the key and the plugin's instance.
+ *
+ * Keys that failed or produced warnings are checked again with handle
+ * and parentKey in the order of ks, so that errors and warnings are the
+ * same as if all keys were checked one after the other.
+ *
+ * @param handle the plugin
+ * @param ks the keys to check
+ * @param metaName only check keys having this meta key, all keys if NULL
+ * @param checkKey the per key check of the plugin
+ * @param parentKey gets the error and warnings
+ *
+ * @retval 1 if all keys are valid, the cursor of ks is rewound
+ * @retval -1 if a key is invalid, the cursor of ks points to it
+ * @ingroup plugin
+ */
+int elektraPluginCheckKeys (Plugin * handle, KeySet * ks, const char * metaName, kdbCheckKeyPtr checkKey, Key * parentKey)
+{
+	size_t workers = 1;
+#ifdef HAVE_PTHREAD
+	long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+	if (cpus > 1) workers = cpus;
+#endif
+	return elektraPluginCheckKeysWith (handle, ks, metaName, checkKey, parentKey, workers, ELEKTRA_CHECK_KEYS_PER_WORKER);
+}
@@ -220,6 +220,67 @@ Key * ksPopAtCursor (KeySet * ks, cursor_t pos)
 }
 
 
+/**
+ * @brief Returns the next Key in a KeySet having the meta information metaName.
+ *
+ * Works like ksNext(), but skips all keys without metaName. The positions
+ * of the keys having metaName are remembered within the KeySet, so that
+ * further iterations (also by other plugins) only visit these keys.
+ * The index is rebuilt when keys are added or removed, and when an
+ * iteration starts after the meta information of any key was changed.
+ *
+ * @code
+ksRewind (ks);
+while ((key = ksNextWithMeta (ks, "check/enum")) != 0) {}
+ * @endcode
+ *
+ * @note Meta information added to keys during an iteration will only
+ * be seen after ksRewind().
+ *
+ * @param ks the keyset object to work with
+ * @param metaName the name of the meta information the keys need to have
+ * @return the new current Key
+ * @retval 0 when the end is reached or on NULL pointer
+ * @see ksNext(), ksRewind(), keyGetMeta()
+ */
+Key * ksNextWithMeta (KeySet * ks, const char * metaName)
+{
+	return elektraKsNextWithMeta (ks, metaName);
+}
+
+/**
+ * @brief Computes which keys were added, removed or modified
+ *
+ * Both keysets are walked once in parallel, so this takes linear time.
+ * A key of newKs is modified if a key with the same name exists in oldKs
+ * and either the key of newKs needs to be synced, or the keys are
+ * different objects with a different value or different meta information.
+ *
+ * The keys themselves are appended to the result keysets, they are not
+ * duplicated.
+ *
+ * @code
+KeySet * added = ksNew (0, KS_END);
+KeySet * removed = ksNew (0, KS_END);
+KeySet * modified = ksNew (0, KS_END);
+ksDiff (previous, current, added, removed, modified);
+ * @endcode
+ *
+ * @param oldKs the previous keyset
+ * @param newKs the current keyset
+ * @param added gets the keys of newKs not in oldKs, may be NULL
+ * @param removed gets the keys of oldKs not in newKs, may be NULL
+ * @param modified gets the modified keys of newKs, may be NULL
+ * @return the number of added, removed and modified keys
+ * @retval -1 on NULL pointer of oldKs or newKs
+ * @see keyNeedSync()
+ */
+ssize_t ksDiff (const KeySet * oldKs, const KeySet * newKs, KeySet * added, KeySet * removed, KeySet * modified)
+{
+	return elektraKsDiff (oldKs, newKs, added, removed, modified);
+}
+
+
 /**
  * keyRel replacement
  */
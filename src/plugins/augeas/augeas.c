@@ -60,11 +60,6 @@ int keySetOrderMeta (Key * key, int order)
 	return result;
 }
 
-static int keyCmpOrderWrapper (const void * a, const void * b)
-{
-	return elektraKeyCmpOrder (*((const Key **)a), *((const Key **)b));
-}
-
 static const char * getLensPath (Plugin * handle)
 {
 	KeySet * config = elektraPluginGetConfig (handle);
@@ -385,7 +380,9 @@ static int saveTree (augeas * augeasHandle, KeySet * ks, const char * lensPath,
 
 	if (ret < 0) goto memoryerror;
 
-	qsort (keyArray, arraySize, sizeof (Key *), keyCmpOrderWrapper);
+	ret = elektraSortKeysByOrder (keyArray, arraySize);
+
+	if (ret < 0) goto memoryerror;
 
 	/* convert the Elektra KeySet to an Augeas tree */
 	for (size_t i = 0; i < arraySize; i++)
@@ -3,9 +3,29 @@
 #include <kdberrors.h>
 
 static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-#define ALPHABET_LENGTH (sizeof (alphabet) - 1)
 static const char padding = '=';
 
+// index of every character in the alphabet, 0xff for characters not in the alphabet
+static const kdb_octet_t alphabetIndex[256] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+	0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+	0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+#define INVALID_INDEX 0xff
+
 /**
  * @brief encodes arbitrary binary data using the Base64 encoding scheme (RFC4648)
  * @param input holds the data to be encoded
@@ -14,80 +34,52 @@ static const char padding = '=';
             caller.
  */
 char * PLUGIN_FUNCTION (base64Encode) (const kdb_octet_t * input, const size_t inputLength)
-#ifdef __llvm__
-	__attribute__ ((annotate ("oclint:suppress[long method]")))
-#endif
 {
-	size_t encodedLength = 0;
-	if (inputLength % 3 == 0)
-	{
-		encodedLength = (inputLength / 3 * 4) + 1;
-	}
-	else
-	{
-		encodedLength = ((inputLength + (3 - (inputLength % 3))) / 3 * 4) + 1;
-	}
+	const size_t encodedLength = (inputLength + 2) / 3 * 4 + 1;
 	ELEKTRA_ASSERT (encodedLength > 0, "Base64 output array size smaller or equal to 0.");
 
-	size_t out = 0;
 	char * encoded = elektraMalloc (encodedLength);
 	if (!encoded) return NULL;
 
-	for (size_t i = 0; i < inputLength; i += 3)
+	// no padding required for all complete blocks of 3 octets
+	const size_t completeLength = inputLength - inputLength % 3;
+	char * out = encoded;
+	for (size_t i = 0; i < completeLength; i += 3)
+	{
+		const kdb_unsigned_long_t block = (input[i] << 16) | (input[i + 1] << 8) | input[i + 2];
+		out[0] = alphabet[block >> 18];
+		out[1] = alphabet[(block >> 12) & 0x3f];
+		out[2] = alphabet[(block >> 6) & 0x3f];
+		out[3] = alphabet[block & 0x3f];
+		out += 4;
+	}
+
+	if (completeLength < inputLength)
 	{
-		if (inputLength - i < 3)
+		// padding required
+		kdb_octet_t padded[3] = { 0 };
+		memcpy (padded, input + completeLength, inputLength - completeLength);
+
+		*out++ = alphabet[padded[0] >> 2];
+		*out++ = alphabet[((padded[0] << 4) + (padded[1] >> 4)) & 0x3f];
+
+		if (inputLength - completeLength == 2)
 		{
-			// padding required
-			kdb_octet_t padded[3] = { 0 };
-			memcpy (padded, input + i, inputLength - i);
-
-			encoded[out++] = alphabet[padded[0] >> 2];
-			encoded[out++] = alphabet[((padded[0] << 4) + (padded[1] >> 4)) & 0x3f];
-
-			if (inputLength - i == 2)
-			{
-				// 2 octets available in input
-				encoded[out++] = alphabet[((padded[1] << 2) + (padded[2] >> 6)) & 0x3f];
-				encoded[out++] = padding;
-			}
-			else
-			{
-				// 1 octet available in input
-				encoded[out++] = padding;
-				encoded[out++] = padding;
-			}
+			// 2 octets available in input
+			*out++ = alphabet[((padded[1] << 2) + (padded[2] >> 6)) & 0x3f];
+			*out++ = padding;
 		}
 		else
 		{
-			// no padding required
-			encoded[out++] = alphabet[input[i] >> 2];
-			encoded[out++] = alphabet[((input[i] << 4) + (input[i + 1] >> 4)) & 0x3f];
-			encoded[out++] = alphabet[((input[i + 1] << 2) + (input[i + 2] >> 6)) & 0x3f];
-			encoded[out++] = alphabet[input[i + 2] & 0x3f];
+			// 1 octet available in input
+			*out++ = padding;
+			*out++ = padding;
 		}
 	}
-	encoded[out++] = '\0';
+	*out = '\0';
 	return encoded;
 }
 
-/**
- * @brief lookup Base64 character in the alphabet and return the index.
- * @param character the character to look up
- * @param errorFlag set to 1 in case of error
- * @returns the index in the Base64 alphabet or 0 if the padding character was detected.
- */
-static kdb_octet_t getBase64Index (const char character, int * errorFlag)
-{
-	if (character == padding) return 0;
-
-	for (kdb_octet_t i = 0; i < ALPHABET_LENGTH; i++)
-	{
-		if (alphabet[i] == character) return i;
-	}
-	*errorFlag = 1;
-	return 0;
-}
-
 /**
  * @brief decodes Base64 encoded data.
  * @param input holds the Base64 encoded data string
@@ -100,12 +92,12 @@ static kdb_octet_t getBase64Index (const char character, int * errorFlag)
  */
 int PLUGIN_FUNCTION (base64Decode) (const char * input, kdb_octet_t ** output, size_t * outputLength)
 #ifdef __llvm__
-	__attribute__ ((annotate ("oclint:suppress[high ncss method]"), annotate ("oclint:suppress[high npath complexity]"),
-			annotate ("oclint:suppress[long method]"), annotate ("oclint:suppress[high cyclomatic complexity]")))
+	__attribute__ ((annotate ("oclint:suppress[high npath complexity]"), annotate ("oclint:suppress[long method]"),
+			annotate ("oclint:suppress[high cyclomatic complexity]")))
 #endif
 {
 	const size_t inputLen = strlen (input);
-	if (inputLen == 0 || (inputLen == 1 && input[0] == '\0'))
+	if (inputLen == 0)
 	{
 		*output = NULL;
 		*outputLength = 0;
@@ -118,25 +110,35 @@ int PLUGIN_FUNCTION (base64Decode) (const char * input, kdb_octet_t ** output, s
 		return -1;
 	}
 
-	*outputLength = inputLen / 4 * 3;
-	if (input[inputLen - 1] == padding) (*outputLength)--;
-	if (input[inputLen - 2] == padding) (*outputLength)--;
+	// padding is only allowed at the end of the last block
+	const kdb_octet_t * in = (const kdb_octet_t *)input;
+	const size_t lastBlock = inputLen - 4;
+	const int paddingLength = (input[inputLen - 1] == padding) + (input[inputLen - 2] == padding);
+	if (input[inputLen - 1] != padding && input[inputLen - 2] == padding)
+	{
+		*output = NULL;
+		return -1;
+	}
 
+	*outputLength = inputLen / 4 * 3 - paddingLength;
 	*output = elektraMalloc (*outputLength);
 	if (!(*output)) return -2;
 
-	size_t position = 0;
-	size_t outputIndex = 0;
-
-	for (position = 0; position < inputLen; position += 4)
+	kdb_octet_t * out = *output;
+	for (size_t position = 0; position <= lastBlock; position += 4)
 	{
-		int errorFlag = 0;
-		const kdb_octet_t byte0 = getBase64Index (input[position], &errorFlag);
-		const kdb_octet_t byte1 = getBase64Index (input[position + 1], &errorFlag);
-		const kdb_octet_t byte2 = getBase64Index (input[position + 2], &errorFlag);
-		const kdb_octet_t byte3 = getBase64Index (input[position + 3], &errorFlag);
+		const kdb_octet_t byte0 = alphabetIndex[in[position]];
+		const kdb_octet_t byte1 = alphabetIndex[in[position + 1]];
+		kdb_octet_t byte2 = alphabetIndex[in[position + 2]];
+		kdb_octet_t byte3 = alphabetIndex[in[position + 3]];
+
+		if (position == lastBlock)
+		{
+			if (paddingLength == 2) byte2 = 0;
+			if (paddingLength >= 1) byte3 = 0;
+		}
 
-		if (errorFlag)
+		if ((byte0 | byte1 | byte2 | byte3) == INVALID_INDEX)
 		{
 			// invalid character detected in input string
 			elektraFree (*output);
@@ -144,15 +146,11 @@ int PLUGIN_FUNCTION (base64Decode) (const char * input, kdb_octet_t ** output, s
 			return -1;
 		}
 
-		(*output)[outputIndex++] = (byte0 << 2) + (byte1 >> 4);
-		if (input[position + 2] != padding)
-		{
-			(*output)[outputIndex++] = (byte1 << 4) + (byte2 >> 2);
-		}
-		if (input[position + 3] != padding)
-		{
-			(*output)[outputIndex++] = (byte2 << 6) + byte3;
-		}
+		*out++ = (byte0 << 2) + (byte1 >> 4);
+		if (position == lastBlock && paddingLength == 2) break;
+		*out++ = (byte1 << 4) + (byte2 >> 2);
+		if (position == lastBlock && paddingLength == 1) break;
+		*out++ = (byte2 << 6) + byte3;
 	}
 	return 1;
 }
@@ -123,6 +123,20 @@ static void test_base64_decoding (void)
 	}
 }
 
+static void test_base64_decoding_invalid (void)
+{
+	const char * invalid[] = { "Zg=", "Zg!=", "====", "Z===", "Zg=v", "Zm=vYg==", "Zm9v=g==", "Zm9vYmF\n" };
+
+	for (size_t i = 0; i < sizeof (invalid) / sizeof (invalid[0]); i++)
+	{
+		kdb_octet_t * buffer = NULL;
+		size_t bufferLen = 0;
+		succeed_if (PLUGIN_FUNCTION (base64Decode) (invalid[i], &buffer, &bufferLen) == -1, "decoding of invalid input succeeded");
+		succeed_if (buffer == NULL, "decoding of invalid input returned a result vector");
+		if (buffer) elektraFree (buffer);
+	}
+}
+
 static void test_base64_plugin_regular (void)
 #ifdef __llvm__
 	__attribute__ ((annotate ("oclint:suppress[deep nested block]"), annotate ("oclint:suppress[high ncss method]"),
@@ -276,6 +290,7 @@ int main (int argc, char ** argv)
 	// test the encoding and decoding process
 	test_base64_encoding ();
 	test_base64_decoding ();
+	test_base64_decoding_invalid ();
 
 	// test the plugin functionality
 	test_init ();
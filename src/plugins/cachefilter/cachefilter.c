@@ -14,6 +14,73 @@
 #include <kdbhelper.h>
 
 #include <kdblogger.h>
+#include <kdbprivate.h> // for ksSearchInternal
+
+/**
+ * @brief Adds all keys of returned to the cache, which are not already cached
+ *
+ * Keys returned by a previous call are shared with the cache, so if
+ * the resolvers did not report any change they are found and skipped.
+ */
+static void updateCache (KeySet * cache, KeySet * returned)
+{
+	Key * cur;
+	ksRewind (returned);
+	while ((cur = ksNext (returned)) != 0)
+	{
+		ssize_t pos = ksSearchInternal (cache, cur);
+		if (pos >= 0 && ksAtCursor (cache, pos) == cur) continue;
+		ksAppendKey (cache, cur);
+	}
+}
+
+/**
+ * @brief Appends the keys of the cache which are below or same as cutpoint to returned
+ *
+ * The keys below cutpoint directly follow its position in the sorted cache,
+ * so both ends of the range are found by binary search.
+ */
+static void appendCachedRange (KeySet * returned, KeySet * cache, const Key * cutpoint)
+{
+	ssize_t begin = ksSearchInternal (cache, cutpoint);
+	if (begin < 0) begin = -begin - 1;
+
+	ssize_t end = ksGetSize (cache);
+	ssize_t lower = begin;
+	while (lower < end)
+	{
+		ssize_t middle = lower + (end - lower) / 2;
+		if (keyIsBelowOrSame (cutpoint, ksAtCursor (cache, middle)))
+			lower = middle + 1;
+		else
+			end = middle;
+	}
+
+	for (ssize_t i = begin; i < end; ++i)
+	{
+		ksAppendKey (returned, ksAtCursor (cache, i));
+	}
+}
+
+static void appendCachedKeys (KeySet * returned, KeySet * cache, const Key * parentKey)
+{
+	const char * name = keyName (parentKey);
+	if (name[0] != '/')
+	{
+		appendCachedRange (returned, cache, parentKey);
+		return;
+	}
+
+	// cascading keys are below all namespaces, as in ksCut()
+	const char * namespaces[] = { "spec", "proc", "dir", "user", "system" };
+	for (size_t i = 0; i < sizeof (namespaces) / sizeof (namespaces[0]); ++i)
+	{
+		Key * cutpoint = keyNew (namespaces[i], KEY_END);
+		keyAddName (cutpoint, name);
+		appendCachedRange (returned, cache, cutpoint);
+		keyDel (cutpoint);
+	}
+}
 
 
 int elektraCachefilterGet (Plugin * handle, KeySet * returned, Key * parentKey)
@@ -50,19 +117,15 @@ int elektraCachefilterGet (Plugin * handle, KeySet * returned, Key * parentKey)
 	}
 
 	// first ensure the cache is up to date with the
-	// freshly requested keys
-	ksAppend (toBeCached, returned);
+	// freshly requested keys, the cache is then the
+	// authoritative store for all keys
+	updateCache (toBeCached, returned);
 
 	// then ensure to return only the requested keys
-	// (matching parentKey)
+	// (matching parentKey), they stay in the cache for
+	// successive kdbGet() calls
 	ksClear (returned);
-	KeySet * requestedKeys = ksCut (toBeCached, parentKey);
-	ksAppend (returned, requestedKeys);
-	ksDel (requestedKeys);
-
-	// and also keep the returned keys in cache as well
-	// this is necessary for successive kdbGet() calls
-	ksAppend (toBeCached, returned);
+	appendCachedKeys (returned, toBeCached, parentKey);
 
 	// point the plugin data to the cached keyset
 	elektraPluginSetData (handle, toBeCached);
@@ -395,6 +395,88 @@ static void test_successfulSiblingGets (void)
 	PLUGIN_CLOSE ();
 }
 
+static void test_successfulCascadingGet (void)
+{
+	Key * parentKey = keyNew ("/tests/cachefilter/will/not/be/cached", KEY_END);
+	KeySet * conf = ksNew (0, KS_END);
+	PLUGIN_OPEN ("cachefilter");
+
+	KeySet * testKeysCache = createTestKeysToCache ();
+	KeySet * testKeysNoCache = createTestKeysToNotCache ();
+
+	KeySet * ks = ksNew (0, KS_END);
+	ksAppend (ks, testKeysCache);
+	ksAppend (ks, testKeysNoCache);
+	ksAppendKey (ks, keyNew ("system/tests/cachefilter/will/not/be/cached/key1", KEY_END));
+	ksAppendKey (ks, keyNew ("system/tests/cachefilter/will/be/cached/key1", KEY_END));
+
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) >= 1, "call to kdbGet was not successful");
+	succeed_if (output_error (parentKey), "error in kdbGet");
+	succeed_if (output_warnings (parentKey), "warnings in kdbGet");
+	succeed_if (ksGetSize (ks) == 4, "wrong number of keys in result, expected 4");
+
+	KeySet * expected = ksNew (0, KS_END);
+	ksAppend (expected, testKeysNoCache);
+	ksAppendKey (expected, keyNew ("system/tests/cachefilter/will/not/be/cached/key1", KEY_END));
+	compare_keyset (ks, expected);
+	ksDel (expected);
+
+	keyDel (parentKey);
+	ksDel (ks);
+
+	ksDel (testKeysCache);
+	ksDel (testKeysNoCache);
+
+	PLUGIN_CLOSE ();
+}
+
+static void test_repeatedGetsFromCache (void)
+{
+	Key * parentKey = keyNew ("user/tests/cachefilter/will/not/be/cached/with", KEY_END);
+	Key * parentKey2 = keyNew ("user/tests/cachefilter/will/not/be/cached/for", KEY_END);
+	KeySet * conf = ksNew (0, KS_END);
+	PLUGIN_OPEN ("cachefilter");
+
+	KeySet * testKeysNoCacheCascading = createTestKeysToNotCacheCascading ();
+	KeySet * testKeysNoCacheSiblings = createTestKeysToNotCacheSiblings ();
+	KeySet * ks = ksNew (0, KS_END);
+	ksAppend (ks, testKeysNoCacheCascading);
+	ksAppend (ks, testKeysNoCacheSiblings);
+
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) >= 1, "call to kdbGet was not successful");
+	succeed_if (ksGetSize (ks) == 3, "wrong number of keys in result, expected 3");
+
+	KeySet * cache = elektraPluginGetData (plugin);
+	succeed_if (ksGetSize (cache) == 6, "all keys should be cached");
+
+	// the resolvers did not report a change, so the keys of the previous call are passed again
+	for (int i = 0; i < 3; ++i)
+	{
+		succeed_if (plugin->kdbGet (plugin, ks, parentKey2) >= 1, "call to kdbGet was not successful");
+		succeed_if (ksGetSize (ks) == 3, "wrong number of keys in result, expected 3");
+		succeed_if (ksLookupByName (ks, "user/tests/cachefilter/will/not/be/cached/for/whatever/key1", 0), "key of sibling missing");
+
+		succeed_if (plugin->kdbGet (plugin, ks, parentKey) >= 1, "call to kdbGet was not successful");
+		succeed_if (ksGetSize (ks) == 3, "wrong number of keys in result, expected 3");
+		compare_keyset (ks, testKeysNoCacheCascading);
+
+		succeed_if (elektraPluginGetData (plugin) == cache, "cache should be kept");
+		succeed_if (ksGetSize (cache) == 6, "cache should not grow");
+	}
+
+	// the cached keys are returned, not copies of them
+	Key * cached = ksLookupByName (cache, "user/tests/cachefilter/will/not/be/cached/with/directory/key1", 0);
+	succeed_if (cached && ksLookupByName (ks, keyName (cached), 0) == cached, "key should be shared with the cache");
+
+	keyDel (parentKey);
+	keyDel (parentKey2);
+	ksDel (ks);
+	ksDel (testKeysNoCacheCascading);
+	ksDel (testKeysNoCacheSiblings);
+
+	PLUGIN_CLOSE ();
+}
+
 int main (int argc, char ** argv)
 {
 	printf ("CACHEFILTER     TESTS\n");
@@ -407,6 +489,8 @@ int main (int argc, char ** argv)
 	test_successfulGetSetGetSet ();
 	test_successfulGetGetGet ();
 	test_successfulSiblingGets ();
+	test_successfulCascadingGet ();
+	test_repeatedGetsFromCache ();
 
 	print_result ("testmod_cachefilter");
 
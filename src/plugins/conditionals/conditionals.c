@@ -53,6 +53,64 @@ typedef enum {
 	NOEXPR = -3,
 } CondResult;
 
+typedef struct
+{
+	char * position; // character that holds the result of another step
+	size_t step;
+} Placeholder;
+
+/**
+ * A single condition of an expression, e.g. `../key == 'value'`.
+ *
+ * Nested conditions are replaced by `'1'` or `'0'` once they are evaluated,
+ * the placeholders point to these characters in `condition`, `leftSide` and `rightSide`.
+ */
+typedef struct
+{
+	char * condition; // used in error messages
+	char * leftSide;
+	char * rightSide;
+	Comparator cmpOp;
+	int valid;
+	Placeholder * placeholders;
+	size_t placeholderCount;
+	CondResult result;
+} Step;
+
+/**
+ * A parsed expression, the steps are evaluated in order and the last one
+ * yields the result of the expression.
+ */
+typedef struct
+{
+	Step * steps;
+	size_t stepCount;
+	int malformed;
+} Expression;
+
+typedef struct
+{
+	char * conditionString;
+	int valid;
+	char * condition;
+	char * thenexpr;
+	char * elseexpr;
+	Expression ifExpr;
+	Expression thenExpr;
+	Expression elseExpr;
+} CompiledCondition;
+
+typedef struct
+{
+	regex_t groupRegex;
+	regex_t ifRegex;
+	regex_t thenRegex;
+	regex_t elseRegex;
+	CompiledCondition ** conditions; // sorted by conditionString
+	size_t size;
+	size_t alloc;
+} ConditionalsData;
+
 static int isValidSuffix (char * suffix, const Key * suffixList)
 {
 	if (!suffixList) return 0;
@@ -401,19 +459,29 @@ static char * condition2cmpOp (const char * condition, Comparator * cmpOp)
 	return opStr;
 }
 
-static CondResult parseSingleCondition (const Key * key, const char * condition, const Key * suffixList, KeySet * ks, Key * parentKey)
+/**
+ * @brief splits a single condition into its comparator and both sides
+ *
+ * `rightSide` is NULL for the existence test `! key`.
+ * The offsets of both sides within `condition` are stored in `leftOffset` and `rightOffset`.
+ *
+ * @retval 0 on success
+ * @retval 1 if `condition` contains no comparator
+ * @retval -1 if out of memory
+ */
+static int splitSingleCondition (const char * condition, Comparator * cmpOp, char ** leftSide, size_t * leftOffset, char ** rightSide,
+				 size_t * rightOffset)
 {
-	Comparator cmpOp;
 	char * opStr;
-	opStr = condition2cmpOp (condition, &cmpOp);
+	opStr = condition2cmpOp (condition, cmpOp);
 
 	if (!opStr)
 	{
-		return ERROR;
+		return 1;
 	}
 
 	int opLen;
-	if (cmpOp == LT || cmpOp == GT || cmpOp == NEX)
+	if (*cmpOp == LT || *cmpOp == GT || *cmpOp == NEX)
 	{
 		opLen = 1;
 	}
@@ -434,7 +502,7 @@ static CondResult parseSingleCondition (const Key * key, const char * condition,
 	while (isspace (*ptr))
 	{
 		++ptr;
-		if ((cmpOp == NEX) && (*ptr == '!') && firstNot)
+		if ((*cmpOp == NEX) && (*ptr == '!') && firstNot)
 		{
 			firstNot = 0;
 			++ptr;
@@ -450,15 +518,18 @@ static CondResult parseSingleCondition (const Key * key, const char * condition,
 		++endPos;
 	}
 	int len = opStr - condition - endPos - startPos + 2;
-	char * leftSide = elektraMalloc (len);
-	char * rightSide = NULL;
-	strncpy (leftSide, condition + startPos, len - 2);
-	leftSide[len - 2] = '\0';
+	*leftSide = elektraMalloc (len);
+	*leftOffset = startPos;
+	*rightSide = NULL;
+	*rightOffset = 0;
+	if (!*leftSide) return -1;
+	strncpy (*leftSide, condition + startPos, len - 2);
+	(*leftSide)[len - 2] = '\0';
 	startPos = 0;
 	endPos = 0;
-	if (cmpOp == NEX)
+	if (*cmpOp == NEX)
 	{
-		goto parseSingleEnd;
+		return 0;
 	}
 	ptr = opStr + opLen;
 	while (isspace (*ptr))
@@ -473,16 +544,12 @@ static CondResult parseSingleCondition (const Key * key, const char * condition,
 		++endPos;
 	}
 	len = elektraStrLen (condition) - (opStr - condition) - opLen - endPos - startPos;
-	rightSide = elektraMalloc (len);
-	strncpy (rightSide, opStr + opLen + startPos, len - 1);
-	rightSide[len - 1] = '\0';
-	CondResult ret;
-
-parseSingleEnd:
-	ret = evalCondition (key, leftSide, cmpOp, rightSide, condition, suffixList, ks, parentKey);
-	if (rightSide) elektraFree (rightSide);
-	elektraFree (leftSide);
-	return ret;
+	*rightSide = elektraMalloc (len);
+	*rightOffset = opStr - condition + opLen + startPos;
+	if (!*rightSide) return -1;
+	strncpy (*rightSide, opStr + opLen + startPos, len - 1);
+	(*rightSide)[len - 1] = '\0';
+	return 0;
 }
 
 static const char * isAssign (Key * key, char * expr, Key * parentKey, KeySet * ks)
@@ -553,240 +620,324 @@ static const char * isAssign (Key * key, char * expr, Key * parentKey, KeySet *
 	}
 }
 
-static CondResult parseCondition (Key * key, const char * condition, const Key * suffixList, KeySet * ks, Key * parentKey)
+static void freeExpression (Expression * expr)
 {
-	CondResult result = FALSE;
-	const char * regexString = "((\\(([^\\(\\)]*)\\)))";
-	regex_t regex;
-
-	if ((regcomp (&regex, regexString, REG_EXTENDED | REG_NEWLINE)))
+	for (size_t i = 0; i < expr->stepCount; ++i)
 	{
-		ELEKTRA_SET_ERROR (87, parentKey, "Couldn't compile regex: most likely out of memory"); // the regex compiles so the only
-		// possible error would be out of
-		// memory
-		ksDel (ks);
-		return ERROR;
+		Step * step = &expr->steps[i];
+		if (step->condition) elektraFree (step->condition);
+		if (step->leftSide) elektraFree (step->leftSide);
+		if (step->rightSide) elektraFree (step->rightSide);
+		if (step->placeholders) elektraFree (step->placeholders);
 	}
+	if (expr->steps) elektraFree (expr->steps);
+}
+
+static int addPlaceholder (Step * step, char * position, size_t source)
+{
+	if (elektraRealloc ((void **)&step->placeholders, (step->placeholderCount + 1) * sizeof (Placeholder)) < 0) return -1;
+	step->placeholders[step->placeholderCount].position = position;
+	step->placeholders[step->placeholderCount].step = source;
+	++step->placeholderCount;
+	return 0;
+}
+
+/**
+ * @brief parses an expression with (nested) conditions into steps
+ *
+ * The innermost parentheses are evaluated first and replaced by `'1'` or `'0'`.
+ * Because the replacement does not depend on the result, the positions of all
+ * single conditions are known in advance and the string is only parsed once.
+ *
+ * @retval 0 on success
+ * @retval -1 if out of memory
+ */
+static int compileExpression (Expression * expr, const char * string, regex_t * regex)
+{
+	int ret = -1;
+	size_t len = strlen (string);
+	// the replacement of an empty group writes one character behind it
+	char * localCondition = elektraCalloc (len + 2);
+	// index of the step (starting with 1) whose result is stored at that position
+	size_t * origin = elektraCalloc ((len + 2) * sizeof (size_t));
+	if (!localCondition || !origin) goto CleanUp;
+	memcpy (localCondition, string, len);
 
-	char * localCondition = strdup (condition);
-	int subMatches = 4;
-	regmatch_t m[subMatches];
-	char * ptr = localCondition;
-	while (1)
+	regmatch_t m[4];
+	while (!regexec (regex, localCondition, 4, m, 0))
 	{
-		int nomatch = regexec (&regex, ptr, subMatches, m, 0);
-		if (nomatch)
+		if (m[3].rm_so == -1)
 		{
+			expr->malformed = 1;
 			break;
 		}
-		if (m[3].rm_so == -1)
+		size_t startPos = m[3].rm_so;
+		size_t endPos = m[3].rm_eo;
+		if (elektraRealloc ((void **)&expr->steps, (expr->stepCount + 1) * sizeof (Step)) < 0) goto CleanUp;
+		Step * step = &expr->steps[expr->stepCount++];
+		memset (step, 0, sizeof (Step));
+		step->condition = elektraMalloc (endPos - startPos + 1);
+		if (!step->condition) goto CleanUp;
+		strncpy (step->condition, localCondition + startPos, endPos - startPos);
+		step->condition[endPos - startPos] = '\0';
+
+		size_t leftOffset = 0;
+		size_t rightOffset = 0;
+		int split = splitSingleCondition (step->condition, &step->cmpOp, &step->leftSide, &leftOffset, &step->rightSide,
+						  &rightOffset);
+		if (split < 0) goto CleanUp;
+		step->valid = !split;
+		size_t leftLen = step->leftSide ? strlen (step->leftSide) : 0;
+		size_t rightLen = step->rightSide ? strlen (step->rightSide) : 0;
+		for (size_t i = startPos; i < endPos; ++i)
 		{
-			result = -1;
-			break;
+			if (!origin[i]) continue;
+			size_t offset = i - startPos;
+			size_t source = origin[i] - 1;
+			if (addPlaceholder (step, step->condition + offset, source) < 0) goto CleanUp;
+			if (step->valid && offset >= leftOffset && offset < leftOffset + leftLen)
+			{
+				if (addPlaceholder (step, step->leftSide + (offset - leftOffset), source) < 0) goto CleanUp;
+			}
+			if (step->valid && step->rightSide && offset >= rightOffset && offset < rightOffset + rightLen)
+			{
+				if (addPlaceholder (step, step->rightSide + (offset - rightOffset), source) < 0) goto CleanUp;
+			}
 		}
-		int startPos;
-		int endPos;
-		startPos = m[3].rm_so + (ptr - localCondition);
-		endPos = m[3].rm_eo + (ptr - localCondition);
-		char * singleCondition = elektraMalloc (endPos - startPos + 1);
-		strncpy (singleCondition, localCondition + startPos, endPos - startPos);
-		singleCondition[endPos - startPos] = '\0';
-		result = parseSingleCondition (key, singleCondition, suffixList, ks, parentKey);
-		for (int i = startPos - 1; i < endPos + 1; ++i)
+
+		for (size_t i = startPos - 1; i < endPos + 1; ++i)
+		{
 			localCondition[i] = ' ';
+			origin[i] = 0;
+		}
 		localCondition[startPos - 1] = '\'';
-		localCondition[startPos] = (result == TRUE) ? '1' : '0';
+		localCondition[startPos] = '1';
+		origin[startPos] = expr->stepCount;
 		localCondition[startPos + 1] = '\'';
-		elektraFree (singleCondition);
+		origin[startPos + 1] = 0;
 	}
-	elektraFree (localCondition);
-	regfree (&regex);
+	ret = 0;
+
+CleanUp:
+	if (localCondition) elektraFree (localCondition);
+	if (origin) elektraFree (origin);
+	return ret;
+}
+
+static CondResult evalExpression (Expression * expr, const Key * key, const Key * suffixList, KeySet * ks, Key * parentKey)
+{
+	CondResult result = FALSE;
+	for (size_t i = 0; i < expr->stepCount; ++i)
+	{
+		Step * step = &expr->steps[i];
+		for (size_t j = 0; j < step->placeholderCount; ++j)
+		{
+			*step->placeholders[j].position = (expr->steps[step->placeholders[j].step].result == TRUE) ? '1' : '0';
+		}
+		if (step->valid)
+		{
+			result = evalCondition (key, step->leftSide, step->cmpOp, step->rightSide, step->condition, suffixList, ks,
+						parentKey);
+		}
+		else
+		{
+			result = ERROR;
+		}
+		step->result = result;
+	}
+	if (expr->malformed) result = ERROR;
 	return result;
 }
 
+static void freeCondition (CompiledCondition * compiled)
+{
+	freeExpression (&compiled->ifExpr);
+	freeExpression (&compiled->thenExpr);
+	freeExpression (&compiled->elseExpr);
+	if (compiled->conditionString) elektraFree (compiled->conditionString);
+	if (compiled->condition) elektraFree (compiled->condition);
+	if (compiled->thenexpr) elektraFree (compiled->thenexpr);
+	if (compiled->elseexpr) elektraFree (compiled->elseexpr);
+	elektraFree (compiled);
+}
 
-static CondResult parseConditionString (const Key * meta, const Key * suffixList, Key * parentKey, Key * key, KeySet * ks, Operation op)
+static char * copyMatch (const char * string, regmatch_t * match)
 {
-	const char * conditionString = keyString (meta);
-	const char * regexString1 = "(\\(((.*)?)\\))[[:space:]]*\\?";
-	const char * regexString2 = "\\?[[:space:]]*(\\(((.*)?)\\))";
-	const char * regexString3 = "[[:space:]]*:[[:space:]]*(\\(((.*)?)\\))";
-	regex_t regex1, regex2, regex3;
-	CondResult ret;
-	if ((ret = regcomp (&regex1, regexString1, REGEX_FLAGS_CONDITION)))
-	{
-		ELEKTRA_SET_ERROR (87, parentKey, "Couldn't compile regex: most likely out of memory"); // the regex compiles so the only
-		// possible error would be out of
-		// memory
-		ksDel (ks);
-		return ERROR;
+	char * copy = elektraMalloc (match->rm_eo - match->rm_so + 1);
+	if (!copy) return NULL;
+	strncpy (copy, string + match->rm_so, match->rm_eo - match->rm_so);
+	copy[match->rm_eo - match->rm_so] = '\0';
+	return copy;
+}
+
+/**
+ * @brief splits `(IF-condition) ? (THEN-condition) : (ELSE-condition)` and parses all parts
+ *
+ * @return the parsed condition, `valid` is 0 if the syntax is invalid
+ * @retval NULL if out of memory
+ */
+static CompiledCondition * compileCondition (ConditionalsData * data, const char * conditionString)
+{
+	CompiledCondition * compiled = elektraCalloc (sizeof (CompiledCondition));
+	if (!compiled) return NULL;
+	compiled->conditionString = elektraStrDup (conditionString);
+	if (!compiled->conditionString) goto error;
+
+	const int subMatches = 6;
+	regmatch_t m[6];
+	if (regexec (&data->ifRegex, conditionString, subMatches, m, 0) || m[1].rm_so == -1)
+	{
+		return compiled;
 	}
-	if ((ret = regcomp (&regex2, regexString2, REGEX_FLAGS_CONDITION)))
+	if (!(compiled->condition = copyMatch (conditionString, &m[1]))) goto error;
+	if (regexec (&data->thenRegex, conditionString, subMatches, m, 0) || m[1].rm_so == -1)
 	{
-		ELEKTRA_SET_ERROR (87, parentKey, "Couldn't compile regex: most likely out of memory"); // the regex compiles so the only
-		// possible error would be out of
-		// memory
-		regfree (&regex1);
-		ksDel (ks);
-		return ERROR;
+		return compiled;
 	}
-	if ((ret = regcomp (&regex3, regexString3, REGEX_FLAGS_CONDITION)))
+	if (!(compiled->thenexpr = copyMatch (conditionString, &m[1]))) goto error;
+
+	if (!regexec (&data->elseRegex, conditionString, subMatches, m, 0))
 	{
-		ELEKTRA_SET_ERROR (87, parentKey, "Couldn't compile regex: most likely out of memory"); // the regex compiles so the only
-		// possible error would be out of
-		// memory
-		regfree (&regex1);
-		regfree (&regex2);
-		ksDel (ks);
-		return ERROR;
+		if (m[1].rm_so == -1)
+		{
+			return compiled;
+		}
+		size_t thenLen = strlen (compiled->thenexpr);
+		size_t elseLen = m[0].rm_eo - m[0].rm_so;
+		compiled->thenexpr[thenLen > elseLen ? thenLen - elseLen : 0] = '\0';
+		if (!(compiled->elseexpr = copyMatch (conditionString, &m[1]))) goto error;
 	}
-	int subMatches = 6;
-	regmatch_t m[subMatches];
-	int nomatch = regexec (&regex1, conditionString, subMatches, m, 0);
-	if (nomatch)
+
+	if (compileExpression (&compiled->ifExpr, compiled->condition, &data->groupRegex) < 0) goto error;
+	if (compileExpression (&compiled->thenExpr, compiled->thenexpr, &data->groupRegex) < 0) goto error;
+	if (compiled->elseexpr && compileExpression (&compiled->elseExpr, compiled->elseexpr, &data->groupRegex) < 0) goto error;
+	compiled->valid = 1;
+	return compiled;
+
+error:
+	freeCondition (compiled);
+	return NULL;
+}
+
+/**
+ * @brief returns the parsed condition, every distinct condition string is only parsed once per plugin handle
+ *
+ * @retval NULL if out of memory
+ */
+static CompiledCondition * getCondition (ConditionalsData * data, const char * conditionString)
+{
+	size_t lower = 0;
+	size_t upper = data->size;
+	while (lower < upper)
 	{
-		ELEKTRA_SET_ERRORF (134, parentKey, "Invalid syntax: \"%s\". Check kdb info conditionals for additional information",
-				    conditionString);
-		regfree (&regex1);
-		regfree (&regex2);
-		regfree (&regex3);
-		ksDel (ks);
-		return ERROR;
+		size_t middle = lower + (upper - lower) / 2;
+		int cmp = strcmp (data->conditions[middle]->conditionString, conditionString);
+		if (cmp == 0) return data->conditions[middle];
+		if (cmp < 0)
+			lower = middle + 1;
+		else
+			upper = middle;
 	}
-	if (m[1].rm_so == -1)
+
+	if (data->size == data->alloc)
 	{
-		ELEKTRA_SET_ERRORF (134, parentKey, "Invalid syntax: \"%s\". Check kdb info conditionals for additional information",
-				    conditionString);
-		regfree (&regex1);
-		regfree (&regex2);
-		regfree (&regex3);
-		ksDel (ks);
+		size_t alloc = data->alloc ? data->alloc * 2 : 16;
+		if (elektraRealloc ((void **)&data->conditions, alloc * sizeof (CompiledCondition *)) < 0) return NULL;
+		data->alloc = alloc;
+	}
+	CompiledCondition * compiled = compileCondition (data, conditionString);
+	if (!compiled) return NULL;
+	memmove (data->conditions + lower + 1, data->conditions + lower, (data->size - lower) * sizeof (CompiledCondition *));
+	data->conditions[lower] = compiled;
+	++data->size;
+	return compiled;
+}
+
+static CondResult assignExpression (Key * key, const char * expr, Key * parentKey, KeySet * ks)
+{
+	// isAssign modifies the expression
+	char * localExpr = elektraStrDup (expr);
+	if (!localExpr)
+	{
+		ELEKTRA_SET_ERROR (87, parentKey, "Out of memory");
 		return ERROR;
 	}
-	int startPos = m[1].rm_so;
-	int endPos = m[1].rm_eo;
-	char * condition = elektraMalloc (endPos - startPos + 1);
-	char * thenexpr = NULL;
-	char * elseexpr = NULL;
-	strncpy (condition, conditionString + startPos, endPos - startPos);
-	condition[endPos - startPos] = '\0';
-	nomatch = regexec (&regex2, conditionString, subMatches, m, 0);
-	if (nomatch)
+	CondResult ret = ERROR;
+	const char * assign = isAssign (key, localExpr, parentKey, ks);
+	if (assign != NULL)
 	{
-		ELEKTRA_SET_ERRORF (134, parentKey, "Invalid syntax: \"%s\". Check kdb info conditionals for additional information",
-				    conditionString);
-		regfree (&regex1);
-		regfree (&regex2);
-		regfree (&regex3);
-		ksDel (ks);
+		// assigning the value of the key itself would read the freed old value
+		if (assign != keyString (key)) keySetString (key, assign);
+		ret = TRUE;
+	}
+	elektraFree (localExpr);
+	return ret;
+}
+
+static CondResult parseConditionString (ConditionalsData * data, const Key * meta, const Key * suffixList, Key * parentKey, Key * key,
+					KeySet * ks, Operation op)
+{
+	const char * conditionString = keyString (meta);
+	CompiledCondition * compiled = getCondition (data, conditionString);
+	if (!compiled)
+	{
+		ELEKTRA_SET_ERROR (87, parentKey, "Out of memory");
 		return ERROR;
 	}
-	if (m[1].rm_so == -1)
+	if (!compiled->valid)
 	{
 		ELEKTRA_SET_ERRORF (134, parentKey, "Invalid syntax: \"%s\". Check kdb info conditionals for additional information",
 				    conditionString);
-		regfree (&regex1);
-		regfree (&regex2);
-		regfree (&regex3);
-		ksDel (ks);
 		return ERROR;
 	}
 
-	startPos = m[1].rm_so;
-	endPos = m[1].rm_eo;
-	thenexpr = elektraMalloc (endPos - startPos + 1);
-	strncpy (thenexpr, conditionString + startPos, endPos - startPos);
-	thenexpr[endPos - startPos] = '\0';
-
-	nomatch = regexec (&regex3, conditionString, subMatches, m, 0);
-	if (!nomatch)
-	{
-		if (m[1].rm_so == -1)
-		{
-			ELEKTRA_SET_ERRORF (134, parentKey,
-					    "Invalid syntax: \"%s\". Check kdb info conditionals for additional information",
-					    conditionString);
-			regfree (&regex1);
-			regfree (&regex2);
-			regfree (&regex3);
-			ksDel (ks);
-			return ERROR;
-		}
-		thenexpr[strlen (thenexpr) - ((m[0].rm_eo - m[0].rm_so))] = '\0';
-		startPos = m[1].rm_so;
-		endPos = m[1].rm_eo;
-		elseexpr = elektraMalloc (endPos - startPos + 1);
-		strncpy (elseexpr, conditionString + startPos, endPos - startPos);
-		elseexpr[endPos - startPos] = '\0';
-	}
-
-	ret = parseCondition (key, condition, suffixList, ks, parentKey);
+	CondResult ret = evalExpression (&compiled->ifExpr, key, suffixList, ks, parentKey);
 	if (ret == TRUE)
 	{
 		if (op == ASSIGN)
 		{
-			const char * assign = isAssign (key, thenexpr, parentKey, ks);
-			if (assign != NULL)
-			{
-				keySetString (key, assign);
-				ret = TRUE;
-				goto CleanUp;
-			}
-			else
-			{
-				ret = ERROR;
-				goto CleanUp;
-			}
+			ret = assignExpression (key, compiled->thenexpr, parentKey, ks);
 		}
 		else
 		{
-			ret = parseCondition (key, thenexpr, suffixList, ks, parentKey);
+			ret = evalExpression (&compiled->thenExpr, key, suffixList, ks, parentKey);
 			if (ret == FALSE)
 			{
 				ELEKTRA_SET_ERRORF (135, parentKey, "Validation of Key %s: %s failed. (%s failed)",
-						    keyName (key) + strlen (keyName (parentKey)) + 1, conditionString, thenexpr);
+						    keyName (key) + strlen (keyName (parentKey)) + 1, conditionString, compiled->thenexpr);
 			}
 			else if (ret == ERROR)
 			{
 				ELEKTRA_SET_ERRORF (134, parentKey,
 						    "Invalid syntax: \"%s\". Check kdb info conditionals for additional information",
-						    thenexpr);
+						    compiled->thenexpr);
 			}
 		}
 	}
 	else if (ret == FALSE)
 	{
-		if (elseexpr)
+		if (compiled->elseexpr)
 		{
 			if (op == ASSIGN)
 			{
-				const char * assign = isAssign (key, elseexpr, parentKey, ks);
-				if (assign != NULL)
-				{
-					keySetString (key, assign);
-					ret = TRUE;
-					goto CleanUp;
-				}
-				else
-				{
-					ret = ERROR;
-					goto CleanUp;
-				}
+				ret = assignExpression (key, compiled->elseexpr, parentKey, ks);
 			}
 			else
 			{
-				ret = parseCondition (key, elseexpr, suffixList, ks, parentKey);
+				ret = evalExpression (&compiled->elseExpr, key, suffixList, ks, parentKey);
 
 				if (ret == FALSE)
 				{
 					ELEKTRA_SET_ERRORF (135, parentKey, "Validation of Key %s: %s failed. (%s failed)",
-							    keyName (key) + strlen (keyName (parentKey)) + 1, conditionString, elseexpr);
+							    keyName (key) + strlen (keyName (parentKey)) + 1, conditionString,
+							    compiled->elseexpr);
 				}
 				else if (ret == ERROR)
 				{
 					ELEKTRA_SET_ERRORF (
 						134, parentKey,
-						"Invalid syntax: \"%s\". Check kdb info conditionals for additional information", elseexpr);
+						"Invalid syntax: \"%s\". Check kdb info conditionals for additional information",
+						compiled->elseexpr);
 				}
 			}
 		}
@@ -798,24 +949,17 @@ static CondResult parseConditionString (const Key * meta, const Key * suffixList
 	else if (ret == ERROR)
 	{
 		ELEKTRA_SET_ERRORF (134, parentKey, "Invalid syntax: \"%s\". Check kdb info conditionals for additional information",
-				    condition);
+				    compiled->condition);
 	}
 
-CleanUp:
-	elektraFree (condition);
-	elektraFree (thenexpr);
-	if (elseexpr) elektraFree (elseexpr);
-	regfree (&regex1);
-	regfree (&regex2);
-	regfree (&regex3);
-	ksDel (ks);
 	return ret;
 }
 
-static CondResult evaluateKey (const Key * meta, const Key * suffixList, Key * parentKey, Key * key, KeySet * ks, Operation op)
+static CondResult evaluateKey (ConditionalsData * data, const Key * meta, const Key * suffixList, Key * parentKey, Key * key, KeySet * ks,
+			       Operation op)
 {
 	CondResult result;
-	result = parseConditionString (meta, suffixList, parentKey, key, ksDup (ks), op);
+	result = parseConditionString (data, meta, suffixList, parentKey, key, ks, op);
 	if (result == ERROR)
 	{
 		return ERROR;
@@ -835,7 +979,8 @@ static CondResult evaluateKey (const Key * meta, const Key * suffixList, Key * p
 	return TRUE;
 }
 
-static CondResult evalMultipleConditions (Key * key, const Key * meta, const Key * suffixList, Key * parentKey, KeySet * returned)
+static CondResult evalMultipleConditions (ConditionalsData * data, Key * key, const Key * meta, const Key * suffixList, Key * parentKey,
+					  KeySet * ks)
 {
 	int countSucceeded = 0;
 	int countFailed = 0;
@@ -846,7 +991,7 @@ static CondResult evalMultipleConditions (Key * key, const Key * meta, const Key
 	while ((c = ksNext (condKS)) != NULL)
 	{
 		if (!keyCmp (c, meta)) continue;
-		result = evaluateKey (c, suffixList, parentKey, key, returned, CONDITION);
+		result = evaluateKey (data, c, suffixList, parentKey, key, ks, CONDITION);
 		if (result == TRUE)
 			++countSucceeded;
 		else if (result == ERROR)
@@ -881,21 +1026,14 @@ static CondResult evalMultipleConditions (Key * key, const Key * meta, const Key
 	}
 }
 
-int elektraConditionalsGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_UNUSED, Key * parentKey ELEKTRA_UNUSED)
+static CondResult evaluateConditions (ConditionalsData * data, KeySet * returned, Key * parentKey)
 {
-	if (!strcmp (keyName (parentKey), "system/elektra/modules/conditionals"))
+	// lookups move the cursor and might add keys, so they are done in a copy of returned
+	KeySet * ks = ksDup (returned);
+	if (!ks)
 	{
-		KeySet * contract = ksNew (
-			30, keyNew ("system/elektra/modules/conditionals", KEY_VALUE, "conditionals plugin waits for your orders", KEY_END),
-			keyNew ("system/elektra/modules/conditionals/exports", KEY_END),
-			keyNew ("system/elektra/modules/conditionals/exports/get", KEY_FUNC, elektraConditionalsGet, KEY_END),
-			keyNew ("system/elektra/modules/conditionals/exports/set", KEY_FUNC, elektraConditionalsSet, KEY_END),
-#include ELEKTRA_README (conditionals)
-			keyNew ("system/elektra/modules/conditionals/infos/version", KEY_VALUE, PLUGINVERSION, KEY_END), KS_END);
-		ksAppend (returned, contract);
-		ksDel (contract);
-
-		return 1; /* success */
+		ELEKTRA_SET_ERROR (87, parentKey, "Out of memory");
+		return ERROR;
 	}
 	Key * cur;
 	ksRewind (returned);
@@ -913,7 +1051,7 @@ int elektraConditionalsGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned EL
 		{
 			CondResult result;
 
-			result = evaluateKey (conditionMeta, suffixList, parentKey, cur, returned, CONDITION);
+			result = evaluateKey (data, conditionMeta, suffixList, parentKey, cur, ks, CONDITION);
 			if (result == NOEXPR)
 			{
 				ret |= TRUE;
@@ -926,19 +1064,19 @@ int elektraConditionalsGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned EL
 		else if (allConditionMeta)
 		{
 			CondResult result;
-			result = evalMultipleConditions (cur, allConditionMeta, suffixList, parentKey, returned);
+			result = evalMultipleConditions (data, cur, allConditionMeta, suffixList, parentKey, ks);
 			ret |= result;
 		}
 		else if (anyConditionMeta)
 		{
 			CondResult result;
-			result = evalMultipleConditions (cur, anyConditionMeta, suffixList, parentKey, returned);
+			result = evalMultipleConditions (data, cur, anyConditionMeta, suffixList, parentKey, ks);
 			ret |= result;
 		}
 		else if (noneConditionMeta)
 		{
 			CondResult result;
-			result = evalMultipleConditions (cur, noneConditionMeta, suffixList, parentKey, returned);
+			result = evalMultipleConditions (data, cur, noneConditionMeta, suffixList, parentKey, ks);
 			ret |= result;
 		}
 
@@ -951,7 +1089,7 @@ int elektraConditionalsGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned EL
 				while ((a = ksNext (assignKS)) != NULL)
 				{
 					if (keyCmp (a, assignMeta) == 0) continue;
-					CondResult result = evaluateKey (a, suffixList, parentKey, cur, returned, ASSIGN);
+					CondResult result = evaluateKey (data, a, suffixList, parentKey, cur, ks, ASSIGN);
 					if (result == TRUE)
 					{
 						ret |= TRUE;
@@ -970,102 +1108,108 @@ int elektraConditionalsGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned EL
 			}
 			else
 			{
-				ret |= evaluateKey (assignMeta, suffixList, parentKey, cur, returned, ASSIGN);
+				ret |= evaluateKey (data, assignMeta, suffixList, parentKey, cur, ks, ASSIGN);
 			}
 		}
 	}
+	ksDel (ks);
 	if (ret == TRUE) keySetMeta (parentKey, "error", 0);
-	return ret; /* success */
+	return ret;
 }
 
+int elektraConditionalsOpen (Plugin * handle, Key * errorKey)
+{
+	ConditionalsData * data = elektraCalloc (sizeof (ConditionalsData));
+	if (!data)
+	{
+		ELEKTRA_SET_ERROR (87, errorKey, "Out of memory");
+		return -1;
+	}
+	// the regexes compile so the only possible error would be out of memory
+	if (regcomp (&data->groupRegex, "((\\(([^\\(\\)]*)\\)))", REG_EXTENDED | REG_NEWLINE))
+	{
+		goto error;
+	}
+	if (regcomp (&data->ifRegex, "(\\(((.*)?)\\))[[:space:]]*\\?", REGEX_FLAGS_CONDITION))
+	{
+		regfree (&data->groupRegex);
+		goto error;
+	}
+	if (regcomp (&data->thenRegex, "\\?[[:space:]]*(\\(((.*)?)\\))", REGEX_FLAGS_CONDITION))
+	{
+		regfree (&data->groupRegex);
+		regfree (&data->ifRegex);
+		goto error;
+	}
+	if (regcomp (&data->elseRegex, "[[:space:]]*:[[:space:]]*(\\(((.*)?)\\))", REGEX_FLAGS_CONDITION))
+	{
+		regfree (&data->groupRegex);
+		regfree (&data->ifRegex);
+		regfree (&data->thenRegex);
+		goto error;
+	}
+	elektraPluginSetData (handle, data);
+	return 1; /* success */
 
-int elektraConditionalsSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_UNUSED, Key * parentKey ELEKTRA_UNUSED)
+error:
+	ELEKTRA_SET_ERROR (87, errorKey, "Couldn't compile regex: most likely out of memory");
+	elektraFree (data);
+	return -1;
+}
+
+int elektraConditionalsClose (Plugin * handle, Key * errorKey ELEKTRA_UNUSED)
 {
-	Key * cur;
-	ksRewind (returned);
-	CondResult ret = FALSE;
-	while ((cur = ksNext (returned)) != NULL)
+	ConditionalsData * data = elektraPluginGetData (handle);
+	if (!data) return 1;
+
+	for (size_t i = 0; i < data->size; ++i)
 	{
-		Key * conditionMeta = (Key *)keyGetMeta (cur, "check/condition");
-		Key * assignMeta = (Key *)keyGetMeta (cur, "assign/condition");
-		Key * suffixList = (Key *)keyGetMeta (cur, "condition/validsuffix");
-		Key * anyConditionMeta = (Key *)keyGetMeta (cur, "check/condition/any");
-		Key * allConditionMeta = (Key *)keyGetMeta (cur, "check/condition/all");
-		Key * noneConditionMeta = (Key *)keyGetMeta (cur, "check/condition/none");
+		freeCondition (data->conditions[i]);
+	}
+	if (data->conditions) elektraFree (data->conditions);
+	regfree (&data->groupRegex);
+	regfree (&data->ifRegex);
+	regfree (&data->thenRegex);
+	regfree (&data->elseRegex);
+	elektraFree (data);
+	elektraPluginSetData (handle, 0);
 
-		if (conditionMeta)
-		{
-			CondResult result;
+	return 1; /* success */
+}
 
-			result = evaluateKey (conditionMeta, suffixList, parentKey, cur, returned, CONDITION);
-			if (result == NOEXPR)
-			{
-				ret |= TRUE;
-			}
-			else
-			{
-				ret |= result;
-			}
-		}
-		else if (allConditionMeta)
-		{
-			CondResult result;
-			result = evalMultipleConditions (cur, allConditionMeta, suffixList, parentKey, returned);
-			ret |= result;
-		}
-		else if (anyConditionMeta)
-		{
-			CondResult result;
-			result = evalMultipleConditions (cur, anyConditionMeta, suffixList, parentKey, returned);
-			ret |= result;
-		}
-		else if (noneConditionMeta)
-		{
-			CondResult result;
-			result = evalMultipleConditions (cur, noneConditionMeta, suffixList, parentKey, returned);
-			ret |= result;
-		}
+int elektraConditionalsGet (Plugin * handle, KeySet * returned, Key * parentKey)
+{
+	if (!strcmp (keyName (parentKey), "system/elektra/modules/conditionals"))
+	{
+		KeySet * contract = ksNew (
+			30, keyNew ("system/elektra/modules/conditionals", KEY_VALUE, "conditionals plugin waits for your orders", KEY_END),
+			keyNew ("system/elektra/modules/conditionals/exports", KEY_END),
+			keyNew ("system/elektra/modules/conditionals/exports/open", KEY_FUNC, elektraConditionalsOpen, KEY_END),
+			keyNew ("system/elektra/modules/conditionals/exports/close", KEY_FUNC, elektraConditionalsClose, KEY_END),
+			keyNew ("system/elektra/modules/conditionals/exports/get", KEY_FUNC, elektraConditionalsGet, KEY_END),
+			keyNew ("system/elektra/modules/conditionals/exports/set", KEY_FUNC, elektraConditionalsSet, KEY_END),
+#include ELEKTRA_README (conditionals)
+			keyNew ("system/elektra/modules/conditionals/infos/version", KEY_VALUE, PLUGINVERSION, KEY_END), KS_END);
+		ksAppend (returned, contract);
+		ksDel (contract);
 
-		if (assignMeta)
-		{
-			if (keyString (assignMeta)[0] == '#')
-			{
-				KeySet * assignKS = elektraMetaArrayToKS (cur, "assign/condition");
-				Key * a;
-				while ((a = ksNext (assignKS)) != NULL)
-				{
-					if (keyCmp (a, assignMeta) == 0) continue;
-					CondResult result = evaluateKey (a, suffixList, parentKey, cur, returned, ASSIGN);
-					if (result == TRUE)
-					{
-						ret |= TRUE;
-						break;
-					}
-					else if (result == NOEXPR)
-					{
-						ret |= TRUE;
-					}
-					else
-					{
-						ret |= ERROR;
-					}
-				}
-				ksDel (assignKS);
-			}
-			else
-			{
-				ret |= evaluateKey (assignMeta, suffixList, parentKey, cur, returned, ASSIGN);
-			}
-		}
+		return 1; /* success */
 	}
-	if (ret == TRUE) keySetMeta (parentKey, "error", 0);
-	return ret;
+	return evaluateConditions (elektraPluginGetData (handle), returned, parentKey);
+}
+
+
+int elektraConditionalsSet (Plugin * handle, KeySet * returned, Key * parentKey)
+{
+	return evaluateConditions (elektraPluginGetData (handle), returned, parentKey);
 }
 
 Plugin * ELEKTRA_PLUGIN_EXPORT (conditionals)
 {
 	// clang-format off
     return elektraPluginExport ("conditionals",
+	    ELEKTRA_PLUGIN_OPEN, &elektraConditionalsOpen,
+	    ELEKTRA_PLUGIN_CLOSE, &elektraConditionalsClose,
 	    ELEKTRA_PLUGIN_GET, &elektraConditionalsGet,
 	    ELEKTRA_PLUGIN_SET, &elektraConditionalsSet,
 	    ELEKTRA_PLUGIN_END);
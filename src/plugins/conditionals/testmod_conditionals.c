@@ -627,6 +627,29 @@ static void test_multiAssign3 (void)
 	PLUGIN_CLOSE ();
 }
 
+static void test_sharedCondition (void)
+{
+	const char * condition = "((../enabled == '1') && (./ > '2')) ? (./ < '10')";
+	Key * parentKey = keyNew ("user/tests/conditionals", KEY_VALUE, "", KEY_END);
+	KeySet * ks = ksNew (5, keyNew ("user/tests/conditionals/a/value", KEY_VALUE, "5", KEY_META, "check/condition", condition, KEY_END),
+			     keyNew ("user/tests/conditionals/a/enabled", KEY_VALUE, "1", KEY_END),
+			     keyNew ("user/tests/conditionals/b/value", KEY_VALUE, "50", KEY_META, "check/condition", condition, KEY_END),
+			     keyNew ("user/tests/conditionals/b/enabled", KEY_VALUE, "0", KEY_END), KS_END);
+
+	KeySet * conf = ksNew (0, KS_END);
+	PLUGIN_OPEN ("conditionals");
+	// the parsed condition is reused for every key and every call
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) == 1, "error");
+	keySetString (ksLookupByName (ks, "user/tests/conditionals/b/enabled", 0), "1");
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) == -1, "validation of b/value should fail");
+	keySetString (ksLookupByName (ks, "user/tests/conditionals/b/value", 0), "7");
+	keySetMeta (parentKey, "error", 0);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "error");
+	ksDel (ks);
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
 int main (int argc, char ** argv)
 {
 	printf ("CONDITIONALS     TESTS\n");
@@ -668,6 +691,7 @@ int main (int argc, char ** argv)
 	test_multiCond2NoFail ();
 	test_multiAssign2 ();
 	test_multiAssign3 ();
+	test_sharedCondition ();
 	print_result ("testmod_conditionals");
 
 	return nbError;
@@ -25,8 +25,9 @@ using std::unique_ptr;
 
 extern "C" {
 
-#include "botan_operations.h"
 #include "crypto.h"
+
+#include "botan_operations.h"
 #include "gpg.h"
 #include "helper.h"
 #include <base64_functions.h>
@@ -35,53 +36,85 @@ extern "C" {
 #include <string.h>
 
 /**
- * @brief derive the cryptographic key and IV for a given (Elektra) Key k
+ * @brief derive the cryptographic material from the master password, unless it has already been derived from the same salt.
  * @param config KeySet holding the plugin/backend configuration
  * @param errorKey holds an error description in case of failure
  * @param masterKey holds the decrypted master password from the plugin configuration
+ * @param batch holds the cryptographic material of the current kdbGet() or kdbSet()
+ * @param salt the salt for the key derivation
+ * @param saltLen the length of the salt
+ * @retval -1 on failure. errorKey holds the error description.
+ * @retval 1 on success
+ */
+static int deriveKey (KeySet * config, Key * errorKey, Key * masterKey, CryptoBatch * batch, const kdb_octet_t * salt,
+		      kdb_unsigned_long_t saltLen)
+{
+	const size_t requiredKeyBytes = ELEKTRA_CRYPTO_BOTAN_KEYSIZE + ELEKTRA_CRYPTO_BOTAN_BLOCKSIZE;
+
+	if (CRYPTO_PLUGIN_FUNCTION (batchHasSalt) (batch, salt, saltLen))
+	{
+		return 1;
+	}
+
+	// read iteration count
+	const kdb_unsigned_long_t iterations = CRYPTO_PLUGIN_FUNCTION (getIterationCount) (errorKey, config);
+
+	try
+	{
+		// generate/derive the cryptographic key and the IV
+		PKCS5_PBKDF2 pbkdf (new HMAC (new SHA_256));
+		OctetString derived = pbkdf.derive_key (
+			requiredKeyBytes, std::string (reinterpret_cast<const char *> (keyValue (masterKey)), keyGetValueSize (masterKey)),
+			salt, saltLen, iterations);
+		memcpy (batch->derived, derived.begin (), requiredKeyBytes);
+	}
+	catch (std::exception & e)
+	{
+		ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_CRYPTO_INIT, errorKey, "Failed to derive a cryptographic key because: %s", e.what ());
+		batch->saltLen = 0;
+		return -1;
+	}
+
+	CRYPTO_PLUGIN_FUNCTION (batchSetSalt) (batch, salt, saltLen);
+	return 1;
+}
+
+/**
+ * @brief derive the cryptographic key and generate the IV for a given (Elektra) Key k
+ * @param config KeySet holding the plugin/backend configuration
+ * @param errorKey holds an error description in case of failure
+ * @param masterKey holds the decrypted master password from the plugin configuration
+ * @param batch holds the cryptographic material shared by all Keys of the current kdbSet()
  * @param k the (Elektra)-Key to be encrypted
  * @param cKey holds a unique pointer to an allocated SymmetricKey.
  * @param cIv holds a unique pointer to an allocated InitializationVector.
  * @retval -1 on failure. errorKey holds the error description.
  * @retval 1 on success
  */
-static int getKeyIvForEncryption (KeySet * config, Key * errorKey, Key * masterKey, Key * k, unique_ptr<SymmetricKey> & cKey,
-				  unique_ptr<InitializationVector> & cIv)
+static int getKeyIvForEncryption (KeySet * config, Key * errorKey, Key * masterKey, CryptoBatch * batch, Key * k,
+				  unique_ptr<SymmetricKey> & cKey, unique_ptr<InitializationVector> & cIv)
 {
-	byte salt[ELEKTRA_CRYPTO_DEFAULT_SALT_LEN];
-	char * saltHexString = NULL;
-	const size_t requiredKeyBytes = ELEKTRA_CRYPTO_BOTAN_KEYSIZE + ELEKTRA_CRYPTO_BOTAN_BLOCKSIZE;
+	byte iv[ELEKTRA_CRYPTO_BOTAN_BLOCKSIZE];
 
 	ELEKTRA_ASSERT (masterKey != NULL, "Parameter `masterKey` must not be NULL");
 
 	try
 	{
-		// generate the salt
 		AutoSeeded_RNG rng;
-		rng.randomize (salt, sizeof (salt));
-		saltHexString = ELEKTRA_PLUGIN_FUNCTION (ELEKTRA_PLUGIN_NAME_C, base64Encode) (salt, sizeof (salt));
-		if (!saltHexString)
+
+		// generate the salt once per kdbSet()
+		if (!batch->saltLen)
 		{
-			ELEKTRA_SET_ERROR (87, errorKey, "Memory allocation failed");
-			return -1;
+			byte salt[ELEKTRA_CRYPTO_DEFAULT_SALT_LEN];
+			rng.randomize (salt, sizeof (salt));
+			if (deriveKey (config, errorKey, masterKey, batch, salt, sizeof (salt)) != 1)
+			{
+				return -1;
+			}
 		}
-		keySetMeta (k, ELEKTRA_CRYPTO_META_SALT, saltHexString);
-		elektraFree (saltHexString);
-
-		// read iteration count
-		const kdb_unsigned_long_t iterations = CRYPTO_PLUGIN_FUNCTION (getIterationCount) (errorKey, config);
-
-		// generate/derive the cryptographic key and the IV
-		PKCS5_PBKDF2 pbkdf (new HMAC (new SHA_256));
-		OctetString derived = pbkdf.derive_key (
-			requiredKeyBytes, std::string (reinterpret_cast<const char *> (keyValue (masterKey)), keyGetValueSize (masterKey)),
-			salt, sizeof (salt), iterations);
 
-		cKey = unique_ptr<SymmetricKey> (new SymmetricKey (derived.begin (), ELEKTRA_CRYPTO_BOTAN_KEYSIZE));
-		cIv = unique_ptr<InitializationVector> (
-			new InitializationVector (derived.begin () + ELEKTRA_CRYPTO_BOTAN_KEYSIZE, ELEKTRA_CRYPTO_BOTAN_BLOCKSIZE));
-
-		return 1;
+		// generate the IV for every Key
+		rng.randomize (iv, sizeof (iv));
 	}
 	catch (std::exception & e)
 	{
@@ -89,6 +122,15 @@ static int getKeyIvForEncryption (KeySet * config, Key * errorKey, Key * masterK
 				    e.what ());
 		return -1;
 	}
+
+	if (CRYPTO_PLUGIN_FUNCTION (setSaltMetakey) (errorKey, k, batch->salt, batch->saltLen, iv, sizeof (iv)) != 1)
+	{
+		return -1; // error set by CRYPTO_PLUGIN_FUNCTION(setSaltMetakey)()
+	}
+
+	cKey = unique_ptr<SymmetricKey> (new SymmetricKey (batch->derived, ELEKTRA_CRYPTO_BOTAN_KEYSIZE));
+	cIv = unique_ptr<InitializationVector> (new InitializationVector (iv, ELEKTRA_CRYPTO_BOTAN_BLOCKSIZE));
+	return 1;
 }
 
 /**
@@ -96,42 +138,43 @@ static int getKeyIvForEncryption (KeySet * config, Key * errorKey, Key * masterK
  * @param config KeySet holding the plugin/backend configuration
  * @param errorKey holds an error description in case of failure
  * @param masterKey holds the decrypted master password from the plugin configuration
+ * @param batch holds the cryptographic material derived during the current kdbGet()
  * @param k the (Elektra)-Key to be encrypted
  * @param cKey holds a unique pointer to an allocated SymmetricKey.
  * @param cIv holds a unique pointer to an allocated InitializationVector.
  * @retval -1 on failure. errorKey holds the error description.
  * @retval 1 on success
  */
-static int getKeyIvForDecryption (KeySet * config, Key * errorKey, Key * masterKey, Key * k, unique_ptr<SymmetricKey> & cKey,
-				  unique_ptr<InitializationVector> & cIv)
+static int getKeyIvForDecryption (KeySet * config, Key * errorKey, Key * masterKey, CryptoBatch * batch, Key * k,
+				  unique_ptr<SymmetricKey> & cKey, unique_ptr<InitializationVector> & cIv)
 {
-	const size_t requiredKeyBytes = ELEKTRA_CRYPTO_BOTAN_KEYSIZE + ELEKTRA_CRYPTO_BOTAN_BLOCKSIZE;
 	kdb_octet_t * saltBuffer;
 	kdb_unsigned_long_t saltBufferLen = 0;
+	kdb_octet_t * iv = NULL;
 
 	ELEKTRA_ASSERT (masterKey != NULL, "Parameter `masterKey` must not be NULL");
 
-	// get the salt
+	// get the salt and the IV
 	if (CRYPTO_PLUGIN_FUNCTION (getSaltFromPayload) (errorKey, k, &saltBuffer, &saltBufferLen) != 1)
 	{
 		return -1; // error set by CRYPTO_PLUGIN_FUNCTION(getSaltFromPayload)()
 	}
+	if (CRYPTO_PLUGIN_FUNCTION (getIvFromPayload) (errorKey, k, &saltBufferLen, &iv, ELEKTRA_CRYPTO_BOTAN_BLOCKSIZE) != 1)
+	{
+		return -1; // error set by CRYPTO_PLUGIN_FUNCTION(getIvFromPayload)()
+	}
 
-	// get the iteration count
-	const kdb_unsigned_long_t iterations = CRYPTO_PLUGIN_FUNCTION (getIterationCount) (errorKey, config);
+	// derive the cryptographic key and the IV
+	if (deriveKey (config, errorKey, masterKey, batch, saltBuffer, saltBufferLen) != 1)
+	{
+		return -1;
+	}
 
 	try
 	{
-		// derive the cryptographic key and the IV
-		PKCS5_PBKDF2 pbkdf (new HMAC (new SHA_256));
-		OctetString derived = pbkdf.derive_key (
-			requiredKeyBytes, std::string (reinterpret_cast<const char *> (keyValue (masterKey)), keyGetValueSize (masterKey)),
-			saltBuffer, saltBufferLen, iterations);
-
-		cKey = unique_ptr<SymmetricKey> (new SymmetricKey (derived.begin (), ELEKTRA_CRYPTO_BOTAN_KEYSIZE));
+		cKey = unique_ptr<SymmetricKey> (new SymmetricKey (batch->derived, ELEKTRA_CRYPTO_BOTAN_KEYSIZE));
 		cIv = unique_ptr<InitializationVector> (
-			new InitializationVector (derived.begin () + ELEKTRA_CRYPTO_BOTAN_KEYSIZE, ELEKTRA_CRYPTO_BOTAN_BLOCKSIZE));
-
+			new InitializationVector (iv ? iv : batch->derived + ELEKTRA_CRYPTO_BOTAN_KEYSIZE, ELEKTRA_CRYPTO_BOTAN_BLOCKSIZE));
 		return 1;
 	}
 	catch (std::exception & e)
@@ -156,12 +199,12 @@ int elektraCryptoBotanInit (Key * errorKey)
 	return 1; // success
 }
 
-int elektraCryptoBotanEncrypt (KeySet * pluginConfig, Key * k, Key * errorKey, Key * masterKey)
+int elektraCryptoBotanEncrypt (KeySet * pluginConfig, Key * k, Key * errorKey, Key * masterKey, CryptoBatch * batch)
 {
 	// get cryptographic material
 	unique_ptr<SymmetricKey> cryptoKey;
 	unique_ptr<InitializationVector> cryptoIv;
-	if (getKeyIvForEncryption (pluginConfig, errorKey, masterKey, k, cryptoKey, cryptoIv) != 1)
+	if (getKeyIvForEncryption (pluginConfig, errorKey, masterKey, batch, k, cryptoKey, cryptoIv) != 1)
 	{
 		return -1;
 	}
@@ -243,12 +286,12 @@ int elektraCryptoBotanEncrypt (KeySet * pluginConfig, Key * k, Key * errorKey, K
 	return 1; // success
 }
 
-int elektraCryptoBotanDecrypt (KeySet * pluginConfig, Key * k, Key * errorKey, Key * masterKey)
+int elektraCryptoBotanDecrypt (KeySet * pluginConfig, Key * k, Key * errorKey, Key * masterKey, CryptoBatch * batch)
 {
 	// get cryptographic material
 	unique_ptr<SymmetricKey> cryptoKey;
 	unique_ptr<InitializationVector> cryptoIv;
-	if (getKeyIvForDecryption (pluginConfig, errorKey, masterKey, k, cryptoKey, cryptoIv) != 1)
+	if (getKeyIvForDecryption (pluginConfig, errorKey, masterKey, batch, k, cryptoKey, cryptoIv) != 1)
 	{
 		return -1;
 	}
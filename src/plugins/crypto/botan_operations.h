@@ -19,7 +19,7 @@
 
 char * elektraCryptoBotanCreateRandomString (Key * errorKey, const kdb_unsigned_short_t length);
 int elektraCryptoBotanInit (Key * errorKey);
-int elektraCryptoBotanEncrypt (KeySet * pluginConfig, Key * k, Key * errorKey, Key * masterKey);
-int elektraCryptoBotanDecrypt (KeySet * pluginConfig, Key * k, Key * errorKey, Key * masterKey);
+int elektraCryptoBotanEncrypt (KeySet * pluginConfig, Key * k, Key * errorKey, Key * masterKey, CryptoBatch * batch);
+int elektraCryptoBotanDecrypt (KeySet * pluginConfig, Key * k, Key * errorKey, Key * masterKey, CryptoBatch * batch);
 
 #endif
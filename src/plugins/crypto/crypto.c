@@ -28,6 +28,7 @@
 #include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 
 static pthread_mutex_t mutex_ref_cnt = PTHREAD_MUTEX_INITIALIZER;
 static unsigned int ref_cnt = 0;
@@ -90,9 +91,10 @@ static int checkPayloadVersion (Key * k, Key * errorKey)
 		return 0; // failure
 	}
 
-	// check the version
+	// check the version, payloads written with a salt per Key are still supported
 	const size_t versionOffset = ELEKTRA_CRYPTO_MAGIC_NUMBER_LEN - 2;
-	if (memcmp (&value[versionOffset], ELEKTRA_CRYPTO_PAYLOAD_VERSION, 2))
+	if (memcmp (&value[versionOffset], ELEKTRA_CRYPTO_PAYLOAD_VERSION, 2) &&
+	    memcmp (&value[versionOffset], ELEKTRA_CRYPTO_PAYLOAD_VERSION_PER_KEY_SALT, 2))
 	{
 		ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_CRYPTO_VERSION, errorKey, "%s", keyName (k));
 		return 0; // failure
@@ -199,6 +201,113 @@ static void elektraCryptoSafelyReleaseKey (Key * key)
 	}
 }
 
+/**
+ * @brief zeroes and releases the cached master password of a plugin instance.
+ * @param data of the plugin instance
+ */
+static void elektraCryptoForgetMasterPassword (CryptoData * data)
+{
+	if (!data->masterPassword) return;
+
+	ssize_t length = keyGetValueSize (data->masterPassword);
+	void * value = (void *)keyValue (data->masterPassword);
+	memset (value, 0, length);
+	munlock (value, length);
+	keyDel (data->masterPassword);
+	data->masterPassword = NULL;
+}
+
+#if defined(ELEKTRA_CRYPTO_API_GCRYPT) || defined(ELEKTRA_CRYPTO_API_OPENSSL) || defined(ELEKTRA_CRYPTO_API_BOTAN)
+
+/**
+ * @brief read the plugin configuration for how long the decrypted master password may be cached.
+ * @param errorKey may hold a warning if the provided configuration is invalid
+ * @param conf the plugin configuration
+ * @return the number of seconds the master password may be cached, 0 if it must not be cached
+ */
+static kdb_unsigned_long_t elektraCryptoGetMasterPasswordTtl (Key * errorKey, KeySet * conf)
+{
+	Key * k = ksLookupByName (conf, ELEKTRA_CRYPTO_PARAM_MASTER_PASSWORD_TTL, 0);
+	if (k)
+	{
+		char * end;
+		const kdb_unsigned_long_t ttl = strtoul (keyString (k), &end, 10);
+		if (*keyString (k) != '\0' && *end == '\0')
+		{
+			return ttl;
+		}
+		else
+		{
+			ELEKTRA_ADD_WARNING (ELEKTRA_WARNING_CRYPTO_CONFIG, errorKey,
+					     "Master password TTL provided at " ELEKTRA_CRYPTO_PARAM_MASTER_PASSWORD_TTL
+					     " is invalid. Using default value instead.");
+		}
+	}
+	return ELEKTRA_CRYPTO_DEFAULT_MASTER_PWD_TTL;
+}
+
+/**
+ * @brief returns the current time of the monotonic clock in seconds.
+ */
+static time_t elektraCryptoNow (void)
+{
+	struct timespec now;
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	return now.tv_sec;
+}
+
+/**
+ * @brief get the decrypted master password of a plugin instance.
+ *
+ * Decrypting the master password means calling the gpg binary. If configured, the decrypted
+ * master password is kept in memory that is locked against swapping for a limited time,
+ * so that subsequent calls do not need to call gpg.
+ *
+ * @param handle for the current plugin instance
+ * @param errorKey holds an error description in case of failure
+ * @returns the decrypted master password as (Elektra) Key or NULL in case of error.
+ * Must be released with elektraCryptoSafelyReleaseKey().
+ */
+static Key * elektraCryptoGetMasterPassword (Plugin * handle, Key * errorKey)
+{
+	CryptoData * data = elektraPluginGetData (handle);
+	if (data && data->masterPassword)
+	{
+		if (elektraCryptoNow () < data->expires)
+		{
+			return keyDup (data->masterPassword);
+		}
+		elektraCryptoForgetMasterPassword (data);
+	}
+
+	KeySet * pluginConfig = elektraPluginGetConfig (handle);
+	Key * masterKey = CRYPTO_PLUGIN_FUNCTION (getMasterPassword) (errorKey, pluginConfig);
+	if (!masterKey || !data)
+	{
+		return masterKey;
+	}
+
+	const kdb_unsigned_long_t ttl = elektraCryptoGetMasterPasswordTtl (errorKey, pluginConfig);
+	if (ttl == 0)
+	{
+		return masterKey;
+	}
+
+	Key * cached = keyDup (masterKey);
+	const ssize_t length = keyGetValueSize (cached);
+	if (length <= 0 || mlock (keyValue (cached), length) != 0)
+	{
+		// the master password is not cached in memory that might be swapped out
+		elektraCryptoSafelyReleaseKey (cached);
+		return masterKey;
+	}
+	data->masterPassword = cached;
+	data->expires = elektraCryptoNow () + ttl;
+	return masterKey;
+}
+
+#endif
+
 /**
  * @brief encrypt the (Elektra) Keys contained in data.
  * @param handle for the current plugin instance
@@ -211,10 +320,11 @@ static int elektraCryptoEncrypt (Plugin * handle ELEKTRA_UNUSED, KeySet * data E
 {
 	Key * k;
 	Key * masterKey = NULL;
+	CryptoBatch batch = { .saltLen = 0 }; // shares the derived cryptographic key among the Keys of data
 
 #if defined(ELEKTRA_CRYPTO_API_GCRYPT) || defined(ELEKTRA_CRYPTO_API_OPENSSL) || defined(ELEKTRA_CRYPTO_API_BOTAN)
 	KeySet * pluginConfig = elektraPluginGetConfig (handle);
-	masterKey = CRYPTO_PLUGIN_FUNCTION (getMasterPassword) (errorKey, pluginConfig);
+	masterKey = elektraCryptoGetMasterPassword (handle, errorKey);
 	if (!masterKey)
 	{
 		goto error; // error has been set by getMasterPassword
@@ -235,7 +345,7 @@ static int elektraCryptoEncrypt (Plugin * handle ELEKTRA_UNUSED, KeySet * data E
 
 #if defined(ELEKTRA_CRYPTO_API_GCRYPT)
 
-		if (elektraCryptoGcryHandleCreate (&cryptoHandle, pluginConfig, errorKey, masterKey, k, ELEKTRA_CRYPTO_ENCRYPT) != 1)
+		if (elektraCryptoGcryHandleCreate (&cryptoHandle, pluginConfig, errorKey, masterKey, &batch, k, ELEKTRA_CRYPTO_ENCRYPT) != 1)
 		{
 			goto error;
 		}
@@ -251,7 +361,7 @@ static int elektraCryptoEncrypt (Plugin * handle ELEKTRA_UNUSED, KeySet * data E
 
 #elif defined(ELEKTRA_CRYPTO_API_OPENSSL)
 
-		if (elektraCryptoOpenSSLHandleCreate (&cryptoHandle, pluginConfig, errorKey, masterKey, k, ELEKTRA_CRYPTO_ENCRYPT) != 1)
+		if (elektraCryptoOpenSSLHandleCreate (&cryptoHandle, pluginConfig, errorKey, masterKey, &batch, k, ELEKTRA_CRYPTO_ENCRYPT) != 1)
 		{
 			elektraCryptoOpenSSLHandleDestroy (cryptoHandle);
 			goto error;
@@ -268,17 +378,19 @@ static int elektraCryptoEncrypt (Plugin * handle ELEKTRA_UNUSED, KeySet * data E
 
 #elif defined(ELEKTRA_CRYPTO_API_BOTAN)
 
-		if (elektraCryptoBotanEncrypt (pluginConfig, k, errorKey, masterKey) != 1)
+		if (elektraCryptoBotanEncrypt (pluginConfig, k, errorKey, masterKey, &batch) != 1)
 		{
 			goto error; // failure, error has been set by elektraCryptoBotanEncrypt
 		}
 
 #endif
 	}
+	memset (&batch, 0, sizeof (batch));
 	elektraCryptoSafelyReleaseKey (masterKey);
 	return 1;
 
 error:
+	memset (&batch, 0, sizeof (batch));
 	elektraCryptoSafelyReleaseKey (masterKey);
 	return -1;
 }
@@ -295,10 +407,11 @@ static int elektraCryptoDecrypt (Plugin * handle ELEKTRA_UNUSED, KeySet * data,
 {
 	Key * k;
 	Key * masterKey = NULL;
+	CryptoBatch batch = { .saltLen = 0 }; // shares the derived cryptographic key among the Keys of data
 
 #if defined(ELEKTRA_CRYPTO_API_GCRYPT) || defined(ELEKTRA_CRYPTO_API_OPENSSL) || defined(ELEKTRA_CRYPTO_API_BOTAN)
 	KeySet * pluginConfig = elektraPluginGetConfig (handle);
-	masterKey = CRYPTO_PLUGIN_FUNCTION (getMasterPassword) (errorKey, pluginConfig);
+	masterKey = elektraCryptoGetMasterPassword (handle, errorKey);
 	if (!masterKey)
 	{
 		goto error; // error has been set by getMasterPassword
@@ -325,7 +438,7 @@ static int elektraCryptoDecrypt (Plugin * handle ELEKTRA_UNUSED, KeySet * data,
 
 #if defined(ELEKTRA_CRYPTO_API_GCRYPT)
 
-		if (elektraCryptoGcryHandleCreate (&cryptoHandle, pluginConfig, errorKey, masterKey, k, ELEKTRA_CRYPTO_DECRYPT) != 1)
+		if (elektraCryptoGcryHandleCreate (&cryptoHandle, pluginConfig, errorKey, masterKey, &batch, k, ELEKTRA_CRYPTO_DECRYPT) != 1)
 		{
 			goto error;
 		}
@@ -341,7 +454,7 @@ static int elektraCryptoDecrypt (Plugin * handle ELEKTRA_UNUSED, KeySet * data,
 
 #elif defined(ELEKTRA_CRYPTO_API_OPENSSL)
 
-		if (elektraCryptoOpenSSLHandleCreate (&cryptoHandle, pluginConfig, errorKey, masterKey, k, ELEKTRA_CRYPTO_DECRYPT) != 1)
+		if (elektraCryptoOpenSSLHandleCreate (&cryptoHandle, pluginConfig, errorKey, masterKey, &batch, k, ELEKTRA_CRYPTO_DECRYPT) != 1)
 		{
 			elektraCryptoOpenSSLHandleDestroy (cryptoHandle);
 			goto error;
@@ -358,17 +471,19 @@ static int elektraCryptoDecrypt (Plugin * handle ELEKTRA_UNUSED, KeySet * data,
 
 #elif defined(ELEKTRA_CRYPTO_API_BOTAN)
 
-		if (elektraCryptoBotanDecrypt (pluginConfig, k, errorKey, masterKey) != 1)
+		if (elektraCryptoBotanDecrypt (pluginConfig, k, errorKey, masterKey, &batch) != 1)
 		{
 			goto error; // failure, error has been set by elektraCryptoBotanDecrypt
 		}
 
 #endif
 	}
+	memset (&batch, 0, sizeof (batch));
 	elektraCryptoSafelyReleaseKey (masterKey);
 	return 1;
 
 error:
+	memset (&batch, 0, sizeof (batch));
 	elektraCryptoSafelyReleaseKey (masterKey);
 	return -1;
 }
@@ -376,30 +491,43 @@ error:
 /**
  * @brief initialize the crypto provider for the first instance of the plugin.
  *
+ * Also allocates the data of the plugin instance.
+ *
  * @param handle holds the plugin handle
  * @param errorKey holds an error description in case of failure
  * @retval 1 on success
  * @retval -1 on failure. Check errorKey
  */
-int CRYPTO_PLUGIN_FUNCTION (open) (Plugin * handle ELEKTRA_UNUSED, Key * errorKey)
+int CRYPTO_PLUGIN_FUNCTION (open) (Plugin * handle, Key * errorKey)
 {
+	CryptoData * data = elektraCalloc (sizeof (CryptoData));
+	if (!data)
+	{
+		ELEKTRA_SET_ERROR (87, errorKey, "Memory allocation failed");
+		return -1;
+	}
+
 	pthread_mutex_lock (&mutex_ref_cnt);
 	if (ref_cnt == 0)
 	{
 		if (elektraCryptoInit (errorKey) != 1)
 		{
 			pthread_mutex_unlock (&mutex_ref_cnt);
+			elektraFree (data);
 			return -1;
 		}
 	}
 	ref_cnt++;
 	pthread_mutex_unlock (&mutex_ref_cnt);
+	elektraPluginSetData (handle, data);
 	return 1;
 }
 
 /**
  * @brief finalizes the crypto provider for the last instance of the plugin.
  *
+ * Also releases the data of the plugin instance, including a cached master password.
+ *
  * @param handle holds the plugin handle
  * @param errorKey holds an error description in case of failure. Not used at the moment.
  * @retval 1 on success
@@ -407,6 +535,14 @@ int CRYPTO_PLUGIN_FUNCTION (open) (Plugin * handle ELEKTRA_UNUSED, Key * errorKe
  */
 int CRYPTO_PLUGIN_FUNCTION (close) (Plugin * handle, Key * errorKey ELEKTRA_UNUSED)
 {
+	CryptoData * data = elektraPluginGetData (handle);
+	if (data)
+	{
+		elektraCryptoForgetMasterPassword (data);
+		elektraFree (data);
+		elektraPluginSetData (handle, NULL);
+	}
+
 	/* default behaviour: no teardown except the user/system requests it */
 	KeySet * pluginConfig = elektraPluginGetConfig (handle);
 	if (!pluginConfig)
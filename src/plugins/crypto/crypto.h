@@ -11,7 +11,9 @@
 #define ELEKTRA_PLUGIN_CRYPTO_H
 
 #include <kdbplugin.h>
+#include <kdbtypes.h>
 #include <stdio.h>
+#include <time.h>
 
 enum ElektraCryptoHeaderFlags
 {
@@ -44,8 +46,15 @@ enum ElektraCryptoOperation
  * | Lc | original content length                   | 15 + Ls |    4 B | unsigned long integer | YES       |
  * +----+-------------------------------------------+---------+--------+-----------------------+-----------+
  *
+ * In payload version 00 the cryptographic key and the IV are derived from the salt, which is generated for every Key.
+ *
+ * In payload version 01 the salt S consists of a salt shared by all Keys written by the same kdbSet(), followed by the
+ * IV of the Key (one cipher block). Only the cryptographic key is derived from the shared salt, so the expensive key
+ * derivation runs once per kdbSet() instead of once per Key.
+ *
  */
-#define ELEKTRA_CRYPTO_PAYLOAD_VERSION "00"
+#define ELEKTRA_CRYPTO_PAYLOAD_VERSION "01"
+#define ELEKTRA_CRYPTO_PAYLOAD_VERSION_PER_KEY_SALT "00"
 #define ELEKTRA_CRYPTO_MAGIC_NUMBER "#!crypto" ELEKTRA_CRYPTO_PAYLOAD_VERSION
 #define ELEKTRA_CRYPTO_MAGIC_NUMBER_LEN (sizeof (ELEKTRA_CRYPTO_MAGIC_NUMBER) - 1)
 
@@ -53,10 +62,15 @@ enum ElektraCryptoOperation
 #define ELEKTRA_CRYPTO_DEFAULT_MASTER_PWD_LENGTH (30)
 #define ELEKTRA_CRYPTO_DEFAULT_ITERATION_COUNT (15000)
 #define ELEKTRA_CRYPTO_DEFAULT_SALT_LEN (17)
+#define ELEKTRA_CRYPTO_DEFAULT_MASTER_PWD_TTL (0)
+
+// upper limit for the cryptographic key and IV derived from the master password
+#define ELEKTRA_CRYPTO_MAX_DERIVED_LEN (64)
 
 // plugin configuration parameters
 #define ELEKTRA_CRYPTO_PARAM_MASTER_PASSWORD_LEN "/crypto/masterpasswordlength"
 #define ELEKTRA_CRYPTO_PARAM_MASTER_PASSWORD "/crypto/masterpassword"
+#define ELEKTRA_CRYPTO_PARAM_MASTER_PASSWORD_TTL "/crypto/masterpasswordttl"
 #define ELEKTRA_CRYPTO_PARAM_SHUTDOWN "/shutdown"
 #define ELEKTRA_CRYPTO_PARAM_ITERATION_COUNT "/crypto/iterations"
 
@@ -66,6 +80,25 @@ enum ElektraCryptoOperation
 
 #define CRYPTO_PLUGIN_FUNCTION(name) ELEKTRA_PLUGIN_FUNCTION (ELEKTRA_PLUGIN_NAME_C, name)
 
+/**
+ * Data of a plugin instance.
+ */
+typedef struct
+{
+	Key * masterPassword; // decrypted master password locked in memory, NULL if not cached
+	time_t expires;	      // point in time (CLOCK_MONOTONIC) after which masterPassword must not be used anymore
+} CryptoData;
+
+/**
+ * Cryptographic material derived from the master password during one kdbGet() or kdbSet().
+ */
+typedef struct
+{
+	kdb_octet_t salt[ELEKTRA_CRYPTO_DEFAULT_SALT_LEN];
+	kdb_unsigned_long_t saltLen; // 0 if nothing has been derived yet
+	kdb_octet_t derived[ELEKTRA_CRYPTO_MAX_DERIVED_LEN];
+} CryptoBatch;
+
 #if defined(ELEKTRA_CRYPTO_API_GCRYPT)
 
 // gcrypt specific declarations
@@ -190,16 +190,14 @@ static int getGpgBinary (char ** gpgBin, KeySet * conf, Key * errorKey)
 	if (k)
 	{
 		const char * configPath = keyString (k);
-		const size_t configPathLen = strlen (configPath);
-		if (configPathLen > 0)
+		if (strlen (configPath) > 0)
 		{
-			*gpgBin = elektraMalloc (configPathLen + 1);
+			*gpgBin = elektraStrDup (configPath);
 			if (!(*gpgBin))
 			{
 				ELEKTRA_SET_ERROR (87, errorKey, "Memory allocation failed");
 				return -1;
 			}
-			strncpy (*gpgBin, configPath, configPathLen);
 			return 1;
 		}
 	}
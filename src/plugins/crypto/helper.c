@@ -13,6 +13,7 @@
 #include <base64_functions.h>
 #include <kdberrors.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**
  * @brief parse the hex-encoded salt from the metakey.
@@ -95,6 +96,105 @@ int CRYPTO_PLUGIN_FUNCTION (getSaltFromPayload) (Key * errorKey, Key * k, kdb_oc
 	return 1;
 }
 
+/**
+ * @brief split the IV of the given (Elektra) Key off the salt within the crypto payload.
+ *
+ * Payloads of version 01 store the IV of the Key after the salt shared by all Keys of a kdbSet().
+ * Payloads of version 00 do not contain an IV, because it is derived from the salt.
+ *
+ * @param errorKey holds an error description in case of failure.
+ * @param k holds the crypto payload.
+ * @param saltLen holds the length of the salt as read by getSaltFromPayload(). Is set to the length of the shared salt.
+ * @param iv is set to the location of the IV within the crypto payload or to NULL if the IV must be derived.
+ * @param ivLen the length of the IV (the block size of the cipher).
+ * @retval 1 on success
+ * @retval -1 on error. errorKey holds a description.
+ */
+int CRYPTO_PLUGIN_FUNCTION (getIvFromPayload) (Key * errorKey, Key * k, kdb_unsigned_long_t * saltLen, kdb_octet_t ** iv,
+						 kdb_unsigned_long_t ivLen)
+{
+	const kdb_octet_t * value = (kdb_octet_t *)keyValue (k);
+	const size_t versionOffset = ELEKTRA_CRYPTO_MAGIC_NUMBER_LEN - 2;
+
+	*iv = NULL;
+	if (memcmp (&value[versionOffset], ELEKTRA_CRYPTO_PAYLOAD_VERSION, 2))
+	{
+		return 1; // the IV is derived from the salt
+	}
+
+	if (*saltLen <= ivLen)
+	{
+		ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_CRYPTO_INTERNAL_ERROR, errorKey,
+				    "restored salt is too small to contain an IV (salt length is: %u)", *saltLen);
+		return -1;
+	}
+
+	*saltLen -= ivLen;
+	*iv = ((kdb_octet_t *)value) + ELEKTRA_CRYPTO_MAGIC_NUMBER_LEN + sizeof (kdb_unsigned_long_t) + *saltLen;
+	return 1;
+}
+
+/**
+ * @brief store the salt and the IV Base64 encoded as metakey, so that they get encoded into the crypto payload.
+ * @param errorKey holds an error description in case of failure.
+ * @param k the (Elektra) Key to be encrypted.
+ * @param salt the salt shared by all Keys of the kdbSet()
+ * @param saltLen the length of the salt
+ * @param iv the IV of k
+ * @param ivLen the length of the IV
+ * @retval 1 on success
+ * @retval -1 on error. errorKey holds a description.
+ */
+int CRYPTO_PLUGIN_FUNCTION (setSaltMetakey) (Key * errorKey, Key * k, const kdb_octet_t * salt, kdb_unsigned_long_t saltLen,
+					     const kdb_octet_t * iv, kdb_unsigned_long_t ivLen)
+{
+	kdb_octet_t * buffer = elektraMalloc (saltLen + ivLen);
+	if (!buffer)
+	{
+		ELEKTRA_SET_ERROR (87, errorKey, "Memory allocation failed");
+		return -1;
+	}
+	memcpy (buffer, salt, saltLen);
+	memcpy (buffer + saltLen, iv, ivLen);
+
+	char * saltHexString = ELEKTRA_PLUGIN_FUNCTION (ELEKTRA_PLUGIN_NAME_C, base64Encode) (buffer, saltLen + ivLen);
+	elektraFree (buffer);
+	if (!saltHexString)
+	{
+		ELEKTRA_SET_ERROR (87, errorKey, "Memory allocation failed");
+		return -1;
+	}
+	keySetMeta (k, ELEKTRA_CRYPTO_META_SALT, saltHexString);
+	elektraFree (saltHexString);
+	return 1;
+}
+
+/**
+ * @brief check if the cryptographic material of the batch has been derived from the given salt.
+ * @retval 1 if the derived material can be reused
+ * @retval 0 otherwise
+ */
+int CRYPTO_PLUGIN_FUNCTION (batchHasSalt) (const CryptoBatch * batch, const kdb_octet_t * salt, kdb_unsigned_long_t saltLen)
+{
+	return batch->saltLen > 0 && batch->saltLen == saltLen && !memcmp (batch->salt, salt, saltLen);
+}
+
+/**
+ * @brief remember the salt the cryptographic material of the batch has been derived from.
+ *
+ * Salts longer than the default length are not remembered, so the material is derived again for the next Key.
+ */
+void CRYPTO_PLUGIN_FUNCTION (batchSetSalt) (CryptoBatch * batch, const kdb_octet_t * salt, kdb_unsigned_long_t saltLen)
+{
+	if (saltLen > sizeof (batch->salt))
+	{
+		batch->saltLen = 0;
+		return;
+	}
+	memcpy (batch->salt, salt, saltLen);
+	batch->saltLen = saltLen;
+}
+
 /**
 * @brief read the encrypted password form the configuration and decrypt it.
 * @param errorKey holds an error description in case of failure.
@@ -16,6 +16,12 @@
 
 int CRYPTO_PLUGIN_FUNCTION (getSaltFromMetakey) (Key * errorKey, Key * k, kdb_octet_t ** salt, kdb_unsigned_long_t * saltLen);
 int CRYPTO_PLUGIN_FUNCTION (getSaltFromPayload) (Key * errorKey, Key * k, kdb_octet_t ** salt, kdb_unsigned_long_t * saltLen);
+int CRYPTO_PLUGIN_FUNCTION (getIvFromPayload) (Key * errorKey, Key * k, kdb_unsigned_long_t * saltLen, kdb_octet_t ** iv,
+						 kdb_unsigned_long_t ivLen);
+int CRYPTO_PLUGIN_FUNCTION (setSaltMetakey) (Key * errorKey, Key * k, const kdb_octet_t * salt, kdb_unsigned_long_t saltLen,
+					     const kdb_octet_t * iv, kdb_unsigned_long_t ivLen);
+int CRYPTO_PLUGIN_FUNCTION (batchHasSalt) (const CryptoBatch * batch, const kdb_octet_t * salt, kdb_unsigned_long_t saltLen);
+void CRYPTO_PLUGIN_FUNCTION (batchSetSalt) (CryptoBatch * batch, const kdb_octet_t * salt, kdb_unsigned_long_t saltLen);
 Key * CRYPTO_PLUGIN_FUNCTION (getMasterPassword) (Key * errorKey, KeySet * config);
 kdb_unsigned_long_t CRYPTO_PLUGIN_FUNCTION (getIterationCount) (Key * errorKey, KeySet * config);
 
@@ -35,61 +35,101 @@
 static pthread_mutex_t mutex_ssl = PTHREAD_MUTEX_INITIALIZER;
 
 /**
- * @brief derive the cryptographic key and IV for a given (Elektra) Key k
+ * @brief derive the cryptographic material from the master password, unless it has already been derived from the same salt.
  * @param config KeySet holding the plugin/backend configuration
  * @param errorKey holds an error description in case of failure
  * @param masterKey holds the decrypted master password from the plugin configuration
- * @param k the (Elektra)-Key to be encrypted
- * @param cKey (Elektra)-Key holding the cryptographic material
- * @param cIv (Elektra)-Key holding the initialization vector
+ * @param batch holds the cryptographic material of the current kdbGet() or kdbSet()
+ * @param salt the salt for the key derivation
+ * @param saltLen the length of the salt
  * @retval -1 on failure. errorKey holds the error description.
  * @retval 1 on success
  */
-static int getKeyIvForEncryption (KeySet * config, Key * errorKey, Key * masterKey, Key * k, Key * cKey, Key * cIv)
+static int deriveKey (KeySet * config, Key * errorKey, Key * masterKey, CryptoBatch * batch, const kdb_octet_t * salt,
+		      kdb_unsigned_long_t saltLen)
 {
-	kdb_octet_t salt[ELEKTRA_CRYPTO_DEFAULT_SALT_LEN] = { 0 };
-	kdb_octet_t keyBuffer[KEY_BUFFER_SIZE] = { 0 };
-	char * saltHexString = NULL;
+	if (CRYPTO_PLUGIN_FUNCTION (batchHasSalt) (batch, salt, saltLen))
+	{
+		return 1;
+	}
 
-	ELEKTRA_ASSERT (masterKey != NULL, "Parameter `masterKey` must not be NULL");
+	// read iteration count
+	const kdb_unsigned_long_t iterations = CRYPTO_PLUGIN_FUNCTION (getIterationCount) (errorKey, config);
 
-	// generate the salt
+	// generate/derive the cryptographic key and the IV
 	pthread_mutex_lock (&mutex_ssl);
-	if (!RAND_bytes (salt, ELEKTRA_CRYPTO_DEFAULT_SALT_LEN - 1))
+	if (!PKCS5_PBKDF2_HMAC_SHA1 (keyValue (masterKey), keyGetValueSize (masterKey), salt, saltLen, iterations, KEY_BUFFER_SIZE,
+				     batch->derived))
 	{
-		ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_CRYPTO_INTERNAL_ERROR, errorKey, "failed to generate random salt with error code %lu",
-				    ERR_get_error ());
+		ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_CRYPTO_INTERNAL_ERROR, errorKey,
+				    "Failed to derive a cryptographic key. Libcrypto returned error code: %lu", ERR_get_error ());
 		pthread_mutex_unlock (&mutex_ssl);
+		batch->saltLen = 0;
 		return -1;
 	}
 	pthread_mutex_unlock (&mutex_ssl);
-	saltHexString = ELEKTRA_PLUGIN_FUNCTION (ELEKTRA_PLUGIN_NAME_C, base64Encode) (salt, sizeof (salt));
-	if (!saltHexString)
+
+	CRYPTO_PLUGIN_FUNCTION (batchSetSalt) (batch, salt, saltLen);
+	return 1;
+}
+
+/**
+ * @brief derive the cryptographic key and generate the IV for a given (Elektra) Key k
+ * @param config KeySet holding the plugin/backend configuration
+ * @param errorKey holds an error description in case of failure
+ * @param masterKey holds the decrypted master password from the plugin configuration
+ * @param batch holds the cryptographic material shared by all Keys of the current kdbSet()
+ * @param k the (Elektra)-Key to be encrypted
+ * @param cKey (Elektra)-Key holding the cryptographic material
+ * @param cIv (Elektra)-Key holding the initialization vector
+ * @retval -1 on failure. errorKey holds the error description.
+ * @retval 1 on success
+ */
+static int getKeyIvForEncryption (KeySet * config, Key * errorKey, Key * masterKey, CryptoBatch * batch, Key * k, Key * cKey,
+				  Key * cIv)
+{
+	kdb_octet_t iv[ELEKTRA_CRYPTO_SSL_BLOCKSIZE];
+
+	ELEKTRA_ASSERT (masterKey != NULL, "Parameter `masterKey` must not be NULL");
+
+	// generate the salt once per kdbSet()
+	if (!batch->saltLen)
 	{
-		ELEKTRA_SET_ERROR (87, errorKey, "Memory allocation failed");
-		return -1;
-	}
-	keySetMeta (k, ELEKTRA_CRYPTO_META_SALT, saltHexString);
-	elektraFree (saltHexString);
+		kdb_octet_t salt[ELEKTRA_CRYPTO_DEFAULT_SALT_LEN];
+		pthread_mutex_lock (&mutex_ssl);
+		if (!RAND_bytes (salt, sizeof (salt)))
+		{
+			ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_CRYPTO_INTERNAL_ERROR, errorKey,
+					    "failed to generate random salt with error code %lu", ERR_get_error ());
+			pthread_mutex_unlock (&mutex_ssl);
+			return -1;
+		}
+		pthread_mutex_unlock (&mutex_ssl);
 
-	// read iteration count
-	const kdb_unsigned_long_t iterations = CRYPTO_PLUGIN_FUNCTION (getIterationCount) (errorKey, config);
+		if (deriveKey (config, errorKey, masterKey, batch, salt, sizeof (salt)) != 1)
+		{
+			return -1;
+		}
+	}
 
-	// generate/derive the cryptographic key and the IV
+	// generate the IV for every Key
 	pthread_mutex_lock (&mutex_ssl);
-	if (!PKCS5_PBKDF2_HMAC_SHA1 (keyValue (masterKey), keyGetValueSize (masterKey), salt, sizeof (salt), iterations, KEY_BUFFER_SIZE,
-				     keyBuffer))
+	if (!RAND_bytes (iv, sizeof (iv)))
 	{
-		ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_CRYPTO_INTERNAL_ERROR, errorKey,
-				    "Failed to create a cryptographic key for encryption. Libcrypto returned error code: %lu",
+		ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_CRYPTO_INTERNAL_ERROR, errorKey, "failed to generate random IV with error code %lu",
 				    ERR_get_error ());
 		pthread_mutex_unlock (&mutex_ssl);
 		return -1;
 	}
 	pthread_mutex_unlock (&mutex_ssl);
 
-	keySetBinary (cKey, keyBuffer, ELEKTRA_CRYPTO_SSL_KEYSIZE);
-	keySetBinary (cIv, keyBuffer + ELEKTRA_CRYPTO_SSL_KEYSIZE, ELEKTRA_CRYPTO_SSL_BLOCKSIZE);
+	if (CRYPTO_PLUGIN_FUNCTION (setSaltMetakey) (errorKey, k, batch->salt, batch->saltLen, iv, sizeof (iv)) != 1)
+	{
+		return -1; // error set by CRYPTO_PLUGIN_FUNCTION(setSaltMetakey)()
+	}
+
+	keySetBinary (cKey, batch->derived, ELEKTRA_CRYPTO_SSL_KEYSIZE);
+	keySetBinary (cIv, iv, ELEKTRA_CRYPTO_SSL_BLOCKSIZE);
 	return 1;
 }
 
@@ -98,44 +138,40 @@ static int getKeyIvForEncryption (KeySet * config, Key * errorKey, Key * masterK
  * @param config KeySet holding the plugin/backend configuration
  * @param errorKey holds an error description in case of failure
  * @param masterKey holds the decrypted master password from the plugin configuration
+ * @param batch holds the cryptographic material derived during the current kdbGet()
  * @param k the (Elektra)-Key to be encrypted
  * @param cKey (Elektra)-Key holding the cryptographic material
  * @param cIv (Elektra)-Key holding the initialization vector
  * @retval -1 on failure. errorKey holds the error description.
  * @retval 1 on success
  */
-static int getKeyIvForDecryption (KeySet * config, Key * errorKey, Key * masterKey, Key * k, Key * cKey, Key * cIv)
+static int getKeyIvForDecryption (KeySet * config, Key * errorKey, Key * masterKey, CryptoBatch * batch, Key * k, Key * cKey,
+				  Key * cIv)
 {
-	kdb_octet_t keyBuffer[KEY_BUFFER_SIZE];
 	kdb_octet_t * saltBuffer = NULL;
 	kdb_unsigned_long_t saltBufferLen = 0;
+	kdb_octet_t * iv = NULL;
 
 	ELEKTRA_ASSERT (masterKey != NULL, "Parameter `masterKey` must not be NULL");
 
-	// get the salt
+	// get the salt and the IV
 	if (CRYPTO_PLUGIN_FUNCTION (getSaltFromPayload) (errorKey, k, &saltBuffer, &saltBufferLen) != 1)
 	{
 		return -1; // error set by CRYPTO_PLUGIN_FUNCTION(getSaltFromPayload)()
 	}
-
-	// get the iteration count
-	const kdb_unsigned_long_t iterations = CRYPTO_PLUGIN_FUNCTION (getIterationCount) (errorKey, config);
+	if (CRYPTO_PLUGIN_FUNCTION (getIvFromPayload) (errorKey, k, &saltBufferLen, &iv, ELEKTRA_CRYPTO_SSL_BLOCKSIZE) != 1)
+	{
+		return -1; // error set by CRYPTO_PLUGIN_FUNCTION(getIvFromPayload)()
+	}
 
 	// derive the cryptographic key and the IV
-	pthread_mutex_lock (&mutex_ssl);
-	if (!PKCS5_PBKDF2_HMAC_SHA1 (keyValue (masterKey), keyGetValueSize (masterKey), saltBuffer, saltBufferLen, iterations,
-				     KEY_BUFFER_SIZE, keyBuffer))
+	if (deriveKey (config, errorKey, masterKey, batch, saltBuffer, saltBufferLen) != 1)
 	{
-		ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_CRYPTO_INTERNAL_ERROR, errorKey,
-				    "Failed to restore the cryptographic key for decryption. Libcrypto returned the error code: %lu",
-				    ERR_get_error ());
-		pthread_mutex_unlock (&mutex_ssl);
 		return -1;
 	}
-	pthread_mutex_unlock (&mutex_ssl);
 
-	keySetBinary (cKey, keyBuffer, ELEKTRA_CRYPTO_SSL_KEYSIZE);
-	keySetBinary (cIv, keyBuffer + ELEKTRA_CRYPTO_SSL_KEYSIZE, ELEKTRA_CRYPTO_SSL_BLOCKSIZE);
+	keySetBinary (cKey, batch->derived, ELEKTRA_CRYPTO_SSL_KEYSIZE);
+	keySetBinary (cIv, iv ? iv : batch->derived + ELEKTRA_CRYPTO_SSL_KEYSIZE, ELEKTRA_CRYPTO_SSL_BLOCKSIZE);
 	return 1;
 }
 
@@ -150,8 +186,8 @@ int elektraCryptoOpenSSLInit (Key * errorKey ELEKTRA_UNUSED)
 	return 1;
 }
 
-int elektraCryptoOpenSSLHandleCreate (elektraCryptoHandle ** handle, KeySet * config, Key * errorKey, Key * masterKey, Key * k,
-				      const enum ElektraCryptoOperation op)
+int elektraCryptoOpenSSLHandleCreate (elektraCryptoHandle ** handle, KeySet * config, Key * errorKey, Key * masterKey,
+				      CryptoBatch * batch, Key * k, const enum ElektraCryptoOperation op)
 {
 	unsigned char keyBuffer[64], ivBuffer[64];
 
@@ -163,7 +199,7 @@ int elektraCryptoOpenSSLHandleCreate (elektraCryptoHandle ** handle, KeySet * co
 	switch (op)
 	{
 	case ELEKTRA_CRYPTO_ENCRYPT:
-		if (getKeyIvForEncryption (config, errorKey, masterKey, k, key, iv) != 1)
+		if (getKeyIvForEncryption (config, errorKey, masterKey, batch, k, key, iv) != 1)
 		{
 			keyDel (key);
 			keyDel (iv);
@@ -172,7 +208,7 @@ int elektraCryptoOpenSSLHandleCreate (elektraCryptoHandle ** handle, KeySet * co
 		break;
 
 	case ELEKTRA_CRYPTO_DECRYPT:
-		if (getKeyIvForDecryption (config, errorKey, masterKey, k, key, iv) != 1)
+		if (getKeyIvForDecryption (config, errorKey, masterKey, batch, k, key, iv) != 1)
 		{
 			keyDel (key);
 			keyDel (iv);
@@ -27,7 +27,9 @@
 	test_gpg ();                                                                                                                       \
 	test_init (PLUGIN_NAME);                                                                                                           \
 	test_incomplete_config (PLUGIN_NAME);                                                                                              \
-	test_crypto_operations (PLUGIN_NAME);
+	test_crypto_operations (PLUGIN_NAME);                                                                                              \
+	test_master_password_cache (PLUGIN_NAME);                                                                                          \
+	test_payload_versions (PLUGIN_NAME);
 
 typedef int (*checkConfPtr) (Key *, KeySet *);
 
@@ -37,6 +39,28 @@ static const char strFullBlockSingle[] = "abcdefghijklmno";
 static const char strFullBlockDouble[] = "I am root!!!!!!!!!!!!!!!!!!!!!?";
 static const kdb_octet_t binVal[] = { 0x01, 0x02, 0x03, 0x04 };
 
+#if defined(ELEKTRA_CRYPTO_API_OPENSSL)
+// "written by payload version 00" encrypted with payload version 00, the master password of setLegacyMasterPassword and 100 iterations
+static const kdb_octet_t legacyPayloadOpenSSL[] = {
+	0x23, 0x21, 0x63, 0x72, 0x79, 0x70, 0x74, 0x6f, 0x30, 0x30, 0x11, 0x00, 0x00, 0x00, 0xc6, 0xc1,
+	0x51, 0xf1, 0x5a, 0x06, 0x3a, 0x2e, 0x5f, 0xc7, 0x09, 0xed, 0xef, 0x6c, 0x3f, 0x57, 0x00, 0x68,
+	0x39, 0xe3, 0x36, 0xe8, 0xb7, 0xc5, 0x3f, 0x9c, 0x15, 0x09, 0x5d, 0x4a, 0xcb, 0xde, 0x3f, 0xb9,
+	0x39, 0xc5, 0x91, 0x60, 0x18, 0xd8, 0x27, 0x2a, 0x10, 0x8b, 0xeb, 0x25, 0x82, 0xd4, 0x1c, 0x2e,
+	0xe4, 0x51, 0x34, 0xc5, 0xab, 0x8b, 0x17, 0xb5, 0x1d, 0x4e, 0x1d, 0xbf, 0xca, 0xfa, 0xb2
+};
+#define LEGACY_PAYLOAD legacyPayloadOpenSSL
+#elif defined(ELEKTRA_CRYPTO_API_GCRYPT)
+// "written by payload version 00" encrypted with payload version 00, the master password of setLegacyMasterPassword and 100 iterations
+static const kdb_octet_t legacyPayloadGcrypt[] = {
+	0x23, 0x21, 0x63, 0x72, 0x79, 0x70, 0x74, 0x6f, 0x30, 0x30, 0x11, 0x00, 0x00, 0x00, 0x14, 0xf9,
+	0x4c, 0x6d, 0xb7, 0xf7, 0x2f, 0x8f, 0x3f, 0xfb, 0xa6, 0xb3, 0xae, 0xd5, 0x19, 0x98, 0x77, 0x5d,
+	0xc5, 0xd0, 0x8a, 0x41, 0x8e, 0xeb, 0x3e, 0xe0, 0xa9, 0x20, 0xde, 0xca, 0x3c, 0x25, 0xec, 0x43,
+	0xa5, 0x0a, 0x20, 0xb3, 0x1a, 0x67, 0x89, 0x96, 0x05, 0x25, 0x9e, 0x0e, 0x3d, 0x3d, 0x5f, 0xbc,
+	0x9b, 0x76, 0x7f, 0x87, 0x74, 0x28, 0x81, 0x08, 0xa5, 0xc0, 0x5e, 0xcf, 0x4b, 0xb7, 0x47
+};
+#define LEGACY_PAYLOAD legacyPayloadGcrypt
+#endif
+
 static inline ssize_t MIN (ssize_t a, ssize_t b)
 {
 	return (a < b) ? a : b;
@@ -104,6 +128,27 @@ static KeySet * newPluginConfiguration (void)
 		      keyNew (ELEKTRA_CRYPTO_PARAM_GPG_UNIT_TEST, KEY_VALUE, "1", KEY_END), KS_END);
 }
 
+/**
+ * @brief encrypt the fixed master password, that was used to create the legacy payload, with gpg.
+ *
+ * The password is long and not compressible, because gpg's output is read into a buffer twice the size of the input.
+ */
+static void setLegacyMasterPassword (KeySet * config, Key * errorKey)
+{
+	char password[513];
+	kdb_unsigned_long_t seed = 1;
+	for (size_t i = 0; i < sizeof (password) - 1; ++i)
+	{
+		seed = seed * 1103515245 + 12345;
+		password[i] = 'A' + (seed >> 16) % 58;
+	}
+	password[sizeof (password) - 1] = '\0';
+
+	Key * k = keyNew ("user/" ELEKTRA_CRYPTO_PARAM_MASTER_PASSWORD, KEY_VALUE, password, KEY_END);
+	succeed_if (CRYPTO_PLUGIN_FUNCTION (gpgEncryptMasterPassword) (config, errorKey, k) == 1, "failed to encrypt the master password");
+	ksAppendKey (config, k);
+}
+
 static void test_init (const char * pluginName)
 {
 	Plugin * plugin = NULL;
@@ -247,6 +292,125 @@ static void test_crypto_operations (const char * pluginName)
 	keyDel (parentKey);
 }
 
+static void test_master_password_cache (const char * pluginName)
+{
+	Plugin * plugin = NULL;
+	Key * parentKey = keyNew ("system", KEY_END);
+	KeySet * modules = ksNew (0, KS_END);
+	KeySet * config = newPluginConfiguration ();
+	ksAppendKey (config, keyNew (ELEKTRA_CRYPTO_PARAM_MASTER_PASSWORD_TTL, KEY_VALUE, "3600", KEY_END));
+
+	setPluginShutdown (config);
+
+	elektraModulesInit (modules, 0);
+
+	plugin = elektraPluginOpen (pluginName, modules, config, 0);
+	succeed_if (plugin != 0, "failed to open the plugin");
+	if (plugin)
+	{
+		KeySet * pluginConfig = elektraPluginGetConfig (plugin);
+		succeed_if (CRYPTO_PLUGIN_FUNCTION (checkconf) (parentKey, pluginConfig) == 1, "checkconf call failed");
+
+		KeySet * data = newTestdataKeySet ();
+		KeySet * original = ksDup (data);
+
+		succeed_if (plugin->kdbSet (plugin, data, parentKey) == 1, "kdb set failed");
+		CryptoData * cryptoData = elektraPluginGetData (plugin);
+		succeed_if (cryptoData && cryptoData->masterPassword, "master password has not been cached");
+
+		// the cached master password is used, so gpg is not needed anymore
+		ksAppendKey (pluginConfig, keyNew (ELEKTRA_CRYPTO_PARAM_GPG_BIN, KEY_VALUE, "/does/not/exist/gpg", KEY_END));
+		succeed_if (plugin->kdbGet (plugin, data, parentKey) == 1, "kdb get with cached master password failed");
+		compare_keyset (data, original);
+
+		// without cache gpg is called
+		succeed_if (plugin->kdbClose (plugin, parentKey) == 1, "kdb close failed");
+		succeed_if (elektraPluginGetData (plugin) == NULL, "cached master password has not been released");
+		succeed_if (plugin->kdbOpen (plugin, parentKey) == 1, "re-opening the plugin failed");
+		succeed_if (plugin->kdbSet (plugin, data, parentKey) == -1, "kdb set succeeded without gpg");
+
+		ksDel (original);
+		ksDel (data);
+		elektraPluginClose (plugin, 0);
+	}
+
+	elektraModulesClose (modules, 0);
+	ksDel (modules);
+	keyDel (parentKey);
+}
+
+static void test_payload_versions (const char * pluginName)
+{
+	Plugin * plugin = NULL;
+	Key * parentKey = keyNew ("system", KEY_END);
+	KeySet * modules = ksNew (0, KS_END);
+	KeySet * config = newPluginConfiguration ();
+	setLegacyMasterPassword (config, parentKey);
+	ksAppendKey (config, keyNew (ELEKTRA_CRYPTO_PARAM_ITERATION_COUNT, KEY_VALUE, "100", KEY_END));
+
+	setPluginShutdown (config);
+
+	elektraModulesInit (modules, 0);
+
+	plugin = elektraPluginOpen (pluginName, modules, config, 0);
+	succeed_if (plugin != 0, "failed to open the plugin");
+	if (plugin)
+	{
+		KeySet * data = newTestdataKeySet ();
+		KeySet * original = ksDup (data);
+		Key * k;
+		const kdb_octet_t * salt = NULL;
+		const kdb_octet_t * iv = NULL;
+		const size_t saltOffset = ELEKTRA_CRYPTO_MAGIC_NUMBER_LEN + sizeof (kdb_unsigned_long_t);
+		const size_t ivLen = 16;
+
+		// all Keys of a kdbSet share the salt, but not the IV
+		succeed_if (plugin->kdbSet (plugin, data, parentKey) == 1, "kdb set failed");
+		ksRewind (data);
+		while ((k = ksNext (data)) != 0)
+		{
+			if (!isMarkedForEncryption (k)) continue;
+
+			const kdb_octet_t * value = keyValue (k);
+			kdb_unsigned_long_t saltLen = 0;
+			succeed_if (!memcmp (value, "#!crypto" ELEKTRA_CRYPTO_PAYLOAD_VERSION, ELEKTRA_CRYPTO_MAGIC_NUMBER_LEN),
+				    "wrong magic number or payload version");
+			memcpy (&saltLen, value + ELEKTRA_CRYPTO_MAGIC_NUMBER_LEN, sizeof (kdb_unsigned_long_t));
+			succeed_if (saltLen == ELEKTRA_CRYPTO_DEFAULT_SALT_LEN + ivLen, "salt does not contain the IV");
+			if (salt)
+			{
+				succeed_if (!memcmp (salt, value + saltOffset, ELEKTRA_CRYPTO_DEFAULT_SALT_LEN),
+					    "Keys of one kdbSet use different salts");
+				succeed_if (memcmp (iv, value + saltOffset + ELEKTRA_CRYPTO_DEFAULT_SALT_LEN, ivLen),
+					    "Keys of one kdbSet share the IV");
+			}
+			salt = value + saltOffset;
+			iv = salt + ELEKTRA_CRYPTO_DEFAULT_SALT_LEN;
+		}
+		succeed_if (plugin->kdbGet (plugin, data, parentKey) == 1, "kdb get failed");
+		compare_keyset (data, original);
+
+#ifdef LEGACY_PAYLOAD
+		// payloads written with a salt per Key can still be decrypted
+		k = keyNew ("user/crypto/test/legacy", KEY_BINARY, KEY_SIZE, sizeof (LEGACY_PAYLOAD), KEY_VALUE, LEGACY_PAYLOAD, KEY_META,
+			    ELEKTRA_CRYPTO_META_ENCRYPT, "1", KEY_END);
+		KeySet * legacy = ksNew (1, k, KS_END);
+		succeed_if (plugin->kdbGet (plugin, legacy, parentKey) == 1, "kdb get of payload version 00 failed");
+		succeed_if (keyIsString (k) == 1, "decrypted Key is not a string");
+		succeed_if (!strcmp (keyString (k), "written by payload version 00"), "payload version 00 has not been decrypted");
+		ksDel (legacy);
+#endif
+
+		ksDel (original);
+		ksDel (data);
+		elektraPluginClose (plugin, 0);
+	}
+
+	elektraModulesClose (modules, 0);
+	ksDel (modules);
+	keyDel (parentKey);
+}
+
 static void test_gpg (void)
 {
 	// Plugin configuration
@@ -21,6 +21,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#define READ_BUFFER_SIZE 65536
+
 
 // returns next field in record
 // ignore record and field separators in quoted fields according to RFC 4180
@@ -101,22 +103,21 @@ static char * parseLine (char * origLine, char delim, unsigned long offset, Key
 			}
 		}
 	}
-	unsigned long len = elektraStrLen (line);
-	if (isQuoted)
+	if (isQuoted || isCol)
 	{
+		unsigned long len = elektraStrLen (line);
 		if (line[len - 2] == '\n')
 		{
 			line[len - 2] = '\0';
 		}
+	}
+	if (isQuoted)
+	{
 		ELEKTRA_ADD_WARNINGF (136, parentKey, "Unexpected end of line(%lu). unbalanced number of double-quotes in (%s)", lineNr,
 				      line);
 	}
 	else if (isCol)
 	{
-		if (line[len - 2] == '\n')
-		{
-			line[len - 2] = '\0';
-		}
 		ELEKTRA_ADD_WARNINGF (136, parentKey, "Unexpected end of line(%lu): (%s)", lineNr, line);
 	}
 	else
@@ -131,22 +132,6 @@ static char * parseLine (char * origLine, char delim, unsigned long offset, Key
 	return line;
 }
 
-static unsigned long getLineLength (FILE * fp)
-{
-	int startPos = ftell (fp);
-	char c;
-	while ((c = fgetc (fp)) && (!feof (fp)))
-	{
-		if (c == '\n') break;
-	}
-	int endPos = ftell (fp);
-	fseek (fp, startPos, SEEK_SET);
-	if ((endPos - startPos) == 0)
-		return 0;
-	else
-		return (endPos - startPos) + 1;
-}
-
 // count columns in lineBuffer
 // ignore record and field separators in quoted fields
 
@@ -215,100 +200,144 @@ static unsigned long getColumnCount (char * lineBuffer, char delim)
 	return counter;
 }
 
-// reads next record from file according to RFC 4180
-// if EOL is reached with unbalanced quotes, assume record continues at the next
-// line. append succeeding lines until quotes are balanced or EOF is reached
+// holds the whole file in memory, so records can be read in a single pass
+// without seeking back and forth in the file
 
-static char * readNextLine (FILE * fp, char delim, int * lastLine, int * linesRead)
+typedef struct
 {
-	int done = 0;
-	unsigned long bufLen = 0;
-	unsigned long offset = 0;
-	*linesRead = 0;
-	char * lineBuffer = NULL;
-	*linesRead = 0;
-	while (!done)
+	char * data;
+	size_t size;
+	size_t pos;
+	char * line;
+	size_t lineSize;
+	int outOfMemory;
+} CsvReader;
+
+static int csvReaderOpen (CsvReader * reader, FILE * fp)
+{
+	size_t alloc = READ_BUFFER_SIZE;
+	size_t read;
+	memset (reader, 0, sizeof (CsvReader));
+	if (!(reader->data = elektraMalloc (alloc))) return -1;
+	while ((read = fread (reader->data + reader->size, 1, alloc - reader->size - 1, fp)) > 0)
+	{
+		reader->size += read;
+		if (reader->size + 1 < alloc) continue;
+		alloc *= 2;
+		if (elektraRealloc ((void **)&reader->data, alloc) == -1) return -1;
+	}
+	// parsing looks one character ahead, so the last line needs a terminator
+	reader->data[reader->size] = '\0';
+	return 0;
+}
+
+static void csvReaderClose (CsvReader * reader)
+{
+	if (reader->data) elektraFree (reader->data);
+	if (reader->line) elektraFree (reader->line);
+}
+
+// checks if a line ends inside of a quoted field
+// ignore record and field separators in quoted fields
+
+static int isLineComplete (const char * ptr, const char * end, char delim)
+{
+	int isQuoted = 0;
+	int isCol = 0;
+	while (ptr < end)
 	{
-		int isQuoted = 0;
-		int isCol = 0;
-		unsigned long len = getLineLength (fp);
-		if (!len)
+		if (*ptr == '"')
 		{
-			if (!lineBuffer)
+			if (!isQuoted && !isCol)
 			{
-				*lastLine = 0;
-				return NULL;
+				isQuoted = 1;
+				isCol = 1;
 			}
-			else
-				return lineBuffer;
-		}
-		else
-		{
-			++(*linesRead);
-		}
-		char buffer[len];
-		fgets (buffer, len, fp);
-		char * ptr = buffer;
-
-		while (*ptr)
-		{
-			if (*ptr == '"')
+			else if (isQuoted && isCol)
 			{
-				if (!isQuoted && !isCol)
+				if (*(ptr + 1) == '"')
 				{
-					isQuoted = 1;
-					isCol = 1;
+					ptr += 1;
 				}
-				else if (isQuoted && isCol)
+				else if (*(ptr + 1) == delim)
 				{
-					if (*(ptr + 1) == '"')
-					{
-						ptr += 1;
-					}
-					else if (*(ptr + 1) == delim)
-					{
-						isQuoted = 0;
-						isCol = 0;
-						++ptr;
-					}
+					isQuoted = 0;
+					isCol = 0;
+					++ptr;
 				}
 			}
-			else if (*ptr == delim)
+		}
+		else if (*ptr == delim)
+		{
+			if (!isQuoted)
 			{
-				if (!isQuoted)
-				{
-					isCol = 0;
-				}
+				isCol = 0;
 			}
-			else if (*ptr != '\n')
+		}
+		else if (*ptr != '\n')
+		{
+			if (!isCol)
 			{
-				if (!isCol)
-				{
-					isCol = 1;
-				}
+				isCol = 1;
 			}
-			else // its \n
+		}
+		else // its \n
+		{
+			if (isQuoted && isCol)
 			{
-				if (isQuoted && isCol)
-				{
-					break;
-				}
-				else
-				{
-					isCol = 0;
-					isQuoted = 0;
-				}
+				break;
+			}
+			else
+			{
+				isCol = 0;
+				isQuoted = 0;
 			}
-			++ptr;
 		}
-		len = elektraStrLen (buffer);
-		bufLen += len;
-		lineBuffer = realloc (lineBuffer, bufLen);
-		memcpy (lineBuffer + offset, buffer, len);
-		offset += (len - 1);
-		if (!isCol && !isQuoted) done = 1;
+		++ptr;
 	}
-	return lineBuffer;
+	return !isCol && !isQuoted;
+}
+
+// reads next record from file according to RFC 4180
+// if EOL is reached with unbalanced quotes, assume record continues at the next
+// line. append succeeding lines until quotes are balanced or EOF is reached
+
+static char * readNextLine (CsvReader * reader, char delim, int * lastLine, int * linesRead)
+{
+	size_t start = reader->pos;
+	int done = 0;
+	*linesRead = 0;
+	while (!done && reader->pos < reader->size)
+	{
+		char * line = reader->data + reader->pos;
+		char * end = memchr (line, '\n', reader->size - reader->pos);
+		end = end ? end + 1 : reader->data + reader->size;
+		reader->pos += end - line;
+		++(*linesRead);
+		// without double-quotes the line can not end inside of a quoted field
+		done = !memchr (line, '"', end - line) || isLineComplete (line, end, delim);
+	}
+	if (reader->pos == start)
+	{
+		*lastLine = 0;
+		return NULL;
+	}
+	size_t len = reader->pos - start;
+	if (len + 2 > reader->lineSize)
+	{
+		if (elektraRealloc ((void **)&reader->line, len + 2) == -1)
+		{
+			reader->outOfMemory = 1;
+			return NULL;
+		}
+		reader->lineSize = len + 2;
+	}
+	memcpy (reader->line, reader->data + start, len);
+	// parseLine may step over the terminator of the last field, so the buffer
+	// needs to end there too and not with the rest of a previous record
+	reader->line[len] = '\0';
+	reader->line[len + 1] = '\0';
+	return reader->line;
 }
 
 static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHeader, unsigned long fixColumnCount, const char ** colNames)
@@ -321,12 +350,21 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 		ELEKTRA_SET_ERRORF (116, parentKey, "couldn't open file %s\n", fileName);
 		return -1;
 	}
+	CsvReader reader;
+	int readFailed = csvReaderOpen (&reader, fp) == -1;
+	fclose (fp);
+	if (readFailed)
+	{
+		ELEKTRA_SET_ERROR (87, parentKey, "Memory allocation failed");
+		csvReaderClose (&reader);
+		return -1;
+	}
 	int lastLine = 0;
 	int linesRead = 0;
-	char * lineBuffer = readNextLine (fp, delim, &lastLine, &linesRead);
+	char * lineBuffer = readNextLine (&reader, delim, &lastLine, &linesRead);
 	if (!lineBuffer)
 	{
-		fclose (fp);
+		csvReaderClose (&reader);
 		return 0;
 	}
 	unsigned long columns = 0;
@@ -336,8 +374,7 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 		if (columns != fixColumnCount)
 		{
 			ELEKTRA_SET_ERROR (117, parentKey, "illegal number of columns in Header line");
-			elektraFree (lineBuffer);
-			fclose (fp);
+			csvReaderClose (&reader);
 			return -1;
 		}
 	}
@@ -359,10 +396,9 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 			offset += elektraStrLen (col);
 			if (elektraArrayIncName (orderKey) == -1)
 			{
-				elektraFree (lineBuffer);
 				keyDel (orderKey);
 				ksDel (header);
-				fclose (fp);
+				csvReaderClose (&reader);
 				return -1;
 			}
 			key = keyDup (orderKey);
@@ -379,7 +415,7 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 			++colCounter;
 		}
 		keyDel (orderKey);
-		fseek (fp, 0, SEEK_SET);
+		reader.pos = 0;
 		lineCounter += linesRead;
 	}
 	else
@@ -392,10 +428,9 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 		{
 			if (elektraArrayIncName (orderKey) == -1)
 			{
-				elektraFree (lineBuffer);
 				keyDel (orderKey);
 				ksDel (header);
-				fclose (fp);
+				csvReaderClose (&reader);
 				return -1;
 			}
 			key = keyDup (orderKey);
@@ -410,7 +445,7 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 		keyDel (orderKey);
 		if (useHeader == 0)
 		{
-			fseek (fp, 0, SEEK_SET);
+			reader.pos = 0;
 		}
 		lineCounter += 1;
 	}
@@ -418,24 +453,28 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 	Key * cur;
 	dirKey = keyDup (parentKey);
 	keyAddName (dirKey, "#");
-	elektraFree (lineBuffer);
 	while (1)
 	{
-		lineBuffer = readNextLine (fp, delim, &lastLine, &linesRead);
+		lineBuffer = readNextLine (&reader, delim, &lastLine, &linesRead);
 		if (!lineBuffer)
 		{
-			fclose (fp);
+			int outOfMemory = reader.outOfMemory;
+			csvReaderClose (&reader);
 			keyDel (dirKey);
 			ksDel (header);
+			if (outOfMemory)
+			{
+				ELEKTRA_SET_ERROR (87, parentKey, "Memory allocation failed");
+				return -1;
+			}
 			return (lineCounter > 0) ? 1 : 0;
 		}
 
 		if (elektraArrayIncName (dirKey) == -1)
 		{
-			elektraFree (lineBuffer);
 			keyDel (dirKey);
 			ksDel (header);
-			fclose (fp);
+			csvReaderClose (&reader);
 			return -1;
 		}
 		++nr_keys;
@@ -459,7 +498,7 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 			}
 			keyAddBaseName (key, keyString (cur));
 			keySetString (key, col);
-			keySetMeta (key, "csv/order", keyBaseName (cur));
+			keyCopyMeta (key, cur, "csv/order");
 			ksAppendKey (returned, key);
 			lastIndex = (char *)keyBaseName (cur);
 			++nr_keys;
@@ -473,8 +512,7 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 			if (fixColumnCount)
 			{
 				ELEKTRA_SET_ERRORF (117, parentKey, "illegal number of columns in line %lu", lineCounter);
-				elektraFree (lineBuffer);
-				fclose (fp);
+				csvReaderClose (&reader);
 				keyDel (dirKey);
 				ksDel (header);
 				return -1;
@@ -482,13 +520,12 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 			ELEKTRA_ADD_WARNINGF (118, parentKey, "illegal number of columns in line %lu", lineCounter);
 		}
 		lineCounter += linesRead;
-		elektraFree (lineBuffer);
 	}
 	key = keyDup (parentKey);
 	keySetString (key, keyBaseName (dirKey));
 	ksAppendKey (returned, key);
 	keyDel (dirKey);
-	fclose (fp);
+	csvReaderClose (&reader);
 	ksDel (header);
 	return 1;
 }
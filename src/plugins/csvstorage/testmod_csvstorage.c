@@ -170,6 +170,29 @@ static void testreadunescapedDQuote (const char * file)
 	keyDel (parentKey);
 	PLUGIN_CLOSE ();
 }
+
+static void testreadmultiline (const char * file)
+{
+	Key * parentKey = keyNew ("user/tests/csvstorage", KEY_VALUE, srcdir_file (file), KEY_END);
+	KeySet * conf = ksNew (10, keyNew ("system/delimiter", KEY_VALUE, ";", KEY_END),
+			       keyNew ("system/header", KEY_VALUE, "colname", KEY_END), KS_END);
+	KeySet * ks = ksNew (0, KS_END);
+	PLUGIN_OPEN ("csvstorage");
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) > 0, "call to kdbGet was not successful");
+	succeed_if (output_warnings (parentKey), "warnings in kdbGet");
+	Key * key = ksLookupByName (ks, "user/tests/csvstorage/#1/col2", 0);
+	exit_if_fail (key, "key not found");
+	succeed_if (!strcmp (keyString (key), "l1\nc2"), "key value doesn't match expected value");
+	key = ksLookupByName (ks, "user/tests/csvstorage/#2/col3", 0);
+	exit_if_fail (key, "key not found");
+	succeed_if (!strcmp (keyString (key), "l2c3"), "key value doesn't match expected value");
+	succeed_if (!ksLookupByName (ks, "user/tests/csvstorage/#3", 0), "found record that should not exist");
+
+	ksDel (ks);
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
 int main (int argc, char ** argv)
 {
 	printf ("CSVSTORAGE     TESTS\n");
@@ -186,6 +209,7 @@ int main (int argc, char ** argv)
 	testSetColnames ("csvstorage/valid.csv");
 	testreadwritecomplicated ("csvstorage/complicated.csv");
 	testreadunescapedDQuote ("csvstorage/unescapedQuote.csv");
+	testreadmultiline ("csvstorage/multiline.csv");
 	print_result ("testmod_csvstorage");
 
 	return nbError;
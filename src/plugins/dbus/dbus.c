@@ -13,6 +13,8 @@
 
 #include "dbus.h"
 
+#include <kdbprivate.h> // for elektraKsDiff
+
 int elektraDbusGet (Plugin * handle, KeySet * returned, Key * parentKey)
 {
 	if (!strcmp (keyName (parentKey), "system/elektra/modules/dbus"))
@@ -49,37 +51,89 @@ static void announceKeys (KeySet * ks, const char * signalName, DBusBusType busT
 	}
 }
 
+/**
+ * @brief Adds the prefix below which key was changed to prefixes
+ *
+ * The prefix is the name of the key's parent, but never above parentKey.
+ */
+static void addChangedPrefix (KeySet * prefixes, const Key * key, const Key * parentKey)
+{
+	Key * prefix = keyDup (key);
+	keySetBaseName (prefix, 0);
+	if (!keyIsBelowOrSame (parentKey, prefix))
+	{
+		keyDel (prefix);
+		prefix = keyDup (parentKey);
+	}
+	ksAppendKey (prefixes, prefix);
+}
+
+static void addChangedPrefixes (KeySet * prefixes, KeySet * ks, const Key * parentKey)
+{
+	ksRewind (ks);
+	Key * k = 0;
+	while ((k = ksNext (ks)) != 0)
+	{
+		addChangedPrefix (prefixes, k, parentKey);
+	}
+}
+
+/**
+ * @brief Removes all prefixes which are below another prefix
+ *
+ * Keys below a prefix directly follow it in the sorted keyset,
+ * so a single pass is enough.
+ */
+static void compressPrefixes (KeySet * prefixes)
+{
+	KeySet * covering = ksNew (ksGetSize (prefixes), KS_END);
+	Key * last = 0;
+	Key * k = 0;
+	ksRewind (prefixes);
+	while ((k = ksNext (prefixes)) != 0)
+	{
+		if (last && keyIsBelow (last, k)) continue;
+		ksAppendKey (covering, k);
+		last = k;
+	}
+	ksCopy (prefixes, covering);
+	ksDel (covering);
+}
+
+static void announcePrefixes (Key * parentKey, KeySet * addedKeys, KeySet * changedKeys, KeySet * removedKeys, DBusBusType busType)
+{
+	KeySet * prefixes = ksNew (0, KS_END);
+	addChangedPrefixes (prefixes, addedKeys, parentKey);
+	addChangedPrefixes (prefixes, changedKeys, parentKey);
+	addChangedPrefixes (prefixes, removedKeys, parentKey);
+	if (ksGetSize (prefixes) > 0)
+	{
+		compressPrefixes (prefixes);
+		elektraDbusSendPrefixesMessage (busType, keyName (parentKey), "Commit", prefixes);
+	}
+	ksDel (prefixes);
+}
+
 int elektraDbusSet (Plugin * handle, KeySet * returned, Key * parentKey)
 {
 	KeySet * oldKeys = (KeySet *)elektraPluginGetData (handle);
 	// because elektraLogchangeGet will always be executed before elektraLogchangeSet
 	// we know that oldKeys must exist here!
-	ksRewind (oldKeys);
-	ksRewind (returned);
-
-	KeySet * addedKeys = ksDup (returned);
+	KeySet * addedKeys = ksNew (0, KS_END);
 	KeySet * changedKeys = ksNew (0, KS_END);
 	KeySet * removedKeys = ksNew (0, KS_END);
 
-	Key * k = 0;
-	while ((k = ksNext (oldKeys)) != 0)
+	elektraKsDiff (oldKeys, returned, addedKeys, removedKeys, changedKeys);
+
+	const char * announce = keyString (ksLookupByName (elektraPluginGetConfig (handle), "/announce", 0));
+	if (!strcmp (announce, "prefix"))
 	{
-		Key * p = ksLookup (addedKeys, k, KDB_O_POP);
-		// Note: keyDel not needed, because at least two references exist
-		if (p)
-		{
-			if (keyNeedSync (p))
-			{
-				ksAppendKey (changedKeys, p);
-			}
-		}
-		else
-		{
-			ksAppendKey (removedKeys, k);
-		}
+		if (!strncmp (keyName (parentKey), "user", 4))
+			announcePrefixes (parentKey, addedKeys, changedKeys, removedKeys, DBUS_BUS_SESSION);
+		else if (!strncmp (keyName (parentKey), "system", 6))
+			announcePrefixes (parentKey, addedKeys, changedKeys, removedKeys, DBUS_BUS_SYSTEM);
 	}
-
-	if (!strncmp (keyString (ksLookupByName (elektraPluginGetConfig (handle), "/announce", 0)), "once", 4))
+	else if (!strncmp (announce, "once", 4))
 	{
 		if (!strncmp (keyName (parentKey), "user", 4)) elektraDbusSendMessage (DBUS_BUS_SESSION, keyName (parentKey), "Commit");
 		if (!strncmp (keyName (parentKey), "system", 6)) elektraDbusSendMessage (DBUS_BUS_SYSTEM, keyName (parentKey), "Commit");
@@ -18,6 +18,7 @@
 
 
 int elektraDbusSendMessage (DBusBusType type, const char * keyName, const char * signalName);
+int elektraDbusSendPrefixesMessage (DBusBusType type, const char * keyName, const char * signalName, KeySet * prefixes);
 int elektraDbusReceiveMessage (DBusBusType type, DBusHandleMessageFunction filter_func);
 
 int elektraDbusClose (Plugin * handle, Key * errorKey);
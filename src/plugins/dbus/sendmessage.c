@@ -15,7 +15,39 @@
 
 #include <kdblogger.h>
 
-int elektraDbusSendMessage (DBusBusType type, const char * keyName, const char * signalName)
+/**
+ * @brief Appends the names of all keys in prefixes as array of strings
+ *
+ * @retval 0 if out of memory
+ */
+static dbus_bool_t appendPrefixes (DBusMessage * message, KeySet * prefixes)
+{
+	DBusMessageIter args;
+	DBusMessageIter array;
+	dbus_message_iter_init_append (message, &args);
+	if (!dbus_message_iter_open_container (&args, DBUS_TYPE_ARRAY, DBUS_TYPE_STRING_AS_STRING, &array)) return FALSE;
+
+	ksRewind (prefixes);
+	Key * k = 0;
+	while ((k = ksNext (prefixes)) != 0)
+	{
+		const char * name = keyName (k);
+		if (!dbus_message_iter_append_basic (&array, DBUS_TYPE_STRING, &name))
+		{
+			dbus_message_iter_abandon_container (&args, &array);
+			return FALSE;
+		}
+	}
+	return dbus_message_iter_close_container (&args, &array);
+}
+
+/**
+ * @brief Sends the signal signalName with the string keyName and, if given, the names of prefixes as arguments
+ *
+ * @retval 1 on success
+ * @retval -1 if the signal could not be sent
+ */
+static int sendMessage (DBusBusType type, const char * keyName, const char * signalName, KeySet * prefixes)
 {
 	DBusConnection * connection;
 	DBusError error;
@@ -64,6 +96,15 @@ int elektraDbusSendMessage (DBusBusType type, const char * keyName, const char *
 		return -1;
 	}
 
+	if (prefixes && !appendPrefixes (message, prefixes))
+	{
+		ELEKTRA_LOG_WARNING ("Couldn't add message argument");
+		dbus_message_unref (message);
+		dbus_connection_unref (connection);
+		dbus_error_free (&error);
+		return -1;
+	}
+
 	dbus_connection_send (connection, message, NULL);
 	dbus_connection_flush (connection);
 
@@ -73,3 +114,18 @@ int elektraDbusSendMessage (DBusBusType type, const char * keyName, const char *
 
 	return 1;
 }
+
+int elektraDbusSendMessage (DBusBusType type, const char * keyName, const char * signalName)
+{
+	return sendMessage (type, keyName, signalName, 0);
+}
+
+/**
+ * @brief Sends a single signal announcing all prefixes below which keys were changed
+ *
+ * The signal has the arguments keyName and an array containing the names of prefixes.
+ */
+int elektraDbusSendPrefixesMessage (DBusBusType type, const char * keyName, const char * signalName, KeySet * prefixes)
+{
+	return sendMessage (type, keyName, signalName, prefixes);
+}
@@ -14,6 +14,9 @@
 
 #include <stdio.h>
 
+#include <tests_internal.h>
+#include <tests_plugin.h>
+
 void print_message (DBusMessage * message, dbus_bool_t literal);
 
 DBusHandlerResult callback (DBusConnection * connection ELEKTRA_UNUSED, DBusMessage * message, void * user_data ELEKTRA_UNUSED)
@@ -26,6 +29,172 @@ DBusHandlerResult callback (DBusConnection * connection ELEKTRA_UNUSED, DBusMess
 	return DBUS_HANDLER_RESULT_HANDLED;
 }
 
+/**
+ * Opens an own connection to the session bus, which receives the signals of the plugin.
+ *
+ * @retval NULL if there is no session bus, e.g. if not run with dbus-run-session
+ */
+static DBusConnection * openReceiver (void)
+{
+	DBusError error;
+	dbus_error_init (&error);
+	DBusConnection * connection = dbus_bus_get_private (DBUS_BUS_SESSION, &error);
+	if (connection)
+	{
+		dbus_connection_set_exit_on_disconnect (connection, FALSE);
+		dbus_bus_add_match (connection, "type='signal',interface='org.libelektra',path='/org/libelektra/configuration'", &error);
+	}
+	if (dbus_error_is_set (&error))
+	{
+		printf ("no session bus, skipping tests with signals: %s\n", error.message);
+		if (connection)
+		{
+			dbus_connection_close (connection);
+			dbus_connection_unref (connection);
+		}
+		connection = NULL;
+	}
+	dbus_error_free (&error);
+	return connection;
+}
+
+static void closeReceiver (DBusConnection * connection)
+{
+	dbus_connection_close (connection);
+	dbus_connection_unref (connection);
+}
+
+/**
+ * Receives signals until none arrived for a while.
+ *
+ * @param parent gets the name of the parent key of the last Commit signal
+ * @param prefixes gets a key for every prefix of the last Commit signal
+ *
+ * @return the number of Commit signals received
+ */
+static int receiveCommits (DBusConnection * connection, Key * parent, KeySet * prefixes)
+{
+	int commits = 0;
+	int idle = 0;
+	while (idle < 3 && dbus_connection_read_write (connection, 100))
+	{
+		DBusMessage * message = dbus_connection_pop_message (connection);
+		if (!message)
+		{
+			++idle;
+			continue;
+		}
+		idle = 0;
+		if (!dbus_message_is_signal (message, "org.libelektra", "Commit"))
+		{
+			dbus_message_unref (message);
+			continue;
+		}
+
+		++commits;
+		ksClear (prefixes);
+		DBusMessageIter args;
+		if (dbus_message_iter_init (message, &args) && dbus_message_iter_get_arg_type (&args) == DBUS_TYPE_STRING)
+		{
+			const char * name;
+			dbus_message_iter_get_basic (&args, &name);
+			keySetName (parent, name);
+			dbus_message_iter_next (&args);
+		}
+		if (dbus_message_iter_get_arg_type (&args) == DBUS_TYPE_ARRAY)
+		{
+			DBusMessageIter array;
+			dbus_message_iter_recurse (&args, &array);
+			while (dbus_message_iter_get_arg_type (&array) == DBUS_TYPE_STRING)
+			{
+				const char * name;
+				dbus_message_iter_get_basic (&array, &name);
+				ksAppendKey (prefixes, keyNew (name, KEY_END));
+				dbus_message_iter_next (&array);
+			}
+		}
+		dbus_message_unref (message);
+	}
+	return commits;
+}
+
+/**
+ * @return the keys as they are after kdbGet, without the sync flag
+ */
+static KeySet * createKeys (void)
+{
+	KeySet * ks = ksNew (10, keyNew ("user/tests/dbus", KEY_END), keyNew ("user/tests/dbus/a", KEY_END),
+			     keyNew ("user/tests/dbus/a/b", KEY_END), keyNew ("user/tests/dbus/a/b/c", KEY_VALUE, "c", KEY_END),
+			     keyNew ("user/tests/dbus/a/b/c/d", KEY_VALUE, "d", KEY_END),
+			     keyNew ("user/tests/dbus/e/f", KEY_VALUE, "f", KEY_END),
+			     keyNew ("user/tests/dbus/g/h", KEY_VALUE, "h", KEY_END), KS_END);
+	Key * cur;
+	ksRewind (ks);
+	while ((cur = ksNext (ks)) != NULL)
+	{
+		keyClearSync (cur);
+	}
+	return ks;
+}
+
+static void test_announcePrefix (void)
+{
+	DBusConnection * receiver = openReceiver ();
+	if (!receiver) return;
+
+	Key * parentKey = keyNew ("user/tests/dbus", KEY_END);
+	KeySet * conf = ksNew (1, keyNew ("user/announce", KEY_VALUE, "prefix", KEY_END), KS_END);
+	PLUGIN_OPEN ("dbus");
+
+	KeySet * ks = createKeys ();
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) >= 1, "call to kdbGet was not successful");
+
+	Key * parent = keyNew ("/", KEY_CASCADING_NAME, KEY_END);
+	KeySet * prefixes = ksNew (0, KS_END);
+
+	// nothing changed
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) >= 1, "call to kdbSet was not successful");
+	succeed_if (receiveCommits (receiver, parent, prefixes) == 0, "no signal should be sent without changes");
+
+	// change keys below a/b/c and a, add e/f/x and remove g/h
+	ksDel (ks);
+	ks = createKeys ();
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) >= 1, "call to kdbGet was not successful");
+	keySetString (ksLookupByName (ks, "user/tests/dbus/a/b/c/d", 0), "changed");
+	keySetString (ksLookupByName (ks, "user/tests/dbus/a/b", 0), "changed");
+	ksAppendKey (ks, keyNew ("user/tests/dbus/e/f/x", KEY_VALUE, "x", KEY_END));
+	keyDel (ksLookupByName (ks, "user/tests/dbus/g/h", KDB_O_POP));
+
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) >= 1, "call to kdbSet was not successful");
+	succeed_if (receiveCommits (receiver, parent, prefixes) == 1, "exactly one signal should be sent");
+	succeed_if_same_string (keyName (parent), "user/tests/dbus");
+
+	KeySet * expected = ksNew (3, keyNew ("user/tests/dbus/a", KEY_END), keyNew ("user/tests/dbus/e/f", KEY_END),
+				   keyNew ("user/tests/dbus/g", KEY_END), KS_END);
+	compare_keyset (prefixes, expected);
+	ksDel (expected);
+
+	// a change of the parent key itself is announced with the parent key
+	ksDel (ks);
+	ks = createKeys ();
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) >= 1, "call to kdbGet was not successful");
+	keySetString (ksLookupByName (ks, "user/tests/dbus", 0), "changed");
+	keySetString (ksLookupByName (ks, "user/tests/dbus/e/f", 0), "changed");
+
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) >= 1, "call to kdbSet was not successful");
+	succeed_if (receiveCommits (receiver, parent, prefixes) == 1, "exactly one signal should be sent");
+	expected = ksNew (1, keyNew ("user/tests/dbus", KEY_END), KS_END);
+	compare_keyset (prefixes, expected);
+	ksDel (expected);
+
+	ksDel (prefixes);
+	keyDel (parent);
+	ksDel (ks);
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+	closeReceiver (receiver);
+}
+
 int main (int argc, char ** argv)
 {
 	if (argc == 2)
@@ -34,5 +203,25 @@ int main (int argc, char ** argv)
 		if (!strcmp (argv[1], "send_system")) elektraDbusSendMessage (DBUS_BUS_SYSTEM, "test2", "KeyChanged");
 		if (!strcmp (argv[1], "receive_session")) elektraDbusReceiveMessage (DBUS_BUS_SESSION, callback);
 		if (!strcmp (argv[1], "receive_system")) elektraDbusReceiveMessage (DBUS_BUS_SYSTEM, callback);
+		return 0;
+	}
+
+	printf ("DBUS       TESTS\n");
+	printf ("================\n\n");
+
+	// signals are only tested if a session bus is available, e.g. with dbus-run-session
+	char * address = getenv ("DBUS_SESSION_BUS_ADDRESS");
+	if (address) address = elektraStrDup (address);
+	init (argc, argv); // clears the environment
+	if (address)
+	{
+		setenv ("DBUS_SESSION_BUS_ADDRESS", address, 1);
+		elektraFree (address);
 	}
+
+	test_announcePrefix ();
+
+	print_result ("testmod_dbus");
+
+	return nbError;
 }
@@ -15,7 +15,7 @@
 #include "enum.h"
 #include <ctype.h>
 #include <kdberrors.h>
-#include <kdbmeta.h>
+#include <kdbhelper.h>
 #include <kdbutility.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -23,7 +23,40 @@
 #include <strings.h>
 
 
-static int validateKey (Key *, Key *);
+/**
+ * A value of an enum. Values of an array may occur several times,
+ * each occurrence may be used once by a multi enum.
+ */
+typedef struct
+{
+	char * value; // NULL for empty slots of the hash set
+	size_t count; // occurrences within the array
+	size_t used;  // occurrences used by the current multi enum
+	size_t stamp; // validation in which used was counted
+} EnumValue;
+
+/**
+ * The parsed form of a check/enum, shared by all keys with the same enum.
+ */
+typedef struct
+{
+	char * definition; // value of check/enum, or the values of the array separated by '\0'
+	size_t size;	   // size of definition
+	int isArray;
+	size_t elements; // number of values including duplicates
+	EnumValue * values;
+	size_t capacity; // of the hash set values, a power of two
+} Enum;
+
+typedef struct
+{
+	Enum ** enums; // sorted by isArray and definition
+	size_t size;
+	size_t alloc;
+	char * buffer; // definition of the array of the key currently validated
+	size_t bufferSize;
+	size_t stamp;
+} EnumData;
 
 // turn list into null-terminated array. strip quotes from elements and
 // drop brackets from the beginning and end of the list
@@ -38,7 +71,7 @@ static char ** stringToArray (const char * string, const char * delim)
 
 	while (*ptr)
 	{
-		if (*ptr == *delim)
+		if (strchr (delim, *ptr))
 		{
 			++elems;
 		}
@@ -46,37 +79,41 @@ static char ** stringToArray (const char * string, const char * delim)
 	}
 	++elems; // terminating element
 	array = elektraCalloc (elems * sizeof (char *));
+	if (!array) return NULL;
 	char * localString = NULL;
 	if (string[0] == '[' || string[0] == '(' || string[0] == '{')
 		localString = elektraStrDup (string + 1);
 	else
 		localString = elektraStrDup (string);
-	char lastChar = localString[strlen (localString) - 1];
-	if (lastChar == ']' || lastChar == ')' || lastChar == '}') localString[strlen (localString) - 1] = '\0';
+	if (!localString)
+	{
+		elektraFree (array);
+		return NULL;
+	}
+	size_t length = strlen (localString);
+	char lastChar = length ? localString[length - 1] : '\0';
+	if (lastChar == ']' || lastChar == ')' || lastChar == '}') localString[length - 1] = '\0';
 
 	int current = 0;
-	ptr = strtok (localString, delim);
+	char * saveptr = NULL; // strtok_r, because keys may be checked on several threads
+	ptr = strtok_r (localString, delim, &saveptr);
 	while (ptr)
 	{
 		if (*ptr == '\0')
 		{
-			ptr = strtok (NULL, delim);
+			ptr = strtok_r (NULL, delim, &saveptr);
 			continue;
 		}
 		char * tmp = elektraStrDup (ptr);
 		char * start = elektraLskip (tmp);
 		(void)elektraRstrip (start, NULL);
 		if (start[0] == '\'') ++start;
-		if (start[strlen (start) - 1] == '\'') start[strlen (start) - 1] = '\0';
+		if (start[0] != '\0' && start[strlen (start) - 1] == '\'') start[strlen (start) - 1] = '\0';
 		array[current++] = elektraStrDup (start);
 		elektraFree (tmp);
-		ptr = strtok (NULL, delim);
-	}
-	if (current + 1 < elems)
-	{
-		elektraRealloc ((void **)array, (current + 1) * (sizeof (char *)));
-		array[current] = NULL;
+		ptr = strtok_r (NULL, delim, &saveptr);
 	}
+	// the array was zeroed, so it is terminated after the last element
 	elektraFree (localString);
 	return array;
 }
@@ -90,129 +127,297 @@ static void freeArray (char ** array)
 	elektraFree (array);
 }
 
-static int validateWithList (Key * key, const char * meta)
+static void freeEnum (Enum * e)
 {
-	const char * validValues = keyString (keyGetMeta (key, meta));
-	const Key * multiEnum = keyGetMeta (key, "check/enum/multi");
-	char ** list = stringToArray (validValues, ",");
-	if (!list) return 0;
+	for (size_t i = 0; i < e->capacity; ++i)
+	{
+		if (e->values[i].value) elektraFree (e->values[i].value);
+	}
+	if (e->values) elektraFree (e->values);
+	elektraFree (e->definition);
+	elektraFree (e);
+}
 
-	if (!multiEnum)
+static size_t hashValue (const char * value)
+{
+	// FNV-1a
+	size_t hash = 2166136261u;
+	for (; *value; ++value)
 	{
-		const char * value = keyString (key);
-		for (size_t i = 0; list[i] != NULL; ++i)
-		{
-			if (!strcmp (list[i], value))
-			{
-				freeArray (list);
-				return 1;
-			}
-		}
+		hash = (hash ^ (unsigned char)*value) * 16777619u;
+	}
+	return hash;
+}
+
+static EnumValue * findValue (Enum * e, const char * value)
+{
+	size_t mask = e->capacity - 1;
+	for (size_t i = hashValue (value) & mask;; i = (i + 1) & mask)
+	{
+		if (!e->values[i].value || !strcmp (e->values[i].value, value)) return &e->values[i];
+	}
+}
+
+/**
+ * @brief adds value to the hash set of e, the set must be large enough
+ *
+ * @retval -1 if out of memory
+ */
+static int addValue (Enum * e, const char * value)
+{
+	EnumValue * slot = findValue (e, value);
+	if (!slot->value)
+	{
+		slot->value = elektraStrDup (value);
+		if (!slot->value) return -1;
+	}
+	++slot->count;
+	return 0;
+}
+
+/**
+ * @brief builds the hash set of the values of an enum from its definition
+ *
+ * @return the parsed enum, which takes ownership of definition
+ * @retval NULL if out of memory
+ */
+static Enum * compileEnum (char * definition, size_t size, int isArray)
+{
+	Enum * e = elektraCalloc (sizeof (Enum));
+	if (!e)
+	{
+		elektraFree (definition);
+		return NULL;
+	}
+	e->definition = definition;
+	e->size = size;
+	e->isArray = isArray;
+
+	char ** list = NULL;
+	if (isArray)
+	{
+		for (size_t i = 0; i < size; i += strlen (definition + i) + 1)
+			++e->elements;
 	}
 	else
 	{
-		char * delim = (char *)keyString (multiEnum);
-		char ** array = stringToArray (keyString (key), delim);
-		if (!array)
+		list = stringToArray (definition, ",");
+		if (!list) goto error;
+		while (list[e->elements])
+			++e->elements;
+	}
+
+	e->capacity = 16;
+	while (e->capacity < 2 * e->elements)
+		e->capacity *= 2;
+	e->values = elektraCalloc (e->capacity * sizeof (EnumValue));
+	if (!e->values) goto error;
+
+	if (isArray)
+	{
+		for (size_t i = 0; i < size; i += strlen (definition + i) + 1)
 		{
-			freeArray (list);
-			return 0;
+			if (addValue (e, definition + i) < 0) goto error;
 		}
-		for (size_t i = 0; array[i] != NULL; ++i)
+	}
+	else
+	{
+		for (size_t i = 0; list[i] != NULL; ++i)
 		{
-			int found = 0;
-			for (size_t j = 0; list[j] != NULL; ++j)
-			{
-				if (!strcmp (array[i], list[j]))
-				{
-					found = 1;
-					break;
-				}
-			}
-			if (!found)
-			{
-				freeArray (array);
-				freeArray (list);
-				return 0;
-			}
+			if (addValue (e, list[i]) < 0) goto error;
 		}
 		freeArray (list);
-		freeArray (array);
-		return 1;
 	}
-	freeArray (list);
+	return e;
+
+error:
+	if (list) freeArray (list);
+	freeEnum (e);
+	return NULL;
+}
+
+/**
+ * @brief appends value including its terminating null to the buffer of data
+ *
+ * @retval -1 if out of memory
+ */
+static int appendToBuffer (EnumData * data, size_t * size, const char * value)
+{
+	size_t length = strlen (value) + 1;
+	if (*size + length > data->bufferSize)
+	{
+		size_t bufferSize = data->bufferSize ? data->bufferSize : 256;
+		while (bufferSize < *size + length)
+			bufferSize *= 2;
+		if (elektraRealloc ((void **)&data->buffer, bufferSize) < 0) return -1;
+		data->bufferSize = bufferSize;
+	}
+	memcpy (data->buffer + *size, value, length);
+	*size += length;
 	return 0;
 }
 
-static int validateWithArray (Key * key)
+/**
+ * @brief collects the values of the meta array check/enum of key in the buffer of data
+ *
+ * Like elektraMetaArrayToKS the array starts with the value of check/enum
+ * itself and ends before the first missing index.
+ *
+ * @return the size of the definition in the buffer
+ * @retval -1 if out of memory
+ */
+static ssize_t readArray (EnumData * data, Key * key, const Key * meta)
 {
+	size_t size = 0;
+	if (appendToBuffer (data, &size, keyString (meta)) < 0) return -1;
+
+	char name[sizeof ("check/enum/") + ELEKTRA_MAX_ARRAY_SIZE];
+	const size_t prefixLength = sizeof ("check/enum/") - 1;
+	strcpy (name, "check/enum/");
+	kdb_long_long_t index = 0;
+	elektraWriteArrayNumber (name + prefixLength, index);
+
+	// the elements follow each other in the metadata, so iterating is cheaper than looking up each of them
+	const Key * cur;
+	keyRewindMeta (key);
+	while ((cur = keyNextMeta (key)) != NULL)
+	{
+		if (strcmp (keyName (cur), name)) continue;
+		if (appendToBuffer (data, &size, keyString (cur)) < 0) return -1;
+		elektraWriteArrayNumber (name + prefixLength, ++index);
+	}
+	return size;
+}
+
+static int compareEnum (const Enum * e, int isArray, const char * definition, size_t size)
+{
+	if (e->isArray != isArray) return e->isArray - isArray;
+	int cmp = memcmp (e->definition, definition, e->size < size ? e->size : size);
+	if (cmp) return cmp;
+	return (e->size > size) - (e->size < size);
+}
+
+/**
+ * @brief returns the parsed enum of key, every distinct enum is only parsed once per plugin handle
+ *
+ * @retval NULL if out of memory
+ */
+static Enum * getEnum (EnumData * data, Key * key)
+{
+	const Key * meta = keyGetMeta (key, "check/enum");
+	int isArray = keyString (meta)[0] == '#';
+	const char * definition;
+	size_t size;
+	if (isArray)
+	{
+		ssize_t arraySize = readArray (data, key, meta);
+		if (arraySize < 0) return NULL;
+		definition = data->buffer;
+		size = arraySize;
+	}
+	else
+	{
+		definition = keyString (meta);
+		size = keyGetValueSize (meta);
+	}
+
+	size_t lower = 0;
+	size_t upper = data->size;
+	while (lower < upper)
+	{
+		size_t middle = lower + (upper - lower) / 2;
+		int cmp = compareEnum (data->enums[middle], isArray, definition, size);
+		if (cmp == 0) return data->enums[middle];
+		if (cmp < 0)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+
+	if (data->size == data->alloc)
+	{
+		size_t alloc = data->alloc ? data->alloc * 2 : 16;
+		if (elektraRealloc ((void **)&data->enums, alloc * sizeof (Enum *)) < 0) return NULL;
+		data->alloc = alloc;
+	}
+	char * copy = elektraMalloc (size);
+	if (!copy) return NULL;
+	memcpy (copy, definition, size);
+	Enum * e = compileEnum (copy, size, isArray);
+	if (!e) return NULL;
+	memmove (data->enums + lower + 1, data->enums + lower, (data->size - lower) * sizeof (Enum *));
+	data->enums[lower] = e;
+	++data->size;
+	return e;
+}
+
+static void freeData (EnumData * data)
+{
+	for (size_t i = 0; i < data->size; ++i)
+	{
+		freeEnum (data->enums[i]);
+	}
+	if (data->enums) elektraFree (data->enums);
+	if (data->buffer) elektraFree (data->buffer);
+}
+
+/**
+ * @retval 1 if the value of key is one of the values of e
+ * @retval 0 if not
+ * @retval -1 if out of memory
+ */
+static int validateWithEnum (EnumData * data, Enum * e, Key * key)
+{
+	// an array needs at least one element besides check/enum itself
+	if (e->isArray && e->elements < 2) return 0;
+
 	const Key * multiEnum = keyGetMeta (key, "check/enum/multi");
-	KeySet * validValues = elektraMetaArrayToKS (key, "check/enum");
-
-	Key * cur;
-	// got to first element
-	ksNext (validValues);
-	cur = ksNext (validValues);
-	int rc = 0;
-	if (cur)
+	if (!multiEnum)
 	{
-		if (multiEnum)
+		return findValue (e, keyString (key))->value != NULL;
+	}
+
+	char * delim = (char *)keyString (multiEnum);
+	char ** array = stringToArray (keyString (key), delim);
+	if (!array) return -1;
+	++data->stamp;
+	int rc = 1;
+	for (size_t i = 0; array[i] != NULL; ++i)
+	{
+		EnumValue * value = findValue (e, array[i]);
+		if (!value->value)
 		{
-			char * delim = (char *)keyString (multiEnum);
-			char ** array = stringToArray (keyString (key), delim);
-			if (!array)
-			{
-				goto VALIDATE_END;
-			}
-			for (size_t i = 0; array[i] != NULL; ++i)
-			{
-				int found = 0;
-				ksRewind (validValues);
-				while ((cur = ksNext (validValues)) != NULL)
-				{
-					if (!strcmp (array[i], keyString (cur)))
-					{
-						keyDel (ksLookup (validValues, cur, KDB_O_POP));
-						found = 1;
-						break;
-					}
-				}
-				if (!found)
-				{
-					freeArray (array);
-					goto VALIDATE_END;
-				}
-			}
-			freeArray (array);
-			rc = 1;
-			goto VALIDATE_END;
+			rc = 0;
+			break;
 		}
-		else
+		if (!e->isArray) continue;
+
+		// every element of an array may only be used once
+		if (value->stamp != data->stamp)
+		{
+			value->stamp = data->stamp;
+			value->used = 0;
+		}
+		if (value->used == value->count)
 		{
-			ksRewind (validValues);
-			while ((cur = ksNext (validValues)) != NULL)
-			{
-				if (!strcmp (keyString (key), keyString (cur)))
-				{
-					rc = 1;
-					goto VALIDATE_END;
-				}
-			}
+			rc = 0;
+			break;
 		}
+		++value->used;
 	}
-VALIDATE_END:
-	ksDel (validValues);
+	freeArray (array);
 	return rc;
 }
 
-static int validateKey (Key * key, Key * parentKey)
+static int validateKeyWithData (EnumData * data, Key * key, Key * parentKey)
 {
-	int rc = 0;
-	const Key * meta = keyGetMeta (key, "check/enum");
-	if (keyString (meta)[0] != '#')
-		rc = validateWithList (key, "check/enum");
-	else
-		rc = validateWithArray (key);
+	Enum * e = getEnum (data, key);
+	int rc = e ? validateWithEnum (data, e, key) : -1;
+	if (rc < 0)
+	{
+		ELEKTRA_SET_ERROR (87, parentKey, "Out of memory");
+		return 0;
+	}
 	if (!rc)
 	{
 		ELEKTRA_SET_ERRORF (121, parentKey, "Validation of key \"%s\" with string \"%s\" failed.", keyName (key), keyString (key));
@@ -220,16 +425,52 @@ static int validateKey (Key * key, Key * parentKey)
 	return rc;
 }
 
-int elektraEnumGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_UNUSED, Key * parentKey ELEKTRA_UNUSED)
+static int validateKey (Key * key, Key * parentKey)
+{
+	EnumData data;
+	memset (&data, 0, sizeof (EnumData));
+	int rc = validateKeyWithData (&data, key, parentKey);
+	freeData (&data);
+	return rc;
+}
+
+int elektraEnumCheckKey (Plugin * handle, Key * key, Key * errorKey)
+{
+	return validateKeyWithData (elektraPluginGetData (handle), key, errorKey);
+}
+
+int elektraEnumOpen (Plugin * handle, Key * errorKey ELEKTRA_UNUSED)
+{
+	EnumData * data = elektraCalloc (sizeof (EnumData));
+	if (!data) return -1;
+	elektraPluginSetData (handle, data);
+	return 1; /* success */
+}
+
+int elektraEnumClose (Plugin * handle, Key * errorKey ELEKTRA_UNUSED)
+{
+	EnumData * data = elektraPluginGetData (handle);
+	if (!data) return 1;
+
+	freeData (data);
+	elektraFree (data);
+	elektraPluginSetData (handle, 0);
+	return 1; /* success */
+}
+
+int elektraEnumGet (Plugin * handle, KeySet * returned, Key * parentKey)
 {
 	if (!strcmp (keyName (parentKey), "system/elektra/modules/enum"))
 	{
 		KeySet * contract =
 			ksNew (30, keyNew ("system/elektra/modules/enum", KEY_VALUE, "enum plugin waits for your orders", KEY_END),
 			       keyNew ("system/elektra/modules/enum/exports", KEY_END),
+			       keyNew ("system/elektra/modules/enum/exports/open", KEY_FUNC, elektraEnumOpen, KEY_END),
+			       keyNew ("system/elektra/modules/enum/exports/close", KEY_FUNC, elektraEnumClose, KEY_END),
 			       keyNew ("system/elektra/modules/enum/exports/get", KEY_FUNC, elektraEnumGet, KEY_END),
 			       keyNew ("system/elektra/modules/enum/exports/set", KEY_FUNC, elektraEnumSet, KEY_END),
 			       keyNew ("system/elektra/modules/enum/exports/validateKey", KEY_FUNC, validateKey, KEY_END),
+			       keyNew ("system/elektra/modules/enum/exports/checkkey", KEY_FUNC, elektraEnumCheckKey, KEY_END),
 #include ELEKTRA_README (enum)
 			       keyNew ("system/elektra/modules/enum/infos/version", KEY_VALUE, PLUGINVERSION, KEY_END), KS_END);
 		ksAppend (returned, contract);
@@ -238,41 +479,21 @@ int elektraEnumGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_UN
 		return 1; /* success */
 	}
 	/* get all keys */
-	Key * cur;
-	ksRewind (returned);
-	while ((cur = ksNext (returned)) != NULL)
-	{
-		const Key * meta = keyGetMeta (cur, "check/enum");
-		if (!meta) continue;
-		if (!validateKey (cur, parentKey))
-		{
-			return -1;
-		}
-	}
-	return 1; /* success */
+	return elektraPluginCheckKeys (handle, returned, "check/enum", elektraEnumCheckKey, parentKey);
 }
 
-int elektraEnumSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_UNUSED, Key * parentKey ELEKTRA_UNUSED)
+int elektraEnumSet (Plugin * handle, KeySet * returned, Key * parentKey)
 {
 	/* set all keys */
-	Key * cur;
-	while ((cur = ksNext (returned)) != NULL)
-	{
-		const Key * meta = keyGetMeta (cur, "check/enum");
-		if (!meta) continue;
-		if (!validateKey (cur, parentKey))
-		{
-			return -1;
-		}
-	}
-
-	return 1; /* success */
+	return elektraPluginCheckKeys (handle, returned, "check/enum", elektraEnumCheckKey, parentKey);
 }
 
 Plugin * ELEKTRA_PLUGIN_EXPORT (enum)
 {
 	// clang-format off
     return elektraPluginExport ("enum", 
+            ELEKTRA_PLUGIN_OPEN, 	&elektraEnumOpen,
+            ELEKTRA_PLUGIN_CLOSE, 	&elektraEnumClose,
             ELEKTRA_PLUGIN_GET, 	&elektraEnumGet,
             ELEKTRA_PLUGIN_SET, 	&elektraEnumSet,
             ELEKTRA_PLUGIN_END);
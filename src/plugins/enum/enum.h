@@ -13,8 +13,11 @@
 #include <kdbplugin.h>
 
 
+int elektraEnumOpen (Plugin * handle, Key * errorKey);
+int elektraEnumClose (Plugin * handle, Key * errorKey);
 int elektraEnumGet (Plugin * handle, KeySet * ks, Key * parentKey);
 int elektraEnumSet (Plugin * handle, KeySet * ks, Key * parentKey);
+int elektraEnumCheckKey (Plugin * handle, Key * key, Key * errorKey);
 
 Plugin * ELEKTRA_PLUGIN_EXPORT (enum);
 
@@ -16,6 +16,8 @@
 #include <tests_internal.h>
 #include <tests_plugin.h>
 
+#include "enum.h"
+
 
 static void test (void)
 {
@@ -145,6 +147,108 @@ static void testMultiList (void)
 	PLUGIN_CLOSE ();
 }
 
+static void testSharedEnum (void)
+{
+	Key * parentKey = keyNew ("user/tests/enum", KEY_VALUE, "", KEY_END);
+	KeySet * conf = ksNew (0, KS_END);
+	PLUGIN_OPEN ("enum");
+
+	// the parsed list is reused for every key with the same enum
+	char list[4096] = "";
+	for (int i = 0; i < 300; ++i)
+	{
+		char value[16];
+		snprintf (value, sizeof (value), "%s'v%d'", i ? ", " : "", i);
+		strcat (list, value);
+	}
+	KeySet * ks = ksNew (0, KS_END);
+	for (int i = 0; i < 300; i += 7)
+	{
+		char name[64];
+		char value[16];
+		snprintf (name, sizeof (name), "user/tests/enum/key%d", i);
+		snprintf (value, sizeof (value), "v%d", i);
+		ksAppendKey (ks, keyNew (name, KEY_VALUE, value, KEY_META, "check/enum", list, KEY_END));
+	}
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "kdbSet failed");
+	ksAppendKey (ks, keyNew ("user/tests/enum/keyInvalid", KEY_VALUE, "v300", KEY_META, "check/enum", list, KEY_END));
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == -1, "kdbSet should have failed");
+	ksDel (ks);
+
+	// values occurring twice in an array may be used twice
+	ks = ksNew (20,
+		    keyNew ("user/tests/enum/twice", KEY_VALUE, "LOW LOW", KEY_META, "check/enum/multi", " ", KEY_META, "check/enum", "#2",
+			    KEY_META, "check/enum/#0", "LOW", KEY_META, "check/enum/#1", "LOW", KEY_META, "check/enum/#2", "HIGH", KEY_END),
+		    KS_END);
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "kdbSet failed");
+	ksDel (ks);
+
+	ks = ksNew (20,
+		    keyNew ("user/tests/enum/thrice", KEY_VALUE, "LOW LOW LOW", KEY_META, "check/enum/multi", " ", KEY_META, "check/enum", "#2",
+			    KEY_META, "check/enum/#0", "LOW", KEY_META, "check/enum/#1", "LOW", KEY_META, "check/enum/#2", "HIGH", KEY_END),
+		    KS_END);
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == -1, "kdbSet should have failed");
+	ksDel (ks);
+
+	// an array with another element is parsed separately
+	ks = ksNew (20,
+		    keyNew ("user/tests/enum/other", KEY_VALUE, "MIDDLE", KEY_META, "check/enum", "#2", KEY_META, "check/enum/#0", "LOW",
+			    KEY_META, "check/enum/#1", "MIDDLE", KEY_META, "check/enum/#2", "HIGH", KEY_END),
+		    KS_END);
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "kdbSet failed");
+	ksDel (ks);
+
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
+static void testThreadedMulti (void)
+{
+	Key * parentKey = keyNew ("user/tests/enum", KEY_VALUE, "", KEY_END);
+	KeySet * conf = ksNew (0, KS_END);
+	PLUGIN_OPEN ("enum");
+
+	// every key has its own enum, so all workers parse lists and multi values at the same time
+	KeySet * ks = ksNew (0, KS_END);
+	for (int i = 0; i < 4096; ++i)
+	{
+		char name[64];
+		char list[256];
+		char value[256];
+		snprintf (name, sizeof (name), "user/tests/enum/key%04d", i);
+		snprintf (list, sizeof (list), "'LOW', 'MIDDLE%d', 'HIGH', 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'VALUE%d'", i, i);
+		snprintf (value, sizeof (value), "LOW MIDDLE%d A B C D E F G H VALUE%d", i, i);
+		ksAppendKey (ks, keyNew (name, KEY_VALUE, value, KEY_META, "check/enum", list, KEY_META, "check/enum/multi", " ", KEY_END));
+	}
+
+	for (size_t workers = 2; workers <= 8; workers *= 2)
+	{
+		succeed_if (elektraPluginCheckKeysWith (plugin, ks, "check/enum", elektraEnumCheckKey, parentKey, workers, 0) == 1,
+			    "keys should be valid");
+		succeed_if (output_error (parentKey), "error for valid keys");
+		succeed_if (output_warnings (parentKey), "warnings for valid keys");
+	}
+
+	Key * invalid = ksLookupByName (ks, "user/tests/enum/key3000", 0);
+	keySetString (invalid, "LOW MIDDLE2999");
+	for (size_t workers = 2; workers <= 8; workers *= 2)
+	{
+		succeed_if (elektraPluginCheckKeysWith (plugin, ks, "check/enum", elektraEnumCheckKey, parentKey, workers, 0) == -1,
+			    "key should be invalid");
+		succeed_if (ksCurrent (ks) == invalid, "cursor should point to the invalid key");
+		keySetMeta (parentKey, "error", 0);
+	}
+
+	ksDel (ks);
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
 int main (int argc, char ** argv)
 {
 	printf ("ENUM     TESTS\n");
@@ -155,6 +259,8 @@ int main (int argc, char ** argv)
 	test ();
 	testArray ();
 	testMultiList ();
+	testSharedEnum ();
+	testThreadedMulti ();
 
 	print_result ("testmod_enum");
 
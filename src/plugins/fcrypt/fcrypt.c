@@ -7,6 +7,10 @@
  *
  */
 
+#ifdef ELEKTRA_FCRYPT_HAVE_MEMFD
+#define _GNU_SOURCE // provides memfd_create()
+#endif
+
 #ifndef HAVE_KDBCONFIG
 #include "kdbconfig.h"
 #endif
@@ -20,6 +24,7 @@
 #include <libgen.h> // provides basename()
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
@@ -40,6 +45,7 @@ struct _fcryptState
 {
 	enum FcryptGetState getState;
 	int tmpFileFd;
+	int tmpFileInMemory; // the temporary file is not linked into the file system
 	char * tmpFilePath;
 	char * originalFilePath;
 };
@@ -93,6 +99,115 @@ error:
 	return NULL;
 }
 
+#ifdef ELEKTRA_FCRYPT_HAVE_MEMFD
+/**
+ * @brief Creates an anonymous file, that only lives in memory, as temporary file.
+ *
+ * The file can be accessed by its path below /proc by GPG and by the storage plugin, so the plain text never lands on disk.
+ * @param file holds the path to the original file
+ * @param fd will hold the file descriptor to the file in memory in case of success
+ * @returns an allocated string holding the path to the file in memory or NULL if no such file can be created. Must be freed by the caller.
+ */
+static char * getMemoryFileName (const char * file, int * fd)
+{
+	char * fileDup = strdup (file);
+	if (!fileDup) return NULL;
+
+	// the name is only shown in /proc/self/fd, the file descriptor is inherited by GPG
+	*fd = memfd_create (basename (fileDup), 0);
+	free (fileDup);
+	if (*fd < 0) return NULL;
+
+	char path[64];
+	snprintf (path, sizeof (path), "/proc/self/fd/%d", *fd);
+	if (access (path, R_OK | W_OK))
+	{
+		// /proc is not available
+		close (*fd);
+		*fd = -1;
+		return NULL;
+	}
+	return elektraStrDup (path);
+}
+#endif
+
+/**
+ * @brief Allocates a new string holding the name of a temporary file, that is kept in memory if possible.
+ * @param conf holds the plugin configuration
+ * @param file holds the path to the original file
+ * @param fd will hold the file descriptor to the temporary file in case of success
+ * @param inMemory is set to 1 if the temporary file is not linked into the file system, 0 otherwise
+ * @returns an allocated string holding the name of the temporary file. Must be freed by the caller.
+ */
+static char * getTemporaryFile (KeySet * conf, const char * file, int * fd, int * inMemory)
+{
+#ifdef ELEKTRA_FCRYPT_HAVE_MEMFD
+	char * memoryFile = getMemoryFileName (file, fd);
+	if (memoryFile)
+	{
+		*inMemory = 1;
+		return memoryFile;
+	}
+#endif
+	*inMemory = 0;
+	return getTemporaryFileName (conf, file, fd);
+}
+
+/**
+ * @brief Overwrites the file at path with the content of the temporary file.
+ *
+ * The file is overwritten in place, so that no remains of its previous content are left on disk.
+ * @param tmpFileFd holds the file descriptor to the temporary file
+ * @param path holds the path to the file to be overwritten
+ * @param errorKey holds an error description in case of failure
+ * @retval 1 on success
+ * @retval -1 on failure. In this case errorKey holds an error description.
+ */
+static int overwriteWithTemporaryFile (int tmpFileFd, const char * path, Key * errorKey)
+{
+	kdb_octet_t buffer[4096];
+	struct stat fileStat;
+	off_t written = 0;
+	ssize_t readCount;
+
+	int fd = open (path, O_WRONLY);
+	if (fd < 0 || fstat (fd, &fileStat) || lseek (tmpFileFd, 0, SEEK_SET))
+	{
+		goto error;
+	}
+
+	while ((readCount = read (tmpFileFd, buffer, sizeof (buffer))) > 0)
+	{
+		if (write (fd, buffer, readCount) != readCount) goto error;
+		written += readCount;
+	}
+	if (readCount < 0) goto error;
+
+	// overwrite the rest of the previous content
+	memset (buffer, 0, sizeof (buffer));
+	for (off_t i = written; i < fileStat.st_size; i += sizeof (buffer))
+	{
+		if (write (fd, buffer, sizeof (buffer)) != sizeof (buffer)) goto error;
+	}
+	if (ftruncate (fd, written)) goto error;
+
+	memset (buffer, 0, sizeof (buffer));
+	if (close (fd))
+	{
+		ELEKTRA_ADD_WARNINGF (ELEKTRA_WARNING_FCRYPT_CLOSE, errorKey, "%s", strerror (errno));
+	}
+	return 1;
+
+error:
+	ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_FCRYPT_RENAME, errorKey, "Overwriting file %s failed because: %s", path, strerror (errno));
+	memset (buffer, 0, sizeof (buffer));
+	if (fd >= 0 && close (fd))
+	{
+		ELEKTRA_ADD_WARNINGF (ELEKTRA_WARNING_FCRYPT_CLOSE, errorKey, "%s", strerror (errno));
+	}
+	return -1;
+}
+
 /**
  * @brief Overwrites the content of the given file with zeroes.
  * @param fd holds the file descriptor to the temporary file to be shredded
@@ -194,11 +309,27 @@ static size_t getRecipientCount (KeySet * config, const char * keyName)
 	return recipientCount;
 }
 
-static int fcryptGpgCallAndCleanup (Key * parentKey, KeySet * pluginConfig, char ** argv, int argc, int tmpFileFd, char * tmpFile)
+static int fcryptGpgCallAndCleanup (Key * parentKey, KeySet * pluginConfig, char ** argv, int argc, int tmpFileFd, char * tmpFile,
+				    int tmpFileInMemory)
 {
 	int parentKeyFd = -1;
 	int result = CRYPTO_PLUGIN_FUNCTION (gpgCall) (pluginConfig, parentKey, NULL, argv, argc);
 
+	if (tmpFileInMemory)
+	{
+		// the temporary file is released together with its file descriptor
+		if (result == 1)
+		{
+			result = overwriteWithTemporaryFile (tmpFileFd, keyString (parentKey), parentKey);
+		}
+		if (close (tmpFileFd))
+		{
+			ELEKTRA_ADD_WARNINGF (ELEKTRA_WARNING_FCRYPT_CLOSE, parentKey, "%s", strerror (errno));
+		}
+		elektraFree (tmpFile);
+		return result;
+	}
+
 	if (result == 1)
 	{
 		parentKeyFd = open (keyString (parentKey), O_WRONLY);
@@ -264,7 +395,8 @@ static int fcryptEncrypt (KeySet * pluginConfig, Key * parentKey)
 	}
 
 	int tmpFileFd = -1;
-	char * tmpFile = getTemporaryFileName (pluginConfig, keyString (parentKey), &tmpFileFd);
+	int tmpFileInMemory = 0;
+	char * tmpFile = getTemporaryFile (pluginConfig, keyString (parentKey), &tmpFileFd, &tmpFileInMemory);
 	if (!tmpFile)
 	{
 		ELEKTRA_SET_ERROR (87, parentKey, "Memory allocation failed");
@@ -386,8 +518,9 @@ static int fcryptEncrypt (KeySet * pluginConfig, Key * parentKey)
 	// NOTE the encryption process works like this:
 	// gpg2 --batch --yes -o encryptedFile -r keyID -e configFile
 	// mv encryptedFile configFile
+	// if encryptedFile is kept in memory, its content is written to configFile instead
 
-	return fcryptGpgCallAndCleanup (parentKey, pluginConfig, argv, argc, tmpFileFd, tmpFile);
+	return fcryptGpgCallAndCleanup (parentKey, pluginConfig, argv, argc, tmpFileFd, tmpFile, tmpFileInMemory);
 }
 
 /**
@@ -401,7 +534,8 @@ static int fcryptEncrypt (KeySet * pluginConfig, Key * parentKey)
 static int fcryptDecrypt (KeySet * pluginConfig, Key * parentKey, fcryptState * state)
 {
 	int tmpFileFd = -1;
-	char * tmpFile = getTemporaryFileName (pluginConfig, keyString (parentKey), &tmpFileFd);
+	int tmpFileInMemory = 0;
+	char * tmpFile = getTemporaryFile (pluginConfig, keyString (parentKey), &tmpFileFd, &tmpFileInMemory);
 	if (!tmpFile)
 	{
 		ELEKTRA_SET_ERROR (87, parentKey, "Memory allocation failed");
@@ -450,13 +584,14 @@ static int fcryptDecrypt (KeySet * pluginConfig, Key * parentKey, fcryptState *
 		state->originalFilePath = strdup (keyString (parentKey));
 		state->tmpFilePath = tmpFile;
 		state->tmpFileFd = tmpFileFd;
+		state->tmpFileInMemory = tmpFileInMemory;
 		keySetString (parentKey, tmpFile);
 	}
 	else
 	{
 		// if anything went wrong above the temporary file is shredded and removed
 		shredTemporaryFile (tmpFileFd, parentKey);
-		if (unlink (tmpFile))
+		if (!tmpFileInMemory && unlink (tmpFile))
 		{
 			ELEKTRA_ADD_WARNINGF (ELEKTRA_WARNING_FCRYPT_UNLINK, parentKey, "Affected file: %s, error description: %s", tmpFile,
 					      strerror (errno));
@@ -486,6 +621,7 @@ int ELEKTRA_PLUGIN_FUNCTION (ELEKTRA_PLUGIN_NAME, open) (Plugin * handle, KeySet
 
 	s->getState = PREGETSTORAGE;
 	s->tmpFileFd = -1;
+	s->tmpFileInMemory = 0;
 	s->tmpFilePath = NULL;
 	s->originalFilePath = NULL;
 
@@ -570,7 +706,7 @@ int ELEKTRA_PLUGIN_FUNCTION (ELEKTRA_PLUGIN_NAME, get) (Plugin * handle, KeySet
 				ELEKTRA_ADD_WARNINGF (ELEKTRA_WARNING_FCRYPT_CLOSE, parentKey, "%s", strerror (errno));
 			}
 			s->tmpFileFd = -1;
-			if (unlink (s->tmpFilePath))
+			if (!s->tmpFileInMemory && unlink (s->tmpFilePath))
 			{
 				ELEKTRA_ADD_WARNINGF (ELEKTRA_WARNING_FCRYPT_UNLINK, parentKey, "Affected file: %s, error description: %s",
 						      s->tmpFilePath, strerror (errno));
@@ -14,6 +14,7 @@
 #include <string.h>
 #include <tests_internal.h>
 #include <tests_plugin.h>
+#include <unistd.h>
 
 #include <gpg.h>
 #include <test_key.h>
@@ -190,10 +191,13 @@ static void test_file_crypto_operations (void)
 			// try to decrypt the file again (simulating the pregetstorage call)
 			succeed_if (plugin->kdbGet (plugin, data, parentKey) == 1, "kdb get (pregetstorage) failed");
 			succeed_if (isTestFileCorrect (keyString (parentKey)) == 1, "file content could not be restored during decryption");
+			char * decryptedFile = elektraStrDup (keyString (parentKey));
 
 			// a second call to kdb get (the postgetstorage call) should re-encrypt the file again
 			succeed_if (plugin->kdbGet (plugin, data, parentKey) == 1, "kdb get (postgetstorage) failed");
 			succeed_if (isTestFileCorrect (tmpFile) == -1, "postgetstorage did not encrypt the file again");
+			succeed_if (access (decryptedFile, F_OK) != 0, "postgetstorage did not remove the decrypted file");
+			elektraFree (decryptedFile);
 
 			remove (tmpFile);
 		}
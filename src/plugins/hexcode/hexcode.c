@@ -17,46 +17,28 @@
 #include <stdlib.h>
 #include <string.h>
 
+/**
+  * Gives the integer number 0-15 for every hex character
+  * '0'-'9', 'a'-'f' or 'A'-'F' and 0 for all other characters.
+  */
+static const unsigned char elektraHexcodeFromHex[256] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 0, 0, 0, 0, 0,
+	0, 10, 11, 12, 13, 14, 15, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 10, 11, 12, 13, 14, 15, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
 /**
   * Gives the integer number 0-15 to a corresponding
   * hex character '0'-'9', 'a'-'f' or 'A'-'F'.
   */
 static inline int elektraHexcodeConvFromHex (char c)
 {
-	if (c == '0')
-		return 0;
-	else if (c == '1')
-		return 1;
-	else if (c == '2')
-		return 2;
-	else if (c == '3')
-		return 3;
-	else if (c == '4')
-		return 4;
-	else if (c == '5')
-		return 5;
-	else if (c == '6')
-		return 6;
-	else if (c == '7')
-		return 7;
-	else if (c == '8')
-		return 8;
-	else if (c == '9')
-		return 9;
-	else if (c == 'a' || c == 'A')
-		return 10;
-	else if (c == 'b' || c == 'B')
-		return 11;
-	else if (c == 'c' || c == 'C')
-		return 12;
-	else if (c == 'd' || c == 'D')
-		return 13;
-	else if (c == 'e' || c == 'E')
-		return 14;
-	else if (c == 'f' || c == 'F')
-		return 15;
-	else
-		return 0; /* Unknown escape char */
+	return elektraHexcodeFromHex[(unsigned char)c]; /* 0 for unknown escape chars */
 }
 
 /** Reads the value of the key and decodes all escaping
@@ -148,48 +130,12 @@ int elektraHexcodeGet (Plugin * handle, KeySet * returned, Key * parentKey)
 
 
 /**
-  * Gives the integer number 0-15 to a corresponding
-  * hex character '0'-'9', 'a'-'f' or 'A'-'F'.
+  * Gives the hex character '0'-'9' or 'A'-'F'
+  * to a corresponding integer number 0-15.
   */
 static inline char elektraHexcodeConvToHex (int c)
 {
-	switch (c)
-	{
-	case 0:
-		return '0';
-	case 1:
-		return '1';
-	case 2:
-		return '2';
-	case 3:
-		return '3';
-	case 4:
-		return '4';
-	case 5:
-		return '5';
-	case 6:
-		return '6';
-	case 7:
-		return '7';
-	case 8:
-		return '8';
-	case 9:
-		return '9';
-	case 10:
-		return 'A';
-	case 11:
-		return 'B';
-	case 12:
-		return 'C';
-	case 13:
-		return 'D';
-	case 14:
-		return 'E';
-	case 15:
-		return 'F';
-	default:
-		return '0';
-	}
+	return "0123456789ABCDEF"[c & 15];
 }
 
 
@@ -16,11 +16,6 @@
 #include <kdbextension.h>
 #include <kdbproposal.h>
 
-static int keyCmpOrderWrapper (const void * a, const void * b)
-{
-	return elektraKeyCmpOrder (*((const Key **)a), *((const Key **)b));
-}
-
 static void writeComment (const char * spaces, const char * start, const char * comment, FILE * fp)
 {
 	if (spaces)
@@ -136,6 +131,7 @@ int elektraHostsSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * pa
 
 	ksRewind (returned);
 	int ret = elektraKsToMemArray (returned, keyArray);
+	if (ret >= 0) ret = elektraSortKeysByOrder (keyArray, arraySize);
 
 	if (ret < 0)
 	{
@@ -144,8 +140,6 @@ int elektraHostsSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * pa
 		return -1;
 	}
 
-	qsort (keyArray, arraySize, sizeof (Key *), keyCmpOrderWrapper);
-
 	Key * ipv4Base = keyDup (parentKey);
 	keyAddBaseName (ipv4Base, "ipv4");
 	Key * ipv6Base = keyDup (parentKey);
@@ -26,6 +26,8 @@
 int kdbbNeedsUTF8Conversion (Plugin * handle);
 int kdbbUTF8Engine (Plugin * handle, int direction, char ** string, size_t * inputOutputByteSize);
 
+int elektraIconvOpen (Plugin * handle, Key * errorKey);
+int elektraIconvClose (Plugin * handle, Key * errorKey);
 int elektraIconvGet (Plugin * handle, KeySet * ks, Key * parentKey);
 int elektraIconvSet (Plugin * handle, KeySet * ks, Key * parentKey);
 Plugin * ELEKTRA_PLUGIN_EXPORT (iconv);
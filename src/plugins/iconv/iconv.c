@@ -8,6 +8,18 @@
 
 #include "conv.h"
 
+#include <kdbtypes.h>
+
+typedef struct
+{
+	char * from; // encodings the converters were opened for
+	char * to;
+	iconv_t converter[2];	 // indexed by UTF8_FROM and UTF8_TO
+	int asciiUnchanged[2]; // converter leaves 7-bit ASCII as is
+	char * buffer;		 // holds the result of the last conversion
+	size_t bufferSize;
+} IconvData;
+
 static inline const char * getFrom (Plugin * handle)
 {
 	const char * from;
@@ -54,6 +66,144 @@ int kdbbNeedsUTF8Conversion (Plugin * handle)
 }
 
 
+static void closeConverters (IconvData * data)
+{
+	for (int direction = UTF8_FROM; direction <= UTF8_TO; ++direction)
+	{
+		if (data->converter[direction] != (iconv_t) (-1)) iconv_close (data->converter[direction]);
+		data->converter[direction] = (iconv_t) (-1);
+	}
+	if (data->from) elektraFree (data->from);
+	if (data->to) elektraFree (data->to);
+	data->from = 0;
+	data->to = 0;
+}
+
+/**
+ * Checks if the converter leaves all 7-bit ASCII characters unchanged,
+ * which is the case for UTF-8, the ISO-8859 family and most other encodings.
+ */
+static int leavesAsciiUnchanged (iconv_t converter)
+{
+	char ascii[128];
+	char converted[sizeof (ascii)];
+	for (size_t i = 0; i < sizeof (ascii); ++i)
+	{
+		ascii[i] = i;
+	}
+
+	char * readCursor = ascii;
+	char * writeCursor = converted;
+	size_t readLeft = sizeof (ascii);
+	size_t writeLeft = sizeof (converted);
+	int unchanged = iconv (converter, &readCursor, &readLeft, &writeCursor, &writeLeft) != (size_t) (-1) && readLeft == 0 &&
+			writeLeft == 0 && !memcmp (ascii, converted, sizeof (ascii));
+	iconv (converter, 0, 0, 0, 0);
+	return unchanged;
+}
+
+/**
+ * Returns the converter for the direction, which stays open as long as
+ * the encodings do not change.
+ */
+static iconv_t getConverter (Plugin * handle, int direction)
+{
+	IconvData * data = elektraPluginGetData (handle);
+	const char * from = getFrom (handle);
+	const char * to = getTo (handle);
+
+	if (!data->from || strcmp (data->from, from) || strcmp (data->to, to))
+	{
+		closeConverters (data);
+		data->from = elektraStrDup (from);
+		data->to = elektraStrDup (to);
+		if (!data->from || !data->to)
+		{
+			closeConverters (data);
+			return (iconv_t) (-1);
+		}
+	}
+
+	if (data->converter[direction] == (iconv_t) (-1))
+	{
+		if (direction == UTF8_TO)
+			data->converter[direction] = iconv_open (to, from);
+		else
+			data->converter[direction] = iconv_open (from, to);
+
+		if (data->converter[direction] == (iconv_t) (-1)) return (iconv_t) (-1);
+		data->asciiUnchanged[direction] = leavesAsciiUnchanged (data->converter[direction]);
+	}
+	return data->converter[direction];
+}
+
+static int isAscii (const char * string, size_t size)
+{
+	const kdb_unsigned_long_long_t highBits = (kdb_unsigned_long_long_t)0x8080808080808080ULL;
+	size_t i = 0;
+
+	// check a word at once
+	for (; i + sizeof (highBits) <= size; i += sizeof (highBits))
+	{
+		kdb_unsigned_long_long_t word;
+		memcpy (&word, string + i, sizeof (word));
+		if (word & highBits) return 0;
+	}
+	for (; i < size; ++i)
+	{
+		if (string[i] & 0x80) return 0;
+	}
+	return 1;
+}
+
+/**
+ * Converts a string without allocating memory.
+ *
+ * @param converted is set to the converted string, which is either string
+ * 	itself, if nothing had to be converted, or the buffer of the plugin,
+ * 	which is valid until the next conversion
+ * @param convertedSize is set to the size of the converted string
+ * @retval 0 on success
+ * @retval -1 on failure
+ */
+static int convert (Plugin * handle, int direction, const char * string, size_t size, const char ** converted, size_t * convertedSize)
+{
+	IconvData * data = elektraPluginGetData (handle);
+	iconv_t converter = getConverter (handle, direction);
+	if (converter == (iconv_t) (-1)) return -1;
+
+	if (data->asciiUnchanged[direction] && isAscii (string, size))
+	{
+		*converted = string;
+		*convertedSize = size;
+		return 0;
+	}
+
+	/* work with worst case, when all chars are wide */
+	if (size * 4 > data->bufferSize)
+	{
+		if (elektraRealloc ((void **)&data->buffer, size * 4) < 0) return -1;
+		data->bufferSize = size * 4;
+	}
+
+	/* On some systems and with libiconv, arg1 is const char **.
+	 * ICONV_CONST is defined by configure if the system needs this */
+	char * readCursor = (char *)string;
+	char * writeCursor = data->buffer;
+	size_t readLeft = size;
+	size_t writeLeft = data->bufferSize;
+	if (iconv (converter, &readCursor, &readLeft, &writeCursor, &writeLeft) == (size_t) (-1) ||
+	    iconv (converter, 0, 0, &writeCursor, &writeLeft) == (size_t) (-1))
+	{
+		iconv (converter, 0, 0, 0, 0);
+		return -1;
+	}
+
+	*converted = data->buffer;
+	*convertedSize = writeCursor - data->buffer;
+	return 0;
+}
+
 /**
  * Converts string to (@p direction = @c UTF8_TO) and from
  * (@p direction = @c UTF8_FROM) UTF-8.
@@ -80,7 +230,8 @@ setlocale (LC_ALL, "");
  * @param direction must be @c UTF8_TO (convert from current non-UTF-8 to
  * 	UTF-8) or @c UTF8_FROM (convert from UTF-8 to current non-UTF-8)
  * @param string before the call: the string to be converted; after the call:
- * 	reallocated to carry the converted string
+ * 	reallocated to carry the converted string, unless the conversion did not
+ * 	change it
  * @param inputOutputByteSize before the call: the size of the string including
  * 	leading NULL; after the call: the size of the converted string including
  * 	leading NULL
@@ -96,55 +247,48 @@ int kdbbUTF8Engine (Plugin * handle, int direction, char ** string, size_t * inp
 	 * In this case we it should be possible to determine charset through other means
 	 * See http://www.cl.cam.ac.uk/~mgk25/unicode.html#activate for more info on a possible solution */
 
-	char * converted = 0;
-	char *readCursor, *writeCursor;
-	size_t bufferSize;
-	iconv_t converter;
+	const char * converted;
+	size_t convertedSize;
 
 	if (!*inputOutputByteSize) return 0;
 	if (!kdbbNeedsUTF8Conversion (handle)) return 0;
 
-	if (direction == UTF8_TO)
-		converter = iconv_open (getTo (handle), getFrom (handle));
-	else
-		converter = iconv_open (getFrom (handle), getTo (handle));
-
-	if (converter == (iconv_t) (-1)) return -1;
-
-	/* work with worst case, when all chars are wide */
-	bufferSize = *inputOutputByteSize * 4;
-	converted = elektraMalloc (bufferSize);
-	if (!converted) return -1;
-
-	readCursor = *string;
-	writeCursor = converted;
-	/* On some systems and with libiconv, arg1 is const char **.
-	 * ICONV_CONST is defined by configure if the system needs this */
-	if (iconv (converter, &readCursor, inputOutputByteSize, &writeCursor, &bufferSize) == (size_t) (-1))
-	{
-		elektraFree (converted);
-		iconv_close (converter);
-		return -1;
-	}
+	if (convert (handle, direction, *string, *inputOutputByteSize, &converted, &convertedSize)) return -1;
+	if (converted == *string) return 0;
 
-	/* calculate the UTF-8 string byte size, that will be returned */
-	*inputOutputByteSize = writeCursor - converted;
-	/* store the current kdbbDecoded string for future free */
-	readCursor = *string;
 	/* allocate an optimal size area to store the converted string */
-	*string = elektraMalloc (*inputOutputByteSize);
-	/* copy all that matters for returning */
-	memcpy (*string, converted, *inputOutputByteSize);
+	char * result = elektraMalloc (convertedSize);
+	if (!result) return -1;
+	memcpy (result, converted, convertedSize);
 	/* release memory used by passed string */
-	elektraFree (readCursor);
-	/* release buffer memory */
-	elektraFree (converted);
-	/* release the conversor engine */
-	iconv_close (converter);
+	elektraFree (*string);
+	*string = result;
+	*inputOutputByteSize = convertedSize;
 	return 0;
 }
 
 
+int elektraIconvOpen (Plugin * handle, Key * errorKey ELEKTRA_UNUSED)
+{
+	IconvData * data = elektraCalloc (sizeof (IconvData));
+	if (!data) return -1;
+	data->converter[UTF8_FROM] = (iconv_t) (-1);
+	data->converter[UTF8_TO] = (iconv_t) (-1);
+	elektraPluginSetData (handle, data);
+	return 1;
+}
+
+int elektraIconvClose (Plugin * handle, Key * errorKey ELEKTRA_UNUSED)
+{
+	IconvData * data = elektraPluginGetData (handle);
+	if (!data) return 1;
+	closeConverters (data);
+	if (data->buffer) elektraFree (data->buffer);
+	elektraFree (data);
+	elektraPluginSetData (handle, 0);
+	return 1;
+}
+
 int elektraIconvGet (Plugin * handle, KeySet * returned, Key * parentKey)
 {
 	Key * cur;
@@ -158,6 +302,8 @@ int elektraIconvGet (Plugin * handle, KeySet * returned, Key * parentKey)
 			       keyNew ("system/elektra/modules/iconv/exports", KEY_END),
 			       keyNew ("system/elektra/modules/iconv/exports/get", KEY_FUNC, elektraIconvGet, KEY_END),
 			       keyNew ("system/elektra/modules/iconv/exports/set", KEY_FUNC, elektraIconvSet, KEY_END),
+			       keyNew ("system/elektra/modules/iconv/exports/open", KEY_FUNC, elektraIconvOpen, KEY_END),
+			       keyNew ("system/elektra/modules/iconv/exports/close", KEY_FUNC, elektraIconvClose, KEY_END),
 #include "readme_iconv.c"
 			       keyNew ("system/elektra/modules/iconv/infos/version", KEY_VALUE, PLUGINVERSION, KEY_END), KS_END);
 		ksAppend (returned, pluginConfig);
@@ -172,39 +318,33 @@ int elektraIconvGet (Plugin * handle, KeySet * returned, Key * parentKey)
 		if (keyIsString (cur))
 		{
 			/* String or similar type of value */
-			size_t convertedDataSize = keyGetValueSize (cur);
-			char * convertedData = elektraMalloc (convertedDataSize);
+			const char * converted;
+			size_t convertedSize;
 
-			memcpy (convertedData, keyString (cur), keyGetValueSize (cur));
-			if (kdbbUTF8Engine (handle, UTF8_FROM, &convertedData, &convertedDataSize))
+			if (convert (handle, UTF8_FROM, keyString (cur), keyGetValueSize (cur), &converted, &convertedSize))
 			{
 				ELEKTRA_SET_ERRORF (46, parentKey,
-						    "Could not convert string %s, got result %s, encoding settings are from %s to %s",
-						    keyString (cur), convertedData, getFrom (handle), getTo (handle));
-				elektraFree (convertedData);
+						    "Could not convert string %s, encoding settings are from %s to %s",
+						    keyString (cur), getFrom (handle), getTo (handle));
 				return -1;
 			}
-			keySetString (cur, convertedData);
-			elektraFree (convertedData);
+			if (converted != keyString (cur)) keySetString (cur, converted);
 		}
 		const Key * meta = keyGetMeta (cur, "comment");
 		if (meta)
 		{
 			/* String or similar type of value */
-			size_t convertedDataSize = keyGetValueSize (meta);
-			char * convertedData = elektraMalloc (convertedDataSize);
+			const char * converted;
+			size_t convertedSize;
 
-			memcpy (convertedData, keyString (meta), keyGetValueSize (meta));
-			if (kdbbUTF8Engine (handle, UTF8_FROM, &convertedData, &convertedDataSize))
+			if (convert (handle, UTF8_FROM, keyString (meta), keyGetValueSize (meta), &converted, &convertedSize))
 			{
 				ELEKTRA_SET_ERRORF (46, parentKey,
-						    "Could not convert string %s, got result %s, encoding settings are from %s to %s",
-						    keyString (meta), convertedData, getFrom (handle), getTo (handle));
-				elektraFree (convertedData);
+						    "Could not convert string %s, encoding settings are from %s to %s",
+						    keyString (meta), getFrom (handle), getTo (handle));
 				return -1;
 			}
-			keySetMeta (cur, "comment", convertedData);
-			elektraFree (convertedData);
+			if (converted != keyString (meta)) keySetMeta (cur, "comment", converted);
 		}
 	}
 
@@ -224,41 +364,35 @@ int elektraIconvSet (Plugin * handle, KeySet * returned, Key * parentKey)
 		if (keyIsString (cur))
 		{
 			/* String or similar type of value */
-			size_t convertedDataSize = keyGetValueSize (cur);
-			char * convertedData = elektraMalloc (convertedDataSize);
+			const char * converted;
+			size_t convertedSize;
 
-			memcpy (convertedData, keyString (cur), keyGetValueSize (cur));
-			if (kdbbUTF8Engine (handle, UTF8_TO, &convertedData, &convertedDataSize))
+			if (convert (handle, UTF8_TO, keyString (cur), keyGetValueSize (cur), &converted, &convertedSize))
 			{
 				ELEKTRA_SET_ERRORF (46, parentKey,
-						    "Could not convert string %s, got result %s,"
+						    "Could not convert string %s,"
 						    " encoding settings are from %s to %s (but swapped for write)",
-						    keyString (cur), convertedData, getFrom (handle), getTo (handle));
-				elektraFree (convertedData);
+						    keyString (cur), getFrom (handle), getTo (handle));
 				return -1;
 			}
-			keySetString (cur, convertedData);
-			elektraFree (convertedData);
+			if (converted != keyString (cur)) keySetString (cur, converted);
 		}
 		const Key * meta = keyGetMeta (cur, "comment");
 		if (meta)
 		{
 			/* String or similar type of value */
-			size_t convertedDataSize = keyGetValueSize (meta);
-			char * convertedData = elektraMalloc (convertedDataSize);
+			const char * converted;
+			size_t convertedSize;
 
-			memcpy (convertedData, keyString (meta), keyGetValueSize (meta));
-			if (kdbbUTF8Engine (handle, UTF8_TO, &convertedData, &convertedDataSize))
+			if (convert (handle, UTF8_TO, keyString (meta), keyGetValueSize (meta), &converted, &convertedSize))
 			{
 				ELEKTRA_SET_ERRORF (46, parentKey,
-						    "Could not convert string %s, got result %s,"
+						    "Could not convert string %s,"
 						    " encodings settings are from %s to %s (but swapped for write)",
-						    keyString (meta), convertedData, getFrom (handle), getTo (handle));
-				elektraFree (convertedData);
+						    keyString (meta), getFrom (handle), getTo (handle));
 				return -1;
 			}
-			keySetMeta (cur, "comment", convertedData);
-			elektraFree (convertedData);
+			if (converted != keyString (meta)) keySetMeta (cur, "comment", converted);
 		}
 	}
 
@@ -269,6 +403,8 @@ Plugin * ELEKTRA_PLUGIN_EXPORT (iconv)
 {
 	// clang-format off
 	return elektraPluginExport(BACKENDNAME,
+		ELEKTRA_PLUGIN_OPEN,	&elektraIconvOpen,
+		ELEKTRA_PLUGIN_CLOSE,	&elektraIconvClose,
 		ELEKTRA_PLUGIN_GET,	&elektraIconvGet,
 		ELEKTRA_PLUGIN_SET,	&elektraIconvSet,
 		ELEKTRA_PLUGIN_END);
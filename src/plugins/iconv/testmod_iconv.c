@@ -181,6 +181,48 @@ void test_utf8_conversation (void)
 	ksDel (modules);
 }
 
+static void test_ascii (const char * to, size_t asciiSize)
+{
+	KeySet * modules = ksNew (0, KS_END);
+	elektraModulesInit (modules, 0);
+
+	KeySet * conf =
+		ksNew (2, keyNew ("user/from", KEY_VALUE, "ISO8859-1", KEY_END), keyNew ("user/to", KEY_VALUE, to, KEY_END), KS_END);
+
+	Plugin * plugin = elektraPluginOpen ("iconv", modules, conf, 0);
+	exit_if_fail (plugin != 0, "could not open plugin");
+
+	printf ("Test ascii conversation to %s\n", to);
+
+	for (int i = 0; i < 2; ++i)
+	{
+		char * str = elektraStrDup ("only ascii, but more than a word");
+		size_t len = strlen (str) + 1;
+		succeed_if (kdbbUTF8Engine (plugin, UTF8_TO, &str, &len) != -1, "could not convert ascii");
+		succeed_if (len == asciiSize, "ascii conversation has wrong size");
+		if (len == strlen ("only ascii, but more than a word") + 1)
+		{
+			succeed_if (strcmp ("only ascii, but more than a word", str) == 0, "ascii conversation incorrect");
+		}
+		elektraFree (str);
+
+		// the converter is still in its initial state after converting a non ascii string
+		str = elektraStrDup ("latin1 \xe4");
+		len = strlen (str) + 1;
+		succeed_if (kdbbUTF8Engine (plugin, UTF8_TO, &str, &len) != -1, "could not convert latin1");
+		if (!strcmp (to, "UTF-8"))
+		{
+			succeed_if (len == strlen ("latin1 \xc3\xa4") + 1, "latin1 conversation has wrong size");
+			succeed_if (strcmp ("latin1 \xc3\xa4", str) == 0, "latin1 conversation incorrect");
+		}
+		elektraFree (str);
+	}
+
+	elektraPluginClose (plugin, 0);
+	elektraModulesClose (modules, 0);
+	ksDel (modules);
+}
+
 
 int main (int argc, char ** argv)
 {
@@ -193,6 +235,8 @@ int main (int argc, char ** argv)
 	test_utf8_to_latin1 ();
 	test_utf8_needed ();
 	test_utf8_conversation ();
+	test_ascii ("UTF-8", sizeof ("only ascii, but more than a word"));
+	test_ascii ("UTF-16LE", sizeof ("only ascii, but more than a word") * 2);
 
 	print_result ("test_iconv");
 
@@ -37,6 +37,7 @@ static int iniCmpOrder (const void * a, const void * b);
 #define INTERNAL_ROOT_SECTION "GLOBALROOT"
 #define DEFAULT_DELIMITER '='
 #define DEFAULT_COMMENT_CHAR '#'
+#define WRITE_BUFFER_SIZE 65536 /* the file is written with many small fprintf calls, collect them in a large buffer */
 
 typedef enum { NONE, BINARY, ALWAYS } SectionHandling;
 
@@ -64,6 +65,8 @@ typedef struct
 	short array;
 	short mergeSections;
 	IniPluginConfig * pluginConfig;
+	Key * currentSection;	/* the section key of the last key, reused while the section does not change */
+	char * currentSectionName; /* the unprocessed ini name of currentSection */
 } CallbackHandle;
 
 
@@ -154,19 +157,29 @@ static Key * createUnescapedKey (Key * key, const char * name)
 	return key;
 }
 
+/**
+ * Reads the number of an order string like `#_12`.
+ *
+ * @param ptr points to the `#` of the order string
+ * @param number is left untouched if the string could not be parsed
+ */
+static void readOrderNumber (const char * ptr, kdb_long_long_t * number)
+{
+	++ptr; // skip #
+	while (*ptr == '_')
+	{
+		++ptr;
+	}
+	elektraReadArrayNumber (ptr, number);
+}
+
 static void setOrderNumber (Key * parentKey, Key * key)
 {
 	kdb_long_long_t order = 1;
 	const Key * orderKey = keyGetMeta (parentKey, "internal/ini/order");
 	if (orderKey != NULL)
 	{
-		char * ptr = (char *)keyString (orderKey);
-		++ptr; // skip #
-		while (*ptr == '_')
-		{
-			++ptr;
-		}
-		elektraReadArrayNumber (ptr, &order);
+		readOrderNumber (keyString (orderKey), &order);
 	}
 	++order;
 	char buffer[ELEKTRA_MAX_ARRAY_SIZE];
@@ -181,14 +194,7 @@ static void setSubOrderNumber (Key * key, const char * oldOrder)
 	if ((lastIndexPtr = strrchr (oldOrder, '/')))
 	{
 		kdb_long_long_t subIndex = 0;
-		char * ptr = lastIndexPtr;
-		++ptr; // skip /
-		++ptr; // skip #
-		while (*ptr == '_')
-		{
-			++ptr;
-		}
-		elektraReadArrayNumber (ptr, &subIndex);
+		readOrderNumber (lastIndexPtr + 1, &subIndex); // skip /
 		++subIndex;
 		int len = (lastIndexPtr + 1) - oldOrder;
 		char buffer[ELEKTRA_MAX_ARRAY_SIZE];
@@ -222,11 +228,14 @@ static void setKeyOrderNumber (Key * sectionKey, Key * key)
 {
 	const Key * childMeta = keyGetMeta (sectionKey, "internal/ini/key/last");
 	keySetMeta (key, "internal/ini/key/number", keyString (childMeta));
-	Key * newChild = keyDup (childMeta);
-	keyAddName (newChild, keyString (newChild));
-	elektraArrayIncName (newChild);
-	keySetMeta (sectionKey, "internal/ini/key/last", keyBaseName (newChild));
-	keyDel (newChild);
+	if (childMeta)
+	{
+		kdb_long_long_t last = 0;
+		readOrderNumber (keyString (childMeta), &last);
+		char buffer[ELEKTRA_MAX_ARRAY_SIZE];
+		elektraWriteArrayNumber (buffer, last + 1);
+		keySetMeta (sectionKey, "internal/ini/key/last", buffer);
+	}
 	keySetMeta (key, "internal/ini/order", keyString (keyGetMeta (sectionKey, "internal/ini/order")));
 }
 
@@ -292,7 +301,7 @@ static int iniKeyToElektraArray (CallbackHandle * handle, Key * existingKey, Key
 static void insertKeyIntoKeySet (Key * parentKey, Key * key, KeySet * ks)
 {
 	cursor_t savedCursor = ksGetCursor (ks);
-	char * parent = findParent (parentKey, key, ksDup (ks));
+	char * parent = findParent (parentKey, key, ks);
 	keySetMeta (key, "internal/ini/parent", parent);
 	if (keyGetMeta (key, "internal/ini/section"))
 	{
@@ -339,6 +348,24 @@ static void insertKeyIntoKeySet (Key * parentKey, Key * key, KeySet * ks)
 	ksSetCursor (ks, savedCursor);
 }
 
+static void setCurrentSection (CallbackHandle * handle, Key * sectionKey, const char * section)
+{
+	if (handle->currentSection)
+	{
+		keyDecRef (handle->currentSection);
+		keyDel (handle->currentSection);
+		elektraFree (handle->currentSectionName);
+		handle->currentSection = NULL;
+		handle->currentSectionName = NULL;
+	}
+	if (sectionKey)
+	{
+		keyIncRef (sectionKey);
+		handle->currentSection = sectionKey;
+		handle->currentSectionName = elektraStrDup (section);
+	}
+}
+
 static int iniKeyToElektraKey (void * vhandle, const char * section, const char * name, const char * value, unsigned short lineContinuation)
 {
 	CallbackHandle * handle = (CallbackHandle *)vhandle;
@@ -350,17 +377,23 @@ static int iniKeyToElektraKey (void * vhandle, const char * section, const char
 		ksAppendKey (handle->result, rootKey);
 		return 1;
 	}
-	Key * appendKey = keyNew (keyName (handle->parentKey), KEY_END);
+	Key * appendKey;
 	Key * sectionKey;
 	if (!section || *section == '\0')
 	{
 		section = INTERNAL_ROOT_SECTION;
 	}
-	appendKey = createUnescapedKey (appendKey, section);
-	if (!strcmp (keyBaseName (appendKey), INTERNAL_ROOT_SECTION))
+	if (handle->currentSection && !strcmp (handle->currentSectionName, section))
 	{
+		// consecutive keys of the same section neither need to unescape nor look up the section again
+		sectionKey = handle->currentSection;
+		appendKey = keyNew (keyName (sectionKey), KEY_END);
+	}
+	else
+	{
+		appendKey = createUnescapedKey (keyNew (keyName (handle->parentKey), KEY_END), section);
 		sectionKey = ksLookup (handle->result, appendKey, KDB_O_NONE);
-		if (!sectionKey)
+		if (!sectionKey && !strcmp (keyBaseName (appendKey), INTERNAL_ROOT_SECTION))
 		{
 			keySetMeta (appendKey, "internal/ini/order", "#0");
 			keySetMeta (appendKey, "internal/ini/key/last", "#0");
@@ -371,19 +404,13 @@ static int iniKeyToElektraKey (void * vhandle, const char * section, const char
 			keySetMeta (appendKey, "internal/ini/section", 0);
 			sectionKey = ksLookup (handle->result, appendKey, KDB_O_NONE);
 		}
-	}
-	else
-	{
-		sectionKey = ksLookup (handle->result, appendKey, KDB_O_NONE);
+		if (sectionKey) setCurrentSection (handle, sectionKey, section);
 	}
 	short mergeSections = 0;
 	Key * existingKey = NULL;
-	if ((existingKey = ksLookup (handle->result, appendKey, KDB_O_NONE)))
+	if (sectionKey && keyGetMeta (sectionKey, "internal/ini/duplicate"))
 	{
-		if (keyGetMeta (existingKey, "internal/ini/duplicate"))
-		{
-			mergeSections = 1;
-		}
+		mergeSections = 1;
 	}
 	appendKey = createUnescapedKey (appendKey, name);
 	existingKey = ksLookup (handle->result, appendKey, KDB_O_NONE);
@@ -446,6 +473,7 @@ static short isSectionKey (Key * key)
 static int iniSectionToElektraKey (void * vhandle, const char * section)
 {
 	CallbackHandle * handle = (CallbackHandle *)vhandle;
+	setCurrentSection (handle, NULL, NULL);
 	Key * appendKey = keyNew (keyName (handle->parentKey), KEY_END);
 	createUnescapedKey (appendKey, section);
 	Key * existingKey = NULL;
@@ -635,9 +663,16 @@ static void outputDebug (KeySet * ks)
 }
 #endif
 
+/**
+ * Returns the name of the nearest section above `searchkey` or the name of
+ * `parentKey` if there is none.
+ *
+ * Only lookups are done in `ks`, its cursor is preserved. The returned
+ * string has to be freed by the caller.
+ */
 static char * findParent (Key * parentKey, Key * searchkey, KeySet * ks)
 {
-	ksRewind (ks);
+	cursor_t savedCursor = ksGetCursor (ks);
 	size_t offset = 0;
 	if (keyName (parentKey)[0] == '/' && keyName (searchkey)[0] != '/')
 	{
@@ -667,7 +702,7 @@ static char * findParent (Key * parentKey, Key * searchkey, KeySet * ks)
 	if (!lookedUp) lookedUp = parentKey;
 	char * parentName = strdup (keyName (lookedUp));
 	keyDel (key);
-	ksDel (ks);
+	ksSetCursor (ks, savedCursor);
 	return parentName;
 }
 static void setParents (KeySet * ks, Key * parentKey)
@@ -676,7 +711,7 @@ static void setParents (KeySet * ks, Key * parentKey)
 	ksRewind (ks);
 	while ((cur = ksNext (ks)) != NULL)
 	{
-		char * parentName = findParent (parentKey, cur, ksDup (ks));
+		char * parentName = findParent (parentKey, cur, ks);
 		if (parentName)
 		{
 			keySetMeta (cur, "internal/ini/parent", parentName);
@@ -725,6 +760,8 @@ int elektraIniGet (Plugin * handle, KeySet * returned, Key * parentKey)
 	cbHandle.parentKey = parentKey;
 	cbHandle.result = append;
 	cbHandle.collectedComment = NULL;
+	cbHandle.currentSection = NULL;
+	cbHandle.currentSectionName = NULL;
 
 	// ksAppendKey (cbHandle.result, keyDup(parentKey));
 
@@ -748,6 +785,7 @@ int elektraIniGet (Plugin * handle, KeySet * returned, Key * parentKey)
 	ELEKTRA_LOG_DEBUG ("Try to parse file");
 	int ret = ini_parse_file (fh, &iniConfig, &cbHandle);
 	ELEKTRA_LOG_DEBUG ("Parsed file");
+	setCurrentSection (&cbHandle, NULL, NULL);
 	if (cbHandle.collectedComment)
 	{
 		pluginConfig->lastComments = keyDup (cbHandle.collectedComment);
@@ -1106,34 +1144,47 @@ void insertIntoKS (Key * parentKey, Key * cur, KeySet * newKS, IniPluginConfig *
 	keyDel (appendKey);
 }
 
-static int iniCmpOrder (const void * a, const void * b)
+/**
+ * Sort information of a key, extracted once per write so that
+ * the comparator does not need to look up metadata.
+ */
+typedef struct
 {
-	const Key * ka = (*(const Key **)a);
-	const Key * kb = (*(const Key **)b);
+	Key * key;
+	const char * order;  /* value of internal/ini/order or NULL */
+	const char * number; /* value of internal/ini/key/number or NULL */
+	elektraNamespace ns;
+} IniOrderEntry;
 
-	if (!ka && !kb) return 0;
-	if (ka && !kb) return 1;
-	if (!ka && kb) return -1;
+static void iniFillOrderEntry (IniOrderEntry * entry, Key * key)
+{
+	const Key * orderMeta = keyGetMeta (key, "internal/ini/order");
+	const Key * numberMeta = keyGetMeta (key, "internal/ini/key/number");
+	entry->key = key;
+	entry->order = orderMeta ? keyString (orderMeta) : NULL;
+	entry->number = numberMeta ? keyString (numberMeta) : NULL;
+	entry->ns = keyGetNamespace (key);
+}
 
-	const Key * kaom = keyGetMeta (ka, "internal/ini/order");
-	const Key * kbom = keyGetMeta (kb, "internal/ini/order");
-	const Key * kakm = keyGetMeta (ka, "internal/ini/key/number");
-	const Key * kbkm = keyGetMeta (kb, "internal/ini/key/number");
+static int iniCmpOrder (const void * a, const void * b)
+{
+	const IniOrderEntry * ea = (const IniOrderEntry *)a;
+	const IniOrderEntry * eb = (const IniOrderEntry *)b;
 
-	int ret = keyGetNamespace (ka) - keyGetNamespace (kb);
+	int ret = ea->ns - eb->ns;
 	if (!ret)
 	{
-		if (!kaom && !kbom) return 0;
-		if (kaom && !kbom) return 1;
-		if (!kaom && kbom) return -1;
-		ret = strcmp (keyString (kaom), keyString (kbom));
+		if (!ea->order && !eb->order) return 0;
+		if (ea->order && !eb->order) return 1;
+		if (!ea->order && eb->order) return -1;
+		ret = strcmp (ea->order, eb->order);
 	}
 	if (!ret)
 	{
-		if (!kakm && kbkm) return -1;
-		if (!kakm && !kbkm) return strcmp (keyName (ka), keyName (kb));
-		if (kakm && !kbkm) return 1;
-		if (kakm && kbkm) ret = strcmp (keyString (kakm), keyString (kbkm));
+		if (!ea->number && eb->number) return -1;
+		if (!ea->number && !eb->number) return strcmp (keyName (ea->key), keyName (eb->key));
+		if (ea->number && !eb->number) return 1;
+		if (ea->number && eb->number) ret = strcmp (ea->number, eb->number);
 	}
 
 	return ret;
@@ -1200,7 +1251,17 @@ static int iniWriteKeySet (FILE * fh, Key * parentKey, KeySet * returned, IniPlu
 	if (arraySize == 0) return 0;
 	keyArray = elektraCalloc (arraySize * sizeof (Key *));
 	elektraKsToMemArray (returned, keyArray);
-	qsort (keyArray, arraySize, sizeof (Key *), iniCmpOrder);
+	IniOrderEntry * orderArray = elektraMalloc (arraySize * sizeof (IniOrderEntry));
+	for (ssize_t i = 0; i < arraySize; ++i)
+	{
+		iniFillOrderEntry (&orderArray[i], keyArray[i]);
+	}
+	qsort (orderArray, arraySize, sizeof (IniOrderEntry), iniCmpOrder);
+	for (ssize_t i = 0; i < arraySize; ++i)
+	{
+		keyArray[i] = orderArray[i].key;
+	}
+	elektraFree (orderArray);
 	Key * cur = NULL;
 	Key * sectionKey = parentKey;
 	int ret = 1;
@@ -1466,7 +1527,7 @@ static void stripInternalData (Key * parentKey ELEKTRA_UNUSED, KeySet * ks)
 			}
 			strcat (newName, "/");
 			keySetName (newKey, newName);
-			char * parent = findParent (parentKey, newKey, ksDup (newKS));
+			char * parent = findParent (parentKey, newKey, newKS);
 			keySetMeta (newKey, "internal/ini/parent", parent);
 			elektraFree (parent);
 			if (strcmp (keyName (parentKey), keyName (newKey))) ksAppendKey (newKS, keyDup (newKey));
@@ -1544,6 +1605,8 @@ int elektraIniSet (Plugin * handle, KeySet * returned, Key * parentKey)
 		errno = errnosave;
 		return -1;
 	}
+	char * writeBuffer = elektraMalloc (WRITE_BUFFER_SIZE);
+	if (writeBuffer) setvbuf (fh, writeBuffer, _IOFBF, WRITE_BUFFER_SIZE);
 	Key * root = keyDup (ksLookup (returned, parentKey, KDB_O_NONE));
 	Key * head = keyDup (ksHead (returned));
 	IniPluginConfig * pluginConfig = elektraPluginGetData (handle);
@@ -1619,6 +1682,7 @@ int elektraIniSet (Plugin * handle, KeySet * returned, Key * parentKey)
 	ret = iniWriteKeySet (fh, parentKey, returned, pluginConfig);
 
 	fclose (fh);
+	elektraFree (writeBuffer);
 	errno = errnosave;
 	if (pluginConfig->lastOrder) elektraFree (pluginConfig->lastOrder);
 	pluginConfig->lastOrder = strdup (keyString (keyGetMeta (parentKey, "internal/ini/order")));
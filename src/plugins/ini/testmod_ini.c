@@ -421,6 +421,31 @@ static void test_preserveEmptyLines (char * fileName)
 	PLUGIN_CLOSE ();
 }
 
+static void test_keyOrder (char * fileName)
+{
+	Key * parentKey = keyNew ("user/tests/ini-write", KEY_VALUE, srcdir_file (fileName), KEY_END);
+	Key * writeParentKey = keyNew ("user/tests/ini-write", KEY_VALUE, elektraFilename (), KEY_END);
+	KeySet * conf = ksNew (0, KS_END);
+	KeySet * ks = ksNew (30, KS_END);
+	PLUGIN_OPEN ("ini");
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) >= 0, "call to kdbGet was not successful");
+	Key * lookupKey = ksLookupByName (ks, "user/tests/ini-write/sec1/key11", KDB_O_NONE);
+	exit_if_fail (lookupKey, "key sec1/key11 not found");
+	succeed_if (!strcmp (keyString (keyGetMeta (lookupKey, "internal/ini/key/number")), "#_11"),
+		    "key sec1/key11 has the wrong key number");
+	lookupKey = ksLookupByName (ks, "user/tests/ini-write/sec2/a", KDB_O_NONE);
+	exit_if_fail (lookupKey, "key sec2/a not found");
+	succeed_if (!strcmp (keyString (keyGetMeta (lookupKey, "internal/ini/key/number")), "#1"), "key sec2/a has the wrong key number");
+	keyDel (ksLookup (ks, parentKey, KDB_O_POP));
+	keyDel (parentKey);
+	succeed_if (plugin->kdbSet (plugin, ks, writeParentKey) >= 1, "call to kdbSet was not successful");
+	succeed_if (compare_line_files (srcdir_file (fileName), keyString (writeParentKey)), "files do not match as expected");
+	keyDel (ksLookup (ks, writeParentKey, KDB_O_POP));
+	keyDel (writeParentKey);
+	ksDel (ks);
+	PLUGIN_CLOSE ();
+}
+
 static void test_insertOrder (char * source, char * compare)
 {
 	Key * parentKey = keyNew ("user/tests/ini-write", KEY_VALUE, srcdir_file (source), KEY_END);
@@ -601,6 +626,7 @@ int main (int argc, char ** argv)
 	test_sectionMerge ("ini/sectionmerge.input", "ini/sectionmerge.output");
 	test_array ("ini/array.ini");
 	test_preserveEmptyLines ("ini/emptyLines");
+	test_keyOrder ("ini/keyOrder.ini");
 	test_insertOrder ("ini/insertTest.input.ini", "ini/insertTest.output.ini");
 	test_complexInsert ("ini/complexIn.ini", "ini/complexOut.ini");
 	test_arrayInsert ("ini/arrayInsertIn.ini", "ini/arrayInsertOut.ini");
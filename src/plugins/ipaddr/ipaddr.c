@@ -113,6 +113,11 @@ static int validateKey (Key * key, Key * parentKey)
 	return rc;
 }
 
+int elektraIpaddrCheckKey (Plugin * handle ELEKTRA_UNUSED, Key * key, Key * errorKey)
+{
+	return validateKey (key, errorKey);
+}
+
 int elektraIpaddrGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_UNUSED, Key * parentKey ELEKTRA_UNUSED)
 {
 	if (!elektraStrCmp (keyName (parentKey), "system/elektra/modules/ipaddr"))
@@ -122,6 +127,7 @@ int elektraIpaddrGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_
 			       keyNew ("system/elektra/modules/ipaddr/exports", KEY_END),
 			       keyNew ("system/elektra/modules/ipaddr/exports/get", KEY_FUNC, elektraIpaddrGet, KEY_END),
 			       keyNew ("system/elektra/modules/ipaddr/exports/set", KEY_FUNC, elektraIpaddrSet, KEY_END),
+			       keyNew ("system/elektra/modules/ipaddr/exports/checkkey", KEY_FUNC, elektraIpaddrCheckKey, KEY_END),
 #include ELEKTRA_README (ipaddr)
 			       keyNew ("system/elektra/modules/ipaddr/infos/version", KEY_VALUE, PLUGINVERSION, KEY_END), KS_END);
 		ksAppend (returned, contract);
@@ -131,20 +137,11 @@ int elektraIpaddrGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_
 	return ELEKTRA_PLUGIN_STATUS_NO_UPDATE;
 }
 
-int elektraIpaddrSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_UNUSED, Key * parentKey ELEKTRA_UNUSED)
+int elektraIpaddrSet (Plugin * handle, KeySet * returned, Key * parentKey)
 {
 	// set all keys
 	// this function is optional
-	Key * cur;
-	ksRewind (returned);
-	while ((cur = ksNext (returned)) != NULL)
-	{
-		const Key * meta = keyGetMeta (cur, "check/ipaddr");
-		if (!meta) continue;
-		int rc = validateKey (cur, parentKey);
-		if (!rc) return ELEKTRA_PLUGIN_STATUS_ERROR;
-	}
-	return ELEKTRA_PLUGIN_STATUS_SUCCESS;
+	return elektraPluginCheckKeys (handle, returned, "check/ipaddr", elektraIpaddrCheckKey, parentKey);
 }
 
 Plugin * ELEKTRA_PLUGIN_EXPORT (ipaddr)
@@ -14,6 +14,7 @@
 
 int elektraIpaddrGet (Plugin * handle, KeySet * ks, Key * parentKey);
 int elektraIpaddrSet (Plugin * handle, KeySet * ks, Key * parentKey);
+int elektraIpaddrCheckKey (Plugin * handle, Key * key, Key * errorKey);
 
 Plugin * ELEKTRA_PLUGIN_EXPORT (ipaddr);
 
@@ -23,26 +23,6 @@ static const char * CONVERT_TARGET = "convert/to";
 static const char * CONVERT_APPEND_SAMELEVEL = "convert/append/samelevel";
 static const char * CONVERT_APPENDMODE = "convert/append";
 
-/*
- * Wrapper for the function comparing by order metadata. As
- * qsort is not stable returning 0 on missing order may
- * mess up the original order.
- */
-int elektraKeyCmpOrderWrapper (const void * a, const void * b)
-{
-	const Key ** ka = (const Key **)a;
-	const Key ** kb = (const Key **)b;
-
-	int orderResult = elektraKeyCmpOrder (*ka, *kb);
-
-	/* comparing the order meta could not order the keys
-	 * revert to comparing the names instead
-	 */
-	if (orderResult == 0) return keyCmp (*ka, *kb);
-
-	return orderResult;
-}
-
 /* The KeySet MUST be sorted alphabetically (or at least ascending
  * by the length of keynames) for this function to work
  */
@@ -249,6 +229,8 @@ int elektraKeyToMetaGet (Plugin * handle, KeySet * returned, Key * parentKey ELE
 
 	Key ** keyArray = calloc (ksGetSize (returned), sizeof (Key *));
 	int ret = elektraKsToMemArray (returned, keyArray);
+	/* the keyset is sorted by name, so keys with the same order stay sorted by name */
+	if (ret >= 0) ret = elektraSortKeysByOrder (keyArray, ksGetSize (returned));
 
 	if (ret < 0)
 	{
@@ -259,7 +241,6 @@ int elektraKeyToMetaGet (Plugin * handle, KeySet * returned, Key * parentKey ELE
 	}
 
 	size_t numKeys = ksGetSize (returned);
-	qsort (keyArray, numKeys, sizeof (Key *), elektraKeyCmpOrderWrapper);
 
 	KeySet * convertedKeys = convertKeys (keyArray, numKeys, returned);
 
@@ -17,6 +17,8 @@
 
 #include "logchange.h"
 
+#include <kdbprivate.h> // for elektraKsDiff
+
 int elektraLogchangeGet (Plugin * handle, KeySet * returned, Key * parentKey ELEKTRA_UNUSED)
 {
 	if (!strcmp (keyName (parentKey), "system/elektra/modules/logchange"))
@@ -58,30 +60,11 @@ int elektraLogchangeSet (Plugin * handle, KeySet * returned, Key * parentKey ELE
 	KeySet * oldKeys = (KeySet *)elektraPluginGetData (handle);
 	// because elektraLogchangeGet will always be executed before elektraLogchangeSet
 	// we know that oldKeys must exist here!
-	ksRewind (oldKeys);
-	ksRewind (returned);
-
-	KeySet * addedKeys = ksDup (returned);
+	KeySet * addedKeys = ksNew (0, KS_END);
 	KeySet * changedKeys = ksNew (0, KS_END);
 	KeySet * removedKeys = ksNew (0, KS_END);
 
-	Key * k = 0;
-	while ((k = ksNext (oldKeys)) != 0)
-	{
-		Key * p = ksLookup (addedKeys, k, KDB_O_POP);
-		// Note: keyDel not needed, because at least two references exist
-		if (p)
-		{
-			if (keyNeedSync (p))
-			{
-				ksAppendKey (changedKeys, p);
-			}
-		}
-		else
-		{
-			ksAppendKey (removedKeys, k);
-		}
-	}
+	elektraKsDiff (oldKeys, returned, addedKeys, removedKeys, changedKeys);
 
 	logKeys (addedKeys, "added key");
 	logKeys (changedKeys, "changed key");
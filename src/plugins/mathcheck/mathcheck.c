@@ -16,6 +16,7 @@
 #include "mathcheck.h"
 #include <ctype.h>
 #include <kdberrors.h>
+#include <kdbproposal.h>
 #include <math.h>
 #include <regex.h>
 #include <stdio.h>
@@ -50,6 +51,85 @@ typedef struct
 	Operation op;
 } PNElem;
 
+/**
+ * A token of a compiled expression. Operands referring to keys are looked up
+ * when the expression is evaluated, all other tokens are copied to the stack as is.
+ */
+typedef struct
+{
+	PNElem elem;
+	char * name;	   // name of the operand key, NULL for other tokens
+	char base;	   // '@' if the name is relative to the parent key, '.' if relative to the checked key
+	Key * resolved;	   // operand key, if the name does not depend on the checked key
+	size_t generation; // call of kdbSet in which resolved was looked up
+} Token;
+
+typedef struct
+{
+	char * expression;
+	Token * tokens;
+	size_t count;
+	Operation resultOp;
+	char invalidOp; // character that is not a valid operation
+	PNElem * stack; // count + 1 elements used during evaluation
+} Program;
+
+typedef struct
+{
+	regex_t regex;
+	Program ** programs; // sorted by expression
+	size_t size;
+	size_t alloc;
+	size_t generation;
+	char * searchKey;
+	size_t searchKeySize;
+} MathcheckData;
+
+
+static void freeProgram (Program * program)
+{
+	for (size_t i = 0; i < program->count; ++i)
+	{
+		if (program->tokens[i].name) elektraFree (program->tokens[i].name);
+	}
+	if (program->tokens) elektraFree (program->tokens);
+	if (program->stack) elektraFree (program->stack);
+	elektraFree (program->expression);
+	elektraFree (program);
+}
+
+int elektraMathcheckOpen (Plugin * handle, Key * errorKey ELEKTRA_UNUSED)
+{
+	const char * regexString =
+		"(((((\\.)|(\\.\\.\\/)*|(@)|(\\/))([[:alnum:]]*/)*[[:alnum:]]+))|('[0-9]*[.,]{0,1}[0-9]*')|(==)|([-+:/<>=!{*]))";
+	MathcheckData * data = elektraCalloc (sizeof (MathcheckData));
+	if (!data) return -1;
+	if (regcomp (&data->regex, regexString, REG_EXTENDED | REG_NEWLINE))
+	{
+		elektraFree (data);
+		return -1;
+	}
+	elektraPluginSetData (handle, data);
+	return 1; /* success */
+}
+
+int elektraMathcheckClose (Plugin * handle, Key * errorKey ELEKTRA_UNUSED)
+{
+	MathcheckData * data = elektraPluginGetData (handle);
+	if (!data) return 1;
+
+	for (size_t i = 0; i < data->size; ++i)
+	{
+		freeProgram (data->programs[i]);
+	}
+	if (data->programs) elektraFree (data->programs);
+	if (data->searchKey) elektraFree (data->searchKey);
+	regfree (&data->regex);
+	elektraFree (data);
+	elektraPluginSetData (handle, 0);
+
+	return 1; /* success */
+}
 
 int elektraMathcheckGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_UNUSED, Key * parentKey)
 {
@@ -58,6 +138,8 @@ int elektraMathcheckGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKT
 		KeySet * contract = ksNew (
 			30, keyNew ("system/elektra/modules/mathcheck", KEY_VALUE, "mathcheck plugin waits for your orders", KEY_END),
 			keyNew ("system/elektra/modules/mathcheck/exports", KEY_END),
+			keyNew ("system/elektra/modules/mathcheck/exports/open", KEY_FUNC, elektraMathcheckOpen, KEY_END),
+			keyNew ("system/elektra/modules/mathcheck/exports/close", KEY_FUNC, elektraMathcheckClose, KEY_END),
 			keyNew ("system/elektra/modules/mathcheck/exports/get", KEY_FUNC, elektraMathcheckGet, KEY_END),
 			keyNew ("system/elektra/modules/mathcheck/exports/set", KEY_FUNC, elektraMathcheckSet, KEY_END),
 #include ELEKTRA_README (mathcheck)
@@ -79,6 +161,7 @@ static PNElem nextVal (const PNElem * stackPtr)
 	PNElem * ptr = (PNElem *)stackPtr;
 	PNElem result;
 	result.op = ERROR;
+	result.value = 0;
 	while (ptr->op != END)
 	{
 		if (ptr->op == VAL)
@@ -103,6 +186,7 @@ static PNElem doPrefixCalculation (PNElem * stack, PNElem * stackPtr)
 {
 	--stackPtr;
 	PNElem result;
+	result.value = 0;
 	if (stackPtr < stack)
 	{
 		result.op = ERROR;
@@ -194,37 +278,30 @@ static PNElem doPrefixCalculation (PNElem * stack, PNElem * stackPtr)
 	result.value = stackPtr->value;
 	return result;
 }
-static PNElem parsePrefixString (const char * prefixString, Key * curKey, KeySet * ks, Key * parentKey)
+/**
+ * @brief splits a prefix expression into tokens
+ *
+ * @return the compiled expression
+ * @retval NULL if out of memory
+ */
+static Program * compilePrefixString (MathcheckData * data, const char * prefixString)
 {
-	const char * regexString =
-		"(((((\\.)|(\\.\\.\\/)*|(@)|(\\/))([[:alnum:]]*/)*[[:alnum:]]+))|('[0-9]*[.,]{0,1}[0-9]*')|(==)|([-+:/<>=!{*]))";
-	char * ptr = (char *)prefixString;
-	regex_t regex;
-	Key * key;
-
-	PNElem * stack = elektraMalloc (MIN_VALID_STACK * sizeof (PNElem));
+	Program * program = elektraCalloc (sizeof (Program));
+	if (!program) return NULL;
+	program->expression = elektraStrDup (prefixString);
+	if (!program->expression) goto error;
 
-	PNElem * stackPtr = stack;
-	PNElem result;
+	const char * ptr = prefixString;
 	Operation resultOp = ERROR;
-	result.op = ERROR;
-	int ret;
-	if ((ret = regcomp (&regex, regexString, REG_EXTENDED | REG_NEWLINE)))
-	{
-		ksDel (ks);
-		return result;
-	}
 	regmatch_t match;
-	char * searchKey = NULL;
-	while (1)
+	while (!regexec (&data->regex, ptr, 1, &match, 0))
 	{
-		stackPtr->op = ERROR;
-		stackPtr->value = 0;
-		int nomatch = regexec (&regex, ptr, 1, &match, 0);
-		if (nomatch)
-		{
-			break;
-		}
+		if (elektraRealloc ((void **)&program->tokens, (program->count + 1) * sizeof (Token)) < 0) goto error;
+		Token * token = &program->tokens[program->count++];
+		memset (token, 0, sizeof (Token));
+		token->elem.op = ERROR;
+		token->elem.value = 0;
+
 		int len = match.rm_eo - match.rm_so;
 		int start = match.rm_so + (ptr - prefixString);
 		if (!strncmp (prefixString + start, "==", 2))
@@ -239,16 +316,16 @@ static PNElem parsePrefixString (const char * prefixString, Key * curKey, KeySet
 			{
 
 			case '+':
-				stackPtr->op = ADD;
+				token->elem.op = ADD;
 				break;
 			case '-':
-				stackPtr->op = SUB;
+				token->elem.op = SUB;
 				break;
 			case '/':
-				stackPtr->op = DIV;
+				token->elem.op = DIV;
 				break;
 			case '*':
-				stackPtr->op = MUL;
+				token->elem.op = MUL;
 				break;
 			case ':':
 				resultOp = SET;
@@ -266,18 +343,6 @@ static PNElem parsePrefixString (const char * prefixString, Key * curKey, KeySet
 				{
 					resultOp = EQU;
 				}
-				else if (resultOp == EQU)
-				{
-					resultOp = EQU;
-				}
-				else if (resultOp == NOT)
-				{
-					resultOp = NOT;
-				}
-				else if (resultOp == SET)
-				{
-					resultOp = SET;
-				}
 				break;
 			case '<':
 				resultOp = LT;
@@ -289,113 +354,199 @@ static PNElem parsePrefixString (const char * prefixString, Key * curKey, KeySet
 				resultOp = NOT;
 				break;
 			default:
-				ELEKTRA_SET_ERRORF (122, parentKey, "%c isn't a valid operation", prefixString[start]);
-				regfree (&regex);
-				if (searchKey)
-				{
-					elektraFree (searchKey);
-				}
-				elektraFree (stack);
-				ksDel (ks);
-				return result;
-				break;
+				// reported whenever the expression is evaluated
+				program->invalidOp = prefixString[start];
+				return program;
 			}
 		}
 		else
 		{
 			char * subString = elektraMalloc (len + 1);
+			if (!subString) goto error;
 			strncpy (subString, prefixString + start, len);
 			subString[len] = '\0';
 			if (subString[0] == '\'' && subString[len - 1] == '\'')
 			{
 				subString[len - 1] = '\0';
 				char * subPtr = (subString + 1);
-				stackPtr->value = elektraEFtoF (subPtr);
+				token->elem.value = elektraEFtoF (subPtr);
 				elektraFree (subString);
 			}
-			else
+			else if (subString[0] == '@')
 			{
-				ksRewind (ks);
-				if (subString[0] == '@')
-				{
-					searchKey = realloc (searchKey, len + 2 + strlen (keyName (parentKey)));
-					strcpy (searchKey, keyName (parentKey));
-					strcat (searchKey, "/");
-					strcat (searchKey, subString + 2);
-				}
-				else if (subString[0] == '.')
-				{
-					searchKey = realloc (searchKey, len + 2 + strlen (keyName (curKey)));
-					strcpy (searchKey, keyName (curKey));
-					strcat (searchKey, "/");
-					strcat (searchKey, subString);
-				}
-				else
-				{
-					searchKey = realloc (searchKey, len + 1);
-					strcpy (searchKey, subString);
-				}
-				key = ksLookupByName (ks, searchKey, 0);
-				if (!key)
-				{
-					stackPtr->value = 0;
-					stackPtr->op = NA;
-				}
-				else
-				{
-					stackPtr->value = elektraEFtoF (keyString (key));
-				}
+				token->base = '@';
+				token->name = elektraStrDup (subString + 2);
 				elektraFree (subString);
+				if (!token->name) goto error;
 			}
-			if (stackPtr->op != NA) stackPtr->op = VAL;
+			else
+			{
+				if (subString[0] == '.') token->base = '.';
+				token->name = subString;
+			}
+			token->elem.op = VAL;
 		}
-		++stackPtr;
-		int offset = stackPtr - stack;
-		stack = realloc (stack, (offset + 1) * sizeof (PNElem));
-		stackPtr = stack;
-		stackPtr += offset;
 		ptr += match.rm_eo;
 	}
-	regfree (&regex);
-	elektraFree (searchKey);
-	ksDel (ks);
-	stackPtr->op = END;
-	result = doPrefixCalculation (stack, stackPtr);
+	program->resultOp = resultOp;
+	program->stack = elektraMalloc ((program->count + 1) * sizeof (PNElem));
+	if (!program->stack) goto error;
+	return program;
+
+error:
+	freeProgram (program);
+	return NULL;
+}
+
+/**
+ * @brief returns the compiled expression, every distinct expression is only compiled once per plugin handle
+ *
+ * @retval NULL if out of memory
+ */
+static Program * getProgram (MathcheckData * data, const char * prefixString)
+{
+	size_t lower = 0;
+	size_t upper = data->size;
+	while (lower < upper)
+	{
+		size_t middle = lower + (upper - lower) / 2;
+		int cmp = strcmp (data->programs[middle]->expression, prefixString);
+		if (cmp == 0) return data->programs[middle];
+		if (cmp < 0)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+
+	if (data->size == data->alloc)
+	{
+		size_t alloc = data->alloc ? data->alloc * 2 : 16;
+		if (elektraRealloc ((void **)&data->programs, alloc * sizeof (Program *)) < 0) return NULL;
+		data->alloc = alloc;
+	}
+	Program * program = compilePrefixString (data, prefixString);
+	if (!program) return NULL;
+	memmove (data->programs + lower + 1, data->programs + lower, (data->size - lower) * sizeof (Program *));
+	data->programs[lower] = program;
+	++data->size;
+	return program;
+}
+
+static Key * lookupOperand (MathcheckData * data, Token * token, Key * curKey, KeySet * ks, Key * parentKey)
+{
+	if (token->base != '.' && token->resolved && token->generation == data->generation)
+	{
+		return token->resolved;
+	}
+
+	const char * base = NULL;
+	if (token->base == '@')
+		base = keyName (parentKey);
+	else if (token->base == '.')
+		base = keyName (curKey);
+	size_t size = (base ? strlen (base) + 1 : 0) + strlen (token->name) + 1;
+	if (size > data->searchKeySize)
+	{
+		if (elektraRealloc ((void **)&data->searchKey, size) < 0) return NULL;
+		data->searchKeySize = size;
+	}
+	if (base)
+		snprintf (data->searchKey, size, "%s/%s", base, token->name);
+	else
+		strcpy (data->searchKey, token->name);
+
+	Key * key = ksLookupByName (ks, data->searchKey, 0);
+	if (token->base != '.')
+	{
+		// the name does not depend on the checked key, so other keys with the same expression reuse the lookup
+		token->resolved = key;
+		token->generation = data->generation;
+	}
+	return key;
+}
+
+static PNElem evalPrefixString (MathcheckData * data, Program * program, Key * curKey, KeySet * ks, Key * parentKey)
+{
+	PNElem result;
+	result.op = ERROR;
+	if (program->invalidOp)
+	{
+		ELEKTRA_SET_ERRORF (122, parentKey, "%c isn't a valid operation", program->invalidOp);
+		return result;
+	}
+
+	if (!program->count)
+	{
+		ELEKTRA_SET_ERRORF (122, parentKey, "%s\n", program->expression);
+		return result;
+	}
+
+	PNElem * stack = program->stack;
+	for (size_t i = 0; i < program->count; ++i)
+	{
+		Token * token = &program->tokens[i];
+		stack[i] = token->elem;
+		if (!token->name) continue;
+		Key * key = lookupOperand (data, token, curKey, ks, parentKey);
+		if (!key)
+		{
+			stack[i].value = 0;
+			stack[i].op = NA;
+		}
+		else
+		{
+			stack[i].value = elektraEFtoF (keyString (key));
+		}
+	}
+	stack[program->count].op = END;
+	stack[program->count].value = 0;
+	result = doPrefixCalculation (stack, stack + program->count);
 	if (result.op != ERROR)
 	{
-		result.op = resultOp;
+		result.op = program->resultOp;
 	}
 	else
 	{
-		ELEKTRA_SET_ERRORF (122, parentKey, "%s\n", prefixString);
+		ELEKTRA_SET_ERRORF (122, parentKey, "%s\n", program->expression);
 	}
-	elektraFree (stack);
 	return result;
 }
 
-int elektraMathcheckSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * parentKey)
+int elektraMathcheckSet (Plugin * handle, KeySet * returned, Key * parentKey)
 {
+	MathcheckData * data = elektraPluginGetData (handle);
+	// lookups move the cursor, so they are done in a copy of returned
+	KeySet * ks = ksDup (returned);
+	int ret = 1;
+	++data->generation;
 	Key * cur;
 	PNElem result;
-	while ((cur = ksNext (returned)) != NULL)
+	while ((cur = ksNextWithMeta (returned, "check/math")) != NULL)
 	{
 		const Key * meta = keyGetMeta (cur, "check/math");
-		if (!meta) continue;
-		result = parsePrefixString (keyString (meta), cur, ksDup (returned), parentKey);
+		Program * program = getProgram (data, keyString (meta));
+		if (!program)
+		{
+			ELEKTRA_SET_ERROR (87, parentKey, "Out of memory");
+			ret = -1;
+			break;
+		}
+		result = evalPrefixString (data, program, cur, ks, parentKey);
 		char val1[MAX_CHARS_DOUBLE];
 		char val2[MAX_CHARS_DOUBLE];
 		strncpy (val1, keyString (cur), sizeof (val1));
 		elektraFtoA (val2, sizeof (val2), result.value);
 		if (result.op == ERROR)
 		{
-			return 1;
+			break;
 		}
 		else if (result.op == EQU)
 		{
 			if (fabs (elektraEFtoF (keyString (cur)) - result.value) > EPSILON)
 			{
 				ELEKTRA_SET_ERRORF (123, parentKey, "%s != %s", val1, val2);
-				return -1;
+				ret = -1;
+				break;
 			}
 		}
 		else if (result.op == NOT)
@@ -403,7 +554,8 @@ int elektraMathcheckSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key
 			if (fabs (elektraEFtoF (keyString (cur)) - result.value) < EPSILON)
 			{
 				ELEKTRA_SET_ERRORF (123, parentKey, "%s == %s but requirement was !=", val1, val2);
-				return -1;
+				ret = -1;
+				break;
 			}
 		}
 		else if (result.op == LT)
@@ -411,7 +563,8 @@ int elektraMathcheckSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key
 			if (elektraEFtoF (keyString (cur)) >= result.value)
 			{
 				ELEKTRA_SET_ERRORF (123, parentKey, "%s not < %s", val1, val2);
-				return -1;
+				ret = -1;
+				break;
 			}
 		}
 		else if (result.op == GT)
@@ -419,7 +572,8 @@ int elektraMathcheckSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key
 			if (elektraEFtoF (keyString (cur)) <= result.value)
 			{
 				ELEKTRA_SET_ERRORF (123, parentKey, "%s not > %s", val1, val2);
-				return -1;
+				ret = -1;
+				break;
 			}
 		}
 		else if (result.op == LE)
@@ -427,7 +581,8 @@ int elektraMathcheckSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key
 			if (elektraEFtoF (keyString (cur)) > result.value)
 			{
 				ELEKTRA_SET_ERRORF (123, parentKey, "%s not <=	%s", val1, val2);
-				return -1;
+				ret = -1;
+				break;
 			}
 		}
 		else if (result.op == GE)
@@ -435,7 +590,8 @@ int elektraMathcheckSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key
 			if (elektraEFtoF (keyString (cur)) < result.value)
 			{
 				ELEKTRA_SET_ERRORF (123, parentKey, "%s not >= %s", val1, val2);
-				return -1;
+				ret = -1;
+				break;
 			}
 		}
 		else if (result.op == SET)
@@ -443,15 +599,17 @@ int elektraMathcheckSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key
 			keySetString (cur, val2);
 		}
 	}
-	return 1; /* success */
+	ksDel (ks);
+	return ret; /* success */
 }
 
 Plugin * ELEKTRA_PLUGIN_EXPORT (mathcheck)
 {
 	// clang-format off
 	return elektraPluginExport("mathcheck",
+			ELEKTRA_PLUGIN_OPEN,	&elektraMathcheckOpen,
+			ELEKTRA_PLUGIN_CLOSE,	&elektraMathcheckClose,
 			ELEKTRA_PLUGIN_GET,	&elektraMathcheckGet,
 			ELEKTRA_PLUGIN_SET,	&elektraMathcheckSet,
 			ELEKTRA_PLUGIN_END);
 }
-
@@ -13,6 +13,8 @@
 #include <kdbplugin.h>
 
 
+int elektraMathcheckOpen (Plugin * handle, Key * errorKey);
+int elektraMathcheckClose (Plugin * handle, Key * errorKey);
 int elektraMathcheckGet (Plugin * handle, KeySet * ks, Key * parentKey);
 int elektraMathcheckSet (Plugin * handle, KeySet * ks, Key * parentKey);
 
@@ -65,6 +65,42 @@ static void test_multiUp (void)
 	ksDel (ks);
 }
 
+static void test_sharedExpression (void)
+{
+	Key * parentKey = keyNew ("user/tests/mathcheck", KEY_VALUE, "", KEY_END);
+	KeySet * conf = ksNew (0, KS_END);
+	KeySet * ks = ksNew (10, keyNew ("user/tests/mathcheck/factor", KEY_VALUE, "2", KEY_END),
+			     keyNew ("user/tests/mathcheck/x/sum", KEY_VALUE, "0", KEY_META, "check/math", ":= * @/factor ../val", KEY_END),
+			     keyNew ("user/tests/mathcheck/x/val", KEY_VALUE, "3", KEY_END),
+			     keyNew ("user/tests/mathcheck/y/sum", KEY_VALUE, "0", KEY_META, "check/math", ":= * @/factor ../val", KEY_END),
+			     keyNew ("user/tests/mathcheck/y/val", KEY_VALUE, "5", KEY_END), KS_END);
+
+	PLUGIN_OPEN ("mathcheck");
+	// the compiled expression is shared by both keys and reused by the second kdbSet
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "error");
+	succeed_if (!strcmp (keyString (ksLookupByName (ks, "user/tests/mathcheck/x/sum", 0)), "6"), "error");
+	succeed_if (!strcmp (keyString (ksLookupByName (ks, "user/tests/mathcheck/y/sum", 0)), "10"), "error");
+
+	keySetString (ksLookupByName (ks, "user/tests/mathcheck/factor", 0), "3");
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "error");
+	succeed_if (!strcmp (keyString (ksLookupByName (ks, "user/tests/mathcheck/x/sum", 0)), "9"), "error");
+	succeed_if (!strcmp (keyString (ksLookupByName (ks, "user/tests/mathcheck/y/sum", 0)), "15"), "error");
+
+	ksDel (ks);
+	ks = ksNew (10, keyNew ("user/tests/mathcheck/factor", KEY_VALUE, "4", KEY_END),
+		    keyNew ("user/tests/mathcheck/x/sum", KEY_VALUE, "0", KEY_META, "check/math", ":= * @/factor ../val", KEY_END),
+		    keyNew ("user/tests/mathcheck/x/val", KEY_VALUE, "3", KEY_END), KS_END);
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "error");
+	succeed_if (!strcmp (keyString (ksLookupByName (ks, "user/tests/mathcheck/x/sum", 0)), "12"), "error");
+
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+	ksDel (ks);
+}
+
 int main (int argc, char ** argv)
 {
 	printf ("MATHCHECK	   TESTS\n");
@@ -145,6 +181,7 @@ int main (int argc, char ** argv)
 	ksDel (ks);
 
 	test_multiUp ();
+	test_sharedExpression ();
 
 	print_result ("testmod_mathcheck");
 
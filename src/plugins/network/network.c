@@ -73,7 +73,7 @@ int elektraNetworkSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key *
 	Key * cur;
 
 	ksRewind (returned);
-	while ((cur = ksNext (returned)) != 0)
+	while ((cur = ksNextWithMeta (returned, "check/ipaddr")) != 0)
 	{
 		int s = elektraNetworkAddrInfo (cur);
 		if (s != 0)
@@ -87,10 +87,8 @@ int elektraPathSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * par
 	Key * cur;
 	ksRewind (returned);
 	int rc = 1;
-	while ((cur = ksNext (returned)) != 0)
+	while ((cur = ksNextWithMeta (returned, "check/path")) != 0)
 	{
-		const Key * meta = keyGetMeta (cur, "check/path");
-		if (!meta) continue;
 		rc = validateKey (cur, parentKey);
 		if (!rc) return -1;
 	}
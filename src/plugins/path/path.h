@@ -11,6 +11,7 @@
 
 #include <kdberrors.h>
 #include <kdbplugin.h>
+#include <kdbproposal.h>
 
 #include <errno.h>
 #include <stdlib.h>
@@ -39,6 +39,35 @@ typedef struct
 	} Value;
 } RangeValue;
 
+typedef struct
+{
+	RangeValue min;
+	RangeValue max;
+} Interval;
+
+/**
+ * The parsed form of a check/range for one type, shared by all keys with the same range.
+ * Only the ranges before the first range with invalid syntax are used,
+ * because validation stops at the first range containing the value.
+ */
+typedef struct
+{
+	char * rangeString;
+	RangeType type;
+	Interval * intervals; // sorted and disjoint
+	size_t size;
+	int containsAll;     // a bound is NaN, so every value is within the range
+	char * firstRange;   // reported if the value itself cannot be parsed
+	char * invalidRange; // first range with invalid syntax, NULL if all ranges are valid
+} Range;
+
+typedef struct
+{
+	Range ** ranges; // sorted by type and rangeString
+	size_t size;
+	size_t alloc;
+} RangeData;
+
 
 // switch min and max values if needed and apply -1 factor
 static void normalizeValues (RangeType type, RangeValue * min, RangeValue * max, RangeValue * a, RangeValue * b, int factorA, int factorB)
@@ -241,119 +270,224 @@ static int rangeStringToRange (const char * rangeString, RangeValue * min, Range
 }
 
 
-static int validateSingleRange (const char * valueStr, const char * rangeString, RangeType type)
+// parse the value of a key, return -1 on error, 0 on success
+
+static int parseValue (const char * valueStr, RangeValue * val, RangeType type)
 {
-	RangeValue min, max;
-	min.Value.i = 0;
-	max.Value.i = 0;
-	min.type = type;
-	max.type = type;
-	int rc = rangeStringToRange (rangeString, &min, &max, type);
-	if (rc)
-	{
-		return -1;
-	}
-	RangeValue val;
-	val.type = type;
-	val.Value.i = 0;
+	val->type = type;
+	val->Value.i = 0;
 	char * endPtr;
 	errno = 0; // the c std library doesn't reset errno, so do it before conversions to be safe
 	switch (type)
 	{
 	case INT:
 	case UINT:
-		val.Value.i = strtoull (valueStr, &endPtr, 10);
+		val->Value.i = strtoull (valueStr, &endPtr, 10);
 		break;
 	case FLOAT:
-		val.Value.f = strtold (valueStr, &endPtr);
+		val->Value.f = strtold (valueStr, &endPtr);
 		break;
 	case HEX:
-		val.Value.i = strtoull (valueStr, &endPtr, 16);
+		val->Value.i = strtoull (valueStr, &endPtr, 16);
 		break;
 	case CHAR:
-		val.Value.i = valueStr[0];
+		val->Value.i = valueStr[0];
 		break;
 	default:
 		break;
 	}
-	if (errno == ERANGE || (errno != 0 && val.Value.i == 0))
+	if (errno == ERANGE || (errno != 0 && val->Value.i == 0))
 	{
 		return -1;
 	}
+	return 0;
+}
+
+static int compareValues (const RangeValue * a, const RangeValue * b, RangeType type)
+{
 	switch (type)
 	{
 	case INT:
 	case HEX:
 	case CHAR:
-		if ((long long)val.Value.i < (long long)min.Value.i || (long long)val.Value.i > (long long)max.Value.i)
-		{
-			return 0;
-		}
-		else
-		{
-			return 1;
-		}
-		break;
+		return ((long long)a->Value.i > (long long)b->Value.i) - ((long long)a->Value.i < (long long)b->Value.i);
 	case UINT:
-		if (val.Value.i < min.Value.i || val.Value.i > max.Value.i)
-		{
-			return 0;
-		}
-		else
-		{
-			return 1;
-		}
-		break;
+		return (a->Value.i > b->Value.i) - (a->Value.i < b->Value.i);
 	case FLOAT:
-		if (val.Value.f < min.Value.f || val.Value.f > max.Value.f)
-		{
-			return 0;
-		}
-		else
-		{
-			return 1;
-		}
-		break;
+		return (a->Value.f > b->Value.f) - (a->Value.f < b->Value.f);
 	default:
-		return -1;
-		break;
+		return 0;
 	}
 }
 
-static int validateMultipleRanges (const char * valueStr, const char * rangeString, Key * parentKey, RangeType type)
+static int compareIntervalsSigned (const void * a, const void * b)
+{
+	return compareValues (&((const Interval *)a)->min, &((const Interval *)b)->min, INT);
+}
+
+static int compareIntervalsUnsigned (const void * a, const void * b)
+{
+	return compareValues (&((const Interval *)a)->min, &((const Interval *)b)->min, UINT);
+}
+
+static int compareIntervalsFloat (const void * a, const void * b)
+{
+	return compareValues (&((const Interval *)a)->min, &((const Interval *)b)->min, FLOAT);
+}
+
+static void freeRange (Range * range)
 {
+	if (range->intervals) elektraFree (range->intervals);
+	if (range->firstRange) elektraFree (range->firstRange);
+	if (range->invalidRange) elektraFree (range->invalidRange);
+	elektraFree (range->rangeString);
+	elektraFree (range);
+}
+
+/**
+ * @brief parses the comma separated ranges of rangeString into sorted, disjoint intervals
+ *
+ * @retval NULL if out of memory
+ */
+static Range * compileRange (const char * rangeString, RangeType type)
+{
+	Range * range = elektraCalloc (sizeof (Range));
+	if (!range) return NULL;
+	range->type = type;
+	range->rangeString = elektraStrDup (rangeString);
 	char * localCopy = elektraStrDup (rangeString);
+	if (!range->rangeString || !localCopy) goto error;
+
+	size_t count = 1;
+	for (const char * ptr = rangeString; *ptr; ++ptr)
+	{
+		if (*ptr == ',') ++count;
+	}
+	range->intervals = elektraMalloc (count * sizeof (Interval));
+	if (!range->intervals) goto error;
+
 	char * savePtr = NULL;
 	char * token = strtok_r (localCopy, ",", &savePtr);
-	int rc = validateSingleRange (valueStr, token, type);
-	if (rc == 1)
+	range->firstRange = elektraStrDup (token ? token : rangeString);
+	if (!range->firstRange) goto error;
+	if (!token)
 	{
-		elektraFree (localCopy);
-		return 1;
+		range->invalidRange = elektraStrDup (rangeString);
+		if (!range->invalidRange) goto error;
 	}
-	else if (rc == -1)
+	for (; token != NULL; token = strtok_r (NULL, ",", &savePtr))
 	{
-		elektraFree (localCopy);
-		ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_RANGE_SYNTAX, parentKey, "invalid syntax: %s", token);
-		return -1;
+		Interval * interval = &range->intervals[range->size];
+		interval->min.type = type;
+		interval->max.type = type;
+		interval->min.Value.i = 0;
+		interval->max.Value.i = 0;
+		if (rangeStringToRange (token, &interval->min, &interval->max, type))
+		{
+			range->invalidRange = elektraStrDup (token);
+			if (!range->invalidRange) goto error;
+			break;
+		}
+		if (type == FLOAT && (isnan (interval->min.Value.f) || isnan (interval->max.Value.f))) range->containsAll = 1;
+		++range->size;
 	}
-	while ((token = strtok_r (NULL, ",", &savePtr)) != NULL)
+	elektraFree (localCopy);
+
+	if (range->size == 0 || range->containsAll) return range;
+	qsort (range->intervals, range->size, sizeof (Interval),
+	       type == FLOAT ? compareIntervalsFloat : type == UINT ? compareIntervalsUnsigned : compareIntervalsSigned);
+	size_t merged = 0;
+	for (size_t i = 1; i < range->size; ++i)
 	{
-		rc = validateSingleRange (valueStr, token, type);
-		if (rc == 1)
+		Interval * last = &range->intervals[merged];
+		if (compareValues (&range->intervals[i].min, &last->max, type) <= 0)
 		{
-			elektraFree (localCopy);
-			return 1;
+			if (compareValues (&range->intervals[i].max, &last->max, type) > 0) last->max = range->intervals[i].max;
 		}
-		else if (rc == -1)
+		else
 		{
-			elektraFree (localCopy);
-			ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_RANGE_SYNTAX, parentKey, "invalid syntax: %s", token);
-			return -1;
+			range->intervals[++merged] = range->intervals[i];
 		}
 	}
-	elektraFree (localCopy);
-	return 0;
+	range->size = merged + 1;
+	return range;
+
+error:
+	if (localCopy) elektraFree (localCopy);
+	freeRange (range);
+	return NULL;
+}
+
+static int compareRange (const Range * range, RangeType type, const char * rangeString)
+{
+	if (range->type != type) return range->type < type ? -1 : 1;
+	return strcmp (range->rangeString, rangeString);
+}
+
+/**
+ * @brief returns the parsed range, every distinct range is only parsed once per plugin handle
+ *
+ * @retval NULL if out of memory
+ */
+static Range * getRange (RangeData * data, const char * rangeString, RangeType type)
+{
+	size_t lower = 0;
+	size_t upper = data->size;
+	while (lower < upper)
+	{
+		size_t middle = lower + (upper - lower) / 2;
+		int cmp = compareRange (data->ranges[middle], type, rangeString);
+		if (cmp == 0) return data->ranges[middle];
+		if (cmp < 0)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+
+	if (data->size == data->alloc)
+	{
+		size_t alloc = data->alloc ? data->alloc * 2 : 16;
+		if (elektraRealloc ((void **)&data->ranges, alloc * sizeof (Range *)) < 0) return NULL;
+		data->alloc = alloc;
+	}
+	Range * range = compileRange (rangeString, type);
+	if (!range) return NULL;
+	memmove (data->ranges + lower + 1, data->ranges + lower, (data->size - lower) * sizeof (Range *));
+	data->ranges[lower] = range;
+	++data->size;
+	return range;
+}
+
+static void freeData (RangeData * data)
+{
+	for (size_t i = 0; i < data->size; ++i)
+	{
+		freeRange (data->ranges[i]);
+	}
+	if (data->ranges) elektraFree (data->ranges);
+}
+
+// return 1 if the value is within one of the intervals, 0 otherwise
+
+static int withinRange (const Range * range, const RangeValue * val)
+{
+	if (range->size == 0) return 0;
+	// comparisons with NaN are false, so such values are never outside of an interval
+	if (range->containsAll || (range->type == FLOAT && isnan (val->Value.f))) return 1;
+
+	// find the last interval starting at or before the value
+	size_t lower = 0;
+	size_t upper = range->size;
+	while (lower < upper)
+	{
+		size_t middle = lower + (upper - lower) / 2;
+		if (compareValues (&range->intervals[middle].min, val, range->type) <= 0)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	if (lower == 0) return 0;
+	return compareValues (val, &range->intervals[lower - 1].max, range->type) <= 0;
 }
 
 static RangeType stringToType (const Key * typeMeta)
@@ -401,7 +535,7 @@ static RangeType getType (const Key * key)
 		return type;
 }
 
-static int validateKey (Key * key, Key * parentKey)
+static int validateKeyWithData (RangeData * data, Key * key, Key * parentKey)
 {
 	const Key * rangeMeta = keyGetMeta (key, "check/range");
 	const char * rangeString = keyString (rangeMeta);
@@ -423,35 +557,61 @@ static int validateKey (Key * key, Key * parentKey)
 		}
 	}
 
-	if (!strchr (rangeString, ','))
+	Range * range = getRange (data, rangeString, type);
+	if (!range)
 	{
-		int rc = validateSingleRange (keyString (key), rangeString, type);
-		if (rc == -1)
-		{
-			ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_RANGE_SYNTAX, parentKey, "invalid syntax: %s", keyString (rangeMeta));
-			return -1;
-		}
-		else if (rc == 0)
-		{
-			ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_INVALID_RANGE, parentKey, "value %s not within range %s", keyString (key),
-					    rangeString);
-			return 0;
-		}
-		else
-		{
-			return rc;
-		}
+		ELEKTRA_SET_ERROR (87, parentKey, "Out of memory");
+		return -1;
 	}
-	else
+
+	RangeValue val;
+	if (range->size == 0 || parseValue (keyString (key), &val, type))
 	{
-		int rc = validateMultipleRanges (keyString (key), rangeString, parentKey, type);
-		if (rc == 0)
-		{
-			ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_INVALID_RANGE, parentKey, "value %s not within range %s", keyString (key),
-					    rangeString);
-		}
-		return rc;
+		// like checking the ranges one after another, the first range is reported
+		ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_RANGE_SYNTAX, parentKey, "invalid syntax: %s", range->firstRange);
+		return -1;
+	}
+	if (withinRange (range, &val)) return 1;
+	if (range->invalidRange)
+	{
+		ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_RANGE_SYNTAX, parentKey, "invalid syntax: %s", range->invalidRange);
+		return -1;
 	}
+	ELEKTRA_SET_ERRORF (ELEKTRA_ERROR_INVALID_RANGE, parentKey, "value %s not within range %s", keyString (key), rangeString);
+	return 0;
+}
+
+static int validateKey (Key * key, Key * parentKey)
+{
+	RangeData data;
+	memset (&data, 0, sizeof (RangeData));
+	int rc = validateKeyWithData (&data, key, parentKey);
+	freeData (&data);
+	return rc;
+}
+
+int elektraRangeCheckKey (Plugin * handle, Key * key, Key * errorKey)
+{
+	return validateKeyWithData (elektraPluginGetData (handle), key, errorKey);
+}
+
+int elektraRangeOpen (Plugin * handle, Key * errorKey ELEKTRA_UNUSED)
+{
+	RangeData * data = elektraCalloc (sizeof (RangeData));
+	if (!data) return -1;
+	elektraPluginSetData (handle, data);
+	return 1; // success
+}
+
+int elektraRangeClose (Plugin * handle, Key * errorKey ELEKTRA_UNUSED)
+{
+	RangeData * data = elektraPluginGetData (handle);
+	if (!data) return 1;
+
+	freeData (data);
+	elektraFree (data);
+	elektraPluginSetData (handle, 0);
+	return 1; // success
 }
 
 int elektraRangeGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_UNUSED, Key * parentKey ELEKTRA_UNUSED)
@@ -461,9 +621,12 @@ int elektraRangeGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_U
 		KeySet * contract =
 			ksNew (30, keyNew ("system/elektra/modules/range", KEY_VALUE, "range plugin waits for your orders", KEY_END),
 			       keyNew ("system/elektra/modules/range/exports", KEY_END),
+			       keyNew ("system/elektra/modules/range/exports/open", KEY_FUNC, elektraRangeOpen, KEY_END),
+			       keyNew ("system/elektra/modules/range/exports/close", KEY_FUNC, elektraRangeClose, KEY_END),
 			       keyNew ("system/elektra/modules/range/exports/get", KEY_FUNC, elektraRangeGet, KEY_END),
 			       keyNew ("system/elektra/modules/range/exports/set", KEY_FUNC, elektraRangeSet, KEY_END),
 			       keyNew ("system/elektra/modules/range/exports/validateKey", KEY_FUNC, validateKey, KEY_END),
+			       keyNew ("system/elektra/modules/range/exports/checkkey", KEY_FUNC, elektraRangeCheckKey, KEY_END),
 #include ELEKTRA_README (range)
 			       keyNew ("system/elektra/modules/range/infos/version", KEY_VALUE, PLUGINVERSION, KEY_END), KS_END);
 		ksAppend (returned, contract);
@@ -476,30 +639,19 @@ int elektraRangeGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_U
 	return 1; // success
 }
 
-int elektraRangeSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_UNUSED, Key * parentKey ELEKTRA_UNUSED)
+int elektraRangeSet (Plugin * handle, KeySet * returned, Key * parentKey)
 {
 	// set all keys
 	// this function is optional
-	Key * cur;
-	while ((cur = ksNext (returned)) != NULL)
-	{
-		const Key * meta = keyGetMeta (cur, "check/range");
-		if (meta)
-		{
-			int rc = validateKey (cur, parentKey);
-			if (rc <= 0)
-			{
-				return -1;
-			}
-		}
-	}
-	return 1; // success
+	return elektraPluginCheckKeys (handle, returned, "check/range", elektraRangeCheckKey, parentKey);
 }
 
 Plugin * ELEKTRA_PLUGIN_EXPORT (range)
 {
 	// clang-format off
     return elektraPluginExport ("range",
+	    ELEKTRA_PLUGIN_OPEN,	&elektraRangeOpen,
+	    ELEKTRA_PLUGIN_CLOSE,	&elektraRangeClose,
 	    ELEKTRA_PLUGIN_GET,	&elektraRangeGet,
 	    ELEKTRA_PLUGIN_SET,	&elektraRangeSet,
 	    ELEKTRA_PLUGIN_END);
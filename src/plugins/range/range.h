@@ -13,8 +13,11 @@
 #include <kdbplugin.h>
 
 
+int elektraRangeOpen (Plugin * handle, Key * errorKey);
+int elektraRangeClose (Plugin * handle, Key * errorKey);
 int elektraRangeGet (Plugin * handle, KeySet * ks, Key * parentKey);
 int elektraRangeSet (Plugin * handle, KeySet * ks, Key * parentKey);
+int elektraRangeCheckKey (Plugin * handle, Key * key, Key * errorKey);
 
 Plugin * ELEKTRA_PLUGIN_EXPORT (range);
 
@@ -100,6 +100,55 @@ void testChar (const char * value, int ret, const char * rangeString)
 	PLUGIN_CLOSE ();
 }
 
+void testSharedRange (void)
+{
+	Key * parentKey = keyNew ("user/tests/range", KEY_VALUE, "", KEY_END);
+	KeySet * conf = ksNew (0, KS_END);
+	PLUGIN_OPEN ("range");
+
+	// the parsed range is reused for every key, overlapping ranges are merged
+	KeySet * ks = ksNew (10, KS_END);
+	const char * values[] = { "0", "4", "10", "22", "30", NULL };
+	for (int i = 0; values[i]; ++i)
+	{
+		char name[64];
+		snprintf (name, sizeof (name), "user/tests/range/key%d", i);
+		ksAppendKey (ks, keyNew (name, KEY_VALUE, values[i], KEY_META, "check/range", "15-30,10-20,0-4", KEY_END));
+	}
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "all keys should be within the range");
+
+	ksAppendKey (ks, keyNew ("user/tests/range/keyOutside", KEY_VALUE, "7", KEY_META, "check/range", "15-30,10-20,0-4", KEY_END));
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == -1, "value between the ranges should fail");
+	succeed_if (!strcmp (keyString (keyGetMeta (parentKey, "error/number")), "171"), "wrong error");
+	ksDel (ks);
+
+	// the same range with another type is parsed separately
+	ks = ksNew (10, keyNew ("user/tests/range/key", KEY_VALUE, "-1", KEY_META, "check/range", "15-30,10-20,0-4", KEY_META, "check/type",
+				 "unsigned long", KEY_END),
+		    KS_END);
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == -1, "negative value should fail for unsigned types");
+	ksDel (ks);
+
+	// ranges after an invalid range are ignored, the ones before are used
+	ks = ksNew (10, keyNew ("user/tests/range/key", KEY_VALUE, "3", KEY_META, "check/range", "1-5,x,7-9", KEY_END), KS_END);
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "value within a range before the invalid range should be valid");
+	ksDel (ks);
+	Key * syntaxKey = keyNew ("user/tests/range", KEY_END);
+	ks = ksNew (10, keyNew ("user/tests/range/key", KEY_VALUE, "8", KEY_META, "check/range", "1-5,x,7-9", KEY_END), KS_END);
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, syntaxKey) == -1, "invalid range should be reported");
+	succeed_if (!strcmp (keyString (keyGetMeta (syntaxKey, "error/reason")), "invalid syntax: x"), "wrong error reason");
+	ksDel (ks);
+	keyDel (syntaxKey);
+
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
 int main (int argc, char ** argv)
 {
 	printf ("RANGE     TESTS\n");
@@ -194,6 +243,8 @@ int main (int argc, char ** argv)
 	snprintf (number, 256, "%llu", 1ULL);
 	testUInt (number, 1, range);
 
+	testSharedRange ();
+
 	setlocale (LC_ALL, old_locale);
 	elektraFree (old_locale);
 	print_result ("testmod_range");
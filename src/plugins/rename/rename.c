@@ -268,6 +268,38 @@ static Key * restoreKeyName (Key * key, const Key * parentKey, const Key * confi
 	return 0;
 }
 
+/**
+ * @brief Replaces all keys of returned with the given keys, if they are still ordered
+ *
+ * Renaming usually keeps the order of the keys, so the keyset can be built
+ * by appending one key after the other instead of removing and inserting
+ * every renamed key.
+ *
+ * @param keys holds all keys of returned in their original order, either renamed or not
+ * @retval 1 if returned holds the given keys
+ * @retval 0 if returned is unchanged because the keys are not ordered anymore
+ */
+static int replaceOrderedKeys (KeySet * returned, Key ** keys, size_t size, Key * parentKey)
+{
+	for (size_t i = 1; i < size; ++i)
+	{
+		if (keyCmp (keys[i - 1], keys[i]) >= 0) return 0;
+	}
+
+	KeySet * renamed = ksNew (size, KS_END);
+	for (size_t i = 0; i < size; ++i)
+	{
+		ksAppendKey (renamed, keys[i]);
+	}
+
+	/* make sure the parent key is not deleted */
+	keyIncRef (parentKey);
+	ksCopy (returned, renamed);
+	keyDecRef (parentKey);
+	ksDel (renamed);
+	return 1;
+}
+
 int elektraRenameGet (Plugin * handle, KeySet * returned, Key * parentKey)
 {
 	/* configuration only */
@@ -284,6 +316,13 @@ int elektraRenameGet (Plugin * handle, KeySet * returned, Key * parentKey)
 
 	KeySet * config = elektraPluginGetConfig (handle);
 	KeySet * iterateKs = ksDup (returned);
+	Key ** renamedKeys = elektraMalloc ((ksGetSize (iterateKs) + 1) * sizeof (Key *));
+	if (!renamedKeys)
+	{
+		ELEKTRA_SET_ERROR (87, parentKey, "Out of memory");
+		ksDel (iterateKs);
+		return -1;
+	}
 
 	ksRewind (iterateKs);
 
@@ -295,14 +334,31 @@ int elektraRenameGet (Plugin * handle, KeySet * returned, Key * parentKey)
 
 
 	Key * key;
+	size_t size = 0;
 	while ((key = ksNext (iterateKs)) != 0)
 	{
-
 		Key * renamedKey = renameGet (key, parentKey, cutConfig, replaceWith, toUpper, toLower, getCase);
 
 		if (renamedKey)
 		{
 			keySetMeta (renamedKey, ELEKTRA_ORIGINAL_NAME_META, keyName (key));
+			renamedKeys[size++] = renamedKey;
+		}
+		else
+		{
+			keySetMeta (key, ELEKTRA_ORIGINAL_NAME_META, keyName (key));
+			renamedKeys[size++] = key;
+		}
+	}
+
+	if (!replaceOrderedKeys (returned, renamedKeys, size, parentKey))
+	{
+		ksRewind (iterateKs);
+		for (size_t i = 0; (key = ksNext (iterateKs)) != 0; ++i)
+		{
+			Key * renamedKey = renamedKeys[i];
+			if (renamedKey == key) continue;
+
 			ksLookup (returned, key, KDB_O_POP);
 			keyDel (key);
 
@@ -323,16 +379,13 @@ int elektraRenameGet (Plugin * handle, KeySet * returned, Key * parentKey)
 				ksAppendKey (returned, renamedKey);
 			}
 		}
-		else
-		{
-			keySetMeta (key, ELEKTRA_ORIGINAL_NAME_META, keyName (key));
-		}
 	}
 
 	/* make sure the parent key is not deleted */
 	keyIncRef (parentKey);
 	ksDel (iterateKs);
 	keyDecRef (parentKey);
+	elektraFree (renamedKeys);
 
 	return 1; /* success */
 }
@@ -341,6 +394,13 @@ int elektraRenameSet (Plugin * handle, KeySet * returned, Key * parentKey)
 {
 
 	KeySet * iterateKs = ksDup (returned);
+	Key ** renamedKeys = elektraMalloc ((ksGetSize (iterateKs) + 1) * sizeof (Key *));
+	if (!renamedKeys)
+	{
+		ELEKTRA_SET_ERROR (87, parentKey, "Out of memory");
+		ksDel (iterateKs);
+		return -1;
+	}
 
 	KeySet * config = elektraPluginGetConfig (handle);
 	Key * cutConfig = ksLookupByName (config, "/cut", KDB_O_NONE);
@@ -372,16 +432,17 @@ int elektraRenameSet (Plugin * handle, KeySet * returned, Key * parentKey)
 	Key * key;
 	char * parentKeyName = elektraMalloc (keyGetFullNameSize (parentKey));
 	keyGetFullName (parentKey, parentKeyName, keyGetFullNameSize (parentKey));
-	while ((key = ksNext (iterateKs)) != 0)
+	if (writeConversion != KEYNAME)
 	{
-		Key * renamedKey = NULL;
-		if (writeConversion != KEYNAME)
+		size_t size = 0;
+		int keepsParentKey = 0;
+		while ((key = ksNext (iterateKs)) != 0)
 		{
-			renamedKey = restoreKeyName (key, parentKey, cutConfig);
+			Key * renamedKey = restoreKeyName (key, parentKey, cutConfig);
 
-			if (!renamedKey) renamedKey = keyDup (key);
 			if (writeConversion == TOUPPER || writeConversion == TOLOWER)
 			{
+				if (!renamedKey) renamedKey = keyDup (key);
 				char * curKeyName = elektraMalloc (keyGetFullNameSize (renamedKey));
 				keyGetFullName (renamedKey, curKeyName, keyGetFullNameSize (renamedKey));
 
@@ -392,18 +453,34 @@ int elektraRenameSet (Plugin * handle, KeySet * returned, Key * parentKey)
 				keySetName (renamedKey, curKeyName);
 				elektraFree (curKeyName);
 			}
-			/*
-			 * if something is restored from the parentKey, do
-			 * not delete the parentKey (might cause troubles)
-			 */
-			if (keyCmp (key, parentKey) != 0)
+			// a key named like the parent key is kept in addition to the restored key, see below
+			if (renamedKey && keyCmp (key, parentKey) == 0) keepsParentKey = 1;
+			renamedKeys[size++] = renamedKey ? renamedKey : key;
+		}
+
+		if (keepsParentKey || !replaceOrderedKeys (returned, renamedKeys, size, parentKey))
+		{
+			ksRewind (iterateKs);
+			for (size_t i = 0; (key = ksNext (iterateKs)) != 0; ++i)
 			{
-				keyDel (ksLookup (returned, key, KDB_O_POP));
+				Key * renamedKey = renamedKeys[i];
+				if (renamedKey == key) renamedKey = keyDup (key);
+				/*
+				 * if something is restored from the parentKey, do
+				 * not delete the parentKey (might cause troubles)
+				 */
+				if (keyCmp (key, parentKey) != 0)
+				{
+					keyDel (ksLookup (returned, key, KDB_O_POP));
+				}
+				ksAppendKey (returned, renamedKey);
+				keyDel (renamedKey);
 			}
-			ksAppendKey (returned, renamedKey);
-			keyDel (renamedKey);
 		}
-		else
+	}
+	else
+	{
+		while ((key = ksNext (iterateKs)) != 0)
 		{
 			if (keyCmp (key, parentKey) != 0)
 			{
@@ -419,6 +496,7 @@ int elektraRenameSet (Plugin * handle, KeySet * returned, Key * parentKey)
 
 	ksRewind (returned);
 	elektraFree (parentKeyName);
+	elektraFree (renamedKeys);
 	return 1; /* success */
 }
 
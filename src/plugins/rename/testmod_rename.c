@@ -434,6 +434,138 @@ static void test_write2 (void)
 	ksDel (ks);
 	PLUGIN_CLOSE ();
 }
+static void test_orderedCutRoundTrip (void)
+{
+	Key * parentKey = keyNew ("user/tests/rename", KEY_END);
+	KeySet * conf = ksNew (20, keyNew ("system/cut", KEY_VALUE, "prefix", KEY_END), KS_END);
+	PLUGIN_OPEN ("rename");
+
+	// the cut keeps the order of the keys, so the keyset is rebuilt at once
+	KeySet * ks = ksNew (20, keyNew ("user/tests/rename/prefix/a", KEY_VALUE, "a", KEY_END),
+			     keyNew ("user/tests/rename/prefix/b", KEY_VALUE, "b", KEY_END),
+			     keyNew ("user/tests/rename/prefix/c/d", KEY_VALUE, "d", KEY_END),
+			     keyNew ("user/tests/rename/z", KEY_VALUE, "z", KEY_END), KS_END);
+	ksAppendKey (ks, parentKey);
+	Key * unchanged = ksLookupByName (ks, "user/tests/rename/z", KDB_O_NONE);
+
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) >= 1, "call to kdbGet was not successful");
+	succeed_if (output_error (parentKey), "error in kdbGet");
+	succeed_if (output_warnings (parentKey), "warnings in kdbGet");
+
+	KeySet * expected = ksNew (20, keyNew ("user/tests/rename", KEY_END), keyNew ("user/tests/rename/a", KEY_VALUE, "a", KEY_END),
+				   keyNew ("user/tests/rename/b", KEY_VALUE, "b", KEY_END),
+				   keyNew ("user/tests/rename/c/d", KEY_VALUE, "d", KEY_END),
+				   keyNew ("user/tests/rename/z", KEY_VALUE, "z", KEY_END), KS_END);
+	compareKeySets (ks, expected);
+	ksDel (expected);
+	succeed_if (ksLookupByName (ks, "user/tests/rename", KDB_O_NONE) == parentKey, "parent key should be kept");
+	succeed_if (ksLookupByName (ks, "user/tests/rename/z", KDB_O_NONE) == unchanged, "unchanged key should be kept");
+	Key * key = ksLookupByName (ks, "user/tests/rename/c/d", KDB_O_NONE);
+	succeed_if (key && !strcmp (keyString (keyGetMeta (key, ELEKTRA_ORIGINAL_NAME_META)), "user/tests/rename/prefix/c/d"),
+		    "original name was not stored");
+
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) >= 1, "call to kdbSet was not successful");
+	succeed_if (output_error (parentKey), "error in kdbSet");
+	succeed_if (output_warnings (parentKey), "warnings in kdbSet");
+
+	expected = ksNew (20, keyNew ("user/tests/rename", KEY_END), keyNew ("user/tests/rename/prefix/a", KEY_VALUE, "a", KEY_END),
+			  keyNew ("user/tests/rename/prefix/b", KEY_VALUE, "b", KEY_END),
+			  keyNew ("user/tests/rename/prefix/c/d", KEY_VALUE, "d", KEY_END),
+			  keyNew ("user/tests/rename/z", KEY_VALUE, "z", KEY_END), KS_END);
+	compareKeySets (ks, expected);
+	ksDel (expected);
+	succeed_if (ksLookupByName (ks, "user/tests/rename", KDB_O_NONE) == parentKey, "parent key should be kept");
+	succeed_if (ksLookupByName (ks, "user/tests/rename/z", KDB_O_NONE) == unchanged, "unchanged key should be kept");
+
+	ksDel (ks);
+	PLUGIN_CLOSE ();
+}
+
+static void test_reorderingCaseRoundTrip (void)
+{
+	Key * parentKey = keyNew ("user/tests/rename", KEY_END);
+	KeySet * conf = ksNew (20, keyNew ("system/toupper", KEY_VALUE, "0", KEY_END), KS_END);
+	PLUGIN_OPEN ("rename");
+
+	// B is before a, but A is before B, so the keys are renamed one by one
+	KeySet * ks = ksNew (20, keyNew ("user/tests/rename/B", KEY_VALUE, "b", KEY_END),
+			     keyNew ("user/tests/rename/a", KEY_VALUE, "a", KEY_END),
+			     keyNew ("user/tests/rename/a/c", KEY_VALUE, "c", KEY_END), KS_END);
+
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) >= 1, "call to kdbGet was not successful");
+	succeed_if (output_error (parentKey), "error in kdbGet");
+	succeed_if (output_warnings (parentKey), "warnings in kdbGet");
+
+	KeySet * expected = ksNew (20, keyNew ("user/tests/rename/A", KEY_VALUE, "a", KEY_END),
+				   keyNew ("user/tests/rename/A/C", KEY_VALUE, "c", KEY_END),
+				   keyNew ("user/tests/rename/B", KEY_VALUE, "b", KEY_END), KS_END);
+	compareKeySets (ks, expected);
+	ksDel (expected);
+
+	// the original names are restored, which again changes the order
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) >= 1, "call to kdbSet was not successful");
+	succeed_if (output_error (parentKey), "error in kdbSet");
+	succeed_if (output_warnings (parentKey), "warnings in kdbSet");
+
+	expected = ksNew (20, keyNew ("user/tests/rename/B", KEY_VALUE, "b", KEY_END),
+			  keyNew ("user/tests/rename/a", KEY_VALUE, "a", KEY_END),
+			  keyNew ("user/tests/rename/a/c", KEY_VALUE, "c", KEY_END), KS_END);
+	compareKeySets (ks, expected);
+	ksDel (expected);
+
+	keyDel (parentKey);
+	ksDel (ks);
+	PLUGIN_CLOSE ();
+}
+
+static void test_reorderingToLowerOnGet (void)
+{
+	Key * parentKey = keyNew ("user/tests/rename", KEY_END);
+	KeySet * conf = ksNew (20, keyNew ("system/tolower", KEY_VALUE, "0", KEY_END), KS_END);
+	PLUGIN_OPEN ("rename");
+
+	KeySet * ks = ksNew (20, keyNew ("user/tests/rename/B", KEY_VALUE, "b", KEY_END),
+			     keyNew ("user/tests/rename/a", KEY_VALUE, "a", KEY_END), KS_END);
+
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) >= 1, "call to kdbGet was not successful");
+
+	KeySet * expected = ksNew (20, keyNew ("user/tests/rename/a", KEY_VALUE, "a", KEY_END),
+				   keyNew ("user/tests/rename/b", KEY_VALUE, "b", KEY_END), KS_END);
+	compareKeySets (ks, expected);
+	ksDel (expected);
+
+	keyDel (parentKey);
+	ksDel (ks);
+	PLUGIN_CLOSE ();
+}
+
+static void test_parentKeyRestoredOnSet (void)
+{
+	Key * parentKey = keyNew ("user/tests/rename", KEY_VALUE, "parent", KEY_END);
+	KeySet * conf = ksNew (20, keyNew ("system/cut", KEY_VALUE, "prefix", KEY_END), KS_END);
+	PLUGIN_OPEN ("rename");
+
+	// without the original name, the key named like the parent key is restored below the cut
+	KeySet * ks = ksNew (20, keyNew ("user/tests/rename/a", KEY_VALUE, "a", KEY_META, ELEKTRA_ORIGINAL_NAME_META,
+					 "user/tests/rename/prefix/a", KEY_END),
+			     KS_END);
+	ksAppendKey (ks, parentKey);
+
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) >= 1, "call to kdbSet was not successful");
+	succeed_if (output_error (parentKey), "error in kdbSet");
+	succeed_if (output_warnings (parentKey), "warnings in kdbSet");
+
+	KeySet * expected = ksNew (20, keyNew ("user/tests/rename", KEY_VALUE, "parent", KEY_END),
+				   keyNew ("user/tests/rename/prefix", KEY_VALUE, "parent", KEY_END),
+				   keyNew ("user/tests/rename/prefix/a", KEY_VALUE, "a", KEY_END), KS_END);
+	compareKeySets (ks, expected);
+	ksDel (expected);
+	succeed_if (ksLookupByName (ks, "user/tests/rename", KDB_O_NONE) == parentKey, "parent key should be kept");
+
+	ksDel (ks);
+	PLUGIN_CLOSE ();
+}
+
 int main (int argc, char ** argv)
 {
 	printf ("RENAME       TESTS\n");
@@ -456,6 +588,10 @@ int main (int argc, char ** argv)
 	test_replaceString ();
 	test_write ();
 	test_write2 ();
+	test_orderedCutRoundTrip ();
+	test_reorderingCaseRoundTrip ();
+	test_reorderingToLowerOnGet ();
+	test_parentKeyRestoredOnSet ();
 	print_result ("test_rename");
 
 	return nbError;
@@ -51,6 +51,37 @@ typedef struct
 	int counter;
 } PluginConfig;
 
+typedef struct _SpecNode SpecNode;
+
+/**
+ * A node of the trie built from the matching strings of all spec keys.
+ *
+ * Every edge of the trie stands for one segment of a key name. Literal
+ * segments are stored sorted in `children`, so that we can use a binary
+ * search. `_` and all segments containing other globbing characters
+ * match any segment and are stored in `any`, `#` is stored in `array`.
+ */
+struct _SpecNode
+{
+	char * segment;
+	SpecNode ** children;
+	size_t childCount;
+	SpecNode * any;
+	SpecNode * array;
+	size_t * specs; ///< indices of the spec keys whose matching string ends here
+	size_t specCount;
+};
+
+typedef struct
+{
+	SpecNode * root;
+	Key ** specKeys;
+	char ** patterns;
+	KeySet ** matches; ///< keys that might match the spec key with the same index
+	size_t size;
+	KeySet * known; ///< keys that were already added to `matches`
+} SpecMatcher;
+
 static char * keyNameToMatchingString (const Key * key)
 {
 	uint8_t arrayCount = 0;
@@ -165,7 +196,7 @@ static void validateArrayRange (Key * parent, long validCount, Key * specKey)
 	}
 }
 
-static void validateArray (KeySet * ks, Key * arrayKey, Key * specKey)
+static void validateArray (KeySet * ks, Key * arrayKey, Key * specKey, KeySet * dirty)
 {
 	Key * tmpArrayParent = keyDup (arrayKey);
 	keySetBaseName (tmpArrayParent, 0);
@@ -192,7 +223,11 @@ static void validateArray (KeySet * ks, Key * arrayKey, Key * specKey)
 				Key * toMark;
 				while ((toMark = ksNext (invalidCutKS)) != NULL)
 				{
-					if (strcmp (keyName (cur), keyName (toMark))) keySetMeta (toMark, "conflict/invalid", "");
+					if (strcmp (keyName (cur), keyName (toMark)))
+					{
+						keySetMeta (toMark, "conflict/invalid", "");
+						ksAppendKey (dirty, toMark);
+					}
 					elektraMetaArrayAdd (arrayParent, "conflict/invalid/hasmember", keyName (toMark));
 				}
 				ksDel (invalidCutKS);
@@ -202,8 +237,9 @@ static void validateArray (KeySet * ks, Key * arrayKey, Key * specKey)
 	ksDel (subKeys);
 	ksDel (ksCopy);
 	validateArrayRange (arrayParent, validCount, specKey);
+	ksAppendKey (dirty, arrayParent);
 }
-static void validateWildcardSubs (KeySet * ks, Key * key, Key * specKey)
+static void validateWildcardSubs (KeySet * ks, Key * key, Key * specKey, KeySet * dirty)
 {
 	const Key * requiredMeta = keyGetMeta (specKey, "required");
 	if (!requiredMeta) return;
@@ -226,6 +262,7 @@ static void validateWildcardSubs (KeySet * ks, Key * key, Key * specKey)
 		char buffer[MAX_CHARS_IN_LONG + 1];
 		snprintf (buffer, sizeof (buffer), "%ld", subCount);
 		keySetMeta (parent, "conflict/invalid/subcount", buffer);
+		ksAppendKey (dirty, parent);
 	}
 
 	ksDel (subKeys);
@@ -648,85 +685,474 @@ static int hasRequired (Key * key, Key * specKey, KeySet * ks)
 	return 1;
 }
 
-static int doGlobbing (Key * parentKey, KeySet * returned, KeySet * specKS, ConflictHandling * ch, Direction dir, int clean)
+static SpecNode * newSpecNode (const char * segment, size_t length)
 {
-	Key * specKey;
-	ksRewind (specKS);
-	int ret = 1;
-	while ((specKey = ksNext (specKS)) != NULL)
+	SpecNode * node = elektraCalloc (sizeof (SpecNode));
+	if (!node) return NULL;
+	if (segment)
+	{
+		node->segment = elektraMalloc (length + 1);
+		if (!node->segment)
+		{
+			elektraFree (node);
+			return NULL;
+		}
+		memcpy (node->segment, segment, length);
+		node->segment[length] = '\0';
+	}
+	return node;
+}
+
+static void delSpecNode (SpecNode * node)
+{
+	if (!node) return;
+	for (size_t i = 0; i < node->childCount; ++i)
+	{
+		delSpecNode (node->children[i]);
+	}
+	delSpecNode (node->any);
+	delSpecNode (node->array);
+	if (node->children) elektraFree (node->children);
+	if (node->specs) elektraFree (node->specs);
+	if (node->segment) elektraFree (node->segment);
+	elektraFree (node);
+}
+
+static int compareSegment (const char * segment, size_t length, const char * other)
+{
+	int cmp = strncmp (segment, other, length);
+	if (cmp != 0) return cmp;
+	return other[length] == '\0' ? 0 : -1;
+}
+
+/**
+ * @brief Find the position of a literal child via binary search
+ *
+ * @retval 1 if the child was found
+ * @retval 0 otherwise, then `position` is where the child has to be inserted
+ */
+static int findChild (const SpecNode * node, const char * segment, size_t length, size_t * position)
+{
+	size_t left = 0;
+	size_t right = node->childCount;
+	while (left < right)
+	{
+		size_t middle = left + (right - left) / 2;
+		int cmp = compareSegment (segment, length, node->children[middle]->segment);
+		if (cmp == 0)
+		{
+			*position = middle;
+			return 1;
+		}
+		if (cmp < 0)
+			right = middle;
+		else
+			left = middle + 1;
+	}
+	*position = left;
+	return 0;
+}
+
+static SpecNode * addSpecSegment (SpecNode * node, const char * segment, size_t length)
+{
+	SpecNode ** child;
+	if (length == 2 && !strncmp (segment, "#*", 2))
+	{
+		child = &node->array;
+	}
+	else if (strcspn (segment, "*?[\\") < length)
+	{
+		child = &node->any;
+	}
+	else
+	{
+		size_t position;
+		if (findChild (node, segment, length, &position)) return node->children[position];
+		SpecNode * newNode = newSpecNode (segment, length);
+		if (!newNode) return NULL;
+		if (elektraRealloc ((void **)&node->children, (node->childCount + 1) * sizeof (SpecNode *)) < 0)
+		{
+			delSpecNode (newNode);
+			return NULL;
+		}
+		memmove (node->children + position + 1, node->children + position, (node->childCount - position) * sizeof (SpecNode *));
+		node->children[position] = newNode;
+		++node->childCount;
+		return newNode;
+	}
+	if (!*child) *child = newSpecNode (NULL, 0);
+	return *child;
+}
+
+static int addSpecPattern (SpecNode * root, const char * pattern, size_t index)
+{
+	SpecNode * node = root;
+	const char * segment = pattern;
+	while (node)
+	{
+		size_t length = strcspn (segment, "/");
+		node = addSpecSegment (node, segment, length);
+		if (segment[length] == '\0') break;
+		segment += length + 1;
+	}
+	if (!node) return -1;
+	if (elektraRealloc ((void **)&node->specs, (node->specCount + 1) * sizeof (size_t)) < 0) return -1;
+	node->specs[node->specCount++] = index;
+	return 0;
+}
+
+/**
+ * @brief Add `key` to the candidates of all spec keys (with an index of at least `from`) whose matching string might match the key
+ *
+ * The trie only narrows down the candidates, every candidate is checked with `matchPatternToKey` later on.
+ */
+static int addSpecMatches (SpecMatcher * matcher, const SpecNode * node, const char * name, Key * key, size_t from)
+{
+	size_t length = strcspn (name, "/");
+	const SpecNode * next[3] = { node->any, NULL, NULL };
+	size_t position;
+	if (name[0] == '#') next[1] = node->array;
+	if (node->childCount > 0 && findChild (node, name, length, &position)) next[2] = node->children[position];
+
+	for (size_t i = 0; i < 3; ++i)
+	{
+		if (!next[i]) continue;
+		if (name[length] != '\0')
+		{
+			if (addSpecMatches (matcher, next[i], name + length + 1, key, from) < 0) return -1;
+			continue;
+		}
+		for (size_t j = 0; j < next[i]->specCount; ++j)
+		{
+			size_t index = next[i]->specs[j];
+			if (index < from) continue;
+			if (!matcher->matches[index] && !(matcher->matches[index] = ksNew (0, KS_END))) return -1;
+			if (ksAppendKey (matcher->matches[index], key) < 0) return -1;
+		}
+	}
+	return 0;
+}
+
+static void delSpecMatcher (SpecMatcher * matcher)
+{
+	delSpecNode (matcher->root);
+	for (size_t i = 0; i < matcher->size; ++i)
 	{
-		int require = 0;
-		char * pattern;
+		if (matcher->patterns[i]) elektraFree (matcher->patterns[i]);
+		if (matcher->matches[i]) ksDel (matcher->matches[i]);
+	}
+	if (matcher->specKeys) elektraFree (matcher->specKeys);
+	if (matcher->patterns) elektraFree (matcher->patterns);
+	if (matcher->matches) elektraFree (matcher->matches);
+	ksDel (matcher->known);
+}
+
+static int registerKey (SpecMatcher * matcher, Key * key, size_t from)
+{
+	ksAppendKey (matcher->known, key);
+	if (keyGetNamespace (key) == KEY_NS_SPEC) return 0;
+	const char * name = strchr (keyName (key), '/');
+	if (!name) return 0;
+	return addSpecMatches (matcher, matcher->root, name + 1, key, from);
+}
+
+/**
+ * @brief Compile the matching strings of all spec keys into one trie and assign every key of `returned` its candidate spec keys
+ *
+ * This way we only need a single pass over `returned`, instead of matching every spec key against every key.
+ */
+static int initSpecMatcher (SpecMatcher * matcher, KeySet * specKS, KeySet * returned)
+{
+	memset (matcher, 0, sizeof (SpecMatcher));
+	size_t size = ksGetSize (specKS);
+	matcher->root = newSpecNode (NULL, 0);
+	matcher->known = ksNew (ksGetSize (returned), KS_END);
+	if (!matcher->root || !matcher->known) return -1;
+	if (size > 0)
+	{
+		matcher->specKeys = elektraCalloc (size * sizeof (Key *));
+		matcher->patterns = elektraCalloc (size * sizeof (char *));
+		matcher->matches = elektraCalloc (size * sizeof (KeySet *));
+		if (!matcher->specKeys || !matcher->patterns || !matcher->matches) return -1;
+	}
+	matcher->size = size;
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		Key * specKey = ksAtCursor (specKS, i);
+		matcher->specKeys[i] = specKey;
 		if (keyGetMeta (specKey, "require"))
 		{
-			require = 1;
 			Key * matchKey = keyDup (specKey);
 			keySetBaseName (matchKey, 0);
-			pattern = keyNameToMatchingString (matchKey);
+			matcher->patterns[i] = keyNameToMatchingString (matchKey);
 			keyDel (matchKey);
 		}
 		else
 		{
-			pattern = keyNameToMatchingString (specKey);
+			matcher->patterns[i] = keyNameToMatchingString (specKey);
 		}
-		int found = 0;
-		ksRewind (returned);
-		Key * cur;
-		while ((cur = ksNext (returned)) != NULL)
+		if (!matcher->patterns[i] || addSpecPattern (matcher->root, matcher->patterns[i], i) < 0) return -1;
+	}
+
+	Key * cur;
+	ksRewind (returned);
+	while ((cur = ksNext (returned)) != NULL)
+	{
+		if (registerKey (matcher, cur, 0) < 0) return -1;
+	}
+	return 0;
+}
+
+static int hasUnhandledConflicts (Key * key)
+{
+	keyRewindMeta (key);
+	while (keyNextMeta (key) != NULL)
+	{
+		Key * meta = (Key *)keyCurrentMeta (key);
+		if (getConflict (meta) != NAC || !strncmp (keyName (meta), "conflict/#", 10) ||
+		    !strncmp (keyName (meta), "conflict/invalid/hasmember/#", 28))
 		{
-			if (keyGetNamespace (cur) == KEY_NS_SPEC) continue;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Register keys that were added to `returned` behind our back
+ *
+ * Cascading lookups of keys that have a spec key with a default value add a default key to `returned`.
+ * Such keys are candidates for the spec keys starting at `from`.
+ */
+static int registerNewKeys (SpecMatcher * matcher, KeySet * returned, KeySet * fresh, KeySet * dirty, size_t from)
+{
+	if (ksGetSize (returned) == ksGetSize (matcher->known)) return 0;
 
-			cursor_t cursor = ksGetCursor (returned);
-			if (matchPatternToKey (pattern, cur))
+	for (cursor_t i = 0; i < ksGetSize (returned); ++i)
+	{
+		Key * cur = ksAtCursor (returned, i);
+		if (ksLookup (matcher->known, cur, KDB_O_NOCASCADING) == cur) continue;
+		if (registerKey (matcher, cur, from) < 0) return -1;
+		ksAppendKey (fresh, cur);
+		if (hasUnhandledConflicts (cur)) ksAppendKey (dirty, cur);
+	}
+	return 0;
+}
+
+static cursor_t positionOf (KeySet * ks, Key * key)
+{
+	if (ksLookup (ks, key, KDB_O_NOCASCADING) != key) return -1;
+	return ksGetCursor (ks);
+}
+
+/**
+ * @brief Find the position of the first key in `ks` that is not less than `key`
+ */
+static cursor_t lowerBound (KeySet * ks, const Key * key)
+{
+	cursor_t left = 0;
+	cursor_t right = ksGetSize (ks);
+	while (left < right)
+	{
+		cursor_t middle = left + (right - left) / 2;
+		if (keyCmp (ksAtCursor (ks, middle), key) < 0)
+			left = middle + 1;
+		else
+			right = middle;
+	}
+	return left;
+}
+
+/**
+ * @brief Find the first key directly below `parent` with a position in [`from`, `to`)
+ *
+ * @return the position of the key or `to` if there is none
+ */
+static cursor_t firstDirectChild (KeySet * ks, const Key * parent, cursor_t from, cursor_t to)
+{
+	cursor_t position = lowerBound (ks, parent);
+	if (position < from) position = from;
+	for (; position < to; ++position)
+	{
+		Key * cur = ksAtCursor (ks, position);
+		if (keyCmp (cur, parent) == 0) continue;
+		if (keyGetNamespace (cur) != keyGetNamespace (parent) || !keyIsBelow (parent, cur)) break;
+		if (keyIsDirectBelow (parent, cur)) return position;
+	}
+	return to;
+}
+
+/**
+ * @brief Find the first key after `after` (or the first key at all, if `after` is `NULL`), for which
+ * `handleErrors` handles the conflicts of `key`
+ *
+ * These are `key` itself and all keys whose parent (as looked up by `handleErrors`) is `key`.
+ */
+static Key * nextConflictHandler (KeySet * returned, Key * key, Key * after)
+{
+	Key * next = NULL;
+	if (positionOf (returned, key) >= (after ? positionOf (returned, after) + 1 : 0)) next = key;
+
+	const char * name = strchr (keyName (key), '/');
+	Key * parents[2] = { keyNew (keyName (key), KEY_CASCADING_NAME, KEY_END),
+			     name && name != keyName (key) ? keyNew (name, KEY_CASCADING_NAME, KEY_END) : NULL };
+	for (size_t i = 0; i < 2; ++i)
+	{
+		if (!parents[i]) continue;
+		cursor_t from = after ? positionOf (returned, after) + 1 : 0;
+		cursor_t to = next ? positionOf (returned, next) : (cursor_t)ksGetSize (returned);
+		cursor_t child = firstDirectChild (returned, parents[i], from, to);
+		// only look up the parent if `handleErrors` does the same, the lookup might add a default key
+		if (child < to)
+		{
+			Key * childKey = ksAtCursor (returned, child);
+			if (ksLookup (returned, parents[i], KDB_O_NONE) == key) next = childKey;
+		}
+		keyDel (parents[i]);
+	}
+	return next;
+}
+
+/**
+ * @brief Handle the conflicts of the keys after `after` (or of all keys, if `after` is `NULL`)
+ *
+ * `handleErrors` only does something for keys that have conflicts or whose parent has conflicts.
+ * All keys with conflicts are in `dirty`, so instead of calling `handleErrors` for all keys we
+ * only call it for the keys that handle the conflicts of a key in `dirty` and for the last key,
+ * whose result is returned.
+ */
+static int handleConflicts (Key * parentKey, KeySet * returned, KeySet * dirty, KeySet * fresh, Key * after, Key * specKey,
+			    ConflictHandling * ch, Direction dir, int ret)
+{
+	Key * cur;
+	// handleErrors looks up the parent of every key, which might add a default key (see registerNewKeys)
+	ksRewind (fresh);
+	while ((cur = ksNext (fresh)) != NULL)
+	{
+		if (keyGetNamespace (cur) != KEY_NS_CASCADING) continue;
+		Key * parentLookup = keyDup (cur);
+		keySetBaseName (parentLookup, 0);
+		ksLookup (returned, parentLookup, KDB_O_NONE);
+		keyDel (parentLookup);
+	}
+	ksClear (fresh);
+
+	cursor_t size = ksGetSize (returned);
+	if ((after ? positionOf (returned, after) + 1 : 0) >= size) return ret;
+
+	KeySet * todo = ksNew (ksGetSize (dirty) + 1, KS_END);
+	ksRewind (dirty);
+	while ((cur = ksNext (dirty)) != NULL)
+	{
+		Key * handler = nextConflictHandler (returned, cur, after);
+		if (handler) ksAppendKey (todo, handler);
+	}
+	ksAppendKey (todo, ksAtCursor (returned, size - 1));
+
+	for (cursor_t i = 0; i < ksGetSize (todo); ++i)
+	{
+		cur = ksAtCursor (todo, i);
+		ret = handleErrors (parentKey, returned, cur, specKey, ch, dir);
+		keySetMeta (cur, "conflict/invalid", 0);
+
+		// conflicts that were not handled by this key are handled by the next key
+		Key * parentLookup = keyDup (cur);
+		keySetBaseName (parentLookup, 0);
+		Key * parent = ksLookup (returned, parentLookup, KDB_O_NONE);
+		keyDel (parentLookup);
+		Key * handler = NULL;
+		if (hasUnhandledConflicts (cur) && (handler = nextConflictHandler (returned, cur, cur)) != NULL) ksAppendKey (todo, handler);
+		if (parent && hasUnhandledConflicts (parent) && (handler = nextConflictHandler (returned, parent, cur)) != NULL)
+			ksAppendKey (todo, handler);
+	}
+	ksDel (todo);
+
+	KeySet * stillDirty = ksNew (ksGetSize (dirty), KS_END);
+	ksRewind (dirty);
+	while ((cur = ksNext (dirty)) != NULL)
+	{
+		if (positionOf (returned, cur) >= 0 && hasUnhandledConflicts (cur)) ksAppendKey (stillDirty, cur);
+	}
+	ksClear (dirty);
+	ksAppend (dirty, stillDirty);
+	ksDel (stillDirty);
+	return ret;
+}
+
+static int doGlobbing (Key * parentKey, KeySet * returned, KeySet * specKS, ConflictHandling * ch, Direction dir, int clean)
+{
+	SpecMatcher matcher;
+	KeySet * dirty = ksNew (0, KS_END);
+	KeySet * fresh = ksDup (returned);
+	int ret = 1;
+	if (initSpecMatcher (&matcher, specKS, returned) < 0) goto error;
+
+	Key * cur;
+	ksRewind (returned);
+	while ((cur = ksNext (returned)) != NULL)
+	{
+		if (hasUnhandledConflicts (cur)) ksAppendKey (dirty, cur);
+	}
+
+	for (size_t i = 0; i < matcher.size; ++i)
+	{
+		Key * specKey = matcher.specKeys[i];
+		const char * pattern = matcher.patterns[i];
+		int require = keyGetMeta (specKey, "require") != NULL;
+		int found = 0;
+		KeySet * candidates = matcher.matches[i];
+		ksRewind (candidates);
+		while ((cur = ksNext (candidates)) != NULL)
+		{
+			if (!matchPatternToKey (pattern, cur)) continue;
+			if (!clean)
 			{
-				if (!clean)
+				found = 1;
+				ksAppendKey (dirty, cur);
+				if (require)
 				{
-					found = 1;
-					if (require)
-					{
-						if (hasRequired (cur, specKey, returned)) copyMeta (cur, specKey, parentKey);
-					}
-					else if (keyGetMeta (cur, "conflict/invalid"))
-					{
-						copyMeta (cur, specKey, parentKey);
-					}
-					else if (keyGetMeta (cur, "spec/internal/valid"))
-					{
-						copyMeta (cur, specKey, parentKey);
-					}
-					else if (elektraArrayValidateName (cur) == 1)
-					{
-						validateArray (returned, cur, specKey);
-						copyMeta (cur, specKey, parentKey);
-					}
-					else if (!(strcmp (keyBaseName (specKey), "_")))
-					{
-						validateWildcardSubs (returned, cur, specKey);
-						copyMeta (cur, specKey, parentKey);
-					}
-					else
+					if (hasRequired (cur, specKey, returned)) copyMeta (cur, specKey, parentKey);
+				}
+				else if (keyGetMeta (cur, "conflict/invalid"))
+				{
+					copyMeta (cur, specKey, parentKey);
+				}
+				else if (keyGetMeta (cur, "spec/internal/valid"))
+				{
+					copyMeta (cur, specKey, parentKey);
+				}
+				else if (elektraArrayValidateName (cur) == 1)
+				{
+					validateArray (returned, cur, specKey, dirty);
+					copyMeta (cur, specKey, parentKey);
+				}
+				else if (!(strcmp (keyBaseName (specKey), "_")))
+				{
+					validateWildcardSubs (returned, cur, specKey, dirty);
+					copyMeta (cur, specKey, parentKey);
+				}
+				else
+				{
+					if (hasArray (cur))
 					{
-						if (hasArray (cur))
-						{
-							if (isValidArrayKey (cur))
-							{
-								copyMeta (cur, specKey, parentKey);
-							}
-						}
-						else
+						if (isValidArrayKey (cur))
 						{
 							copyMeta (cur, specKey, parentKey);
 						}
 					}
-				}
-				else
-				{
-					removeMeta (cur, specKey, parentKey);
+					else
+					{
+						copyMeta (cur, specKey, parentKey);
+					}
 				}
 			}
-			ksSetCursor (returned, cursor);
+			else
+			{
+				removeMeta (cur, specKey, parentKey);
+			}
 		}
-		ksRewind (returned);
+		Key * defaultKey = NULL;
 		if (!found && dir == GET)
 		{
 			if (keyGetMeta (specKey, "assign/condition")) // hardcoded for now because only "assign/condition" from "assign/*"
@@ -734,7 +1160,7 @@ static int doGlobbing (Key * parentKey, KeySet * returned, KeySet * specKS, Conf
 			{
 				Key * newKey = keyNew (strchr (keyName (specKey), '/'), KEY_CASCADING_NAME, KEY_END);
 				keySetMeta (newKey, "assign/condition", keyString (keyGetMeta (specKey, "assign/condition")));
-				ksAppendKey (returned, keyDup (newKey));
+				defaultKey = keyDup (newKey);
 				keyDel (newKey);
 			}
 			else if (keyGetMeta (specKey,
@@ -743,19 +1169,33 @@ static int doGlobbing (Key * parentKey, KeySet * returned, KeySet * specKS, Conf
 				Key * newKey = keyNew (strchr (keyName (specKey), '/'), KEY_CASCADING_NAME, KEY_VALUE,
 						       keyString (keyGetMeta (specKey, "default")), KEY_END);
 				copyMeta (newKey, specKey, parentKey);
-				ksAppendKey (returned, keyDup (newKey));
+				defaultKey = keyDup (newKey);
 				keyDel (newKey);
 			}
 		}
-		while ((cur = ksNext (returned)) != NULL)
+		if (defaultKey)
 		{
-			ret = handleErrors (parentKey, returned, cur, specKey, ch, dir);
-			keySetMeta (cur, "conflict/invalid", 0);
+			ksAppendKey (returned, defaultKey);
+			ksAppendKey (fresh, defaultKey);
+			if (registerKey (&matcher, defaultKey, i + 1) < 0) goto error;
 		}
-
-		elektraFree (pattern);
+		if (registerNewKeys (&matcher, returned, fresh, dirty, i + 1) < 0) goto error;
+		// conflicts of keys before an added default key are not handled yet
+		ret = handleConflicts (parentKey, returned, dirty, fresh, defaultKey, specKey, ch, dir, ret);
+		if (registerNewKeys (&matcher, returned, fresh, dirty, i + 1) < 0) goto error;
 	}
+
+	delSpecMatcher (&matcher);
+	ksDel (fresh);
+	ksDel (dirty);
 	return ret;
+
+error:
+	delSpecMatcher (&matcher);
+	ksDel (fresh);
+	ksDel (dirty);
+	ELEKTRA_SET_ERROR (87, parentKey, "Memory allocation failed");
+	return -1;
 }
 
 static void parseConfig (KeySet * config, ConflictHandling * ch)
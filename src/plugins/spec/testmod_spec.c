@@ -0,0 +1,127 @@
+/**
+ * @file
+ *
+ * @brief Tests for spec plugin
+ *
+ * @copyright BSD License (see LICENSE.md or https://www.libelektra.org)
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <kdbconfig.h>
+
+#include <tests_plugin.h>
+
+#define TEST_ROOT "/tests/spec"
+
+static const char * metaString (KeySet * ks, const char * name, const char * meta)
+{
+	Key * key = ksLookupByName (ks, name, 0);
+	if (!key) return NULL;
+	const Key * metaKey = keyGetMeta (key, meta);
+	return metaKey ? keyString (metaKey) : NULL;
+}
+
+static void test_globbing (void)
+{
+	Key * parentKey = keyNew (TEST_ROOT, KEY_CASCADING_NAME, KEY_END);
+	KeySet * conf = ksNew (0, KS_END);
+	PLUGIN_OPEN ("spec");
+	KeySet * ks = ksNew (
+		30, keyNew ("spec" TEST_ROOT "/_/value", KEY_META, "description", "wildcard", KEY_END),
+		keyNew ("spec" TEST_ROOT "/list/#", KEY_META, "description", "array", KEY_END),
+		keyNew ("spec" TEST_ROOT "/literal", KEY_META, "description", "literal", KEY_END),
+		keyNew ("spec" TEST_ROOT "/glob/x*", KEY_META, "description", "glob", KEY_END),
+		keyNew ("user" TEST_ROOT "/a/value", KEY_VALUE, "1", KEY_END), keyNew ("system" TEST_ROOT "/b/value", KEY_VALUE, "2", KEY_END),
+		keyNew ("user" TEST_ROOT "/a/other", KEY_VALUE, "3", KEY_END), keyNew ("user" TEST_ROOT "/a/b/value", KEY_VALUE, "4", KEY_END),
+		keyNew ("user" TEST_ROOT "/list", KEY_VALUE, "", KEY_END), keyNew ("user" TEST_ROOT "/list/#0", KEY_VALUE, "5", KEY_END),
+		keyNew ("user" TEST_ROOT "/list/#1", KEY_VALUE, "6", KEY_END), keyNew ("user" TEST_ROOT "/list/other", KEY_VALUE, "7", KEY_END),
+		keyNew ("user" TEST_ROOT "/literal", KEY_VALUE, "8", KEY_END), keyNew ("user" TEST_ROOT "/literal2", KEY_VALUE, "9", KEY_END),
+		keyNew ("user" TEST_ROOT "/glob/x1", KEY_VALUE, "10", KEY_END), keyNew ("user" TEST_ROOT "/glob/y1", KEY_VALUE, "11", KEY_END),
+		KS_END);
+
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) >= 0, "kdbGet failed");
+
+	succeed_if_same_string (metaString (ks, "user" TEST_ROOT "/a/value", "description"), "wildcard");
+	succeed_if_same_string (metaString (ks, "system" TEST_ROOT "/b/value", "description"), "wildcard");
+	succeed_if (!metaString (ks, "user" TEST_ROOT "/a/other", "description"), "wildcard matched wrong basename");
+	succeed_if (!metaString (ks, "user" TEST_ROOT "/a/b/value", "description"), "wildcard matched more than one level");
+
+	succeed_if_same_string (metaString (ks, "user" TEST_ROOT "/list/#0", "description"), "array");
+	succeed_if_same_string (metaString (ks, "user" TEST_ROOT "/list/#1", "description"), "array");
+	succeed_if (!metaString (ks, "user" TEST_ROOT "/list/other", "description"), "array matched non-array key");
+
+	succeed_if_same_string (metaString (ks, "user" TEST_ROOT "/literal", "description"), "literal");
+	succeed_if (!metaString (ks, "user" TEST_ROOT "/literal2", "description"), "literal matched prefix");
+
+	succeed_if_same_string (metaString (ks, "user" TEST_ROOT "/glob/x1", "description"), "glob");
+	succeed_if (!metaString (ks, "user" TEST_ROOT "/glob/y1", "description"), "glob matched wrong key");
+
+	ksDel (ks);
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
+static void test_default (void)
+{
+	Key * parentKey = keyNew (TEST_ROOT, KEY_CASCADING_NAME, KEY_END);
+	KeySet * conf = ksNew (0, KS_END);
+	PLUGIN_OPEN ("spec");
+	KeySet * ks = ksNew (30, keyNew ("spec" TEST_ROOT "/present", KEY_META, "default", "1", KEY_END),
+			     keyNew ("spec" TEST_ROOT "/missing", KEY_META, "default", "2", KEY_END),
+			     keyNew ("spec" TEST_ROOT "/_", KEY_META, "description", "any", KEY_END),
+			     keyNew ("user" TEST_ROOT "/present", KEY_VALUE, "3", KEY_END), KS_END);
+
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) >= 0, "kdbGet failed");
+
+	Key * key = ksLookupByName (ks, "user" TEST_ROOT "/present", 0);
+	exit_if_fail (key, "key not found");
+	succeed_if_same_string (keyString (key), "3");
+	succeed_if (ksGetSize (ks) == 5, "default key added for present key");
+
+	key = ksLookupByName (ks, TEST_ROOT "/missing", 0);
+	exit_if_fail (key, "default key not added");
+	succeed_if_same_string (keyString (key), "2");
+	succeed_if_same_string (metaString (ks, "user" TEST_ROOT "/present", "description"), "any");
+
+	ksDel (ks);
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
+static void test_collision (void)
+{
+	Key * parentKey = keyNew (TEST_ROOT, KEY_CASCADING_NAME, KEY_END);
+	KeySet * conf = ksNew (10, keyNew ("user/conflict/get", KEY_VALUE, "ERROR", KEY_END), KS_END);
+	PLUGIN_OPEN ("spec");
+	KeySet * ks = ksNew (30, keyNew ("spec" TEST_ROOT "/_", KEY_META, "type", "long", KEY_END),
+			     keyNew ("user" TEST_ROOT "/a", KEY_VALUE, "1", KEY_META, "type", "long", KEY_END),
+			     keyNew ("user" TEST_ROOT "/b", KEY_VALUE, "2", KEY_META, "type", "string", KEY_END), KS_END);
+
+	plugin->kdbGet (plugin, ks, parentKey);
+	succeed_if (keyGetMeta (parentKey, "error"), "no error for conflicting metadata");
+	succeed_if_same_string (metaString (ks, "user" TEST_ROOT "/b", "type"), "long");
+	succeed_if (!metaString (ks, "user" TEST_ROOT "/a", "conflict/collision"), "conflict for equal metadata");
+
+	ksDel (ks);
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
+int main (int argc, char ** argv)
+{
+	printf ("SPEC           TESTS\n");
+	printf ("====================\n\n");
+
+	init (argc, argv);
+
+	test_globbing ();
+	test_default ();
+	test_collision ();
+
+	print_result ("testmod_spec");
+
+	return nbError;
+}
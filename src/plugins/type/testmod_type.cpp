@@ -536,3 +536,90 @@ TEST (type, octet)
 		EXPECT_TRUE (tc.check (k)) << x << " should check successfully as octet";
 	}
 }
+
+TEST (type, limits)
+{
+	KeySet config;
+	TypeChecker tc (config);
+
+	Key k ("user/anything", KEY_VALUE, "-9223372036854775808", KEY_META, "check/type", "long_long", KEY_END);
+	EXPECT_TRUE (tc.check (k)) << "minimum should check successfully";
+	k.setString ("9223372036854775807");
+	EXPECT_TRUE (tc.check (k)) << "maximum should check successfully";
+	k.setString ("9223372036854775808");
+	EXPECT_FALSE (tc.check (k)) << "should fail (number too high)";
+	k.setString ("-9223372036854775809");
+	EXPECT_FALSE (tc.check (k)) << "should fail (number too low)";
+	k.setString ("+1");
+	EXPECT_FALSE (tc.check (k)) << "should fail (not canonical)";
+	k.setString ("01");
+	EXPECT_FALSE (tc.check (k)) << "should fail (not canonical)";
+	k.setString ("-0");
+	EXPECT_FALSE (tc.check (k)) << "should fail (not canonical)";
+	k.setString (" 1");
+	EXPECT_FALSE (tc.check (k)) << "should fail (not canonical)";
+
+	k.setMeta ("check/type", "unsigned_long_long");
+	k.setString ("18446744073709551615");
+	EXPECT_TRUE (tc.check (k)) << "maximum should check successfully";
+	k.setString ("18446744073709551616");
+	EXPECT_FALSE (tc.check (k)) << "should fail (number too high)";
+	k.setString ("-1");
+	EXPECT_FALSE (tc.check (k)) << "should fail (negative)";
+
+	k.setMeta ("check/type", "double");
+	k.setString ("1e5");
+	EXPECT_TRUE (tc.check (k)) << "exponent should check successfully";
+	k.setString ("-1.5E-3");
+	EXPECT_TRUE (tc.check (k)) << "exponent should check successfully";
+	k.setString ("1e");
+	EXPECT_FALSE (tc.check (k)) << "should fail (missing exponent)";
+	k.setString ("1e400");
+	EXPECT_FALSE (tc.check (k)) << "should fail (out of range)";
+	k.setString ("inf");
+	EXPECT_FALSE (tc.check (k)) << "should fail";
+}
+
+TEST (type, boundsChange)
+{
+	KeySet config;
+	TypeChecker tc (config);
+
+	Key k ("user/anything", KEY_VALUE, "50", KEY_META, "check/type", "short", KEY_META, "check/type/min", "10", KEY_META,
+	       "check/type/max", "100", KEY_END);
+	EXPECT_TRUE (tc.check (k)) << "should check successfully";
+	k.setMeta ("check/type/min", "60");
+	EXPECT_FALSE (tc.check (k)) << "should fail because below changed min";
+	k.setMeta ("check/type/min", " +40");
+	EXPECT_TRUE (tc.check (k)) << "should check successfully with changed min";
+	k.setMeta ("check/type/max", "x");
+	EXPECT_FALSE (tc.check (k)) << "should fail because of invalid max";
+	k.setMeta ("check/type/max", "40000");
+	EXPECT_FALSE (tc.check (k)) << "should fail because max is out of range";
+	k.setMeta ("check/type/max", "50");
+	EXPECT_TRUE (tc.check (k)) << "should check successfully with changed max";
+}
+
+TEST (type, keyset)
+{
+	KeySet config;
+	TypeChecker tc (config);
+
+	// clang-format off
+	KeySet ks (10,
+		*Key ("user/a", KEY_VALUE, "1", KEY_META, "check/type", "short", KEY_END),
+		*Key ("user/b", KEY_VALUE, "2", KEY_META, "check/type", "short", KEY_END),
+		*Key ("user/c", KEY_VALUE, "x", KEY_META, "check/type", "short char", KEY_END),
+		*Key ("user/d", KEY_VALUE, "anything", KEY_END),
+		*Key ("user/e", KEY_VALUE, "1.5", KEY_META, "check/type", "unknown double", KEY_END),
+		KS_END);
+	// clang-format on
+	ks.rewind ();
+	EXPECT_TRUE (tc.check (ks)) << "should check successfully";
+
+	ks.append (Key ("user/f", KEY_VALUE, "1.5", KEY_META, "check/type", "short", KEY_END));
+	ks.append (Key ("user/g", KEY_VALUE, "1", KEY_META, "check/type", "short", KEY_END));
+	ks.rewind ();
+	EXPECT_FALSE (tc.check (ks)) << "should fail";
+	EXPECT_EQ (ks.current ().getName (), "user/f") << "cursor should point to the failing key";
+}
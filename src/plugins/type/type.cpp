@@ -50,6 +50,21 @@ int elektraTypeValidateKey (ckdb::Key * key, ckdb::Key * errorKey)
 	return ret;
 }
 
+int elektraTypeCheckKey (ckdb::Plugin * handle, ckdb::Key * key, ckdb::Key * errorKey)
+{
+	int ret = 1;
+
+	kdb::Key k (key); // reinterpret_cast<kdb::Key &> (key)
+	if (!TC::get (handle)->checkNext (k))
+	{
+		setError (key, errorKey);
+		ret = 0;
+	}
+
+	k.release ();
+	return ret;
+}
+
 int elektraTypeOpen (ckdb::Plugin * handle, ckdb::Key * errorKey)
 {
 	/* plugin initialization logic */
@@ -74,6 +89,7 @@ int elektraTypeGet (ckdb::Plugin *, ckdb::KeySet * returned, ckdb::Key *)
 			     keyNew ("system/elektra/modules/type/exports/get", KEY_FUNC, elektraTypeGet, KEY_END),
 			     keyNew ("system/elektra/modules/type/exports/set", KEY_FUNC, elektraTypeSet, KEY_END),
 			     keyNew ("system/elektra/modules/type/exports/validateKey", KEY_FUNC, elektraTypeValidateKey, KEY_END),
+			     keyNew ("system/elektra/modules/type/exports/checkkey", KEY_FUNC, elektraTypeCheckKey, KEY_END),
 #include "readme_type.c"
 			     keyNew ("system/elektra/modules/type/infos/version", KEY_VALUE, PLUGINVERSION, KEY_END), KS_END));
 	ksDel (n);
@@ -83,17 +99,9 @@ int elektraTypeGet (ckdb::Plugin *, ckdb::KeySet * returned, ckdb::Key *)
 
 int elektraTypeSet (ckdb::Plugin * handle, ckdb::KeySet * returned, ckdb::Key * parentKey)
 {
-	int ret = 1;
-
-	kdb::KeySet ks (returned); // reinterpret_cast<kdb::KeySet &> (returned)
-	if (!TC::get (handle)->check (ks))
-	{
-		setError (ksCurrent (returned), parentKey);
-		ret = -1;
-	}
-
-	ks.release ();
-	return ret;
+	// without enforce only keys having check/type need to be checked
+	const char * metaName = TC::get (handle)->isEnforced () ? nullptr : "check/type";
+	return elektraPluginCheckKeys (handle, returned, metaName, elektraTypeCheckKey, parentKey);
 }
 
 ckdb::Plugin * ELEKTRA_PLUGIN_EXPORT (type)
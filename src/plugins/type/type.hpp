@@ -22,6 +22,7 @@ int elektraTypeGet (ckdb::Plugin * handle, ckdb::KeySet * ks, ckdb::Key * parent
 int elektraTypeSet (ckdb::Plugin * handle, ckdb::KeySet * ks, ckdb::Key * parentKey);
 int elektraTypeError (ckdb::Plugin * handle, ckdb::KeySet * ks, ckdb::Key * parentKey);
 int elektraTypeValidateKey (ckdb::Key * key, ckdb::Key * errorKey);
+int elektraTypeCheckKey (ckdb::Plugin * handle, ckdb::Key * key, ckdb::Key * errorKey);
 
 ckdb::Plugin * ELEKTRA_PLUGIN_EXPORT (type);
 }
@@ -15,9 +15,11 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "kdbtypes.h"
 #include "types.hpp"
+#include <kdbproposal.h>
 
 
 namespace elektra
@@ -32,6 +34,11 @@ class TypeChecker
 	std::map<string, Type *> types;
 	bool enforce;
 
+	// check/type of the previously checked key and its resolved types
+	string lastTypeList;
+	bool haveLastTypeList = false;
+	vector<Type *> lastResolved;
+
 public:
 	explicit TypeChecker (KeySet config)
 	{
@@ -63,28 +70,86 @@ public:
 		types.insert (pair<string, Type *> ("FSType", new FSType ()));
 	}
 
-	bool check (Key & k)
+	/**
+	 * @brief resolves the whitespace separated type names of a check/type
+	 *
+	 * Unknown type names are skipped.
+	 */
+	void resolve (const char * typeList, vector<Type *> & resolved) const
 	{
-		Key const m = k.getMeta<const Key> ("check/type");
-		if (!m) return !enforce;
-
-		istringstream istr (m.getString ());
+		resolved.clear ();
 		string type;
-		while (istr >> type)
+		for (const char * it = skipSpace (typeList); *it; it = skipSpace (it))
 		{
-			if (types[type] && types[type]->check (k)) return true;
+			const char * end = it;
+			while (*end && !isSpace (*end))
+				++end;
+			type.assign (it, end);
+			auto found = types.find (type);
+			if (found != types.end ()) resolved.push_back (found->second);
+			it = end;
+		}
+	}
+
+	bool check (Key & k, vector<Type *> const & resolved)
+	{
+		for (auto type : resolved)
+		{
+			if (type->check (k)) return true;
 		}
 
 		/* Type could not be checked successfully */
 		return false;
 	}
 
+	bool check (Key & k)
+	{
+		const ckdb::Key * m = ckdb::keyGetMeta (k.getKey (), "check/type");
+		if (!m) return !enforce;
+
+		vector<Type *> resolved;
+		resolve (ckdb::keyString (m), resolved);
+		return check (k, resolved);
+	}
+
+	bool isEnforced () const
+	{
+		return enforce;
+	}
+
+	/**
+	 * @brief checks a key like check (Key &)
+	 *
+	 * Keys of a spec mostly share their check/type, so the resolved
+	 * types of the previous key are reused if the check/type is the same.
+	 */
+	bool checkNext (Key & k)
+	{
+		const ckdb::Key * m = ckdb::keyGetMeta (k.getKey (), "check/type");
+		if (!m) return !enforce;
+
+		const char * current = ckdb::keyString (m);
+		if (!haveLastTypeList || lastTypeList != current)
+		{
+			lastTypeList = current;
+			haveLastTypeList = true;
+			resolve (current, lastResolved);
+		}
+		return check (k, lastResolved);
+	}
+
+	/**
+	 * @brief checks all keys of ks
+	 *
+	 * @return false on the first key that fails, the cursor of ks points to it
+	 */
 	bool check (KeySet & ks)
 	{
 		Key k;
-		while ((k = ks.next ()))
+		// without enforce only keys having check/type need to be visited
+		while ((k = enforce ? ks.next () : Key (ckdb::ksNextWithMeta (ks.getKeySet (), "check/type"))))
 		{
-			if (!check (k)) return false;
+			if (!checkNext (k)) return false;
 		}
 		return true;
 	}
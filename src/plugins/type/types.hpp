@@ -10,11 +10,18 @@
 #ifndef ELEKTRA_TYPES_HPP
 #define ELEKTRA_TYPES_HPP
 
+#include <climits>
+#include <clocale>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <locale>
 #include <map>
 #include <set>
 #include <sstream>
 #include <string>
+#include <type_traits>
 
 #include <key.hpp>
 #include <keyset.hpp>
@@ -35,6 +42,194 @@ public:
 	virtual ~Type ();
 };
 
+/**
+ * @brief returns the value of the key without copying it
+ *
+ * @throws KeyTypeMismatch for binary values, like Key::getString
+ */
+inline const char * valueOf (Key const & k)
+{
+	// keyString would check for binary values a second time
+	if (ckdb::keyIsBinary (k.getKey ()))
+	{
+		if (ckdb::keyGetValueSize (k.getKey ()) > 0) throw KeyTypeMismatch ();
+		return "";
+	}
+	return static_cast<const char *> (ckdb::keyValue (k.getKey ()));
+}
+
+/**
+ * @brief checks for the whitespace `istream >>` skips in the C locale
+ */
+inline bool isSpace (char c)
+{
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+inline const char * skipSpace (const char * str)
+{
+	while (isSpace (*str))
+		++str;
+	return str;
+}
+
+inline bool isDigit (char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+/**
+ * @brief parses a decimal integer like `istream >> n` in the C locale
+ *
+ * The whole string has to be consumed. Values out of the range of T fail,
+ * negative values wrap around for unsigned types.
+ */
+template <typename T>
+bool parseNumber (const char * str, T & n)
+{
+	typedef typename std::make_unsigned<T>::type U;
+
+	str = skipSpace (str);
+	bool negative = *str == '-';
+	if (*str == '-' || *str == '+') ++str;
+	if (!isDigit (*str)) return false;
+
+	unsigned long long magnitude = 0;
+	for (; isDigit (*str); ++str)
+	{
+		unsigned digit = *str - '0';
+		if (magnitude > (ULLONG_MAX - digit) / 10) return false;
+		magnitude = magnitude * 10 + digit;
+	}
+	if (*str != '\0') return false;
+
+	U max = (negative && std::numeric_limits<T>::is_signed) ? U (U (0) - U (std::numeric_limits<T>::min ()))
+								: U (std::numeric_limits<T>::max ());
+	if (magnitude > max) return false;
+	n = negative ? T (U (U (0) - U (magnitude))) : T (magnitude);
+	return true;
+}
+
+/**
+ * @brief parses a boolean like `istream >> n` without boolalpha: only 0 and 1 are valid
+ */
+inline bool parseNumber (const char * str, bool & n)
+{
+	long l;
+	if (!parseNumber (str, l) || (l != 0 && l != 1)) return false;
+	n = l;
+	return true;
+}
+
+/**
+ * @brief parses a floating point number like `istream >> n` in the C locale
+ *
+ * Accepts decimal numbers with an optional exponent, values that overflow T fail.
+ */
+template <typename T>
+bool parseFloat (const char * str, T & n, T (*convert) (const char *, char **))
+{
+	str = skipSpace (str);
+	const char * begin = str;
+	if (*str == '-' || *str == '+') ++str;
+	bool digits = false;
+	for (; isDigit (*str); ++str)
+		digits = true;
+	const char * point = nullptr;
+	if (*str == '.')
+	{
+		point = str++;
+		for (; isDigit (*str); ++str)
+			digits = true;
+	}
+	if (!digits) return false;
+	if (*str == 'e' || *str == 'E')
+	{
+		++str;
+		if (*str == '-' || *str == '+') ++str;
+		if (!isDigit (*str)) return false;
+		for (; isDigit (*str); ++str)
+			;
+	}
+	if (*str != '\0') return false;
+
+	char sysSep = localeconv ()->decimal_point[0];
+	if (point && sysSep != '.')
+	{
+		std::string localized (begin, str);
+		localized[point - begin] = sysSep;
+		n = convert (localized.c_str (), nullptr);
+	}
+	else
+	{
+		n = convert (begin, nullptr);
+	}
+	return !std::isinf (n);
+}
+
+inline bool parseNumber (const char * str, float & n)
+{
+	return parseFloat<float> (str, n, std::strtof);
+}
+
+inline bool parseNumber (const char * str, double & n)
+{
+	return parseFloat<double> (str, n, std::strtod);
+}
+
+inline bool parseNumber (const char * str, long double & n)
+{
+	return parseFloat<long double> (str, n, std::strtold);
+}
+
+/**
+ * @brief checks if str is the representation `ostream << n` would yield for an integer
+ */
+template <typename T>
+bool isCanonicalInteger (const char * str)
+{
+	if (*str == '-')
+	{
+		if (!std::numeric_limits<T>::is_signed) return false;
+		++str;
+		if (*str == '0') return false;
+	}
+	if (*str == '0') return str[1] == '\0';
+	if (!isDigit (*str)) return false;
+	for (; *str; ++str)
+	{
+		if (!isDigit (*str)) return false;
+	}
+	return true;
+}
+
+/**
+ * @brief a parsed check/type/min or check/type/max
+ *
+ * Keys of the same spec share their bounds, so the last parsed bound is kept.
+ */
+template <typename T>
+class Bound
+{
+	std::string text;
+	T value;
+	bool valid = false;
+	bool parsed = false;
+
+public:
+	bool get (const char * str, T & n)
+	{
+		if (!parsed || text != str)
+		{
+			text = str;
+			valid = parseNumber (str, value);
+			parsed = true;
+		}
+		n = value;
+		return valid;
+	}
+};
+
 class AnyType : public Type
 {
 public:
@@ -49,7 +244,7 @@ class EmptyType : public Type
 public:
 	bool check (Key k) override
 	{
-		return k.getString ().empty ();
+		return *valueOf (k) == '\0';
 	}
 };
 
@@ -58,7 +253,8 @@ class CharType : public Type
 public:
 	bool check (Key k) override
 	{
-		return k.getString ().length () == 1;
+		const char * value = valueOf (k);
+		return value[0] != '\0' && value[1] == '\0';
 	}
 };
 
@@ -67,7 +263,7 @@ class StringType : public Type
 public:
 	bool check (Key k) override
 	{
-		return !k.getString ().empty ();
+		return *valueOf (k) != '\0';
 	}
 };
 
@@ -77,14 +273,8 @@ class TType : public Type
 public:
 	bool check (Key k) override
 	{
-		istringstream i (k.getString ());
-		i.imbue (locale ("C"));
 		T n;
-		i >> n;
-		if (i.bad ()) return false;
-		if (i.fail ()) return false;
-		if (!i.eof ()) return false;
-		return true;
+		return parseNumber (valueOf (k), n);
 	}
 };
 
@@ -125,47 +315,29 @@ public:
 template <typename T>
 class MType : public Type
 {
+	Bound<T> minBound;
+	Bound<T> maxBound;
+
 public:
 	bool check (Key k) override
 	{
-		istringstream i (k.getString ());
-		i.imbue (locale ("C"));
+		const char * value = valueOf (k);
 		T n;
-		i >> n;
-		if (i.bad ()) return false;
-		if (i.fail ()) return false;
-		if (!i.eof ()) return false;
-
-		ostringstream o;
-		o.imbue (locale ("C"));
-		o << n;
-		if (o.fail ()) return false;
-		if (o.str () != k.getString ()) return false;
+		if (!isCanonicalInteger<T> (value) || !parseNumber (value, n)) return false;
 
-		Key const min = k.getMeta<const Key> ("check/type/min");
+		T bound;
+		const ckdb::Key * min = ckdb::keyGetMeta (k.getKey (), "check/type/min");
 		if (min)
 		{
-			istringstream i_min (min.getString ());
-			i_min.imbue (locale ("C"));
-			T n_min;
-			i_min >> n_min;
-			if (i_min.bad ()) return false;
-			if (i_min.fail ()) return false;
-			if (!i_min.eof ()) return false;
-			if (n < n_min) return false;
+			if (!minBound.get (ckdb::keyString (min), bound)) return false;
+			if (n < bound) return false;
 		}
 
-		Key const max = k.getMeta<const Key> ("check/type/max");
+		const ckdb::Key * max = ckdb::keyGetMeta (k.getKey (), "check/type/max");
 		if (max)
 		{
-			istringstream i_max (max.getString ());
-			i_max.imbue (locale ("C"));
-			T n_max;
-			i_max >> n_max;
-			if (i_max.bad ()) return false;
-			if (i_max.fail ()) return false;
-			if (!i_max.eof ()) return false;
-			if (n > n_max) return false;
+			if (!maxBound.get (ckdb::keyString (max), bound)) return false;
+			if (n > bound) return false;
 		}
 
 		return true;
@@ -20,6 +20,7 @@
 
 
 #include <langinfo.h>
+#include <time.h>
 
 #include <tests.h>
 
@@ -247,6 +248,92 @@ void icase_test (void)
 }
 
 
+static KeySet * createManyKeys (size_t count)
+{
+	static const char * patterns[] = { "^[0-9]+$", "^[a-z]+[0-9]*$", "^(yes|no|on|off)$", "^[[:alnum:]_.-]+@[[:alnum:]_.-]+$" };
+	static const char * values[] = { "1234", "value17", "off", "user@example.org" };
+
+	KeySet * ks = ksNew (count, KS_END);
+	char name[100];
+	for (size_t i = 0; i < count; ++i)
+	{
+		snprintf (name, sizeof (name), "user/tests/validation/key%zu", i);
+		ksAppendKey (ks, keyNew (name, KEY_VALUE, values[i % 4], KEY_META, "check/validation", patterns[i % 4], KEY_END));
+	}
+	return ks;
+}
+
+static double validateManyKeys (const char * cacheSize, KeySet * ks)
+{
+	Key * parentKey = keyNew ("user/tests/validation", KEY_VALUE, "", KEY_END);
+	KeySet * conf = ksNew (1, keyNew ("system/cache/size", KEY_VALUE, cacheSize, KEY_END), KS_END);
+	PLUGIN_OPEN ("validation");
+
+	clock_t start = clock ();
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == (1), "kdbSet failed");
+	clock_t end = clock ();
+
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+	return (double)(end - start) / CLOCKS_PER_SEC;
+}
+
+void cache_test (void)
+{
+	Key * parentKey = keyNew ("user/tests/validation", KEY_VALUE, "", KEY_END);
+	KeySet * conf = ksNew (1, keyNew ("system/cache/size", KEY_VALUE, "1", KEY_END), KS_END);
+	PLUGIN_OPEN ("validation");
+
+	// same pattern, but different flags must not share the compiled expression
+	Key * icase = keyNew ("user/tests/validation/icase", KEY_VALUE, "word", KEY_META, "check/validation", "^WORD$", KEY_META,
+			      "check/validation/ignorecase", "1", KEY_END);
+	Key * plain = keyNew ("user/tests/validation/plain", KEY_VALUE, "word", KEY_META, "check/validation", "^WORD$", KEY_END);
+	keyIncRef (icase);
+	keyIncRef (plain);
+	KeySet * ks = ksNew (1, icase, KS_END);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == (1), "ignorecase validation failed");
+	ksDel (ks);
+	ks = ksNew (1, plain, KS_END);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == (-1), "validation without ignorecase should fail");
+	ksDel (ks);
+	ks = ksNew (1, icase, KS_END);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == (1), "ignorecase validation failed after validation without it");
+	ksDel (ks);
+	keyDecRef (icase);
+	keyDel (icase);
+	keyDecRef (plain);
+	keyDel (plain);
+	keySetMeta (parentKey, "error", 0);
+
+	// evicted expressions must be compiled again
+	ks = ksNew (3, keyNew ("user/tests/validation/a", KEY_VALUE, "123", KEY_META, "check/validation", "^[0-9]+$", KEY_END),
+		    keyNew ("user/tests/validation/b", KEY_VALUE, "abc", KEY_META, "check/validation", "^[a-z]+$", KEY_END),
+		    keyNew ("user/tests/validation/c", KEY_VALUE, "456", KEY_META, "check/validation", "^[0-9]+$", KEY_END), KS_END);
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == (1), "kdbSet failed");
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == (1), "kdbSet failed");
+	keySetString (ksLookupByName (ks, "user/tests/validation/c", 0), "abc");
+	ksRewind (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == (-1), "cached expression did not reject invalid value");
+	ksDel (ks);
+
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
+void cache_benchmark (void)
+{
+	KeySet * ks = createManyKeys (20000);
+
+	double uncached = validateManyKeys ("0", ks);
+	double cached = validateManyKeys ("32", ks);
+	printf ("validated %zd keys in %.3fs without and %.3fs with regex cache\n", ksGetSize (ks), uncached, cached);
+
+	ksDel (ks);
+}
+
 int main (int argc, char ** argv)
 {
 	printf ("   VALIDATION   TESTS\n");
@@ -261,6 +348,8 @@ int main (int argc, char ** argv)
 	line_test ();
 	icase_test ();
 	invert_test ();
+	cache_test ();
+	cache_benchmark ();
 	print_result ("testmod_validation");
 
 	return nbError;
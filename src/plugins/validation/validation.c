@@ -17,8 +17,110 @@
 
 #include "validation.h"
 
+#define VALIDATION_CACHE_SIZE 32
+
+// compiled regular expressions, so that keys sharing a pattern
+// only compile it once
+typedef struct
+{
+	char * pattern;
+	int cflags;
+	unsigned long lastUse;
+	regex_t regex;
+} CachedRegex;
+
+typedef struct
+{
+	CachedRegex * entries;
+	size_t size;
+	unsigned long tick;
+} RegexCache;
+
 static int validateKey (Key *, Key *);
 
+int elektraValidationOpen (Plugin * handle, Key * errorKey ELEKTRA_UNUSED)
+{
+	KeySet * config = elektraPluginGetConfig (handle);
+	Key * sizeKey = ksLookupByName (config, "/cache/size", 0);
+	size_t size = sizeKey ? (size_t)strtoul (keyString (sizeKey), NULL, 10) : VALIDATION_CACHE_SIZE;
+
+	RegexCache * cache = elektraCalloc (sizeof (RegexCache));
+	if (!cache) return -1;
+	if (size > 0 && !(cache->entries = elektraCalloc (size * sizeof (CachedRegex))))
+	{
+		elektraFree (cache);
+		return -1;
+	}
+	cache->size = size;
+	elektraPluginSetData (handle, cache);
+
+	return 1; /* success */
+}
+
+int elektraValidationClose (Plugin * handle, Key * errorKey ELEKTRA_UNUSED)
+{
+	RegexCache * cache = elektraPluginGetData (handle);
+	if (!cache) return 1;
+
+	for (size_t i = 0; i < cache->size; ++i)
+	{
+		if (!cache->entries[i].pattern) continue;
+		regfree (&cache->entries[i].regex);
+		elektraFree (cache->entries[i].pattern);
+	}
+	if (cache->entries) elektraFree (cache->entries);
+	elektraFree (cache);
+	elektraPluginSetData (handle, 0);
+
+	return 1; /* success */
+}
+
+// returns the compiled pattern, if possible from the cache
+// if the cache is full, the least recently used entry is replaced
+// if the returned pointer equals uncached, the caller has to regfree it
+
+static const regex_t * getRegex (RegexCache * cache, const char * pattern, int cflags, regex_t * uncached, int * ret)
+{
+	if (!cache || !cache->size)
+	{
+		*ret = regcomp (uncached, pattern, cflags);
+		return uncached;
+	}
+
+	CachedRegex * slot = 0;
+	for (size_t i = 0; i < cache->size; ++i)
+	{
+		CachedRegex * entry = &cache->entries[i];
+		if (entry->pattern && entry->cflags == cflags && !strcmp (entry->pattern, pattern))
+		{
+			entry->lastUse = ++cache->tick;
+			*ret = 0;
+			return &entry->regex;
+		}
+		if (!slot || (slot->pattern && (!entry->pattern || entry->lastUse < slot->lastUse))) slot = entry;
+	}
+
+	if (slot->pattern)
+	{
+		regfree (&slot->regex);
+		elektraFree (slot->pattern);
+		slot->pattern = 0;
+	}
+
+	*ret = regcomp (&slot->regex, pattern, cflags);
+	if (*ret != 0) return &slot->regex;
+
+	if (!(slot->pattern = elektraStrDup (pattern)))
+	{
+		regfree (&slot->regex);
+		*ret = regcomp (uncached, pattern, cflags);
+		return uncached;
+	}
+	slot->cflags = cflags;
+	slot->lastUse = ++cache->tick;
+	return &slot->regex;
+}
+
 int elektraValidationGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * parentKey ELEKTRA_UNUSED)
 {
 	KeySet * n;
@@ -26,17 +128,20 @@ int elektraValidationGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key
 		  n = ksNew (30,
 			     keyNew ("system/elektra/modules/validation", KEY_VALUE, "validation plugin waits for your orders", KEY_END),
 			     keyNew ("system/elektra/modules/validation/exports", KEY_END),
+			     keyNew ("system/elektra/modules/validation/exports/open", KEY_FUNC, elektraValidationOpen, KEY_END),
+			     keyNew ("system/elektra/modules/validation/exports/close", KEY_FUNC, elektraValidationClose, KEY_END),
 			     keyNew ("system/elektra/modules/validation/exports/get", KEY_FUNC, elektraValidationGet, KEY_END),
 			     keyNew ("system/elektra/modules/validation/exports/set", KEY_FUNC, elektraValidationSet, KEY_END),
 			     keyNew ("system/elektra/modules/validation/exports/ksLookupRE", KEY_FUNC, ksLookupRE, KEY_END),
 			     keyNew ("system/elektra/modules/validation/exports/validateKey", KEY_FUNC, validateKey, KEY_END),
+			     keyNew ("system/elektra/modules/validation/exports/checkkey", KEY_FUNC, elektraValidationCheckKey, KEY_END),
 #include "readme_validation.c"
 			     keyNew ("system/elektra/modules/validation/infos/version", KEY_VALUE, PLUGINVERSION, KEY_END), KS_END));
 	ksDel (n);
 	return 1;
 }
 
-static int validateKey (Key * key, Key * parentKey)
+static int validateKeyWithCache (RegexCache * cache, Key * key, Key * parentKey)
 {
 	const Key * regexMeta = keyGetMeta (key, "check/validation");
 
@@ -103,23 +208,24 @@ static int validateKey (Key * key, Key * parentKey)
 		regexString = (char *)keyString (regexMeta);
 	}
 
-	regex_t regex;
+	regex_t uncached;
 	regmatch_t offsets;
-	int ret = regcomp (&regex, regexString, cflags);
+	int ret;
+	const regex_t * regex = getRegex (cache, regexString, cflags, &uncached, &ret);
 
 	if (ret != 0)
 	{
 		char buffer[1000];
-		regerror (ret, &regex, buffer, 999);
+		regerror (ret, regex, buffer, 999);
 		ELEKTRA_SET_ERROR (41, parentKey, buffer);
-		regfree (&regex);
+		if (regex == &uncached) regfree (&uncached);
 		if (freeString) elektraFree (regexString);
 		return 0;
 	}
 	int match = 0;
 	if (!wordValidation)
 	{
-		ret = regexec (&regex, keyString (key), 1, &offsets, 0);
+		ret = regexec (regex, keyString (key), 1, &offsets, 0);
 		if (ret == 0) match = 1;
 	}
 	else
@@ -129,7 +235,7 @@ static int validateKey (Key * key, Key * parentKey)
 		char * string = (char *)keyString (key);
 		while ((token = strtok_r (string, " \t\n", &savePtr)) != NULL)
 		{
-			ret = regexec (&regex, token, 1, &offsets, 0);
+			ret = regexec (regex, token, 1, &offsets, 0);
 			if (ret == 0)
 			{
 				match = 1;
@@ -146,46 +252,47 @@ static int validateKey (Key * key, Key * parentKey)
 		if (msg)
 		{
 			ELEKTRA_SET_ERROR (42, parentKey, keyString (msg));
-			regfree (&regex);
+			if (regex == &uncached) regfree (&uncached);
 			if (freeString) elektraFree (regexString);
 			return 0;
 		}
 		else
 		{
 			char buffer[1000];
-			regerror (ret, &regex, buffer, 999);
+			regerror (ret, regex, buffer, 999);
 			ELEKTRA_SET_ERROR (42, parentKey, buffer);
-			regfree (&regex);
+			if (regex == &uncached) regfree (&uncached);
 			if (freeString) elektraFree (regexString);
 			return 0;
 		}
 	}
 
-	regfree (&regex);
+	if (regex == &uncached) regfree (&uncached);
 	if (freeString) elektraFree (regexString);
 	return 1;
 }
 
-int elektraValidationSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * parentKey)
+static int validateKey (Key * key, Key * parentKey)
 {
-	Key * cur = 0;
-
-	while ((cur = ksNext (returned)) != 0)
-	{
-		const Key * regexMeta = keyGetMeta (cur, "check/validation");
+	return validateKeyWithCache (0, key, parentKey);
+}
 
-		if (!regexMeta) continue;
-		int rc = validateKey (cur, parentKey);
-		if (!rc) return -1;
-	}
+int elektraValidationCheckKey (Plugin * handle, Key * key, Key * errorKey)
+{
+	return validateKeyWithCache (elektraPluginGetData (handle), key, errorKey);
+}
 
-	return 1; /* success */
+int elektraValidationSet (Plugin * handle, KeySet * returned, Key * parentKey)
+{
+	return elektraPluginCheckKeys (handle, returned, "check/validation", elektraValidationCheckKey, parentKey);
 }
 
 Plugin * ELEKTRA_PLUGIN_EXPORT (validation)
 {
 	// clang-format off
 	return elektraPluginExport("validation",
+			ELEKTRA_PLUGIN_OPEN,	&elektraValidationOpen,
+			ELEKTRA_PLUGIN_CLOSE,	&elektraValidationClose,
 			ELEKTRA_PLUGIN_GET,	&elektraValidationGet,
 			ELEKTRA_PLUGIN_SET,	&elektraValidationSet,
 			ELEKTRA_PLUGIN_END);
@@ -20,6 +20,7 @@ int elektraValidationClose (Plugin * handle, Key * errorKey);
 int elektraValidationGet (Plugin * handle, KeySet * ks, Key * parentKey);
 int elektraValidationSet (Plugin * handle, KeySet * ks, Key * parentKey);
 int elektraValidationError (Plugin * handle, KeySet * ks, Key * parentKey);
+int elektraValidationCheckKey (Plugin * handle, Key * key, Key * errorKey);
 
 Key * ksLookupRE (KeySet * ks, const regex_t * regexp);
 
@@ -458,6 +458,144 @@ KeySet *getSomeBelowKeys(void)
 			KS_END);
 }
 
+// names which need escaping, nested arrays of maps and the pseudo keys of empty maps and arrays,
+// map keys starting with # are read as array entries
+KeySet *getParseNamesKeys(void)
+{
+	return ksNew(60,
+			keyNew("user/tests/yajl",
+			       KEY_END),
+			keyNew("user/tests/yajl/a\\/b",
+			       KEY_END),
+			keyNew("user/tests/yajl/a\\/b/c\\/d",
+			       KEY_END),
+			keyNew("user/tests/yajl/a\\/b/c\\/d/#0",
+			       KEY_VALUE, "1",
+			       KEY_META, "type", "double",
+			       KEY_END),
+			keyNew("user/tests/yajl/a\\/b/c\\/d/#1",
+			       KEY_VALUE, "x/y",
+			       KEY_END),
+			keyNew("user/tests/yajl/array",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#0",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#0/a",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#0/a/#0",
+			       KEY_VALUE, "1",
+			       KEY_META, "type", "double",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#0/a/#1",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#0/a/#1/b",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#0/a/#1/b/#0",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#0/a/#1/b/#0/#0",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#0/a/#1/b/#0/#0/c",
+			       KEY_VALUE, "d",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#0/a/#1/b/#0/#1",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#0/a/#1/b/#0/#1/___empty_map",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#0/a/#1/b/#1",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#0/a/#1/b/#1/###empty_array",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#1",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#1/#0",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#1/#0/x",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#1/#0/x/y",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#1/#0/x/y/###empty_array",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#1/#1",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#1/#1/___empty_map",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#2",
+			       KEY_END),
+			keyNew("user/tests/yajl/array/#2/###empty_array",
+			       KEY_END),
+			keyNew("user/tests/yajl/back\\slash",
+			       KEY_END),
+			keyNew("user/tests/yajl/back\\slash/\\\\",
+			       KEY_END),
+			keyNew("user/tests/yajl/back\\slash/\\\\/###empty_array",
+			       KEY_END),
+			keyNew("user/tests/yajl/back\\slash/\\\\\\/",
+			       KEY_VALUE, "2",
+			       KEY_META, "type", "double",
+			       KEY_END),
+			keyNew("user/tests/yajl/back\\slash/t\\\\",
+			       KEY_VALUE, "1",
+			       KEY_META, "type", "double",
+			       KEY_END),
+			keyNew("user/tests/yajl/empty_array",
+			       KEY_END),
+			keyNew("user/tests/yajl/empty_array/###empty_array",
+			       KEY_END),
+			keyNew("user/tests/yajl/empty_map",
+			       KEY_END),
+			keyNew("user/tests/yajl/empty_map/___empty_map",
+			       KEY_END),
+			keyNew("user/tests/yajl/hash",
+			       KEY_END),
+			keyNew("user/tests/yajl/hash/#",
+			       KEY_END),
+			keyNew("user/tests/yajl/hash/#0",
+			       KEY_VALUE, "h",
+			       KEY_END),
+			keyNew("user/tests/yajl/hash/#1",
+			       KEY_END),
+			keyNew("user/tests/yajl/hash/x#y",
+			       KEY_VALUE, "z",
+			       KEY_END),
+			keyNew("user/tests/yajl/nested",
+			       KEY_END),
+			keyNew("user/tests/yajl/nested/#0",
+			       KEY_END),
+			keyNew("user/tests/yajl/nested/#0/###empty_array",
+			       KEY_END),
+			keyNew("user/tests/yajl/nested/#1",
+			       KEY_END),
+			keyNew("user/tests/yajl/nested/#1/___empty_map",
+			       KEY_END),
+			keyNew("user/tests/yajl/nested/#2",
+			       KEY_END),
+			keyNew("user/tests/yajl/nested/#2/#0",
+			       KEY_END),
+			keyNew("user/tests/yajl/nested/#2/#0/___empty_map",
+			       KEY_END),
+			keyNew("user/tests/yajl/nested/#3",
+			       KEY_END),
+			keyNew("user/tests/yajl/nested/#3/#0",
+			       KEY_END),
+			keyNew("user/tests/yajl/nested/#3/#0/###empty_array",
+			       KEY_END),
+			keyNew("user/tests/yajl/percent",
+			       KEY_END),
+			keyNew("user/tests/yajl/percent/\\%",
+			       KEY_END),
+			keyNew("user/tests/yajl/percent/\\%/%",
+			       KEY_END),
+			keyNew("user/tests/yajl/percent/\\%/%/###empty_array",
+			       KEY_END),
+			keyNew("user/tests/yajl/percent/\\..",
+			       KEY_END),
+			keyNew("user/tests/yajl/percent/\\../\\.",
+			       KEY_VALUE, "1",
+			       KEY_META, "type", "double",
+			       KEY_END),
+			KS_END);
+}
+
 // clang-format on
 
 KeySet * modules;
@@ -539,6 +677,31 @@ void test_readWrite (const char * fileName, KeySet * conf)
 	elektraPluginClose (plugin, 0);
 }
 
+/**
+ * Only reads the file, for files which are not written back the same way.
+ */
+void test_parse (const char * fileName, KeySet * compareKeySet, KeySet * conf)
+{
+	printf ("Test parse with %s\n", srcdir_file (fileName));
+
+	Plugin * plugin = elektraPluginOpen ("yajl", modules, conf, 0);
+	exit_if_fail (plugin != 0, "could not open plugin");
+
+	Key * parentKey = keyNew ("user/tests/yajl", KEY_VALUE, srcdir_file (fileName), KEY_END);
+	KeySet * keys = ksNew (0, KS_END);
+	succeed_if (plugin->kdbGet (plugin, keys, parentKey) == 1, "kdbGet was not successful");
+	succeed_if (output_error (parentKey), "error in kdbGet");
+	succeed_if (output_warnings (parentKey), "warnings in kdbGet");
+
+	compare_keyset (keys, compareKeySet);
+
+	keyDel (parentKey);
+	ksDel (keys);
+	ksDel (compareKeySet);
+
+	elektraPluginClose (plugin, 0);
+}
+
 // TODO: make nicer and put to test framework
 #define succeed_if_equal(x, y) succeed_if (!strcmp (x, y), x)
 
@@ -748,6 +911,7 @@ int main (int argc, char ** argv)
 	test_json ("yajl/testdata_array.json", getArrayKeys (), ksNew (0, KS_END));
 	test_json ("yajl/testdata_below.json", getBelowKeys (), ksNew (0, KS_END));
 	test_json ("yajl/OpenICC_device_config_DB.json", getOpenICCKeys (), ksNew (0, KS_END));
+	test_parse ("yajl/testdata_parse_names.json", getParseNamesKeys (), ksNew (0, KS_END));
 
 	// TODO currently do not have a KeySet, wait for C-plugin to make
 	// it easy to generate it..
@@ -15,54 +15,191 @@
 #include <kdbconfig.h>
 #include <kdbease.h>
 #include <kdberrors.h>
+#include <kdbhelper.h>
+#include <kdbprivate.h> // elektraEscapeKeyNamePart
 #include <yajl/yajl_parse.h>
 
 
 /**
- @retval 0 if ksCurrent does not hold an array entry
+ * One map or array the parser is currently in.
+ */
+typedef struct
+{
+	Key * key;		    ///< the key representing the map or array
+	size_t nameSize;	    ///< length of the escaped name of key
+	kdb_long_long_t arrayIndex; ///< index of the last array entry, -1 for empty arrays and maps
+	int isArray;
+} ElektraYajlLevel;
+
+/**
+ * State of the parser.
+ *
+ * The escaped name of the current key is kept in a buffer and every
+ * new key is created directly from it, so that names of parents do not
+ * need to be copied and escaped again for every key.
+ */
+typedef struct
+{
+	KeySet * ks;		  ///< the keyset to add the keys to
+	Key * current;		  ///< the key the next value will be assigned to
+	char * name;		  ///< escaped name of current
+	size_t nameSize;	  ///< length of name (without null)
+	size_t nameAlloc;	  ///< allocated size of name
+	ElektraYajlLevel * levels; ///< stack of maps and arrays above current
+	size_t depth;		  ///< number of used levels
+	size_t levelsAlloc;	  ///< allocated number of levels
+} ElektraYajlParseContext;
+
+static int elektraYajlContextInit (ElektraYajlParseContext * ctx, KeySet * ks, Key * root)
+{
+	ctx->ks = ks;
+	ctx->current = root;
+	ctx->nameSize = strlen (keyName (root));
+	ctx->nameAlloc = ctx->nameSize + 1;
+	ctx->name = elektraMalloc (ctx->nameAlloc);
+	ctx->levels = NULL;
+	ctx->depth = 0;
+	ctx->levelsAlloc = 0;
+	if (!ctx->name) return -1;
+	memcpy (ctx->name, keyName (root), ctx->nameAlloc);
+	return 0;
+}
+
+static void elektraYajlContextClose (ElektraYajlParseContext * ctx)
+{
+	elektraFree (ctx->name);
+	elektraFree (ctx->levels);
+}
+
+/**
+ * @brief Replace the base name of the name buffer
+ *
+ * @param ctx the parser state
+ * @param parentSize length of the name of the parent of the new key
+ * @param escaped escaped base name of the new key
+ *
+ * @retval 0 on success
+ * @retval -1 on memory allocation errors
+ */
+static int elektraYajlSetBaseName (ElektraYajlParseContext * ctx, size_t parentSize, const char * escaped)
+{
+	size_t escapedSize = strlen (escaped);
+	size_t size = parentSize + 1 + escapedSize;
+	if (size + 1 > ctx->nameAlloc)
+	{
+		size_t newAlloc = ctx->nameAlloc * 2 > size + 1 ? ctx->nameAlloc * 2 : size + 1;
+		if (elektraRealloc ((void **)&ctx->name, newAlloc) < 0) return -1;
+		ctx->nameAlloc = newAlloc;
+	}
+	ctx->name[parentSize] = '/';
+	memcpy (ctx->name + parentSize + 1, escaped, escapedSize + 1);
+	ctx->nameSize = size;
+	return 0;
+}
+
+/**
+ * @brief Create a key from the name buffer and make it the current key
+ *
+ * @retval 0 on success
+ * @retval -1 on memory allocation errors
+ */
+static int elektraYajlAppendCurrent (ElektraYajlParseContext * ctx)
+{
+	Key * key = keyNew (ctx->name, KEY_END);
+	if (!key) return -1;
+	ksAppendKey (ctx->ks, key);
+	ctx->current = key;
+	return 0;
+}
+
+/**
+ * @brief Enter a new map or array below the current key
+ *
+ * @retval 0 on success
+ * @retval -1 on memory allocation errors
+ */
+static int elektraYajlPushLevel (ElektraYajlParseContext * ctx, int isArray)
+{
+	if (ctx->depth == ctx->levelsAlloc)
+	{
+		size_t newAlloc = ctx->levelsAlloc ? ctx->levelsAlloc * 2 : 16;
+		if (elektraRealloc ((void **)&ctx->levels, newAlloc * sizeof (ElektraYajlLevel)) < 0) return -1;
+		ctx->levelsAlloc = newAlloc;
+	}
+	ElektraYajlLevel * level = &ctx->levels[ctx->depth++];
+	level->key = ctx->current;
+	level->nameSize = ctx->nameSize;
+	level->arrayIndex = -1;
+	level->isArray = isArray;
+	return 0;
+}
+
+/**
+ * @brief Handles keys with a base name starting with # which are not
+ *        entries of an array we are in (e.g. map keys like #1)
+ *
+ * @see elektraYajlIncrementArrayEntry
+ */
+static int elektraYajlIncrementForeignEntry (ElektraYajlParseContext * ctx)
+{
+	Key * current = keyNew (keyName (ctx->current), KEY_END);
+	elektraArrayIncName (current);
+	ksAppendKey (ctx->ks, current);
+	ctx->current = current;
+
+	size_t size = strlen (keyName (current));
+	if (size + 1 > ctx->nameAlloc)
+	{
+		if (elektraRealloc ((void **)&ctx->name, size + 1) < 0) return -1;
+		ctx->nameAlloc = size + 1;
+	}
+	memcpy (ctx->name, keyName (current), size + 1);
+	ctx->nameSize = size;
+	return 2;
+}
+
+/**
+ @retval 0 if the current key does not hold an array entry
  @retval 1 if the array entry will be used because its the first
  @retval 2 if a new array entry was created
- @retval -1 error in snprintf
+ @retval -1 on memory allocation errors
  */
-static int elektraYajlIncrementArrayEntry (KeySet * ks)
+static int elektraYajlIncrementArrayEntry (ElektraYajlParseContext * ctx)
 {
-	Key * current = ksCurrent (ks);
-	const char * baseName = keyBaseName (current);
+	ElektraYajlLevel * level = ctx->depth ? &ctx->levels[ctx->depth - 1] : NULL;
 
-	if (baseName && *baseName == '#')
+	if (!level || !level->isArray)
 	{
-		current = keyNew (keyName (current), KEY_END);
-		if (!strcmp (baseName, "###empty_array"))
+		const char * baseName = keyBaseName (ctx->current);
+		if (baseName && *baseName == '#')
 		{
-			// get rid of previous key
-			keyDel (ksLookup (ks, current, KDB_O_POP));
-			// we have a new array entry
-			keySetBaseName (current, 0);
-			keyAddName (current, "#0");
-			ksAppendKey (ks, current);
-			return 1;
+			return elektraYajlIncrementForeignEntry (ctx);
 		}
-		else
-		{
-			// we are in an array
-			elektraArrayIncName (current);
-			ksAppendKey (ks, current);
-			return 2;
-		}
-	}
-	else
-	{
 		// previous entry indicates this is not an array
 		return 0;
 	}
+
+	int ret = 2;
+	if (level->arrayIndex == -1)
+	{
+		// get rid of ###empty_array, we have a new array entry
+		keyDel (ksLookup (ctx->ks, ctx->current, KDB_O_POP));
+		ret = 1;
+	}
+
+	char baseName[ELEKTRA_MAX_ARRAY_SIZE];
+	elektraWriteArrayNumber (baseName, ++level->arrayIndex);
+	if (elektraYajlSetBaseName (ctx, level->nameSize, baseName) < 0) return -1;
+	if (elektraYajlAppendCurrent (ctx) < 0) return -1;
+	return ret;
 }
 
 static int elektraYajlParseNull (void * ctx)
 {
-	KeySet * ks = (KeySet *)ctx;
-	elektraYajlIncrementArrayEntry (ks);
+	ElektraYajlParseContext * context = (ElektraYajlParseContext *)ctx;
+	if (elektraYajlIncrementArrayEntry (context) < 0) return 0;
 
-	Key * current = ksCurrent (ks);
+	Key * current = context->current;
 
 	keySetBinary (current, NULL, 0);
 
@@ -75,10 +212,10 @@ static int elektraYajlParseNull (void * ctx)
 
 static int elektraYajlParseBoolean (void * ctx, int boolean)
 {
-	KeySet * ks = (KeySet *)ctx;
-	elektraYajlIncrementArrayEntry (ks);
+	ElektraYajlParseContext * context = (ElektraYajlParseContext *)ctx;
+	if (elektraYajlIncrementArrayEntry (context) < 0) return 0;
 
-	Key * current = ksCurrent (ks);
+	Key * current = context->current;
 
 	if (boolean == 1)
 	{
@@ -99,10 +236,10 @@ static int elektraYajlParseBoolean (void * ctx, int boolean)
 
 static int elektraYajlParseNumber (void * ctx, const char * stringVal, yajl_size_type stringLen)
 {
-	KeySet * ks = (KeySet *)ctx;
-	elektraYajlIncrementArrayEntry (ks);
+	ElektraYajlParseContext * context = (ElektraYajlParseContext *)ctx;
+	if (elektraYajlIncrementArrayEntry (context) < 0) return 0;
 
-	Key * current = ksCurrent (ks);
+	Key * current = context->current;
 
 	unsigned char delim = stringVal[stringLen];
 	char * stringValue = (char *)stringVal;
@@ -123,10 +260,10 @@ static int elektraYajlParseNumber (void * ctx, const char * stringVal, yajl_size
 
 static int elektraYajlParseString (void * ctx, const unsigned char * stringVal, yajl_size_type stringLen)
 {
-	KeySet * ks = (KeySet *)ctx;
-	elektraYajlIncrementArrayEntry (ks);
+	ElektraYajlParseContext * context = (ElektraYajlParseContext *)ctx;
+	if (elektraYajlIncrementArrayEntry (context) < 0) return 0;
 
-	Key * current = ksCurrent (ks);
+	Key * current = context->current;
 
 	unsigned char delim = stringVal[stringLen];
 	char * stringValue = (char *)stringVal;
@@ -145,53 +282,53 @@ static int elektraYajlParseString (void * ctx, const unsigned char * stringVal,
 
 static int elektraYajlParseMapKey (void * ctx, const unsigned char * stringVal, yajl_size_type stringLen)
 {
-	KeySet * ks = (KeySet *)ctx;
-	elektraYajlIncrementArrayEntry (ks);
+	ElektraYajlParseContext * context = (ElektraYajlParseContext *)ctx;
+	if (elektraYajlIncrementArrayEntry (context) < 0) return 0;
+	if (!context->depth) return 0;
 
-	Key * currentKey = keyNew (keyName (ksCurrent (ks)), KEY_END);
-	keySetString (currentKey, 0);
+	ElektraYajlLevel * level = &context->levels[context->depth - 1];
 
 	unsigned char delim = stringVal[stringLen];
 	char * stringValue = (char *)stringVal;
 	stringValue[stringLen] = '\0';
 
 #ifdef ELEKTRA_YAJL_VERBOSE
-	printf ("elektraYajlParseMapKey stringValue: %s currentKey: %s\n", stringValue, keyName (currentKey));
+	printf ("elektraYajlParseMapKey stringValue: %s currentKey: %s\n", stringValue, context->name);
 #endif
-	if (currentKey && !strcmp (keyBaseName (currentKey), "___empty_map"))
+	if (!strcmp (context->name + level->nameSize + 1, "___empty_map"))
 	{
-		// remove old key
-		keyDel (ksLookup (ks, currentKey, KDB_O_POP));
-		// now we know the name of the object
-		keySetBaseName (currentKey, stringValue);
+		// remove old key, now we know the name of the object
+		keyDel (ksLookup (context->ks, context->current, KDB_O_POP));
 	}
-	else
+
+	// we entered a new pair (inside the previous object)
+	char * escaped = elektraMalloc (stringLen * 2 + 2);
+	int ret = escaped != NULL;
+	if (ret)
 	{
-		// we entered a new pair (inside the previous object)
-		keySetBaseName (currentKey, stringValue);
+		elektraEscapeKeyNamePart (stringValue, escaped);
+		ret = elektraYajlSetBaseName (context, level->nameSize, escaped) == 0 && elektraYajlAppendCurrent (context) == 0;
+		elektraFree (escaped);
 	}
-	ksAppendKey (ks, currentKey);
 
 	// restore old character in buffer
 	stringValue[stringLen] = delim;
 
-	return 1;
+	return ret;
 }
 
 static int elektraYajlParseStartMap (void * ctx)
 {
-	KeySet * ks = (KeySet *)ctx;
-	elektraYajlIncrementArrayEntry (ks);
-
-	Key * currentKey = ksCurrent (ks);
+	ElektraYajlParseContext * context = (ElektraYajlParseContext *)ctx;
+	if (elektraYajlIncrementArrayEntry (context) < 0) return 0;
 
-	Key * newKey = keyNew (keyName (currentKey), KEY_END);
 	// add a pseudo element for empty map
-	keyAddBaseName (newKey, "___empty_map");
-	ksAppendKey (ks, newKey);
+	if (elektraYajlPushLevel (context, 0) < 0) return 0;
+	if (elektraYajlSetBaseName (context, context->nameSize, "___empty_map") < 0) return 0;
+	if (elektraYajlAppendCurrent (context) < 0) return 0;
 
 #ifdef ELEKTRA_YAJL_VERBOSE
-	printf ("elektraYajlParseStartMap with new key %s\n", keyName (newKey));
+	printf ("elektraYajlParseStartMap with new key %s\n", context->name);
 #endif
 
 	return 1;
@@ -199,47 +336,34 @@ static int elektraYajlParseStartMap (void * ctx)
 
 static int elektraYajlParseEnd (void * ctx)
 {
-	KeySet * ks = (KeySet *)ctx;
-	Key * currentKey = ksCurrent (ks);
+	ElektraYajlParseContext * context = (ElektraYajlParseContext *)ctx;
+	if (!context->depth) return 0;
 
-	Key * lookupKey = keyNew (keyName (currentKey), KEY_END);
-	keySetBaseName (lookupKey, 0); // remove current baseName
-
-	// lets point current to the correct place
-	Key * foundKey = ksLookup (ks, lookupKey, 0);
+	// lets point current to the map or array we leave
+	ElektraYajlLevel * level = &context->levels[--context->depth];
+	context->current = level->key;
+	context->nameSize = level->nameSize;
+	context->name[context->nameSize] = '\0';
 
 #ifdef ELEKTRA_YAJL_VERBOSE
-	if (foundKey)
-	{
-		printf ("elektraYajlParseEnd %s\n", keyName (foundKey));
-	}
-	else
-	{
-		printf ("elektraYajlParseEnd did not find key!\n");
-	}
-#else
-	(void)foundKey; // foundKey is not used, but lookup is needed
+	printf ("elektraYajlParseEnd %s\n", context->name);
 #endif
 
-	keyDel (lookupKey);
-
 	return 1;
 }
 
 static int elektraYajlParseStartArray (void * ctx)
 {
-	KeySet * ks = (KeySet *)ctx;
-	elektraYajlIncrementArrayEntry (ks);
-
-	Key * currentKey = ksCurrent (ks);
+	ElektraYajlParseContext * context = (ElektraYajlParseContext *)ctx;
+	if (elektraYajlIncrementArrayEntry (context) < 0) return 0;
 
-	Key * newKey = keyNew (keyName (currentKey), KEY_END);
 	// add a pseudo element for empty array
-	keyAddName (newKey, "###empty_array");
-	ksAppendKey (ks, newKey);
+	if (elektraYajlPushLevel (context, 1) < 0) return 0;
+	if (elektraYajlSetBaseName (context, context->nameSize, "###empty_array") < 0) return 0;
+	if (elektraYajlAppendCurrent (context) < 0) return 0;
 
 #ifdef ELEKTRA_YAJL_VERBOSE
-	printf ("elektraYajlParseStartArray with new key %s\n", keyName (newKey));
+	printf ("elektraYajlParseStartArray with new key %s\n", context->name);
 #endif
 
 	return 1;
@@ -320,13 +444,22 @@ int elektraYajlGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * par
 				     elektraYajlParseStartArray,
 				     elektraYajlParseEnd };
 
-	ksAppendKey (returned, keyNew (keyName ((parentKey)), KEY_END));
+	Key * root = keyNew (keyName ((parentKey)), KEY_END);
+	ksAppendKey (returned, root);
+
+	ElektraYajlParseContext context;
+	if (elektraYajlContextInit (&context, returned, root) < 0)
+	{
+		elektraYajlContextClose (&context);
+		ELEKTRA_SET_ERROR (87, parentKey, "Memory allocation failed");
+		return -1;
+	}
 
 #if YAJL_MAJOR == 1
 	yajl_parser_config cfg = { 1, 1 };
-	yajl_handle hand = yajl_alloc (&callbacks, &cfg, NULL, returned);
+	yajl_handle hand = yajl_alloc (&callbacks, &cfg, NULL, &context);
 #else
-	yajl_handle hand = yajl_alloc (&callbacks, NULL, returned);
+	yajl_handle hand = yajl_alloc (&callbacks, NULL, &context);
 	yajl_config (hand, yajl_allow_comments, 1);
 #endif
 
@@ -337,6 +470,7 @@ int elektraYajlGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * par
 	if (!fileHandle)
 	{
 		yajl_free (hand);
+		elektraYajlContextClose (&context);
 		ELEKTRA_SET_ERROR_GET (parentKey);
 		errno = errnosave;
 		return -1;
@@ -352,6 +486,7 @@ int elektraYajlGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * par
 				ELEKTRA_SET_ERROR (76, parentKey, keyString (parentKey));
 				fclose (fileHandle);
 				yajl_free (hand);
+				elektraYajlContextClose (&context);
 				return -1;
 			}
 			done = 1;
@@ -382,6 +517,7 @@ int elektraYajlGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * par
 			yajl_free_error (hand, str);
 			yajl_free (hand);
 			fclose (fileHandle);
+			elektraYajlContextClose (&context);
 
 			return -1;
 		}
@@ -389,6 +525,7 @@ int elektraYajlGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * par
 
 	yajl_free (hand);
 	fclose (fileHandle);
+	elektraYajlContextClose (&context);
 	elektraYajlParseSuppressEmpty (returned, parentKey);
 
 	return 1; /* success */
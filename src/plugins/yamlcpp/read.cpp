@@ -7,14 +7,17 @@
  */
 
 #include "read.hpp"
+#include "yaml-cpp/eventhandler.h"
 #include "yaml-cpp/yaml.h"
 
 #include <kdb.hpp>
-#include <kdbease.h>
+#include <kdbhelper.h>
 #include <kdblogger.h>
 #include <kdbplugin.h>
 
-#include <sstream>
+#include <fstream>
+#include <map>
+#include <vector>
 
 using namespace std;
 using namespace kdb;
@@ -40,83 +43,288 @@ Key newKey (string const & name, Key const & parent)
 /**
  * @brief This function creates a new array key from the given parameters.
  *
- * @param mappings This argument specifies the key set of the new key this function creates.
  * @param arrayKey This argument specifies the key that represents the root of the array.
+ * @param index This number specifies the index of the array element.
  *
  * @returns The function returns a new key that is part of the array represented by `arrayKey`.
  */
-Key newArrayKey (KeySet const & mappings, Key & arrayKey)
+Key newArrayKey (Key const & arrayKey, kdb_long_long_t const index)
 {
-	KeySet arrayEntries{ elektraArrayGet (arrayKey.getKey (), mappings.getKeySet ()) };
-
-	if (arrayEntries.size () <= 0)
-	{
-		Key first = arrayKey.dup ();
-		first.addBaseName ("#");
-		arrayEntries.append (first);
-	}
-
-	Key newKey{ elektraArrayGetNextKey (arrayEntries.getKeySet ()) };
-	arrayKey.setMeta ("array", newKey.getBaseName ());
-
-	return newKey;
+	char name[ELEKTRA_MAX_ARRAY_SIZE];
+	ckdb::elektraWriteArrayNumber (name, index);
+	return newKey (name, arrayKey);
 }
 
 /**
- * @brief Add metadata saved in a YAML map to the specified key
+ * @brief This class converts the events of the yaml-cpp parser directly into keys.
  *
- * @param key This parameter saves the key to which this function should add the metadata stored in `node`.
- * @param node This YAML node stores a map containing metadata.
+ * The handler keeps a stack of the collections that are currently open. This way we do not need to build a `YAML::Node` tree for the
+ * whole document before we create the first key.
  */
-void addMetadata (Key & key, YAML::Node const & node)
+class KeySetBuilder : public YAML::EventHandler
 {
-	for (auto & element : node)
+	/** This enumeration specifies the different types of collections the builder handles. */
+	enum class LevelType
 	{
-		auto metakey = element.first.as<string> ();
-		auto metavalue = element.second.IsNull () ? "" : element.second.as<string> ();
-		ELEKTRA_LOG_DEBUG ("Add metakey “%s: %s”", metakey.c_str (), metavalue.c_str ());
-		key.setMeta (metakey, metavalue);
-	}
-}
+		MAP,      ///< A mapping, whose values are stored below the key of the level
+		SEQUENCE, ///< A sequence, whose elements are stored as array below the key of the level
+		META,     ///< A sequence tagged with `!elektra/meta`, which stores the value and metadata of the key of the level
+		META_MAP, ///< The mapping inside a `!elektra/meta` sequence that stores the metadata of the key of the level
+		SKIP,     ///< A collection the builder ignores
+	};
 
-/**
- * @brief Convert a YAML node to a key set
- *
- * @param node This YAML node stores the data that should be added to the keyset `mappings`
- * @param mappings The key set where the YAML data will be stored
- * @param prefix This key stores the prefix for the key name
- */
-void convertNodeToKeySet (YAML::Node const & node, KeySet & mappings, Key & parent)
-{
-	if (node.Tag () == "!elektra/meta")
+	/** This structure stores the state of a single open collection. */
+	struct Level
 	{
-		Key key (parent.getFullName (), KEY_VALUE, node[0].as<string> ().c_str (), KEY_END);
-		ELEKTRA_LOG_DEBUG ("Add key “%s: %s”", key.getName ().c_str (), key.get<string> ().c_str ());
+		LevelType type;
+		Key key;
+		YAML::Mark mark;
+		string name;
+		bool expectKey;
+		kdb_long_long_t index;
+	};
+
+	/** This structure stores the data of an anchored node, so we can reproduce the data if we encounter an alias. */
+	struct Anchor
+	{
+		Key key;
+		string tag;
+		string value;
+		bool isScalar;
+		bool isNull;
+	};
+
+	KeySet & mappings;
+	Key parent;
+	vector<Level> levels;
+	map<YAML::anchor_t, Anchor> anchors;
+
+	/**
+	 * @brief This function returns the key for the node that follows in the current collection and adds it to the key set.
+	 *
+	 * @returns The intermediate key for the next node or the parent key if the next node is the root of the document
+	 */
+	Key nextKey ()
+	{
+		if (levels.empty ()) return parent;
+
+		Level & level = levels.back ();
+		Key key = level.type == LevelType::MAP ? newKey (level.name, level.key) : newArrayKey (level.key, level.index++);
+		level.expectKey = true;
+		ELEKTRA_LOG_DEBUG ("Add intermediate key “%s”", key.getName ().c_str ());
 		mappings.append (key);
-		addMetadata (key, node[1]);
+		return key;
+	}
+
+	/**
+	 * @brief This function stores the data of an anchored node.
+	 *
+	 * @param anchor This number specifies the anchor of the node. If it is `YAML::NullAnchor`, then the function does nothing.
+	 * @param data This variable stores the data of the node.
+	 */
+	void addAnchor (YAML::anchor_t const anchor, Anchor const & data)
+	{
+		if (anchor == YAML::NullAnchor) return;
+		anchors[anchor] = data;
+	}
+
+	/**
+	 * @brief This function copies the keys stored below an anchored key to a new location.
+	 *
+	 * @param source This key stores the root of the anchored data.
+	 * @param target This key specifies the new location of the data.
+	 */
+	void copyKeys (Key const & source, Key const & target)
+	{
+		if (!mappings.lookup (source)) return;
+
+		vector<Key> copies;
+		string const sourceName = source.getName ();
+		string const targetName = target.getName ();
+		for (cursor_t cursor = mappings.getCursor (); cursor < static_cast<cursor_t> (mappings.size ()); ++cursor)
+		{
+			Key key = mappings.at (cursor);
+			if (!key.isBelowOrSame (source)) break;
+			Key copy = key.dup ();
+			copy.setName (targetName + key.getName ().substr (sourceName.size ()));
+			copies.push_back (copy);
+		}
+		for (auto & copy : copies)
+		{
+			mappings.append (copy);
+		}
 	}
-	else if (node.IsScalar ())
+
+	/**
+	 * @brief This function handles a scalar value.
+	 *
+	 * @param tag This string stores the tag of the scalar.
+	 * @param anchor This number specifies the anchor of the scalar.
+	 * @param value This string stores the scalar value.
+	 * @param isNull This variable specifies if the scalar represents a null value.
+	 */
+	void addScalar (string const & tag, YAML::anchor_t const anchor, string const & value, bool const isNull)
 	{
-		Key key (parent.getFullName (), KEY_VALUE, node.as<string> ().c_str (), KEY_END);
+		addAnchor (anchor, Anchor{ Key (), tag, value, true, isNull });
+
+		if (!levels.empty () && levels.back ().type != LevelType::SEQUENCE)
+		{
+			Level & level = levels.back ();
+			if (level.type == LevelType::SKIP) return;
+			if (level.type != LevelType::META && level.expectKey)
+			{
+				level.name = isNull ? "null" : value;
+				level.expectKey = false;
+				return;
+			}
+			if (level.type == LevelType::META_MAP)
+			{
+				ELEKTRA_LOG_DEBUG ("Add metakey “%s: %s”", level.name.c_str (), isNull ? "" : value.c_str ());
+				level.key.setMeta (level.name, isNull ? "" : value);
+				level.expectKey = true;
+				return;
+			}
+			if (level.type == LevelType::META)
+			{
+				if (level.index++ > 0) return;
+				level.key = Key (level.key.getFullName (), KEY_VALUE, isNull ? "null" : value.c_str (), KEY_END);
+				ELEKTRA_LOG_DEBUG ("Add key “%s: %s”", level.key.getName ().c_str (), level.key.get<string> ().c_str ());
+				mappings.append (level.key);
+				return;
+			}
+		}
+
+		Key key = nextKey ();
+		if (isNull) return;
+
+		key = Key (key.getFullName (), KEY_VALUE, value.c_str (), KEY_END);
 		ELEKTRA_LOG_DEBUG ("Add key “%s: %s”", key.getName ().c_str (), key.get<string> ().c_str ());
-		if (node.Tag () == "tag:yaml.org,2002:binary")
+		if (tag == "tag:yaml.org,2002:binary")
 		{
 			ELEKTRA_LOG_DEBUG ("Set metadata type of key to binary");
 			key.setMeta ("type", "binary");
 		}
 		mappings.append (key);
 	}
-	else if (node.IsMap () || node.IsSequence ())
+
+	/**
+	 * @brief This function opens a new collection.
+	 *
+	 * @param mark This argument specifies the location of the collection in the input.
+	 * @param tag This string stores the tag of the collection.
+	 * @param anchor This number specifies the anchor of the collection.
+	 * @param isMap This variable specifies if the collection is a mapping or a sequence.
+	 */
+	void startCollection (YAML::Mark const & mark, string const & tag, YAML::anchor_t const anchor, bool const isMap)
 	{
-		for (auto element : node)
+		if (!levels.empty () && levels.back ().type != LevelType::SEQUENCE)
 		{
-			Key key = node.IsMap () ? newKey (element.first.as<string> (), parent) : newArrayKey (mappings, parent);
-			ELEKTRA_LOG_DEBUG ("Add intermediate key “%s”", key.getName ().c_str ());
-			mappings.append (key);
-			convertNodeToKeySet (node.IsMap () ? element.second : element, mappings, key);
+			Level & level = levels.back ();
+			if (level.type == LevelType::META)
+			{
+				auto const index = level.index++;
+				if (index == 0) throw YAML::TypedBadConversion<string> (mark);
+				levels.push_back (Level{ index == 1 && isMap ? LevelType::META_MAP : LevelType::SKIP, level.key, mark, "", true, 0 });
+				return;
+			}
+			if (level.type == LevelType::SKIP)
+			{
+				levels.push_back (Level{ LevelType::SKIP, Key (), mark, "", false, 0 });
+				return;
+			}
+			if (level.expectKey || level.type == LevelType::META_MAP) throw YAML::TypedBadConversion<string> (mark);
 		}
+
+		Key key = nextKey ();
+		LevelType type = isMap ? LevelType::MAP : tag == "!elektra/meta" ? LevelType::META : LevelType::SEQUENCE;
+		levels.push_back (Level{ type, key, mark, "", true, 0 });
+		addAnchor (anchor, Anchor{ key, tag, "", false, false });
 	}
-}
+
+	/**
+	 * @brief This function closes the collection opened last.
+	 */
+	void endCollection ()
+	{
+		Level & level = levels.back ();
+		if (level.type == LevelType::META && level.index == 0) throw YAML::TypedBadConversion<string> (level.mark);
+		if (level.type == LevelType::SEQUENCE && level.index > 0)
+		{
+			char name[ELEKTRA_MAX_ARRAY_SIZE];
+			ckdb::elektraWriteArrayNumber (name, level.index - 1);
+			level.key.setMeta ("array", name);
+		}
+		levels.pop_back ();
+	}
+
+public:
+	/**
+	 * @brief This constructor creates a new builder.
+	 *
+	 * @param keySet This key set stores the keys the builder creates.
+	 * @param parentKey This key specifies the root of all keys the builder creates.
+	 */
+	KeySetBuilder (KeySet & keySet, Key const & parentKey) : mappings (keySet), parent (parentKey)
+	{
+	}
+
+	void OnDocumentStart (YAML::Mark const &) override
+	{
+	}
+
+	void OnDocumentEnd () override
+	{
+	}
+
+	void OnNull (YAML::Mark const &, YAML::anchor_t anchor) override
+	{
+		addScalar ("", anchor, "", true);
+	}
+
+	void OnAlias (YAML::Mark const & mark, YAML::anchor_t anchor) override
+	{
+		auto const & data = anchors[anchor];
+		if (data.isScalar)
+		{
+			addScalar (data.tag, YAML::NullAnchor, data.value, data.isNull);
+			return;
+		}
+
+		if (!levels.empty () && levels.back ().type != LevelType::SEQUENCE)
+		{
+			Level & level = levels.back ();
+			if (level.type == LevelType::SKIP || (level.type == LevelType::META && level.index++ > 0)) return;
+			if (level.expectKey || level.type != LevelType::MAP) throw YAML::TypedBadConversion<string> (mark);
+		}
+
+		copyKeys (data.key, nextKey ());
+	}
+
+	void OnScalar (YAML::Mark const &, string const & tag, YAML::anchor_t anchor, string const & value) override
+	{
+		addScalar (tag, anchor, value, false);
+	}
+
+	void OnSequenceStart (YAML::Mark const & mark, string const & tag, YAML::anchor_t anchor, YAML::EmitterStyle::value) override
+	{
+		startCollection (mark, tag, anchor, false);
+	}
+
+	void OnSequenceEnd () override
+	{
+		endCollection ();
+	}
+
+	void OnMapStart (YAML::Mark const & mark, string const & tag, YAML::anchor_t anchor, YAML::EmitterStyle::value) override
+	{
+		startCollection (mark, tag, anchor, true);
+	}
+
+	void OnMapEnd () override
+	{
+		endCollection ();
+	}
+};
 } // end namespace
 
 /**
@@ -127,14 +335,14 @@ void convertNodeToKeySet (YAML::Node const & node, KeySet & mappings, Key & pare
  */
 void yamlcpp::yamlRead (KeySet & mappings, Key & parent)
 {
-	YAML::Node config = YAML::LoadFile (parent.getString ());
+	ifstream input (parent.getString ());
+	if (!input) throw YAML::ParserException (YAML::Mark::null_mark (), "Unable to open file");
 
-#ifdef HAVE_LOGGER
-	ostringstream data;
-	data << config;
-	ELEKTRA_LOG_DEBUG ("Read data “%s”", data.str ().c_str ());
-#endif
+	KeySet keys;
+	YAML::Parser parser (input);
+	KeySetBuilder builder (keys, parent);
+	parser.HandleNextDocument (builder);
+	mappings.append (keys);
 
-	convertNodeToKeySet (config, mappings, parent);
 	ELEKTRA_LOG_DEBUG ("Added %zd key%s", mappings.size (), mappings.size () == 1 ? "" : "s");
 }
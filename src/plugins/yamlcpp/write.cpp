@@ -14,6 +14,7 @@
 #include <kdbplugin.h>
 
 #include <fstream>
+#include <vector>
 
 using namespace std;
 using namespace kdb;
@@ -48,14 +49,13 @@ NameIterator relativeKeyIterator (Key const & key, Key const & parent)
  *
  * If the key name contains a valid array index that is smaller than `unsigned long long`, then the function will also return this index.
  *
- * @param nameIterator This iterator specifies the name of the key.
+ * @param name This string specifies the name of the key.
  *
  * @retval (true, arrayIndex) if `name` specifies an array key, where `arrayIndex` specifies the index stored in the array key.
  * @retval (false, 0) otherwise
  */
-std::pair<bool, unsigned long long> isArrayIndex (NameIterator const & nameIterator)
+std::pair<bool, unsigned long long> isArrayIndex (string const & name)
 {
-	string const name = *nameIterator;
 	if (name.size () < 2 || name.front () != '#') return std::make_pair (false, 0);
 
 	auto errnoValue = errno;
@@ -75,19 +75,34 @@ std::pair<bool, unsigned long long> isArrayIndex (NameIterator const & nameItera
 	}
 }
 
+/** This structure stores a key and the part of its name the writer has not converted yet. */
+struct Entry
+{
+	Key key;
+	NameIterator current;
+	NameIterator end;
+};
+
+/** This structure stores a range of entries that share the same name part below the current level. */
+struct Group
+{
+	string name;
+	size_t begin;
+	size_t end;
+};
+
 /**
- * @brief This function creates a YAML Node containing a key value and optionally metadata.
+ * @brief This function emits a YAML scalar containing a key value and optionally metadata.
  *
- * @param key This key specifies the data that should be saved in the YAML node returned by this function.
- *
- * @returns A new YAML node containing the data and metadata specified in `key`
+ * @param emitter This emitter stores the YAML data this function produces.
+ * @param key This key specifies the data that should be emitted.
  */
-YAML::Node createLeafNode (Key & key)
+void emitLeaf (YAML::Emitter & emitter, Key & key)
 {
 	key.rewindMeta ();
 
-	YAML::Node metaNode{ YAML::Node (YAML::NodeType::Map) };
-	YAML::Node dataNode{ YAML::Node (key.getString ()) };
+	vector<pair<string, string>> metadata;
+	bool binary = false;
 	Key meta;
 
 	while ((meta = key.nextMeta ()))
@@ -95,96 +110,75 @@ YAML::Node createLeafNode (Key & key)
 		if (meta.getName () == "array") continue;
 		if (meta.getName () == "type" && meta.getString () == "binary")
 		{
-			dataNode.SetTag ("tag:yaml.org,2002:binary");
+			binary = true;
 			continue;
 		}
-		metaNode[meta.getName ()] = meta.getString ();
+		metadata.push_back (make_pair (meta.getName (), meta.getString ()));
 		ELEKTRA_LOG_DEBUG ("Add metakey “%s: %s”", meta.getName ().c_str (), meta.getString ().c_str ());
 	}
 
-	if (metaNode.size () <= 0)
+	if (!metadata.empty ()) emitter << YAML::VerbatimTag ("!elektra/meta") << YAML::BeginSeq;
+	if (binary) emitter << YAML::VerbatimTag ("tag:yaml.org,2002:binary");
+	ELEKTRA_LOG_DEBUG ("Emit leaf node with value “%s”", key.getString ().c_str ());
+	emitter << key.getString ();
+	if (metadata.empty ()) return;
+
+	emitter << YAML::BeginMap;
+	for (auto const & element : metadata)
 	{
-		ELEKTRA_LOG_DEBUG ("Return leaf node with value “%s”", key.getString ().c_str ());
-		return dataNode;
+		emitter << YAML::Key << element.first << YAML::Value << element.second;
 	}
-
-	YAML::Node node{ YAML::Node (YAML::NodeType::Sequence) };
-	node.SetTag ("!elektra/meta");
-	node.push_back (dataNode);
-	node.push_back (metaNode);
-
-#ifdef HAVE_LOGGER
-	ostringstream data;
-	data << node;
-	ELEKTRA_LOG_DEBUG ("Return meta leaf node with value “%s”", data.str ().c_str ());
-#endif
-
-	return node;
+	emitter << YAML::EndMap << YAML::EndSeq;
 }
 
 /**
- * @brief This function adds a key to a YAML node.
+ * @brief This function emits the YAML data for a range of keys that share the same name prefix.
+ *
+ * The keys of a key set are sorted, hence all keys below a certain key follow each other directly. This way we can emit the YAML data in
+ * a single pass over the key set.
  *
- * @param data This node stores the data specified via `keyIterator`.
- * @param keyIterator This iterator specifies the current part of the key name this function adds to `data`.
- * @param key This parameter specifies the key that should be added to `data`.
+ * @param emitter This emitter stores the YAML data this function produces.
+ * @param entries This vector stores the keys and the part of their names this function has not converted yet.
+ * @param begin This number specifies the first entry this function converts.
+ * @param end This number specifies the position after the last entry this function converts.
  */
-void addKey (YAML::Node & data, NameIterator & keyIterator, Key & key)
+void emitKeys (YAML::Emitter & emitter, vector<Entry> & entries, size_t begin, size_t end)
 {
-	auto const isArrayAndIndex = isArrayIndex (keyIterator);
-	auto const isArray = isArrayAndIndex.first;
-	auto const arrayIndex = isArrayAndIndex.second;
-
-	if (keyIterator == --key.end ())
+	// A key that has no children is a leaf. Otherwise we can not store its value, since the YAML node has to be a collection.
+	if (end - begin == 1 && entries[begin].current == entries[begin].end)
 	{
-		if (isArray)
-		{
-			data[arrayIndex] = createLeafNode (key);
-		}
-		else
-		{
-			data[*keyIterator] = createLeafNode (key);
-		}
-
+		emitLeaf (emitter, entries[begin].key);
 		return;
 	}
 
-	YAML::Node node;
-
-	if (isArray)
+	vector<Group> groups;
+	for (size_t entry = begin; entry < end; entry++)
 	{
-		node = (data[arrayIndex] && !data[arrayIndex].IsScalar ()) ? data[arrayIndex] : YAML::Node ();
-		data[arrayIndex] = node;
+		if (entries[entry].current == entries[entry].end) continue;
+		string name = *entries[entry].current;
+		if (groups.empty () || groups.back ().name != name) groups.push_back (Group{ name, entry, entry });
+		groups.back ().end = entry + 1;
+		++entries[entry].current;
 	}
-	else
+
+	bool isSequence = true;
+	for (size_t index = 0; index < groups.size () && isSequence; index++)
 	{
-		node = (data[*keyIterator] && !data[*keyIterator].IsScalar ()) ? data[*keyIterator] : YAML::Node ();
-		data[*keyIterator] = node;
+		auto const isArrayAndIndex = isArrayIndex (groups[index].name);
+		isSequence = isArrayAndIndex.first && isArrayAndIndex.second == index;
 	}
-	addKey (node, ++keyIterator, key);
-}
 
-/**
- * @brief This function adds a key set to a YAML node.
- *
- * @param data This node stores the data specified via `mappings`.
- * @param mappings This keyset specifies all keys and values this function adds to `data`.
- * @param parent This key is the root of all keys stored in `mappings`.
- */
-void addKeys (YAML::Node & data, KeySet const & mappings, Key const & parent)
-{
-	for (auto key : mappings)
+	emitter << (isSequence ? YAML::BeginSeq : YAML::BeginMap);
+	for (auto const & group : groups)
 	{
-		ELEKTRA_LOG_DEBUG ("Convert key “%s: %s”", key.getName ().c_str (), key.get<string> ().c_str ());
-		NameIterator keyIterator = relativeKeyIterator (key, parent);
-		addKey (data, keyIterator, key);
-
-#ifdef HAVE_LOGGER
-		ostringstream output;
-		output << data;
-		ELEKTRA_LOG_DEBUG ("Converted key data “%s”", output.str ().c_str ());
-#endif
+		if (!isSequence)
+		{
+			auto const isArrayAndIndex = isArrayIndex (group.name);
+			emitter << YAML::Key << (isArrayAndIndex.first ? to_string (isArrayAndIndex.second) : group.name) << YAML::Value;
+		}
+		emitKeys (emitter, entries, group.begin, group.end);
 	}
+	emitter << (isSequence ? YAML::EndSeq : YAML::EndMap);
 }
 
 } // end namespace
@@ -198,15 +192,15 @@ void addKeys (YAML::Node & data, KeySet const & mappings, Key const & parent)
 void yamlcpp::yamlWrite (KeySet const & mappings, Key const & parent)
 {
 	ofstream output (parent.getString ());
-	auto data = YAML::Node ();
-	addKeys (data, mappings, parent);
-
-#ifdef HAVE_LOGGER
-	ostringstream outputString;
-	outputString << data;
+	YAML::Emitter emitter (output);
 
-	ELEKTRA_LOG_DEBUG ("Write data “%s”", outputString.str ().c_str ());
-#endif
+	vector<Entry> entries;
+	entries.reserve (mappings.size ());
+	for (auto key : mappings)
+	{
+		ELEKTRA_LOG_DEBUG ("Convert key “%s: %s”", key.getName ().c_str (), key.get<string> ().c_str ());
+		entries.push_back (Entry{ key, relativeKeyIterator (key, parent), key.end () });
+	}
 
-	output << data;
+	if (!entries.empty ()) emitKeys (emitter, entries, 0, entries.size ());
 }
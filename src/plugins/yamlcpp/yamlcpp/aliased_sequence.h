@@ -0,0 +1,30 @@
+// clang-format off
+
+#define PREFIX "user/examples/yamlcpp/"
+
+ksNew (30,
+       keyNew (PREFIX "Isis", KEY_META, "array", "#_10", KEY_END),
+       keyNew (PREFIX "Isis/#0", KEY_VALUE, "The Beginning and the End", KEY_END),
+       keyNew (PREFIX "Isis/#1", KEY_VALUE, "The Other", KEY_END),
+       keyNew (PREFIX "Isis/#2", KEY_VALUE, "False Light", KEY_END),
+       keyNew (PREFIX "Isis/#3", KEY_VALUE, "Carry", KEY_END),
+       keyNew (PREFIX "Isis/#4", KEY_VALUE, "-", KEY_END),
+       keyNew (PREFIX "Isis/#5", KEY_VALUE, "Maritime", KEY_END),
+       keyNew (PREFIX "Isis/#6", KEY_VALUE, "Weight", KEY_END),
+       keyNew (PREFIX "Isis/#7", KEY_VALUE, "From Sinking", KEY_END),
+       keyNew (PREFIX "Isis/#8", KEY_VALUE, "Hym", KEY_END),
+       keyNew (PREFIX "Isis/#9", KEY_VALUE, "Untitled", KEY_END),
+       keyNew (PREFIX "Isis/#_10", KEY_VALUE, "Untitled (Hidden Track)", KEY_END),
+       keyNew (PREFIX "Oceanic", KEY_META, "array", "#_10", KEY_END),
+       keyNew (PREFIX "Oceanic/#0", KEY_VALUE, "The Beginning and the End", KEY_END),
+       keyNew (PREFIX "Oceanic/#1", KEY_VALUE, "The Other", KEY_END),
+       keyNew (PREFIX "Oceanic/#2", KEY_VALUE, "False Light", KEY_END),
+       keyNew (PREFIX "Oceanic/#3", KEY_VALUE, "Carry", KEY_END),
+       keyNew (PREFIX "Oceanic/#4", KEY_VALUE, "-", KEY_END),
+       keyNew (PREFIX "Oceanic/#5", KEY_VALUE, "Maritime", KEY_END),
+       keyNew (PREFIX "Oceanic/#6", KEY_VALUE, "Weight", KEY_END),
+       keyNew (PREFIX "Oceanic/#7", KEY_VALUE, "From Sinking", KEY_END),
+       keyNew (PREFIX "Oceanic/#8", KEY_VALUE, "Hym", KEY_END),
+       keyNew (PREFIX "Oceanic/#9", KEY_VALUE, "Untitled", KEY_END),
+       keyNew (PREFIX "Oceanic/#_10", KEY_VALUE, "Untitled (Hidden Track)", KEY_END),
+       KS_END)
@@ -513,6 +513,52 @@ static void test_top (void)
 	ksDel (testCycleOrder3);
 	elektraFree (array);
 }
+static void test_topShared (void)
+{
+	// more dependencies than keys, but no cycle
+	KeySet * shared = ksNew (
+		10, keyNew ("/a", KEY_VALUE, "c, d, e", KEY_META, "dep", "#2", KEY_META, "dep/#0", "/c", KEY_META, "dep/#1", "/d", KEY_META,
+			    "dep/#2", "/e", KEY_END),
+		keyNew ("/b", KEY_VALUE, "c, d, e", KEY_META, "dep", "#2", KEY_META, "dep/#0", "/c", KEY_META, "dep/#1", "/d", KEY_META,
+			"dep/#2", "/e", KEY_END),
+		keyNew ("/c", KEY_VALUE, "x", KEY_META, "dep", "#0", KEY_META, "dep/#0", "/x", KEY_END),
+		keyNew ("/d", KEY_VALUE, "x", KEY_META, "dep", "#0", KEY_META, "dep/#0", "/x", KEY_END),
+		keyNew ("/e", KEY_VALUE, "x", KEY_META, "dep", "#0", KEY_META, "dep/#0", "/x", KEY_END), keyNew ("/x", KEY_END), KS_END);
+	Key ** array = elektraMalloc (ksGetSize (shared) * sizeof (Key *));
+	succeed_if (elektraSortTopology (shared, array) == 1, "sort failed");
+	checkTopArray (array, ksGetSize (shared));
+	elektraFree (array);
+	ksDel (shared);
+}
+
+static void test_topChain (void)
+{
+	// every key depends on the next one
+	const int size = 5000;
+	KeySet * chain = ksNew (size, KS_END);
+	for (int i = 0; i < size; ++i)
+	{
+		char name[32];
+		char dep[32];
+		snprintf (name, sizeof (name), "/chain/%05d", i);
+		snprintf (dep, sizeof (dep), "/chain/%05d", i + 1);
+		Key * key = keyNew (name, KEY_CASCADING_NAME, KEY_END);
+		if (i + 1 < size) elektraMetaArrayAdd (key, "dep", dep);
+		ksAppendKey (chain, key);
+	}
+	Key ** array = elektraMalloc (size * sizeof (Key *));
+	succeed_if (elektraSortTopology (chain, array) == 1, "sort failed");
+	checkTopArray (array, size);
+	succeed_if (!strcmp (keyName (array[0]), "/chain/04999"), "last key of the chain not sorted first");
+	succeed_if (!strcmp (keyName (array[size - 1]), "/chain/00000"), "first key of the chain not sorted last");
+
+	// closing the chain gives a cycle
+	elektraMetaArrayAdd (ksLookupByName (chain, "/chain/04999", 0), "dep", "/chain/00000");
+	succeed_if (elektraSortTopology (chain, array) == 0, "Cycle detection failed\n");
+	elektraFree (array);
+	ksDel (chain);
+}
+
 int main (int argc, char ** argv)
 {
 	printf ("KEY META     TESTS\n");
@@ -529,6 +575,8 @@ int main (int argc, char ** argv)
 
 	test_metaArrayToKS ();
 	test_top ();
+	test_topShared ();
+	test_topChain ();
 	printf ("\ntest_meta RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
 
 	return nbError;
@@ -36,6 +36,33 @@ static void test_cmpOrder (void)
 	keyDel (k2);
 }
 
+static void test_sortByOrder (void)
+{
+	Key * array[] = {
+		keyNew ("user/a", KEY_META, "order", "30", KEY_END),
+		keyNew ("user/b", KEY_END),
+		keyNew ("user/c", KEY_META, "order", "10", KEY_END),
+		keyNew ("user/d", KEY_META, "order", "20", KEY_END),
+		keyNew ("user/e", KEY_END),
+		keyNew ("user/f", KEY_META, "order", "10", KEY_END),
+	};
+	const char * expected[] = { "user/b", "user/e", "user/c", "user/f", "user/d", "user/a" };
+	size_t size = sizeof (array) / sizeof (Key *);
+
+	succeed_if (elektraSortKeysByOrder (array, size) == 0, "could not sort keys");
+	for (size_t i = 0; i < size; ++i)
+	{
+		succeed_if_same_string (keyName (array[i]), expected[i]);
+		if (i > 0) succeed_if (elektraKeyCmpOrder (array[i - 1], array[i]) <= 0, "not sorted like elektraKeyCmpOrder");
+	}
+	succeed_if (elektraSortKeysByOrder (0, size) == -1, "sorting null array did not fail");
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		keyDel (array[i]);
+	}
+}
+
 static KeySet * set_a (void)
 {
 	return ksNew (16, keyNew ("user/0", KEY_END), keyNew ("user/a", KEY_END), keyNew ("user/a/a", KEY_END),
@@ -222,6 +249,7 @@ int main (int argc, char ** argv)
 
 	test_search ();
 	test_cmpOrder ();
+	test_sortByOrder ();
 	test_format ();
 
 	printf ("\ntest_operation RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
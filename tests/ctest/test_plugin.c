@@ -164,6 +164,96 @@ static void test_name (void)
 	ksDel (modules);
 }
 
+static int checkOpened;
+static int checkClosed;
+
+static int checkOpen (Plugin * handle, Key * errorKey ELEKTRA_UNUSED)
+{
+	++checkOpened;
+	elektraPluginSetData (handle, elektraCalloc (sizeof (int)));
+	return 1;
+}
+
+static int checkClose (Plugin * handle, Key * errorKey ELEKTRA_UNUSED)
+{
+	++checkClosed;
+	elektraFree (elektraPluginGetData (handle));
+	return 1;
+}
+
+static int checkKey (Plugin * handle, Key * key, Key * errorKey)
+{
+	int * checked = elektraPluginGetData (handle);
+	++*checked;
+	if (!strcmp (keyString (key), "invalid"))
+	{
+		ELEKTRA_SET_ERRORF (42, errorKey, "key %s is invalid", keyName (key));
+		return -1;
+	}
+	if (!strcmp (keyString (key), "warn"))
+	{
+		ELEKTRA_ADD_WARNINGF (59, errorKey, "key %s is suspicious", keyName (key));
+	}
+	return 1;
+}
+
+static KeySet * checkKeys (void)
+{
+	KeySet * ks = ksNew (0, KS_END);
+	char name[64];
+	for (int i = 0; i < 100; ++i)
+	{
+		snprintf (name, sizeof (name), "user/check/%02d", i);
+		ksAppendKey (ks, keyNew (name, KEY_VALUE, "valid", KEY_META, "check/test", "", KEY_END));
+		snprintf (name, sizeof (name), "user/check/%02d/unchecked", i);
+		ksAppendKey (ks, keyNew (name, KEY_VALUE, "invalid", KEY_END));
+	}
+	return ks;
+}
+
+static void test_checkKeys (void)
+{
+	printf ("Test check keys\n");
+
+	Plugin * plugin = elektraPluginExport ("check", ELEKTRA_PLUGIN_OPEN, &checkOpen, ELEKTRA_PLUGIN_CLOSE, &checkClose, ELEKTRA_PLUGIN_END);
+	checkOpen (plugin, 0);
+	checkOpened = checkClosed = 0;
+
+	for (size_t workers = 1; workers <= 8; workers *= 2)
+	{
+		KeySet * ks = checkKeys ();
+		Key * parentKey = keyNew ("user/check", KEY_END);
+		int * checked = elektraPluginGetData (plugin);
+		*checked = 0;
+
+		succeed_if (elektraPluginCheckKeysWith (plugin, ks, "check/test", checkKey, parentKey, workers, 0) == 1, "keys should be valid");
+		succeed_if (keyGetMeta (parentKey, "error") == 0, "no error expected");
+		succeed_if (keyGetMeta (parentKey, "warnings") == 0, "no warnings expected");
+		succeed_if (checkOpened == (workers > 1 ? (int)workers : 0), "every thread should open the plugin");
+		succeed_if (checkOpened == checkClosed, "every opened plugin should be closed");
+		succeed_if (*checked == (workers > 1 ? 0 : 100), "threads should use their own instance");
+		checkOpened = checkClosed = 0;
+
+		keySetString (ksLookupByName (ks, "user/check/10", 0), "warn");
+		keySetString (ksLookupByName (ks, "user/check/30", 0), "invalid");
+		keySetString (ksLookupByName (ks, "user/check/70", 0), "invalid");
+		keySetString (ksLookupByName (ks, "user/check/80", 0), "warn");
+
+		succeed_if (elektraPluginCheckKeysWith (plugin, ks, "check/test", checkKey, parentKey, workers, 0) == -1, "key should be invalid");
+		succeed_if_same_string (keyString (keyGetMeta (parentKey, "error/reason")), "key user/check/30 is invalid");
+		succeed_if_same_string (keyString (keyGetMeta (parentKey, "warnings")), "00");
+		succeed_if_same_string (keyString (keyGetMeta (parentKey, "warnings/#00/reason")), "key user/check/10 is suspicious");
+		succeed_if_same_string (keyName (ksCurrent (ks)), "user/check/30");
+		checkOpened = checkClosed = 0;
+
+		keyDel (parentKey);
+		ksDel (ks);
+	}
+
+	checkClose (plugin, 0);
+	elektraFree (plugin);
+}
+
 int main (int argc, char ** argv)
 {
 	printf (" PLUGINS  TESTS\n");
@@ -174,6 +264,7 @@ int main (int argc, char ** argv)
 	test_process ();
 	test_simple ();
 	test_name ();
+	test_checkKeys ();
 
 	printf ("\ntest_plugin RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
 
@@ -0,0 +1,305 @@
+/**
+ * @file
+ *
+ * @brief Tests for the keys passed to post-storage plugins of backends
+ *
+ * @copyright BSD License (see LICENSE.md or https://www.libelektra.org)
+ */
+
+#include <../../src/libs/elektra/backend.c>
+#include <../../src/libs/elektra/kdb.c>
+#include <../../src/libs/elektra/mount.c>
+#include <../../src/libs/elektra/split.c>
+#include <../../src/libs/elektra/trie.c>
+#include <tests_internal.h>
+
+typedef enum { NOTHING, ADD, REMOVE, REPLACE } Action;
+
+typedef struct
+{
+	Action action;
+	const char * name; ///< the key to add, remove or replace
+	KeySet * seen;     ///< the keys passed in the last call
+	int calls;
+} Behaviour;
+
+static int postStorageGet (Plugin * handle, KeySet * returned, Key * parentKey ELEKTRA_UNUSED)
+{
+	Behaviour * behaviour = handle->data;
+	++behaviour->calls;
+	ksDel (behaviour->seen);
+	behaviour->seen = ksDup (returned);
+
+	switch (behaviour->action)
+	{
+	case NOTHING:
+		break;
+	case ADD:
+		ksAppendKey (returned, keyNew (behaviour->name, KEY_VALUE, "added", KEY_END));
+		break;
+	case REMOVE:
+		keyDel (ksLookupByName (returned, behaviour->name, KDB_O_POP));
+		break;
+	case REPLACE:
+		ksAppendKey (returned, keyNew (behaviour->name, KEY_VALUE, "replaced", KEY_END));
+		break;
+	}
+	return 1;
+}
+
+static Plugin * newPlugin (Behaviour * behaviour)
+{
+	Plugin * plugin = elektraCalloc (sizeof (Plugin));
+	plugin->kdbGet = postStorageGet;
+	plugin->data = behaviour;
+	return plugin;
+}
+
+static KeySet * createKeys (void)
+{
+	return ksNew (30, keyNew ("spec/tests/a", KEY_END), keyNew ("spec/tests/a/x", KEY_END), keyNew ("dir/tests/a", KEY_END),
+		      keyNew ("dir/tests/a/x", KEY_VALUE, "dir", KEY_END), keyNew ("dir/tests/b/x", KEY_VALUE, "dir", KEY_END),
+		      keyNew ("system/tests", KEY_END), keyNew ("system/tests/a", KEY_END),
+		      keyNew ("system/tests/a/x", KEY_VALUE, "system", KEY_END), keyNew ("system/tests/a/x/y", KEY_END),
+		      keyNew ("system/tests/ab", KEY_END), keyNew ("system/tests/b/x", KEY_VALUE, "system", KEY_END),
+		      keyNew ("user/tests/a/x", KEY_VALUE, "user", KEY_END), keyNew ("user/tests/ab/x", KEY_END),
+		      keyNew ("user/tests/b", KEY_END), keyNew ("user/tests/b/x", KEY_VALUE, "user", KEY_END),
+		      keyNew ("user/tests/c", KEY_END), KS_END);
+}
+
+/**
+ * @return the keys of ks below parent in all namespaces but spec
+ */
+static KeySet * below (KeySet * ks, const char * parent)
+{
+	KeySet * ret = ksNew (0, KS_END);
+	Key * cur;
+	ksRewind (ks);
+	while ((cur = ksNext (ks)) != NULL)
+	{
+		if (keyGetNamespace (cur) == KEY_NS_SPEC) continue;
+		const char * name = strchr (keyName (cur), '/');
+		size_t size = strlen (parent);
+		if (name && !strncmp (name, parent, size) && (name[size] == '\0' || name[size] == '/')) ksAppendKey (ret, cur);
+	}
+	return ret;
+}
+
+/**
+ * Runs the post-storage plugins of backends mounted at /tests/a (for
+ * system and user) and /tests/b (for user) on ks.
+ */
+static void runPostStorage (KDB * handle, KeySet * ks, Plugin ** pluginsA, size_t sizeA, Plugin ** pluginsB, size_t sizeB)
+{
+	Backend * backendA = elektraCalloc (sizeof (Backend));
+	Backend * backendB = elektraCalloc (sizeof (Backend));
+	for (size_t p = 0; p < sizeA; ++p)
+	{
+		backendA->getplugins[STORAGE_PLUGIN + 1 + p] = pluginsA[p];
+	}
+	for (size_t p = 0; p < sizeB; ++p)
+	{
+		backendB->getplugins[STORAGE_PLUGIN + 1 + p] = pluginsB[p];
+	}
+
+	Split * split = splitNew ();
+	splitAppend (split, backendA, keyNew ("system/tests/a", KEY_END), SPLIT_FLAG_SYNC);
+	splitAppend (split, backendA, keyNew ("user/tests/a", KEY_END), SPLIT_FLAG_SYNC);
+	splitAppend (split, backendB, keyNew ("user/tests/b", KEY_END), SPLIT_FLAG_SYNC);
+	splitAppend (split, 0, keyNew ("user/tests/bypass", KEY_END), 0);
+
+	Key * parentKey = keyNew ("/tests", KEY_CASCADING_NAME, KEY_END);
+	Key * initialParent = keyDup (parentKey);
+	succeed_if (elektraGetDoUpdateWithGlobalHooks (handle, split, ks, parentKey, initialParent, LAST) == 0, "could not run plugins");
+
+	keyDel (initialParent);
+	keyDel (parentKey);
+	splitDel (split);
+	elektraFree (backendA);
+	elektraFree (backendB);
+}
+
+static void test_nothing (void)
+{
+	printf ("Test post-storage plugins which change nothing\n");
+
+	KDB * handle = elektraCalloc (sizeof (KDB));
+	KeySet * ks = createKeys ();
+	KeySet * before = ksDup (ks);
+
+	Behaviour a = { NOTHING, 0, 0, 0 };
+	Behaviour b = { NOTHING, 0, 0, 0 };
+	Plugin * pluginA = newPlugin (&a);
+	Plugin * pluginB = newPlugin (&b);
+	runPostStorage (handle, ks, &pluginA, 1, &pluginB, 1);
+
+	succeed_if (a.calls == 2, "plugin of /tests/a should be called for system and user");
+	succeed_if (b.calls == 1, "plugin of /tests/b should be called once");
+
+	KeySet * expected = below (before, "/tests/a");
+	compare_keyset (a.seen, expected);
+	ksDel (expected);
+	expected = below (before, "/tests/b");
+	compare_keyset (b.seen, expected);
+	ksDel (expected);
+
+	succeed_if (ksGetSize (ks) == ksGetSize (before), "size of keyset changed");
+	for (size_t i = 0; i < ks->size && i < before->size; ++i)
+	{
+		succeed_if (ks->array[i] == before->array[i], "keys should be kept");
+	}
+
+	ksDel (a.seen);
+	ksDel (b.seen);
+	elektraFree (pluginA);
+	elektraFree (pluginB);
+	ksDel (before);
+	ksDel (ks);
+	elektraFree (handle);
+}
+
+static void test_add (void)
+{
+	printf ("Test post-storage plugins which add keys\n");
+
+	KDB * handle = elektraCalloc (sizeof (KDB));
+	KeySet * ks = createKeys ();
+
+	Behaviour a = { ADD, "dir/tests/a/added", 0, 0 };
+	Behaviour seen = { NOTHING, 0, 0, 0 };
+	Behaviour b = { ADD, "system/tests/b/added", 0, 0 };
+	Plugin * pluginsA[] = { newPlugin (&a), newPlugin (&seen) };
+	Plugin * pluginB = newPlugin (&b);
+	runPostStorage (handle, ks, pluginsA, 2, &pluginB, 1);
+
+	KeySet * expected = createKeys ();
+	ksAppendKey (expected, keyNew ("dir/tests/a/added", KEY_VALUE, "added", KEY_END));
+	ksAppendKey (expected, keyNew ("system/tests/b/added", KEY_VALUE, "added", KEY_END));
+	compare_keyset (ks, expected);
+
+	KeySet * seenExpected = below (expected, "/tests/a");
+	compare_keyset (seen.seen, seenExpected);
+	ksDel (seenExpected);
+
+	ksDel (expected);
+	ksDel (a.seen);
+	ksDel (seen.seen);
+	ksDel (b.seen);
+	elektraFree (pluginsA[0]);
+	elektraFree (pluginsA[1]);
+	elektraFree (pluginB);
+	ksDel (ks);
+	elektraFree (handle);
+}
+
+static void test_remove (void)
+{
+	printf ("Test post-storage plugins which remove keys\n");
+
+	KDB * handle = elektraCalloc (sizeof (KDB));
+	KeySet * ks = createKeys ();
+
+	Behaviour a = { REMOVE, "system/tests/a/x", 0, 0 };
+	Behaviour b = { REMOVE, "dir/tests/b/x", 0, 0 };
+	Plugin * pluginA = newPlugin (&a);
+	Plugin * pluginB = newPlugin (&b);
+	runPostStorage (handle, ks, &pluginA, 1, &pluginB, 1);
+
+	KeySet * expected = createKeys ();
+	keyDel (ksLookupByName (expected, "system/tests/a/x", KDB_O_POP));
+	keyDel (ksLookupByName (expected, "dir/tests/b/x", KDB_O_POP));
+	compare_keyset (ks, expected);
+
+	KeySet * seenExpected = below (expected, "/tests/a");
+	compare_keyset (a.seen, seenExpected);
+	ksDel (seenExpected);
+
+	ksDel (expected);
+	ksDel (a.seen);
+	ksDel (b.seen);
+	elektraFree (pluginA);
+	elektraFree (pluginB);
+	ksDel (ks);
+	elektraFree (handle);
+}
+
+static void test_replace (void)
+{
+	printf ("Test post-storage plugins which replace keys\n");
+
+	KDB * handle = elektraCalloc (sizeof (KDB));
+	KeySet * ks = createKeys ();
+	Key * old = ksLookupByName (ks, "user/tests/b/x", 0);
+	keyIncRef (old);
+
+	Behaviour a = { NOTHING, 0, 0, 0 };
+	Behaviour b = { REPLACE, "user/tests/b/x", 0, 0 };
+	Plugin * pluginA = newPlugin (&a);
+	Plugin * pluginB = newPlugin (&b);
+	runPostStorage (handle, ks, &pluginA, 1, &pluginB, 1);
+
+	KeySet * expected = createKeys ();
+	keySetString (ksLookupByName (expected, "user/tests/b/x", 0), "replaced");
+	compare_keyset (ks, expected);
+	succeed_if (ksLookupByName (ks, "user/tests/b/x", 0) != old, "key should be replaced");
+
+	keyDecRef (old);
+	keyDel (old);
+	ksDel (expected);
+	ksDel (a.seen);
+	ksDel (b.seen);
+	elektraFree (pluginA);
+	elektraFree (pluginB);
+	ksDel (ks);
+	elektraFree (handle);
+}
+
+static void test_cleanup (void)
+{
+	printf ("Test changes of post-storage plugins seen by global cleanup plugin\n");
+
+	KDB * handle = elektraCalloc (sizeof (KDB));
+	KeySet * ks = createKeys ();
+
+	Behaviour a = { ADD, "user/tests/a/added", 0, 0 };
+	Behaviour b = { NOTHING, 0, 0, 0 };
+	Behaviour cleanup = { NOTHING, 0, 0, 0 };
+	Plugin * pluginA = newPlugin (&a);
+	Plugin * pluginB = newPlugin (&b);
+	handle->globalPlugins[POSTGETCLEANUP][FOREACH] = newPlugin (&cleanup);
+	runPostStorage (handle, ks, &pluginA, 1, &pluginB, 1);
+
+	succeed_if (cleanup.calls == 1, "global plugin should be called once");
+	KeySet * expected = createKeys ();
+	ksAppendKey (expected, keyNew ("user/tests/a/added", KEY_VALUE, "added", KEY_END));
+	compare_keyset (cleanup.seen, expected);
+	compare_keyset (ks, expected);
+
+	ksDel (expected);
+	ksDel (a.seen);
+	ksDel (b.seen);
+	ksDel (cleanup.seen);
+	elektraFree (pluginA);
+	elektraFree (pluginB);
+	elektraFree (handle->globalPlugins[POSTGETCLEANUP][FOREACH]);
+	ksDel (ks);
+	elektraFree (handle);
+}
+
+int main (int argc, char ** argv)
+{
+	printf ("POST-STORAGE TESTS\n");
+	printf ("==================\n\n");
+
+	init (argc, argv);
+
+	test_nothing ();
+	test_add ();
+	test_remove ();
+	test_replace ();
+	test_cleanup ();
+
+	printf ("\ntest_postgetstorage RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
+
+	return nbError;
+}
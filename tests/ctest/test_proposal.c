@@ -54,6 +54,105 @@ static void test_ksToArray (void)
 	ksDel (ks);
 }
 
+static void test_ksNextWithMeta (void)
+{
+	printf ("test ksNextWithMeta\n");
+
+	KeySet * ks = ksNew (10, keyNew ("user/a", KEY_META, "check/enum", "'x'", KEY_END), keyNew ("user/b", KEY_END),
+			     keyNew ("user/c", KEY_META, "check/range", "1-2", KEY_END),
+			     keyNew ("user/d", KEY_META, "check/enum", "'y'", KEY_META, "check/range", "1-2", KEY_END), KS_END);
+
+	ksRewind (ks);
+	succeed_if_same_string (keyName (ksNextWithMeta (ks, "check/enum")), "user/a");
+	succeed_if (ksCurrent (ks) == ksLookupByName (ks, "user/a", 0), "cursor not set");
+	succeed_if_same_string (keyName (ksNextWithMeta (ks, "check/enum")), "user/d");
+	succeed_if (ksNextWithMeta (ks, "check/enum") == 0, "should be at the end");
+	succeed_if (ksNextWithMeta (ks, "check/enum") == 0, "should stay at the end");
+	succeed_if (ksNext (ks) == 0, "ksNext should be at the end too");
+
+	// the index is reused for other names and iterations
+	ksRewind (ks);
+	succeed_if_same_string (keyName (ksNextWithMeta (ks, "check/range")), "user/c");
+	succeed_if_same_string (keyName (ksNextWithMeta (ks, "check/range")), "user/d");
+	succeed_if (ksNextWithMeta (ks, "check/range") == 0, "should be at the end");
+
+	// mixing with ksNext continues after the cursor
+	ksRewind (ks);
+	succeed_if_same_string (keyName (ksNext (ks)), "user/a");
+	succeed_if_same_string (keyName (ksNext (ks)), "user/b");
+	succeed_if_same_string (keyName (ksNextWithMeta (ks, "check/enum")), "user/d");
+
+	// modified meta information is seen in the next iteration
+	keySetMeta (ksLookupByName (ks, "user/b", 0), "check/enum", "'z'");
+	keySetMeta (ksLookupByName (ks, "user/d", 0), "check/enum", 0);
+	ksRewind (ks);
+	succeed_if_same_string (keyName (ksNextWithMeta (ks, "check/enum")), "user/a");
+	succeed_if_same_string (keyName (ksNextWithMeta (ks, "check/enum")), "user/b");
+	succeed_if (ksNextWithMeta (ks, "check/enum") == 0, "should be at the end");
+
+	// added and removed keys are seen
+	ksAppendKey (ks, keyNew ("user/aa", KEY_META, "check/enum", "'w'", KEY_END));
+	keyDel (ksLookupByName (ks, "user/a", KDB_O_POP));
+	ksRewind (ks);
+	succeed_if_same_string (keyName (ksNextWithMeta (ks, "check/enum")), "user/aa");
+	succeed_if_same_string (keyName (ksNextWithMeta (ks, "check/enum")), "user/b");
+	succeed_if (ksNextWithMeta (ks, "check/enum") == 0, "should be at the end");
+
+	KeySet * cut = ksCut (ks, ksLookupByName (ks, "user/b", 0));
+	ksRewind (ks);
+	succeed_if_same_string (keyName (ksNextWithMeta (ks, "check/enum")), "user/aa");
+	succeed_if (ksNextWithMeta (ks, "check/enum") == 0, "should be at the end");
+	ksDel (cut);
+
+	succeed_if (ksNextWithMeta (ks, 0) == 0, "null pointer");
+	succeed_if (ksNextWithMeta (0, "check/enum") == 0, "null pointer");
+	ksDel (ks);
+}
+
+static Key * newSyncedKey (const char * name, const char * value, const char * comment)
+{
+	Key * key = keyNew (name, KEY_VALUE, value, KEY_END);
+	if (comment) keySetMeta (key, "comment", comment);
+	keyClearSync (key);
+	return key;
+}
+
+static void test_ksDiff (void)
+{
+	printf ("test ksDiff\n");
+
+	Key * a = newSyncedKey ("user/a", "a", 0);
+	Key * f = newSyncedKey ("user/f", "f", 0);
+	KeySet * oldKs = ksNew (10, a, newSyncedKey ("user/b", "b", 0), newSyncedKey ("user/c", "c", 0),
+				newSyncedKey ("user/d", "d", "old"), newSyncedKey ("user/e", "e", "same"), f, KS_END);
+	KeySet * newKs = ksNew (10, a, newSyncedKey ("user/c", "changed", 0), newSyncedKey ("user/d", "d", "new"),
+				newSyncedKey ("user/e", "e", "same"), f, newSyncedKey ("user/g", "g", 0), KS_END);
+
+	KeySet * added = ksNew (0, KS_END);
+	KeySet * removed = ksNew (0, KS_END);
+	KeySet * modified = ksNew (0, KS_END);
+
+	succeed_if (ksDiff (oldKs, newKs, added, removed, modified) == 4, "wrong number of changes");
+	succeed_if (ksGetSize (added) == 1 && ksLookupByName (added, "user/g", 0), "user/g should be added");
+	succeed_if (ksGetSize (removed) == 1 && ksLookupByName (removed, "user/b", 0), "user/b should be removed");
+	succeed_if (ksGetSize (modified) == 2, "wrong number of modified keys");
+	succeed_if (ksLookupByName (modified, "user/c", 0) == ksLookupByName (newKs, "user/c", 0), "value of user/c was modified");
+	succeed_if (ksLookupByName (modified, "user/d", 0) == ksLookupByName (newKs, "user/d", 0), "meta of user/d was modified");
+
+	keySetString (f, "modified");
+	succeed_if (ksDiff (oldKs, newKs, 0, 0, 0) == 5, "key needing sync should be modified");
+	succeed_if (ksDiff (newKs, newKs, 0, 0, 0) == 1, "only the key needing sync should differ");
+
+	succeed_if (ksDiff (0, newKs, 0, 0, 0) == -1, "null pointer");
+	succeed_if (ksDiff (oldKs, 0, 0, 0, 0) == -1, "null pointer");
+
+	ksDel (added);
+	ksDel (removed);
+	ksDel (modified);
+	ksDel (oldKs);
+	ksDel (newKs);
+}
+
 static void test_keyAsCascading (void)
 {
 	printf ("test keyAsCascading\n");
@@ -232,6 +331,8 @@ int main (int argc, char ** argv)
 
 	test_ksPopAtCursor ();
 	test_ksToArray ();
+	test_ksNextWithMeta ();
+	test_ksDiff ();
 
 	test_keyAsCascading ();
 	test_keyGetLevelsBelow ();